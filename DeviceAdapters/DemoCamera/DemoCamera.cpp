@@ -63,9 +63,10 @@ const char* g_PixelType_32bit = "32bit";  // floating point greyscale
 // constants for naming camera modes
 const char* g_Sine_Wave = "Artificial Waves";
 const char* g_Norm_Noise = "Noise";
+const char* g_Fast_Noise = "Fast Noise";
 const char* g_Color_Test = "Color Test Pattern";
 
-enum { MODE_ARTIFICIAL_WAVES, MODE_NOISE, MODE_COLOR_TEST };
+enum { MODE_ARTIFICIAL_WAVES, MODE_NOISE, MODE_COLOR_TEST, MODE_FAST_NOISE };
 
 ///////////////////////////////////////////////////////////////////////////////
 // Exported MMDevice API
@@ -90,6 +91,8 @@ MODULE_API void InitializeModuleData()
    RegisterDevice("ImageFlipX", MM::ImageProcessorDevice, "ImageFlipX");
    RegisterDevice("ImageFlipY", MM::ImageProcessorDevice, "ImageFlipY");
    RegisterDevice("MedianFilter", MM::ImageProcessorDevice, "MedianFilter");
+   RegisterDevice("BoxFilter", MM::ImageProcessorDevice, "BoxFilter");
+   RegisterDevice("GaussianFilter", MM::ImageProcessorDevice, "GaussianFilter");
    RegisterDevice(g_HubDeviceName, MM::HubDevice, "DHub");
 }
 
@@ -181,6 +184,14 @@ MODULE_API MM::Device* CreateDevice(const char* deviceName)
    {
       return new MedianFilter();
    }
+   else if(strcmp(deviceName, "BoxFilter") == 0)
+   {
+      return new BoxFilter();
+   }
+   else if(strcmp(deviceName, "GaussianFilter") == 0)
+   {
+      return new GaussianFilter();
+   }
    else if (strcmp(deviceName, g_HubDeviceName) == 0)
    {
 	  return new DemoHub();
@@ -510,6 +521,7 @@ int CDemoCamera::Initialize()
    AddAllowedValue(propName.c_str(), g_Sine_Wave);
    AddAllowedValue(propName.c_str(), g_Norm_Noise);
    AddAllowedValue(propName.c_str(), g_Color_Test);
+   AddAllowedValue(propName.c_str(), g_Fast_Noise);
 
    // Photon Conversion Factor for Noise type camera
    pAct = new CPropertyAction(this, &CDemoCamera::OnPCF);
@@ -1898,6 +1910,9 @@ int CDemoCamera::OnMode(MM::PropertyBase* pProp, MM::ActionType eAct)
          case MODE_COLOR_TEST:
             val = g_Color_Test;
             break;
+         case MODE_FAST_NOISE:
+            val = g_Fast_Noise;
+            break;
          default:
             val = g_Sine_Wave;
             break;
@@ -1915,6 +1930,10 @@ int CDemoCamera::OnMode(MM::PropertyBase* pProp, MM::ActionType eAct)
       {
          mode_ = MODE_COLOR_TEST;
       }
+      else if (val == g_Fast_Noise)
+      {
+         mode_ = MODE_FAST_NOISE;
+      }
       else
       {
          mode_ = MODE_ARTIFICIAL_WAVES;
@@ -2055,13 +2074,39 @@ void CDemoCamera::GenerateEmptyImage(ImgBuffer& img)
 * Options:
 * 1. a spatial sine wave.
 * 2. Gaussian noise
+* 3. Gaussian noise from the fast generator (8 and 16 bit only), for load
+*    testing at high frame rates
 */
 void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
 {
   
    MMThreadGuard g(imgPixelsLock_);
 
-   if (mode_ == MODE_NOISE)
+   if (mode_ == MODE_FAST_NOISE && (img.Depth() == 1 || img.Depth() == 2))
+   {
+      // Same model as MODE_NOISE in a single pass: read noise and shot
+      // noise are independent, so their sum is Gaussian with the summed
+      // variance.
+      const unsigned bitDepth = GetBitDepth();
+      const double offset = bitDepth > 8 ? 100 : 10;
+      const double photons = photonFlux_ * exp;
+      const double readNoiseDN = readNoise_ / pcf_;
+      const double shotNoiseDN = sqrt(photons) / pcf_;
+      const double mean = offset + photons / pcf_;
+      const double stdDev = sqrt(readNoiseDN * readNoiseDN + shotNoiseDN * shotNoiseDN);
+      const unsigned maxValue = (1u << bitDepth) - 1;
+      if (img.Depth() == 1)
+         noiseGenerator_.Fill(img.GetPixelsRW(), img.Width(), img.Height(), mean, stdDev, maxValue);
+      else
+         noiseGenerator_.Fill(reinterpret_cast<uint16_t*>(img.GetPixelsRW()), img.Width(), img.Height(), mean, stdDev, maxValue);
+      if (imgManpl_ != 0)
+      {
+         imgManpl_->ChangePixels(img);
+      }
+      return;
+   }
+
+   if (mode_ == MODE_NOISE || mode_ == MODE_FAST_NOISE)
    {
       double max = 1 << GetBitDepth();
       int offset = 10;
@@ -3361,6 +3406,61 @@ int CDemoObjectiveTurret::OnTrigger(MM::PropertyBase* pProp, MM::ActionType eAct
    return DEVICE_OK;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// DemoSequence implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void DemoSequence::Clear()
+{
+   nascent_.clear();
+   streamed_.clear();
+   streaming_ = false;
+   lowReported_ = false;
+}
+
+void DemoSequence::Send()
+{
+   sent_ = nascent_;
+   nascent_.clear();
+   index_ = 0;
+}
+
+long DemoSequence::Append(const double* values, long count)
+{
+   streaming_ = true;
+   long room = maxLength_ - (long)streamed_.size();
+   long n = std::max(0L, std::min(count, room));
+   streamed_.insert(streamed_.end(), values, values + n);
+   if (n > 0)
+      lowReported_ = false;
+   return n;
+}
+
+bool DemoSequence::Next(double& value, bool& bufferLow)
+{
+   bufferLow = false;
+   if (streaming_)
+   {
+      if (streamed_.empty())
+         return false;
+      value = streamed_.front();
+      streamed_.pop_front();
+      if (!lowReported_ && (long)streamed_.size() <= maxLength_ / 2)
+      {
+         lowReported_ = true;
+         bufferLow = true;
+      }
+      return true;
+   }
+
+   if (index_ >= sent_.size())
+      return false;
+   value = sent_[index_++];
+   if (index_ >= sent_.size())
+      index_ = 0;
+   return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // CDemoStage implementation
 // ~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -3372,10 +3472,14 @@ CDemoStage::CDemoStage() :
    initialized_(false),
    lowerLimit_(-300.0),
    upperLimit_(300.0),
-   sequenceable_(false)
+   sequenceable_(false),
+   sequenceRunning_(false),
+   sequence_(2000)
 {
    InitializeDefaultErrorMessages();
    SetErrorText(ERR_UNKNOWN_POSITION, "Position out of range");
+   SetErrorText(ERR_IN_SEQUENCE, "Sequence triggered, but no position is left in the sequence");
+   SetErrorText(ERR_SEQUENCE_INACTIVE, "Sequence triggered, but sequence is not running");
 
    // parent ID display
    CreateHubIDProperty();
@@ -3435,6 +3539,14 @@ int CDemoStage::Initialize()
    if (ret != DEVICE_OK)
       return ret;
 
+   // Triggers to test sequence capabilities
+   pAct = new CPropertyAction (this, &CDemoStage::OnTrigger);
+   ret = CreateStringProperty("Trigger", "-", false, pAct);
+   AddAllowedValue("Trigger", "-");
+   AddAllowedValue("Trigger", "+");
+   if (ret != DEVICE_OK)
+      return ret;
+
    ret = UpdateStatus();
    if (ret != DEVICE_OK)
       return ret;
@@ -3485,7 +3597,7 @@ int CDemoStage::GetStageSequenceMaxLength(long& nrEvents) const
       return DEVICE_UNSUPPORTED_COMMAND;
    }
 
-   nrEvents = 2000;
+   nrEvents = sequence_.GetMaxLength();
    return DEVICE_OK;
 }
 
@@ -3495,6 +3607,7 @@ int CDemoStage::StartStageSequence()
       return DEVICE_UNSUPPORTED_COMMAND;
    }
 
+   sequenceRunning_ = true;
    return DEVICE_OK;
 }
 
@@ -3504,6 +3617,8 @@ int CDemoStage::StopStageSequence()
       return DEVICE_UNSUPPORTED_COMMAND;
    }
 
+   sequenceRunning_ = false;
+   sequence_.Rewind();
    return DEVICE_OK;
 }
 
@@ -3513,15 +3628,17 @@ int CDemoStage::ClearStageSequence()
       return DEVICE_UNSUPPORTED_COMMAND;
    }
 
+   sequence_.Clear();
    return DEVICE_OK;
 }
 
-int CDemoStage::AddToStageSequence(double /* position */)
+int CDemoStage::AddToStageSequence(double position)
 {
    if (!sequenceable_) {
       return DEVICE_UNSUPPORTED_COMMAND;
    }
 
+   sequence_.Add(position);
    return DEVICE_OK;
 }
 
@@ -3531,6 +3648,18 @@ int CDemoStage::SendStageSequence()
       return DEVICE_UNSUPPORTED_COMMAND;
    }
 
+   sequence_.Send();
+   return DEVICE_OK;
+}
+
+int CDemoStage::AppendToStageSequence(const double* positions, long numPositions,
+   long& numAppended)
+{
+   if (!sequenceable_) {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
+
+   numAppended = sequence_.Append(positions, numPositions);
    return DEVICE_OK;
 }
 
@@ -3583,6 +3712,33 @@ int CDemoStage::OnSequence(MM::PropertyBase* pProp, MM::ActionType eAct)
    }
    return DEVICE_OK;
 }
+
+int CDemoStage::OnTrigger(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      pProp->Set("-");
+   } else if (eAct == MM::AfterSet) {
+      if (!sequenceRunning_)
+         return ERR_SEQUENCE_INACTIVE;
+      std::string tr;
+      pProp->Get(tr);
+      if (tr == "+") {
+         double pos;
+         bool bufferLow;
+         if (!sequence_.Next(pos, bufferLow))
+            return ERR_IN_SEQUENCE;
+         pos_um_ = pos;
+         SetIntensityFactor(pos);
+         int ret = OnStagePositionChanged(pos_um_);
+         if (ret != DEVICE_OK)
+            return ret;
+         if (bufferLow)
+            return OnSequenceBufferLow();
+      }
+   }
+   return DEVICE_OK;
+}
 ///////////////////////////////////////////////////////////////////////////////
 // CDemoXYStage implementation
 // ~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -4079,9 +4235,7 @@ volt_(0),
 gatedVolts_(0), 
 open_(true),
 sequenceRunning_(false),
-sequenceIndex_(0),
-sentSequence_(std::vector<double>()),
-nascentSequence_(std::vector<double>())
+sequence_(256)
 {
    SetErrorText(ERR_SEQUENCE_INACTIVE, "Sequence triggered, but sequence is not running");
 
@@ -4166,26 +4320,26 @@ int DemoDA::GetSignal(double& volts)
 
 int DemoDA::SendDASequence() 
 {
-   (const_cast<DemoDA*> (this))->SetSentSequence();
+   sequence_.Send();
    return DEVICE_OK;
 }
 
-// private
-void DemoDA::SetSentSequence()
+int DemoDA::ClearDASequence()
 {
-   sentSequence_ = nascentSequence_;
-   nascentSequence_.clear();
+   sequence_.Clear();
+   return DEVICE_OK;
 }
 
-int DemoDA::ClearDASequence()
+int DemoDA::AddToDASequence(double voltage)
 {
-   nascentSequence_.clear();
+   sequence_.Add(voltage);
    return DEVICE_OK;
 }
 
-int DemoDA::AddToDASequence(double voltage)
+int DemoDA::AppendToDASequence(const double* voltages, long numVoltages,
+   long& numAppended)
 {
-   nascentSequence_.push_back(voltage);
+   numAppended = sequence_.Append(voltages, numVoltages);
    return DEVICE_OK;
 }
 
@@ -4200,19 +4354,15 @@ int DemoDA::OnTrigger(MM::PropertyBase* pProp, MM::ActionType eAct)
       std::string tr;
       pProp->Get(tr);
       if (tr == "+") {
-         if (sequenceIndex_ < sentSequence_.size()) {
-            double voltage = sentSequence_[sequenceIndex_];
-            int ret = SetSignal(voltage);
-            if (ret != DEVICE_OK)
-               return ERR_IN_SEQUENCE;
-            sequenceIndex_++;
-            if (sequenceIndex_ >= sentSequence_.size()) {
-               sequenceIndex_ = 0;
-            }
-         } else
-         {
+         double voltage;
+         bool bufferLow;
+         if (!sequence_.Next(voltage, bufferLow))
             return ERR_IN_SEQUENCE;
-         }
+         int ret = SetSignal(voltage);
+         if (ret != DEVICE_OK)
+            return ERR_IN_SEQUENCE;
+         if (bufferLow)
+            return OnSequenceBufferLow();
       }
    }
    return DEVICE_OK;
@@ -5017,67 +5167,87 @@ int ImageFlipX::Process(unsigned char *pBuffer, unsigned int width, unsigned int
 ///
 int MedianFilter::Initialize()
 {
-    CPropertyAction* pAct = new CPropertyAction (this, &MedianFilter::OnPerformanceTiming);
-    (void)CreateFloatProperty("PeformanceTiming (microseconds)", 0, true, pAct);
-    (void)CreateStringProperty("BEWARE", "THIS FILTER MODIFIES DATA, EACH PIXEL IS REPLACED BY 3X3 NEIGHBORHOOD MEDIAN", true);
+   (void)CreatePerformanceTimingProperty();
+   (void)CreateStringProperty("BEWARE", "THIS FILTER MODIFIES DATA, EACH PIXEL IS REPLACED BY ITS NEIGHBORHOOD MEDIAN", true);
+   CPropertyAction* pAct = new CPropertyAction (this, &MedianFilter::OnRadius);
+   (void)CreateIntegerProperty("Radius", radius_, false, pAct);
+   (void)SetPropertyLimits("Radius", 1, 50);
    return DEVICE_OK;
 }
 
    // action interface
    // ----------------
-int MedianFilter::OnPerformanceTiming(MM::PropertyBase* pProp, MM::ActionType eAct)
+int MedianFilter::OnRadius(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
-
    if (eAct == MM::BeforeGet)
    {
-      pProp->Set( performanceTiming_.getUsec());
+      pProp->Set(radius_.load());
    }
    else if (eAct == MM::AfterSet)
    {
-      // -- it's ready only!
+      long radius;
+      pProp->Get(radius);
+      radius_ = radius;
    }
-
    return DEVICE_OK;
 }
 
 
-int MedianFilter::Process(unsigned char *pBuffer, unsigned int width, unsigned int height, unsigned int byteDepth)
+///
+int BoxFilter::Initialize()
 {
-   if(busy_)
-      return DEVICE_ERR;
-
-   int ret = DEVICE_OK;
- 
-   busy_ = true;
-   performanceTiming_ = MM::MMTime(0.);
-   MM::MMTime  s0 = GetCurrentMMTime();
-
+   (void)CreatePerformanceTimingProperty();
+   (void)CreateStringProperty("BEWARE", "THIS FILTER MODIFIES DATA, EACH PIXEL IS REPLACED BY ITS NEIGHBORHOOD MEAN", true);
+   CPropertyAction* pAct = new CPropertyAction (this, &BoxFilter::OnRadius);
+   (void)CreateIntegerProperty("Radius", radius_, false, pAct);
+   (void)SetPropertyLimits("Radius", 1, 50);
+   return DEVICE_OK;
+}
 
-   if( sizeof(unsigned char) == byteDepth)
-   {
-      ret = Filter( (unsigned char*)pBuffer, width, height);
-   }
-   else if( sizeof(unsigned short) == byteDepth)
+   // action interface
+   // ----------------
+int BoxFilter::OnRadius(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
    {
-      ret = Filter( (unsigned short*)pBuffer, width, height);
+      pProp->Set(radius_.load());
    }
-   else if( sizeof(unsigned long) == byteDepth)
+   else if (eAct == MM::AfterSet)
    {
-      ret = Filter( (unsigned long*)pBuffer, width, height);
+      long radius;
+      pProp->Get(radius);
+      radius_ = radius;
    }
-   else if( sizeof(unsigned long long) == byteDepth)
+   return DEVICE_OK;
+}
+
+
+///
+int GaussianFilter::Initialize()
+{
+   (void)CreatePerformanceTimingProperty();
+   (void)CreateStringProperty("BEWARE", "THIS FILTER MODIFIES DATA, EACH PIXEL IS REPLACED BY A GAUSSIAN-WEIGHTED NEIGHBORHOOD MEAN", true);
+   CPropertyAction* pAct = new CPropertyAction (this, &GaussianFilter::OnSigma);
+   (void)CreateFloatProperty("Sigma (pixels)", sigma_, false, pAct);
+   (void)SetPropertyLimits("Sigma (pixels)", 0.3, 16.0);
+   return DEVICE_OK;
+}
+
+   // action interface
+   // ----------------
+int GaussianFilter::OnSigma(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
    {
-      ret =  Filter( (unsigned long long*)pBuffer, width, height);
+      pProp->Set(sigma_.load());
    }
-   else
+   else if (eAct == MM::AfterSet)
    {
-      ret =  DEVICE_NOT_SUPPORTED;
+      double sigma;
+      pProp->Get(sigma);
+      sigma_ = sigma;
    }
-
-   performanceTiming_ = GetCurrentMMTime() - s0;
-   busy_ = false;
-
-   return ret;
+   return DEVICE_OK;
 }
 
 
@@ -32,10 +32,14 @@
 #include "DeviceBase.h"
 #include "ImgBuffer.h"
 #include "DeviceThreads.h"
+#include "ImageFilters.h"
+#include "NoiseGenerator.h"
 #include <string>
 #include <map>
 #include <algorithm>
 #include <stdint.h>
+#include <atomic>
+#include <deque>
 #include <future>
 
 //////////////////////////////////////////////////////////////////////////////
@@ -281,6 +285,7 @@ private:
    double pcf_;
    double photonFlux_;
    double readNoise_;
+   NoiseGenerator noiseGenerator_;
 };
 
 class MySequenceThread : public MMDeviceThreadBase
@@ -456,6 +461,41 @@ private:
    long position_;
 };
 
+//////////////////////////////////////////////////////////////////////////////
+// DemoSequence class
+// Values of a triggered sequence (DemoStage positions, DemoDA voltages).
+// A sequence is either sent whole, in which case it repeats, or streamed
+// (appended in chunks while it runs), in which case each value is used once.
+//////////////////////////////////////////////////////////////////////////////
+
+class DemoSequence
+{
+public:
+   explicit DemoSequence(long maxLength) : maxLength_(maxLength) {}
+
+   long GetMaxLength() const { return maxLength_; }
+
+   void Clear();
+   void Add(double value) { nascent_.push_back(value); }
+   void Send();
+   // Returns the number of values that fit
+   long Append(const double* values, long count);
+   void Rewind() { index_ = 0; }
+
+   // Returns false if there is no value to move to. Sets bufferLow the first
+   // time a streamed sequence drops to half its maximum length.
+   bool Next(double& value, bool& bufferLow);
+
+private:
+   const long maxLength_;
+   std::vector<double> nascent_;
+   std::vector<double> sent_;
+   size_t index_ = 0;
+   bool streaming_ = false;
+   std::deque<double> streamed_;
+   bool lowReported_ = false;
+};
+
 //////////////////////////////////////////////////////////////////////////////
 // CDemoStage class
 // Simulation of the single axis stage
@@ -502,6 +542,7 @@ public:
    // ----------------
    int OnPosition(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnSequence(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnTrigger(MM::PropertyBase* pProp, MM::ActionType eAct);
 
    // Sequence functions
    int IsStageSequenceable(bool& isSequenceable) const;
@@ -509,8 +550,9 @@ public:
    int StartStageSequence();
    int StopStageSequence();
    int ClearStageSequence();
-   int AddToStageSequence(double /* position */);
+   int AddToStageSequence(double position);
    int SendStageSequence();
+   int AppendToStageSequence(const double* positions, long numPositions, long& numAppended);
 
 private:
    void SetIntensityFactor(double pos);
@@ -521,6 +563,8 @@ private:
    double lowerLimit_;
    double upperLimit_;
    bool sequenceable_;
+   bool sequenceRunning_;
+   DemoSequence sequence_;
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -682,7 +726,7 @@ public:
    }
    int GetDASequenceMaxLength(long& nrEvents) const 
    {
-      nrEvents = 256;
+      nrEvents = sequence_.GetMaxLength();
       return DEVICE_OK;
    }
    int StartDASequence()
@@ -698,6 +742,7 @@ public:
    int SendDASequence();
    int ClearDASequence();
    int AddToDASequence(double voltage);
+   int AppendToDASequence(const double* voltages, long numVoltages, long& numAppended);
 
    int OnTrigger(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnVoltage(MM::PropertyBase* pProp, MM::ActionType eAct);
@@ -709,14 +754,10 @@ private:
    double gatedVolts_;
    bool open_;
    bool sequenceRunning_;
-   unsigned long sequenceIndex_;
-   std::vector<double> sentSequence_;
-   std::vector<double> nascentSequence_;
+   DemoSequence sequence_;
 
    void SetSequenceStateOn() { sequenceRunning_ = true; }
-   void SetSequenceStateOff() { sequenceRunning_ = false; sequenceIndex_ = 0; }
-
-   void SetSentSequence();
+   void SetSequenceStateOff() { sequenceRunning_ = false; sequence_.Rewind(); }
 };
 
 
@@ -941,125 +982,160 @@ private:
 
 
 //////////////////////////////////////////////////////////////////////////////
-// MedianFilter class
-// apply Median filter an image
-// K.H.
+// NeighborhoodFilter class
+// common part of the smoothing filters below: Process() dispatches on the
+// pixel size to U::Filter() and times the call. Unlike the other processors
+// these can be called concurrently (the work is split across cores inside
+// each call).
 //////////////////////////////////////////////////////////////////////////////
-class MedianFilter : public CImageProcessorBase<MedianFilter>
+template <class U>
+class NeighborhoodFilter : public CImageProcessorBase<U>
 {
 public:
-   MedianFilter () : busy_(false), performanceTiming_(0.),pSmoothedIm_(0), sizeOfSmoothedIm_(0)
+   NeighborhoodFilter () : performanceTiming_(0.)
    {
       // parent ID display
-      CreateHubIDProperty();
-   };
-   ~MedianFilter () { if(0!=pSmoothedIm_) free(pSmoothedIm_); };
+      this->CreateHubIDProperty();
+   }
 
    int Shutdown() {return DEVICE_OK;}
-   void GetName(char* name) const {strcpy(name,"MedianFilter");}
+   bool Busy(void) { return false;}
 
-   int Initialize();
-   bool Busy(void) { return busy_;};
+   int Process(unsigned char* pBuffer, unsigned width, unsigned height, unsigned byteDepth)
+   {
+      MM::MMTime s0 = this->GetCurrentMMTime();
+      U* derived = static_cast<U*>(this);
+      try
+      {
+         if (byteDepth == 1)
+            derived->Filter(reinterpret_cast<uint8_t*>(pBuffer), width, height);
+         else if (byteDepth == 2)
+            derived->Filter(reinterpret_cast<uint16_t*>(pBuffer), width, height);
+         else if (byteDepth == 4)
+            derived->Filter(reinterpret_cast<uint32_t*>(pBuffer), width, height);
+         else if (byteDepth == 8)
+            derived->Filter(reinterpret_cast<uint64_t*>(pBuffer), width, height);
+         else
+            return DEVICE_NOT_SUPPORTED;
+      }
+      catch (const std::bad_alloc&)
+      {
+         return DEVICE_OUT_OF_MEMORY;
+      }
+
+      MMThreadGuard g(timingLock_);
+      performanceTiming_ = this->GetCurrentMMTime() - s0;
+      return DEVICE_OK;
+   }
+
+   // action interface
+   // ----------------
+   int OnPerformanceTiming(MM::PropertyBase* pProp, MM::ActionType eAct)
+   {
+      if (eAct == MM::BeforeGet)
+      {
+         MMThreadGuard g(timingLock_);
+         pProp->Set(performanceTiming_.getUsec());
+      }
+      return DEVICE_OK;
+   }
 
-   // NOTE: this utility MODIFIES the argument, make a copy yourself if you want the original data preserved
-   template <class U> U FindMedian(std::vector<U>& values ) {
-      std::sort(values.begin(), values.end());
-      return values[(values.size())>>1];
-   };
+protected:
+   int CreatePerformanceTimingProperty()
+   {
+      typename CImageProcessorBase<U>::CPropertyAction* pAct =
+         new typename CImageProcessorBase<U>::CPropertyAction(static_cast<U*>(this), &NeighborhoodFilter::OnPerformanceTiming);
+      return this->CreateFloatProperty("PeformanceTiming (microseconds)", 0, true, pAct);
+   }
+
+   // Threads for Filter(), kept across frames
+   RowBandPool rowBands_;
+
+private:
+   MMThreadLock timingLock_;
+   MM::MMTime performanceTiming_;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+// MedianFilter class
+// apply Median filter an image
+// K.H.
+//////////////////////////////////////////////////////////////////////////////
+class MedianFilter : public NeighborhoodFilter<MedianFilter>
+{
+public:
+   MedianFilter () : radius_(1) {}
 
+   void GetName(char* name) const {strcpy(name,"MedianFilter");}
+   int Initialize();
 
    template <typename PixelType>
-   int Filter(PixelType* pI, unsigned int width, unsigned int height)
+   void Filter(PixelType* pI, unsigned int width, unsigned int height)
    {
-      int ret = DEVICE_OK;
-      int x[9];
-      int y[9];
+      ImageFilters::Median(pI, width, height, radius_, rowBands_);
+   }
 
-      const unsigned long thisSize = sizeof(*pI)*width*height;
-      if( thisSize != sizeOfSmoothedIm_)
-      {
-         if(NULL!=pSmoothedIm_)
-         {
-            sizeOfSmoothedIm_ = 0;
-            free(pSmoothedIm_);
-         }
-         // malloc is faster than new...
-         pSmoothedIm_ = (PixelType*)malloc(thisSize);
-         if(NULL!=pSmoothedIm_)
-         {
-            sizeOfSmoothedIm_ = thisSize;
-         }
-      }
+   // action interface
+   // ----------------
+   int OnRadius(MM::PropertyBase* pProp, MM::ActionType eAct);
 
-      PixelType* pSmooth = (PixelType*) pSmoothedIm_;
+private:
+   std::atomic<long> radius_;
+};
 
-      if(NULL != pSmooth)
-      {
-      /*Apply 3x3 median filter to reduce shot noise*/
-      for (unsigned int i=0; i<width; i++) {
-         for (unsigned int j=0; j<height; j++) {
-            x[0]=i-1;
-            y[0]=(j-1);
-            x[1]=i;
-            y[1]=(j-1);
-            x[2]=i+1;
-            y[2]=(j-1);
-            x[3]=i-1;
-            y[3]=(j);
-            x[4]=i;
-            y[4]=(j);
-            x[5]=i+1;
-            y[5]=(j);
-            x[6]=i-1;
-            y[6]=(j+1);
-            x[7]=i;
-            y[7]=(j+1);
-            x[8]=i+1;
-            y[8]=(j+1);
-            // truncate the median filter window  -- duplicate edge points
-            // this could be more efficient, we could fill in the interior image [1,w0-1]x[1,h0-1] then explicitly fill in the edge pixels.
-            // also the temporary image could be as small as 2 rasters of the image
-            for(int ij =0; ij < 9; ++ij)
-            {
-               if( x[ij] < 0)
-                  x[ij] = 0;
-               else if( int(width-1) < x[ij])
-                  x[ij] = int(width-1);
-               if( y[ij] < 0)
-                  y[ij] = 0;
-               else if( int(height-1) < y[ij])
-                  y[ij] = (int)(height-1);
-            }
-            std::vector<PixelType> windo;
-            for(int ij = 0; ij < 9; ++ij)
-            {
-               windo.push_back(pI[ x[ij] + width*y[ij]]);
-            }
-            pSmooth[i + j*width] = FindMedian(windo);
-         }
-      }
 
-      memcpy( pI, pSmoothedIm_, thisSize);
-      }
-      else
-         ret = DEVICE_ERR;
+//////////////////////////////////////////////////////////////////////////////
+// BoxFilter class
+// replace each pixel by the mean of its neighborhood
+//////////////////////////////////////////////////////////////////////////////
+class BoxFilter : public NeighborhoodFilter<BoxFilter>
+{
+public:
+   BoxFilter () : radius_(1) {}
 
-      return ret;
+   void GetName(char* name) const {strcpy(name,"BoxFilter");}
+   int Initialize();
+
+   template <typename PixelType>
+   void Filter(PixelType* pI, unsigned int width, unsigned int height)
+   {
+      ImageFilters::Box(pI, width, height, radius_, rowBands_);
    }
-   int Process(unsigned char* buffer, unsigned width, unsigned height, unsigned byteDepth);
 
    // action interface
    // ----------------
-   int OnPerformanceTiming(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnRadius(MM::PropertyBase* pProp, MM::ActionType eAct);
 
 private:
-   bool busy_;
-   MM::MMTime performanceTiming_;
-   void*  pSmoothedIm_;
-   unsigned long sizeOfSmoothedIm_;
-   
+   std::atomic<long> radius_;
+};
 
 
+//////////////////////////////////////////////////////////////////////////////
+// GaussianFilter class
+// Gaussian blur
+//////////////////////////////////////////////////////////////////////////////
+class GaussianFilter : public NeighborhoodFilter<GaussianFilter>
+{
+public:
+   GaussianFilter () : sigma_(1.0) {}
+
+   void GetName(char* name) const {strcpy(name,"GaussianFilter");}
+   int Initialize();
+
+   template <typename PixelType>
+   void Filter(PixelType* pI, unsigned int width, unsigned int height)
+   {
+      ImageFilters::Gaussian(pI, width, height, sigma_, rowBands_);
+   }
+
+   // action interface
+   // ----------------
+   int OnSigma(MM::PropertyBase* pProp, MM::ActionType eAct);
+
+private:
+   std::atomic<double> sigma_;
 };
 
 
@@ -0,0 +1,794 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ImageFilters.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Neighborhood filters used by the demo image processors
+//                (MedianFilter, BoxFilter, GaussianFilter).
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "ImageFilters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGEFILTERS_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ImageFilters {
+
+namespace {
+
+// Index of the pixel used for coordinate i (edge pixels are replicated)
+inline std::size_t Clamp(long long i, unsigned n)
+{
+   return i < 0 ? 0 : (i >= (long long)n ? n - 1 : (std::size_t)i);
+}
+
+// Filters from a copy of the image so that bands can read their neighbors'
+// rows while those are being overwritten.
+template <typename T, typename RowsFunc>
+void FilterInPlace(T* pixels, unsigned width, unsigned height,
+   RowBandPool& pool, unsigned maxBands, RowsFunc rows)
+{
+   if (width == 0 || height == 0)
+      return;
+   const std::vector<T> src(pixels, pixels + (std::size_t)width * height);
+   pool.ForEachRowBand(width, height, maxBands, [&](unsigned y0, unsigned y1) {
+      rows(src.data(), pixels, y0, y1);
+   });
+}
+
+//
+// Vector helpers
+//
+
+// h[i] += add[i] for a block of 16 histogram counts
+inline void AddCounts16(uint16_t* h, const uint16_t* add)
+{
+#ifdef IMAGEFILTERS_HAVE_SSE2
+   for (int i = 0; i < 16; i += 8)
+   {
+      __m128i v = _mm_loadu_si128((const __m128i*)(h + i));
+      v = _mm_add_epi16(v, _mm_loadu_si128((const __m128i*)(add + i)));
+      _mm_storeu_si128((__m128i*)(h + i), v);
+   }
+#else
+   for (int i = 0; i < 16; ++i)
+      h[i] = (uint16_t)(h[i] + add[i]);
+#endif
+}
+
+// h[i] += add[i] - sub[i] for a block of 16 histogram counts
+inline void AddSubCounts16(uint16_t* h, const uint16_t* add,
+   const uint16_t* sub)
+{
+#ifdef IMAGEFILTERS_HAVE_SSE2
+   for (int i = 0; i < 16; i += 8)
+   {
+      __m128i v = _mm_loadu_si128((const __m128i*)(h + i));
+      v = _mm_add_epi16(v, _mm_loadu_si128((const __m128i*)(add + i)));
+      v = _mm_sub_epi16(v, _mm_loadu_si128((const __m128i*)(sub + i)));
+      _mm_storeu_si128((__m128i*)(h + i), v);
+   }
+#else
+   for (int i = 0; i < 16; ++i)
+      h[i] = (uint16_t)(h[i] + add[i] - sub[i]);
+#endif
+}
+
+// acc[i] += add[i] - sub[i]; sums may wrap in between but never at the end
+template <typename Sum>
+inline void AddSubRow(Sum* acc, const Sum* add, const Sum* sub,
+   std::size_t n)
+{
+   for (std::size_t i = 0; i < n; ++i)
+      acc[i] += add[i] - sub[i];
+}
+
+#ifdef IMAGEFILTERS_HAVE_SSE2
+template <>
+inline void AddSubRow(uint32_t* acc, const uint32_t* add,
+   const uint32_t* sub, std::size_t n)
+{
+   std::size_t i = 0;
+   for (; i + 4 <= n; i += 4)
+   {
+      __m128i v = _mm_loadu_si128((const __m128i*)(acc + i));
+      v = _mm_add_epi32(v, _mm_loadu_si128((const __m128i*)(add + i)));
+      v = _mm_sub_epi32(v, _mm_loadu_si128((const __m128i*)(sub + i)));
+      _mm_storeu_si128((__m128i*)(acc + i), v);
+   }
+   for (; i < n; ++i)
+      acc[i] += add[i] - sub[i];
+}
+#endif
+
+// acc[i] += a * src[i]
+template <typename Real>
+inline void Axpy(Real* acc, const Real* src, Real a, std::size_t n)
+{
+   for (std::size_t i = 0; i < n; ++i)
+      acc[i] += a * src[i];
+}
+
+#ifdef IMAGEFILTERS_HAVE_SSE2
+template <>
+inline void Axpy(float* acc, const float* src, float a, std::size_t n)
+{
+   const __m128 va = _mm_set1_ps(a);
+   std::size_t i = 0;
+   for (; i + 4 <= n; i += 4)
+   {
+      const __m128 v = _mm_mul_ps(va, _mm_loadu_ps(src + i));
+      _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), v));
+   }
+   for (; i < n; ++i)
+      acc[i] += a * src[i];
+}
+
+template <>
+inline void Axpy(double* acc, const double* src, double a, std::size_t n)
+{
+   const __m128d va = _mm_set1_pd(a);
+   std::size_t i = 0;
+   for (; i + 2 <= n; i += 2)
+   {
+      const __m128d v = _mm_mul_pd(va, _mm_loadu_pd(src + i));
+      _mm_storeu_pd(acc + i, _mm_add_pd(_mm_loadu_pd(acc + i), v));
+   }
+   for (; i < n; ++i)
+      acc[i] += a * src[i];
+}
+#endif
+
+//
+// Median, radius 1: sort each column of three, then the median is the median
+// of (largest minimum, median of medians, smallest maximum) over the three
+// columns. Only min/max operations, so 8- and 16-bit pixels are done a
+// vector at a time.
+//
+
+template <typename T>
+struct ScalarMinMax
+{
+   typedef T Vec;
+   static const std::size_t lanes = 1;
+   static Vec Load(const T* p) { return *p; }
+   static void Store(T* p, Vec v) { *p = v; }
+   static Vec Min(Vec a, Vec b) { return b < a ? b : a; }
+   static Vec Max(Vec a, Vec b) { return a < b ? b : a; }
+};
+
+#ifdef IMAGEFILTERS_HAVE_SSE2
+struct MinMaxU8
+{
+   typedef __m128i Vec;
+   static const std::size_t lanes = 16;
+   static Vec Load(const uint8_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+   static void Store(uint8_t* p, Vec v) { _mm_storeu_si128((__m128i*)p, v); }
+   static Vec Min(Vec a, Vec b) { return _mm_min_epu8(a, b); }
+   static Vec Max(Vec a, Vec b) { return _mm_max_epu8(a, b); }
+};
+
+// SSE2 has no unsigned 16-bit min/max; use saturating subtraction
+struct MinMaxU16
+{
+   typedef __m128i Vec;
+   static const std::size_t lanes = 8;
+   static Vec Load(const uint16_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+   static void Store(uint16_t* p, Vec v) { _mm_storeu_si128((__m128i*)p, v); }
+   static Vec Min(Vec a, Vec b) { return _mm_sub_epi16(a, _mm_subs_epu16(a, b)); }
+   static Vec Max(Vec a, Vec b) { return _mm_add_epi16(b, _mm_subs_epu16(a, b)); }
+};
+#endif
+
+// Filters pixels [x, width) of one row from three padded source rows (pixel
+// i at index i + 1); returns the first pixel not done (less than a vector
+// from the end).
+template <typename Ops, typename T>
+std::size_t Median3x3Span(const T* above, const T* row, const T* below,
+   T* out, std::size_t x, std::size_t width)
+{
+   typedef typename Ops::Vec Vec;
+   for (; x + Ops::lanes <= width; x += Ops::lanes)
+   {
+      Vec lo[3], mid[3], hi[3];
+      for (std::size_t k = 0; k < 3; ++k)
+      {
+         const Vec a = Ops::Load(above + x + k);
+         const Vec b = Ops::Load(row + x + k);
+         const Vec c = Ops::Load(below + x + k);
+         const Vec minAB = Ops::Min(a, b);
+         const Vec maxAB = Ops::Max(a, b);
+         lo[k] = Ops::Min(minAB, c);
+         hi[k] = Ops::Max(maxAB, c);
+         mid[k] = Ops::Max(minAB, Ops::Min(maxAB, c));
+      }
+      const Vec maxLo = Ops::Max(Ops::Max(lo[0], lo[1]), lo[2]);
+      const Vec minHi = Ops::Min(Ops::Min(hi[0], hi[1]), hi[2]);
+      const Vec min01 = Ops::Min(mid[0], mid[1]);
+      const Vec max01 = Ops::Max(mid[0], mid[1]);
+      const Vec medMid = Ops::Max(min01, Ops::Min(max01, mid[2]));
+      const Vec minLoMid = Ops::Min(maxLo, medMid);
+      const Vec maxLoMid = Ops::Max(maxLo, medMid);
+      Ops::Store(out + x, Ops::Max(minLoMid, Ops::Min(maxLoMid, minHi)));
+   }
+   return x;
+}
+
+template <typename T>
+std::size_t Median3x3Vector(const T*, const T*, const T*, T*, std::size_t)
+{
+   return 0;
+}
+
+#ifdef IMAGEFILTERS_HAVE_SSE2
+template <>
+std::size_t Median3x3Vector(const uint8_t* above, const uint8_t* row,
+   const uint8_t* below, uint8_t* out, std::size_t width)
+{
+   return Median3x3Span<MinMaxU8>(above, row, below, out, 0, width);
+}
+
+template <>
+std::size_t Median3x3Vector(const uint16_t* above, const uint16_t* row,
+   const uint16_t* below, uint16_t* out, std::size_t width)
+{
+   return Median3x3Span<MinMaxU16>(above, row, below, out, 0, width);
+}
+#endif
+
+template <typename T>
+void Median3x3Rows(const T* src, T* dst, unsigned width, unsigned height,
+   unsigned y0, unsigned y1)
+{
+   std::vector<T> padded(3 * ((std::size_t)width + 2));
+   T* rows[3] = { &padded[0], &padded[width + 2], &padded[2 * (width + 2)] };
+   for (long long y = y0; y < (long long)y1; ++y)
+   {
+      for (long long dy = -1; dy <= 1; ++dy)
+      {
+         const T* source = src + Clamp(y + dy, height) * width;
+         T* p = rows[dy + 1];
+         std::memcpy(p + 1, source, width * sizeof(T));
+         p[0] = source[0];
+         p[width + 1] = source[width - 1];
+      }
+      T* out = dst + (std::size_t)y * width;
+      const std::size_t x = Median3x3Vector(rows[0], rows[1], rows[2], out, width);
+      Median3x3Span<ScalarMinMax<T> >(rows[0], rows[1], rows[2], out, x, width);
+   }
+}
+
+//
+// Median, 8 bits: Perreault & Hebert, "Median Filtering in Constant Time",
+// IEEE Trans. Image Process. 16(9), 2007.
+//
+// Each column keeps a histogram of the 2r+1 pixels above and below the
+// current row, updated with one pixel removed and one added per row. The
+// kernel histogram moves right by adding one column histogram and removing
+// another. Histograms are two-level (16 coarse bins of 16 fine bins); the
+// coarse level is kept up to date for every pixel, and a fine block is only
+// brought up to date when the median falls into it.
+//
+
+void MedianRows8(const uint8_t* src, uint8_t* dst, unsigned width,
+   unsigned height, unsigned radius, unsigned y0, unsigned y1)
+{
+   const long long r = radius;
+   const unsigned target = (2 * radius + 1) * (2 * radius + 1) / 2;
+
+   std::vector<uint16_t> colCoarse((std::size_t)width * 16);
+   std::vector<uint16_t> colFine((std::size_t)width * 256);
+   for (long long dy = -r; dy <= r; ++dy)
+   {
+      const uint8_t* row = src + Clamp(y0 + dy, height) * width;
+      for (std::size_t x = 0; x < width; ++x)
+      {
+         ++colCoarse[x * 16 + (row[x] >> 4)];
+         ++colFine[x * 256 + row[x]];
+      }
+   }
+
+   uint16_t coarse[16];
+   uint16_t fine[256];
+   long long fineAt[16]; // Column each fine block is valid for; -1 if none
+   for (unsigned y = y0; y < y1; ++y)
+   {
+      if (y > y0)
+      {
+         const uint8_t* leaving = src + Clamp((long long)y - r - 1, height) * width;
+         const uint8_t* entering = src + Clamp((long long)y + r, height) * width;
+         for (std::size_t x = 0; x < width; ++x)
+         {
+            --colCoarse[x * 16 + (leaving[x] >> 4)];
+            --colFine[x * 256 + leaving[x]];
+            ++colCoarse[x * 16 + (entering[x] >> 4)];
+            ++colFine[x * 256 + entering[x]];
+         }
+      }
+
+      std::memset(coarse, 0, sizeof(coarse));
+      for (long long dx = -r; dx <= r; ++dx)
+         AddCounts16(coarse, &colCoarse[Clamp(dx, width) * 16]);
+      std::fill(fineAt, fineAt + 16, -1LL);
+
+      uint8_t* out = dst + (std::size_t)y * width;
+      for (long long x = 0; x < (long long)width; ++x)
+      {
+         if (x > 0)
+            AddSubCounts16(coarse, &colCoarse[Clamp(x + r, width) * 16],
+               &colCoarse[Clamp(x - r - 1, width) * 16]);
+
+         unsigned below = 0;
+         unsigned b = 0;
+         while (below + coarse[b] <= target)
+            below += coarse[b++];
+
+         uint16_t* block = fine + b * 16;
+         const std::size_t offset = b * 16;
+         // Catching up costs two block updates per column moved, rebuilding
+         // costs 2r+1
+         if (fineAt[b] < 0 || x - fineAt[b] > r)
+         {
+            std::memset(block, 0, 16 * sizeof(uint16_t));
+            for (long long dx = -r; dx <= r; ++dx)
+               AddCounts16(block, &colFine[Clamp(x + dx, width) * 256 + offset]);
+         }
+         else
+         {
+            for (long long xx = fineAt[b] + 1; xx <= x; ++xx)
+               AddSubCounts16(block,
+                  &colFine[Clamp(xx + r, width) * 256 + offset],
+                  &colFine[Clamp(xx - r - 1, width) * 256 + offset]);
+         }
+         fineAt[b] = x;
+
+         unsigned v = 0;
+         while (below + block[v] <= target)
+            below += block[v++];
+         out[x] = (uint8_t)(offset + v);
+      }
+   }
+}
+
+//
+// Median, 16 bits: the column histograms above would take 128 KiB per
+// column, so the window histogram (two-level, 256 x 256 bins) is instead
+// slid directly, in a serpentine scan so that it never has to be rebuilt.
+// The median is tracked incrementally, which is cheap because neighboring
+// windows have close medians.
+//
+
+class SlidingHistogram16
+{
+public:
+   explicit SlidingHistogram16(unsigned target) :
+      fine_(65536), coarse_(256), target_(target), median_(0), below_(0)
+   {}
+
+   void Add(unsigned v)
+   {
+      ++fine_[v];
+      ++coarse_[v >> 8];
+      if (v < median_)
+         ++below_;
+   }
+
+   void Remove(unsigned v)
+   {
+      --fine_[v];
+      --coarse_[v >> 8];
+      if (v < median_)
+         --below_;
+   }
+
+   unsigned Median()
+   {
+      // Invariant: below_ counts the values < median_
+      while (below_ > target_)
+      {
+         median_ = PrevOccupied(median_);
+         below_ -= fine_[median_];
+      }
+      while (below_ + fine_[median_] <= target_)
+      {
+         below_ += fine_[median_];
+         median_ = NextOccupied(median_);
+      }
+      return median_;
+   }
+
+private:
+   // Largest value < v in the window (there must be one)
+   unsigned PrevOccupied(unsigned v) const
+   {
+      const unsigned blockStart = v & ~0xffu;
+      while (v > blockStart)
+         if (fine_[--v])
+            return v;
+      unsigned b = v >> 8;
+      do
+         --b;
+      while (coarse_[b] == 0);
+      v = b * 256 + 255;
+      while (fine_[v] == 0)
+         --v;
+      return v;
+   }
+
+   // Smallest value > v in the window (there must be one)
+   unsigned NextOccupied(unsigned v) const
+   {
+      const unsigned blockEnd = v | 0xffu;
+      while (v < blockEnd)
+         if (fine_[++v])
+            return v;
+      unsigned b = v >> 8;
+      do
+         ++b;
+      while (coarse_[b] == 0);
+      v = b * 256;
+      while (fine_[v] == 0)
+         ++v;
+      return v;
+   }
+
+   std::vector<uint16_t> fine_;
+   std::vector<uint16_t> coarse_;
+   const unsigned target_;
+   unsigned median_;
+   unsigned below_;
+};
+
+void MedianRows16(const uint16_t* src, uint16_t* dst, unsigned width,
+   unsigned height, unsigned radius, unsigned y0, unsigned y1)
+{
+   const long long r = radius;
+   SlidingHistogram16 hist((2 * radius + 1) * (2 * radius + 1) / 2);
+   auto at = [&](long long x, long long y) {
+      return src[Clamp(y, height) * width + Clamp(x, width)];
+   };
+
+   for (long long dy = -r; dy <= r; ++dy)
+      for (long long dx = -r; dx <= r; ++dx)
+         hist.Add(at(dx, y0 + dy));
+
+   long long x = 0;
+   for (long long y = y0; y < (long long)y1; ++y)
+   {
+      if (y > y0)
+      {
+         for (long long dx = -r; dx <= r; ++dx)
+         {
+            hist.Remove(at(x + dx, y - r - 1));
+            hist.Add(at(x + dx, y + r));
+         }
+      }
+
+      const long long step = ((y - y0) % 2 == 0) ? 1 : -1;
+      uint16_t* out = dst + (std::size_t)y * width;
+      for (unsigned i = 0; ; ++i)
+      {
+         out[x] = (uint16_t)hist.Median();
+         if (i + 1 == width)
+            break;
+         const long long leavingX = x - step * r;
+         const long long enteringX = x + step * (r + 1);
+         for (long long dy = -r; dy <= r; ++dy)
+         {
+            hist.Remove(at(leavingX, y + dy));
+            hist.Add(at(enteringX, y + dy));
+         }
+         x += step;
+      }
+   }
+}
+
+// Median, wider pixels: partial sort of each window
+template <typename T>
+void MedianRowsGeneric(const T* src, T* dst, unsigned width,
+   unsigned height, unsigned radius, unsigned y0, unsigned y1)
+{
+   const long long r = radius;
+   std::vector<T> window((2 * radius + 1) * (2 * radius + 1));
+   const auto middle = window.begin() + window.size() / 2;
+   for (long long y = y0; y < (long long)y1; ++y)
+   {
+      for (long long x = 0; x < (long long)width; ++x)
+      {
+         auto it = window.begin();
+         for (long long dy = -r; dy <= r; ++dy)
+         {
+            const T* row = src + Clamp(y + dy, height) * width;
+            for (long long dx = -r; dx <= r; ++dx)
+               *it++ = row[Clamp(x + dx, width)];
+         }
+         std::nth_element(window.begin(), middle, window.end());
+         dst[(std::size_t)y * width + x] = *middle;
+      }
+   }
+}
+
+//
+// Box: running sums along each row, then running sums of those down the
+// columns.
+//
+
+template <typename T, typename Sum>
+void BoxRowSums(const T* row, Sum* sums, unsigned width, long long r)
+{
+   Sum s = 0;
+   for (long long dx = -r; dx <= r; ++dx)
+      s += row[Clamp(dx, width)];
+   sums[0] = s;
+   for (long long x = 1; x < (long long)width; ++x)
+   {
+      s += (Sum)row[Clamp(x + r, width)] - (Sum)row[Clamp(x - r - 1, width)];
+      sums[x] = s;
+   }
+}
+
+template <typename T, typename Sum>
+void BoxRows(const T* src, T* dst, unsigned width, unsigned height,
+   unsigned radius, unsigned y0, unsigned y1)
+{
+   const long long r = radius;
+   const Sum n = (Sum)(2 * radius + 1) * (2 * radius + 1);
+   std::vector<Sum> window(width);
+   std::vector<Sum> entering(width);
+   std::vector<Sum> leaving(width, 0);
+   for (long long dy = -r; dy <= r; ++dy)
+   {
+      BoxRowSums(src + Clamp(y0 + dy, height) * width, entering.data(),
+         width, r);
+      AddSubRow(window.data(), entering.data(), leaving.data(), width);
+   }
+
+   for (long long y = y0; y < (long long)y1; ++y)
+   {
+      if (y > y0)
+      {
+         const std::size_t in = Clamp(y + r, height);
+         const std::size_t out = Clamp(y - r - 1, height);
+         if (in != out)
+         {
+            BoxRowSums(src + in * width, entering.data(), width, r);
+            BoxRowSums(src + out * width, leaving.data(), width, r);
+            AddSubRow(window.data(), entering.data(), leaving.data(), width);
+         }
+      }
+      T* row = dst + (std::size_t)y * width;
+      for (std::size_t x = 0; x < width; ++x)
+         row[x] = (T)((window[x] + n / 2) / n);
+   }
+}
+
+//
+// Gaussian: a horizontal pass into a ring of 2r+1 filtered rows, then a
+// vertical pass over the ring.
+//
+
+template <typename Real>
+std::vector<Real> GaussianWeights(double sigma)
+{
+   const long long r = GaussianRadius(sigma);
+   std::vector<double> w((std::size_t)(2 * r + 1));
+   double total = 0.0;
+   for (long long i = -r; i <= r; ++i)
+   {
+      w[(std::size_t)(i + r)] = std::exp(-0.5 * (i * i) / (sigma * sigma));
+      total += w[(std::size_t)(i + r)];
+   }
+   std::vector<Real> weights(w.size());
+   for (std::size_t i = 0; i < w.size(); ++i)
+      weights[i] = (Real)(w[i] / total);
+   return weights;
+}
+
+template <typename T, typename Real>
+void GaussianRows(const T* src, T* dst, unsigned width, unsigned height,
+   const std::vector<Real>& weights, unsigned y0, unsigned y1)
+{
+   const long long r = (long long)(weights.size() - 1) / 2;
+   const std::size_t ringRows = weights.size();
+   std::vector<Real> padded(width + 2 * (std::size_t)r);
+   std::vector<Real> ring(ringRows * width);
+   std::vector<Real> acc(width);
+   const Real maxValue = (Real)(std::numeric_limits<T>::max)();
+
+   // Source row s is filtered into ring row s % ringRows; the rows of any
+   // one window are distinct modulo 2r+1.
+   long long filtered = (std::max)(0LL, (long long)y0 - r) - 1;
+   for (long long y = y0; y < (long long)y1; ++y)
+   {
+      const long long last = (std::min)((long long)height - 1, y + r);
+      for (long long s = (std::max)(filtered + 1, y - r); s <= last; ++s)
+      {
+         const T* row = src + (std::size_t)s * width;
+         for (long long i = 0; i < (long long)padded.size(); ++i)
+            padded[(std::size_t)i] = (Real)row[Clamp(i - r, width)];
+         Real* h = &ring[(std::size_t)(s % ringRows) * width];
+         std::fill(h, h + width, Real(0));
+         for (std::size_t k = 0; k < weights.size(); ++k)
+            Axpy(h, &padded[k], weights[k], width);
+      }
+      filtered = last;
+
+      std::fill(acc.begin(), acc.end(), Real(0));
+      for (long long dy = -r; dy <= r; ++dy)
+      {
+         const std::size_t s = Clamp(y + dy, height);
+         Axpy(acc.data(), &ring[(s % ringRows) * width],
+            weights[(std::size_t)(dy + r)], width);
+      }
+
+      T* out = dst + (std::size_t)y * width;
+      for (std::size_t x = 0; x < width; ++x)
+      {
+         const Real v = acc[x] + Real(0.5);
+         out[x] = v <= 0 ? 0 : (v >= maxValue ? (std::numeric_limits<T>::max)() : (T)v);
+      }
+   }
+}
+
+template <typename T>
+void MedianFilterImpl(T* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands)
+{
+   radius = (std::min)(radius, MaxMedianRadius);
+   if (radius == 0)
+      return;
+   FilterInPlace(pixels, width, height, pool, maxBands,
+      [&](const T* src, T* dst, unsigned y0, unsigned y1) {
+         if (radius == 1)
+            Median3x3Rows(src, dst, width, height, y0, y1);
+         else
+            MedianRowsGeneric(src, dst, width, height, radius, y0, y1);
+      });
+}
+
+template <typename T, typename Sum>
+void BoxFilterImpl(T* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands)
+{
+   if (radius == 0)
+      return;
+   FilterInPlace(pixels, width, height, pool, maxBands,
+      [&](const T* src, T* dst, unsigned y0, unsigned y1) {
+         BoxRows<T, Sum>(src, dst, width, height, radius, y0, y1);
+      });
+}
+
+template <typename T, typename Real>
+void GaussianFilterImpl(T* pixels, unsigned width, unsigned height,
+   double sigma, RowBandPool& pool, unsigned maxBands)
+{
+   if (!(sigma > 0.0))
+      return;
+   const std::vector<Real> weights = GaussianWeights<Real>(sigma);
+   FilterInPlace(pixels, width, height, pool, maxBands,
+      [&](const T* src, T* dst, unsigned y0, unsigned y1) {
+         GaussianRows(src, dst, width, height, weights, y0, y1);
+      });
+}
+
+} // anonymous namespace
+
+unsigned GaussianRadius(double sigma)
+{
+   if (!(sigma > 0.0))
+      return 0;
+   return (std::max)(1u, (unsigned)std::ceil(3.0 * sigma));
+}
+
+void Median(uint8_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands)
+{
+   radius = (std::min)(radius, MaxMedianRadius);
+   if (radius == 0)
+      return;
+   FilterInPlace(pixels, width, height, pool, maxBands,
+      [&](const uint8_t* src, uint8_t* dst, unsigned y0, unsigned y1) {
+         if (radius == 1)
+            Median3x3Rows(src, dst, width, height, y0, y1);
+         else
+            MedianRows8(src, dst, width, height, radius, y0, y1);
+      });
+}
+
+void Median(uint16_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands)
+{
+   radius = (std::min)(radius, MaxMedianRadius);
+   if (radius == 0)
+      return;
+   FilterInPlace(pixels, width, height, pool, maxBands,
+      [&](const uint16_t* src, uint16_t* dst, unsigned y0, unsigned y1) {
+         if (radius == 1)
+            Median3x3Rows(src, dst, width, height, y0, y1);
+         else
+            MedianRows16(src, dst, width, height, radius, y0, y1);
+      });
+}
+
+void Median(uint32_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands)
+{
+   MedianFilterImpl(pixels, width, height, radius, pool, maxBands);
+}
+
+void Median(uint64_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands)
+{
+   MedianFilterImpl(pixels, width, height, radius, pool, maxBands);
+}
+
+// 32-bit sums are exact for 16-bit pixels up to radius 127
+void Box(uint8_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands)
+{
+   BoxFilterImpl<uint8_t, uint32_t>(pixels, width, height, radius, pool, maxBands);
+}
+
+void Box(uint16_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands)
+{
+   BoxFilterImpl<uint16_t, uint32_t>(pixels, width, height, radius, pool, maxBands);
+}
+
+void Box(uint32_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands)
+{
+   BoxFilterImpl<uint32_t, uint64_t>(pixels, width, height, radius, pool, maxBands);
+}
+
+void Box(uint64_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands)
+{
+   // Sums can overflow for pixel values above 2^64 / (2 radius + 1)^2
+   BoxFilterImpl<uint64_t, uint64_t>(pixels, width, height, radius, pool, maxBands);
+}
+
+void Gaussian(uint8_t* pixels, unsigned width, unsigned height,
+   double sigma, RowBandPool& pool, unsigned maxBands)
+{
+   GaussianFilterImpl<uint8_t, float>(pixels, width, height, sigma, pool, maxBands);
+}
+
+void Gaussian(uint16_t* pixels, unsigned width, unsigned height,
+   double sigma, RowBandPool& pool, unsigned maxBands)
+{
+   GaussianFilterImpl<uint16_t, float>(pixels, width, height, sigma, pool, maxBands);
+}
+
+void Gaussian(uint32_t* pixels, unsigned width, unsigned height,
+   double sigma, RowBandPool& pool, unsigned maxBands)
+{
+   GaussianFilterImpl<uint32_t, double>(pixels, width, height, sigma, pool, maxBands);
+}
+
+void Gaussian(uint64_t* pixels, unsigned width, unsigned height,
+   double sigma, RowBandPool& pool, unsigned maxBands)
+{
+   GaussianFilterImpl<uint64_t, double>(pixels, width, height, sigma, pool, maxBands);
+}
+
+} // namespace ImageFilters
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ImageFilters.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Neighborhood filters used by the demo image processors
+//                (MedianFilter, BoxFilter, GaussianFilter).
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include "RowBands.h"
+
+#include <stdint.h>
+
+// All filters work in place on a width x height image of single-component
+// unsigned pixels, treat pixels outside the image as copies of the nearest
+// edge pixel, and are safe to call concurrently on different images.
+//
+// The image is split into horizontal bands that are filtered on the threads
+// of the given pool; maxBands = 0 picks the band count from the image size
+// and the number of cores. Scratch memory is allocated per call (std::bad_alloc is
+// thrown if that fails).
+namespace ImageFilters {
+
+// Largest radius supported by Median() (window counts must fit 16 bits)
+const unsigned MaxMedianRadius = 127;
+
+// Replaces each pixel by the median of its (2 radius + 1)^2 neighborhood.
+// Radius 1 uses a min/max network. Larger radii use, for 8-bit images, the
+// constant-time algorithm of Perreault and Hebert (2007); for 16-bit images
+// a sliding histogram that costs O(radius) per pixel; for wider pixels a
+// per-pixel partial sort.
+void Median(uint8_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands = 0);
+void Median(uint16_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands = 0);
+void Median(uint32_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands = 0);
+void Median(uint64_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands = 0);
+
+// Replaces each pixel by the rounded mean of its (2 radius + 1)^2
+// neighborhood, using running sums (constant time per pixel).
+void Box(uint8_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands = 0);
+void Box(uint16_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands = 0);
+void Box(uint32_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands = 0);
+void Box(uint64_t* pixels, unsigned width, unsigned height,
+   unsigned radius, RowBandPool& pool, unsigned maxBands = 0);
+
+// Separable Gaussian blur; the kernel is truncated at 3 sigma.
+void Gaussian(uint8_t* pixels, unsigned width, unsigned height,
+   double sigma, RowBandPool& pool, unsigned maxBands = 0);
+void Gaussian(uint16_t* pixels, unsigned width, unsigned height,
+   double sigma, RowBandPool& pool, unsigned maxBands = 0);
+void Gaussian(uint32_t* pixels, unsigned width, unsigned height,
+   double sigma, RowBandPool& pool, unsigned maxBands = 0);
+void Gaussian(uint64_t* pixels, unsigned width, unsigned height,
+   double sigma, RowBandPool& pool, unsigned maxBands = 0);
+
+// Radius of the kernel used by Gaussian() for the given sigma
+unsigned GaussianRadius(double sigma);
+
+} // namespace ImageFilters
@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          NoiseGenerator.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Fast Gaussian noise images for the demo camera's
+//                "Fast Noise" mode.
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "NoiseGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace {
+
+const std::size_t QuantileCount = 1 << 16;
+const uint64_t Golden = 0x9e3779b97f4a7c15ULL;
+
+// SplitMix64 output function; Mix(stream + k * Golden) for k = 1, 2, ... is
+// the SplitMix64 sequence, here indexed directly by k.
+inline uint64_t Mix(uint64_t z)
+{
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+   return z ^ (z >> 31);
+}
+
+// Standard normal quantiles at probabilities (i + 0.5) / 65536
+const std::vector<double>& NormalQuantiles()
+{
+   static const std::vector<double> quantiles = [] {
+      const double sqrt2 = std::sqrt(2.0);
+      const double invSqrt2Pi = 1.0 / std::sqrt(2.0 * 3.14159265358979323846);
+      std::vector<double> q(QuantileCount);
+      // Newton's method on the upper half, starting each quantile from the
+      // previous one. The CDF is concave there, so the iteration approaches
+      // the root from below without overshooting.
+      double x = 0.0;
+      for (std::size_t i = QuantileCount / 2; i < QuantileCount; ++i)
+      {
+         const double p = (i + 0.5) / QuantileCount;
+         for (int iteration = 0; iteration < 100; ++iteration)
+         {
+            const double cdf = 0.5 * std::erfc(-x / sqrt2);
+            const double step = (cdf - p) / (invSqrt2Pi * std::exp(-0.5 * x * x));
+            x -= step;
+            if (std::fabs(step) < 1e-12)
+               break;
+         }
+         q[i] = x;
+         q[QuantileCount - 1 - i] = -x;
+      }
+      return q;
+   }();
+   return quantiles;
+}
+
+template <typename T>
+inline T Sample(const T* lut, uint64_t stream, std::size_t i)
+{
+   const uint64_t bits = Mix(stream + (i / 4 + 1) * Golden);
+   return lut[(bits >> (16 * (i % 4))) & 0xffff];
+}
+
+template <typename T>
+void FillNoise(T* pixels, unsigned width, unsigned height, double mean,
+   double stdDev, unsigned maxValue, RowBandPool& pool, unsigned maxBands,
+   uint64_t stream)
+{
+   const std::vector<double>& quantiles = NormalQuantiles();
+   const double top = (std::min)((double)maxValue,
+      (double)(std::numeric_limits<T>::max)());
+   std::vector<T> lut(QuantileCount);
+   for (std::size_t k = 0; k < QuantileCount; ++k)
+   {
+      const double v = std::floor(mean + stdDev * quantiles[k] + 0.5);
+      lut[k] = (T)(v < 0.0 ? 0.0 : (v > top ? top : v));
+   }
+
+   // Pixel i takes 16 bits of random block i / 4
+   pool.ForEachRowBand(width, height, maxBands, [&](unsigned y0, unsigned y1) {
+      const T* table = lut.data();
+      std::size_t i = (std::size_t)y0 * width;
+      const std::size_t end = (std::size_t)y1 * width;
+      for (; i < end && i % 4 != 0; ++i)
+         pixels[i] = Sample(table, stream, i);
+      for (; i + 4 <= end; i += 4)
+      {
+         const uint64_t bits = Mix(stream + (i / 4 + 1) * Golden);
+         pixels[i] = table[bits & 0xffff];
+         pixels[i + 1] = table[(bits >> 16) & 0xffff];
+         pixels[i + 2] = table[(bits >> 32) & 0xffff];
+         pixels[i + 3] = table[bits >> 48];
+      }
+      for (; i < end; ++i)
+         pixels[i] = Sample(table, stream, i);
+   });
+}
+
+} // anonymous namespace
+
+NoiseGenerator::NoiseGenerator(uint64_t seed) :
+   seed_(seed),
+   nextFrame_(0)
+{
+}
+
+void NoiseGenerator::Fill(uint8_t* pixels, unsigned width, unsigned height,
+   double mean, double stdDev, unsigned maxValue, unsigned maxBands)
+{
+   const uint64_t stream = Mix(seed_ + (nextFrame_++ + 1) * Golden);
+   FillNoise(pixels, width, height, mean, stdDev, maxValue, rowBands_,
+      maxBands, stream);
+}
+
+void NoiseGenerator::Fill(uint16_t* pixels, unsigned width, unsigned height,
+   double mean, double stdDev, unsigned maxValue, unsigned maxBands)
+{
+   const uint64_t stream = Mix(seed_ + (nextFrame_++ + 1) * Golden);
+   FillNoise(pixels, width, height, mean, stdDev, maxValue, rowBands_,
+      maxBands, stream);
+}
@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ImageFilters-Tests.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Compares the demo image filters against direct
+//                implementations
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include <gtest/gtest.h>
+
+#include "ImageFilters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+const unsigned width = 53;
+const unsigned height = 37;
+
+template <typename T>
+std::vector<T> RandomImage(unsigned maxValue, unsigned seed)
+{
+   std::mt19937 rng(seed);
+   std::uniform_int_distribution<unsigned> dist(0, maxValue);
+   std::vector<T> image(width * height);
+   for (T& p : image)
+      p = (T)dist(rng);
+   return image;
+}
+
+template <typename T>
+T Pixel(const std::vector<T>& image, int x, int y)
+{
+   x = (std::min)((std::max)(x, 0), (int)width - 1);
+   y = (std::min)((std::max)(y, 0), (int)height - 1);
+   return image[y * width + x];
+}
+
+template <typename T>
+std::vector<T> ReferenceMedian(const std::vector<T>& image, int r)
+{
+   std::vector<T> out(image.size());
+   for (int y = 0; y < (int)height; ++y)
+      for (int x = 0; x < (int)width; ++x)
+      {
+         std::vector<T> window;
+         for (int dy = -r; dy <= r; ++dy)
+            for (int dx = -r; dx <= r; ++dx)
+               window.push_back(Pixel(image, x + dx, y + dy));
+         std::sort(window.begin(), window.end());
+         out[y * width + x] = window[window.size() / 2];
+      }
+   return out;
+}
+
+template <typename T>
+std::vector<T> ReferenceBox(const std::vector<T>& image, int r)
+{
+   const unsigned long long n = (2 * r + 1) * (2 * r + 1);
+   std::vector<T> out(image.size());
+   for (int y = 0; y < (int)height; ++y)
+      for (int x = 0; x < (int)width; ++x)
+      {
+         unsigned long long sum = 0;
+         for (int dy = -r; dy <= r; ++dy)
+            for (int dx = -r; dx <= r; ++dx)
+               sum += Pixel(image, x + dx, y + dy);
+         out[y * width + x] = (T)((sum + n / 2) / n);
+      }
+   return out;
+}
+
+template <typename T>
+std::vector<T> ReferenceGaussian(const std::vector<T>& image, double sigma)
+{
+   const int r = (int)ImageFilters::GaussianRadius(sigma);
+   std::vector<double> w;
+   double total = 0.0;
+   for (int i = -r; i <= r; ++i)
+   {
+      w.push_back(std::exp(-0.5 * i * i / (sigma * sigma)));
+      total += w.back();
+   }
+   std::vector<T> out(image.size());
+   for (int y = 0; y < (int)height; ++y)
+      for (int x = 0; x < (int)width; ++x)
+      {
+         double sum = 0.0;
+         for (int dy = -r; dy <= r; ++dy)
+            for (int dx = -r; dx <= r; ++dx)
+               sum += w[dy + r] * w[dx + r] * Pixel(image, x + dx, y + dy);
+         out[y * width + x] = (T)(sum / (total * total) + 0.5);
+      }
+   return out;
+}
+
+} // anonymous namespace
+
+TEST(ImageFiltersTest, Median8BitMatchesReference)
+{
+   RowBandPool pool;
+   for (unsigned radius : {1u, 2u, 6u})
+   {
+      for (unsigned bands : {1u, 4u})
+      {
+         std::vector<uint8_t> image = RandomImage<uint8_t>(255, radius);
+         const std::vector<uint8_t> expected = ReferenceMedian(image, radius);
+         ImageFilters::Median(image.data(), width, height, radius, pool, bands);
+         EXPECT_EQ(expected, image) << "radius " << radius << ", bands " << bands;
+      }
+   }
+}
+
+TEST(ImageFiltersTest, Median16BitMatchesReference)
+{
+   RowBandPool pool;
+   for (unsigned radius : {1u, 3u})
+   {
+      for (unsigned bands : {1u, 5u})
+      {
+         // Sparse values, so that the median moves across empty bins
+         std::vector<uint16_t> image = RandomImage<uint16_t>(65535, radius);
+         const std::vector<uint16_t> expected = ReferenceMedian(image, radius);
+         ImageFilters::Median(image.data(), width, height, radius, pool, bands);
+         EXPECT_EQ(expected, image) << "radius " << radius << ", bands " << bands;
+      }
+   }
+
+   std::vector<uint16_t> image = RandomImage<uint16_t>(4095, 7);
+   const std::vector<uint16_t> expected = ReferenceMedian(image, 2);
+   ImageFilters::Median(image.data(), width, height, 2, pool);
+   EXPECT_EQ(expected, image);
+}
+
+TEST(ImageFiltersTest, Median32BitMatchesReference)
+{
+   RowBandPool pool;
+   std::vector<uint32_t> image = RandomImage<uint32_t>(1000000, 3);
+   const std::vector<uint32_t> expected = ReferenceMedian(image, 2);
+   ImageFilters::Median(image.data(), width, height, 2, pool, 3);
+   EXPECT_EQ(expected, image);
+}
+
+TEST(ImageFiltersTest, BoxMatchesReference)
+{
+   RowBandPool pool;
+   for (unsigned radius : {1u, 4u})
+   {
+      std::vector<uint8_t> image8 = RandomImage<uint8_t>(255, radius);
+      const std::vector<uint8_t> expected8 = ReferenceBox(image8, radius);
+      ImageFilters::Box(image8.data(), width, height, radius, pool, 3);
+      EXPECT_EQ(expected8, image8) << "radius " << radius;
+
+      std::vector<uint16_t> image16 = RandomImage<uint16_t>(65535, radius);
+      const std::vector<uint16_t> expected16 = ReferenceBox(image16, radius);
+      ImageFilters::Box(image16.data(), width, height, radius, pool, 2);
+      EXPECT_EQ(expected16, image16) << "radius " << radius;
+   }
+}
+
+TEST(ImageFiltersTest, GaussianMatchesReference)
+{
+   RowBandPool pool;
+   for (double sigma : {0.8, 2.5})
+   {
+      std::vector<uint16_t> image = RandomImage<uint16_t>(4095, 11);
+      const std::vector<uint16_t> expected = ReferenceGaussian(image, sigma);
+      ImageFilters::Gaussian(image.data(), width, height, sigma, pool, 4);
+      for (std::size_t i = 0; i < image.size(); ++i)
+         ASSERT_LE(std::abs((int)image[i] - (int)expected[i]), 1)
+            << "sigma " << sigma << ", pixel " << i;
+   }
+}
+
+TEST(ImageFiltersTest, FlatImagesAreUnchanged)
+{
+   RowBandPool pool;
+   std::vector<uint8_t> image8(width * height, 255);
+   ImageFilters::Gaussian(image8.data(), width, height, 3.0, pool);
+   ImageFilters::Box(image8.data(), width, height, 5, pool);
+   ImageFilters::Median(image8.data(), width, height, 5, pool);
+   EXPECT_EQ(std::vector<uint8_t>(width * height, 255), image8);
+
+   std::vector<uint16_t> image16(width * height, 40000);
+   ImageFilters::Gaussian(image16.data(), width, height, 3.0, pool);
+   ImageFilters::Box(image16.data(), width, height, 5, pool);
+   ImageFilters::Median(image16.data(), width, height, 5, pool);
+   EXPECT_EQ(std::vector<uint16_t>(width * height, 40000), image16);
+}
+
+TEST(ImageFiltersTest, ZeroRadiusIsIdentity)
+{
+   RowBandPool pool;
+   const std::vector<uint8_t> original = RandomImage<uint8_t>(255, 5);
+   std::vector<uint8_t> image = original;
+   ImageFilters::Median(image.data(), width, height, 0, pool);
+   ImageFilters::Box(image.data(), width, height, 0, pool);
+   ImageFilters::Gaussian(image.data(), width, height, 0.0, pool);
+   EXPECT_EQ(original, image);
+}
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
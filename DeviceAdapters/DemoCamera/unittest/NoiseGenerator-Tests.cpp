@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          NoiseGenerator-Tests.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Statistics and reproducibility of the demo camera's fast
+//                noise generator
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include <gtest/gtest.h>
+
+#include "NoiseGenerator.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const unsigned width = 509; // Rows not a multiple of 4 pixels
+const unsigned height = 301;
+
+template <typename T>
+void MeanAndStdDev(const std::vector<T>& image, double& mean, double& stdDev)
+{
+   double sum = 0.0;
+   double sumSq = 0.0;
+   for (T p : image)
+   {
+      sum += p;
+      sumSq += (double)p * p;
+   }
+   mean = sum / image.size();
+   stdDev = std::sqrt(sumSq / image.size() - mean * mean);
+}
+
+} // anonymous namespace
+
+TEST(NoiseGeneratorTest, HasRequestedMeanAndStdDev)
+{
+   NoiseGenerator generator;
+   std::vector<uint16_t> image(width * height);
+   generator.Fill(image.data(), width, height, 1000.0, 25.0, 65535);
+   double mean, stdDev;
+   MeanAndStdDev(image, mean, stdDev);
+   EXPECT_NEAR(1000.0, mean, 0.5);
+   EXPECT_NEAR(25.0, stdDev, 0.5);
+
+   // Shape: about 68% within one standard deviation (integer pixel values
+   // round the limits out by half a unit)
+   unsigned within = 0;
+   for (uint16_t p : image)
+      if (std::fabs(p - 1000.0) <= 25.0)
+         ++within;
+   const double expected = std::erf(25.5 / 25.0 / std::sqrt(2.0));
+   EXPECT_NEAR(expected, (double)within / image.size(), 0.005);
+}
+
+TEST(NoiseGeneratorTest, ClampsToRange)
+{
+   NoiseGenerator generator;
+   std::vector<uint8_t> image(width * height);
+   generator.Fill(image.data(), width, height, 5.0, 20.0, 15);
+   unsigned zeros = 0;
+   for (uint8_t p : image)
+   {
+      ASSERT_LE(p, 15);
+      if (p == 0)
+         ++zeros;
+   }
+   EXPECT_GT(zeros, 0u);
+}
+
+TEST(NoiseGeneratorTest, OutputDoesNotDependOnThreading)
+{
+   NoiseGenerator a(42);
+   NoiseGenerator b(42);
+   std::vector<uint16_t> imageA(width * height);
+   std::vector<uint16_t> imageB(width * height);
+   a.Fill(imageA.data(), width, height, 100.0, 10.0, 4095, 1);
+   b.Fill(imageB.data(), width, height, 100.0, 10.0, 4095, 7);
+   EXPECT_EQ(imageA, imageB);
+}
+
+TEST(NoiseGeneratorTest, FramesAreIndependent)
+{
+   NoiseGenerator generator;
+   std::vector<uint16_t> first(width * height);
+   std::vector<uint16_t> second(width * height);
+   generator.Fill(first.data(), width, height, 1000.0, 25.0, 65535);
+   generator.Fill(second.data(), width, height, 1000.0, 25.0, 65535);
+
+   double covariance = 0.0;
+   for (std::size_t i = 0; i < first.size(); ++i)
+      covariance += (first[i] - 1000.0) * (second[i] - 1000.0);
+   const double correlation = covariance / first.size() / (25.0 * 25.0);
+   EXPECT_NEAR(0.0, correlation, 0.02);
+}
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
@@ -23,6 +23,8 @@
 
 #include "FakeCamera.h"
 
+#include <cctype>
+
 const char* cameraName = "FakeCamera";
 
 const char* label_CV_8U = "8bit";
@@ -30,6 +32,21 @@ const char* label_CV_16U = "16bit";
 const char* label_CV_8UC4 = "32bitRGB";
 const char* label_CV_16UC4 = "64bitRGB";
 
+const char* g_Prop_CacheSize = "Frame cache (MB)";
+const char* g_Prop_Prefetch = "Prefetch frames";
+const char* g_Prop_RawWidth = "Raw stack width";
+const char* g_Prop_RawHeight = "Raw stack height";
+const char* g_Prop_RawBytes = "Raw stack bytes per pixel";
+const char* g_Prop_RawHeader = "Raw stack header bytes";
+
+enum
+{
+	RAW_WIDTH,
+	RAW_HEIGHT,
+	RAW_BYTES,
+	RAW_HEADER
+};
+
 FakeCamera::FakeCamera() :
 	initialized_(false),
 	path_(""),
@@ -40,8 +57,15 @@ FakeCamera::FakeCamera() :
 	byteCount_(1),
 	type_(CV_8UC1),
 	emptyImg(1, 1, type_),
+	cacheSizeMB_(256),
+	prefetchCount_(4),
+	rawWidth_(512),
+	rawHeight_(512),
+	rawByteCount_(2),
+	rawHeaderBytes_(0),
 	exposure_(10)
 {
+	cache_.SetCapacity((size_t)cacheSizeMB_ << 20);
 	resetCurImg();
 
 	CreateProperty("Path mask", "", MM::String, false, new CPropertyAction(this, &FakeCamera::OnPath));
@@ -49,6 +73,26 @@ FakeCamera::FakeCamera() :
 
 	CreateProperty("FrameCount", "0", MM::Integer, false, new CPropertyAction(this, &FakeCamera::OnFrameCount));
 
+	// Decoded frames are kept, and the next ones predicted from the change
+	// in resolved path are loaded in the background
+	CreateProperty(g_Prop_CacheSize, CDeviceUtils::ConvertToString(cacheSizeMB_), MM::Integer, false, new CPropertyAction(this, &FakeCamera::OnCacheSize));
+	SetPropertyLimits(g_Prop_CacheSize, 0, 16384);
+
+	CreateProperty(g_Prop_Prefetch, CDeviceUtils::ConvertToString(prefetchCount_), MM::Integer, false, new CPropertyAction(this, &FakeCamera::OnPrefetch));
+	SetPropertyLimits(g_Prop_Prefetch, 0, 64);
+
+	// Layout of headerless .raw stacks, which are memory-mapped
+	CreateProperty(g_Prop_RawWidth, CDeviceUtils::ConvertToString((long)rawWidth_), MM::Integer, false, new CPropertyActionEx(this, &FakeCamera::OnRawFormat, RAW_WIDTH));
+	CreateProperty(g_Prop_RawHeight, CDeviceUtils::ConvertToString((long)rawHeight_), MM::Integer, false, new CPropertyActionEx(this, &FakeCamera::OnRawFormat, RAW_HEIGHT));
+	CreateProperty(g_Prop_RawBytes, CDeviceUtils::ConvertToString((long)rawByteCount_), MM::Integer, false, new CPropertyActionEx(this, &FakeCamera::OnRawFormat, RAW_BYTES));
+	CreateProperty(g_Prop_RawHeader, CDeviceUtils::ConvertToString((long)rawHeaderBytes_), MM::Integer, false, new CPropertyActionEx(this, &FakeCamera::OnRawFormat, RAW_HEADER));
+
+	std::vector<std::string> rawBytesValues;
+	rawBytesValues.push_back("1");
+	rawBytesValues.push_back("2");
+
+	SetAllowedValues(g_Prop_RawBytes, rawBytesValues);
+
 	CreateProperty(MM::g_Keyword_Name, cameraName, MM::String, true);
 
 	// Description
@@ -102,6 +146,7 @@ int FakeCamera::Initialize()
 
 int FakeCamera::Shutdown()
 {
+	cache_.Stop();
 	initialized_ = false;
 
 	return DEVICE_OK;
@@ -312,11 +357,6 @@ int FakeCamera::ResolvePath(MM::PropertyBase * pProp, MM::ActionType eAct)
 	return DEVICE_OK;
 }
 
-double scaleFac(int bef, int aft)
-{
-	return (double)(1 << (8 * aft)) / (1 << (8 * bef));
-}
-
 int FakeCamera::OnPixelType(MM::PropertyBase * pProp, MM::ActionType eAct)
 {
 	if (eAct == MM::BeforeGet)
@@ -397,6 +437,62 @@ int FakeCamera::OnFrameCount(MM::PropertyBase * pProp, MM::ActionType eAct)
 	return DEVICE_OK;
 }
 
+int FakeCamera::OnCacheSize(MM::PropertyBase * pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(cacheSizeMB_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		pProp->Get(cacheSizeMB_);
+		cache_.SetCapacity((size_t)cacheSizeMB_ << 20);
+	}
+
+	return DEVICE_OK;
+}
+
+int FakeCamera::OnPrefetch(MM::PropertyBase * pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(prefetchCount_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		pProp->Get(prefetchCount_);
+		if (prefetchCount_ == 0)
+			cache_.Prefetch(std::vector<std::string>());
+	}
+
+	return DEVICE_OK;
+}
+
+int FakeCamera::OnRawFormat(MM::PropertyBase * pProp, MM::ActionType eAct, long field)
+{
+	unsigned* value = field == RAW_WIDTH ? &rawWidth_ :
+		field == RAW_HEIGHT ? &rawHeight_ :
+		field == RAW_BYTES ? &rawByteCount_ : &rawHeaderBytes_;
+
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long)*value);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (capturing_)
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+
+		long val;
+		pProp->Get(val);
+		*value = val < 0 ? 0 : (unsigned)val;
+
+		resetCurImg();
+	}
+
+	return DEVICE_OK;
+}
+
 std::string FakeCamera::parseUntil(const char*& it, const char delim) const throw (parse_error)
 {
 	std::ostringstream ret;
@@ -642,6 +738,87 @@ std::string FakeCamera::iif(bool test, std::string spec)
 	return test ? spec.substr(sepPos + 1) : spec.substr(0, sepPos + 1);
 }
 
+// Extrapolates the last number that differs between two resolved paths,
+// e.g. "z-1.50.tif", "z-2.00.tif" -> "z-2.50.tif", "z-3.00.tif", ...
+// This covers focus steps, frame counters and "#index" into stacks alike.
+std::vector<std::string> FakeCamera::predictPaths(const std::string& prev, const std::string& cur, int count)
+{
+	struct Number
+	{
+		size_t pos;
+		size_t len;
+		int intLen;
+		int prec;
+		double val;
+	};
+
+	struct Split
+	{
+		std::string text;
+		std::vector<Number> nums;
+
+		Split(const std::string& s)
+		{
+			for (size_t i = 0; i < s.size();)
+			{
+				if (!isdigit((unsigned char)s[i]))
+				{
+					text += s[i++];
+					continue;
+				}
+
+				Number n;
+				n.pos = i;
+				while (i < s.size() && isdigit((unsigned char)s[i]))
+					++i;
+				n.intLen = (int)(i - n.pos);
+				n.prec = 0;
+				if (i + 1 < s.size() && s[i] == '.' && isdigit((unsigned char)s[i + 1]))
+				{
+					size_t dot = i++;
+					while (i < s.size() && isdigit((unsigned char)s[i]))
+						++i;
+					n.prec = (int)(i - dot - 1);
+				}
+				n.len = i - n.pos;
+				n.val = atof(s.substr(n.pos, n.len).c_str());
+				nums.push_back(n);
+				text += '\0';
+			}
+		}
+	};
+
+	std::vector<std::string> paths;
+
+	Split a(prev), b(cur);
+	if (a.text != b.text || a.nums.size() != b.nums.size())
+		return paths;
+
+	int changed = -1;
+	for (size_t i = 0; i < b.nums.size(); ++i)
+		if (a.nums[i].val != b.nums[i].val)
+			changed = (int)i;
+
+	if (changed < 0)
+		return paths;
+
+	const Number& n = b.nums[changed];
+	double step = n.val - a.nums[changed].val;
+
+	for (int k = 1; k <= count; ++k)
+	{
+		double val = n.val + k * step;
+		if (val < 0)
+			break;
+
+		std::ostringstream num;
+		printNum(num, std::pair<int, int>(n.intLen, n.prec), val);
+		paths.push_back(cur.substr(0, n.pos) + num.str() + cur.substr(n.pos + n.len));
+	}
+
+	return paths;
+}
+
 std::string FakeCamera::parseMask(std::string mask) const throw(error_code)
 {
 	const char* it = mask.data();
@@ -655,7 +832,7 @@ void FakeCamera::getImg() const
 	if (path == curPath_)
 		return;
 
-	cv::Mat img = path == lastFailedPath_ ? lastFailedImg_ : cv::imread(path, cv::IMREAD_ANYDEPTH | (color_ ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE));
+	cv::Mat img = cache_.Get(path);
 
 	if (img.data == NULL)
 	{
@@ -667,42 +844,23 @@ void FakeCamera::getImg() const
 		}
 		else
 		{
-			throw error_code(CONTROLLER_ERROR, "Could not find image '" + path + "'. Please specify a valid path mask (format: ?? for focus stage, ?[name] for any stage, and ?{prec}[name]/?{prec}? for precision other than 0)");
+			throw error_code(CONTROLLER_ERROR, "Could not find image '" + path + "'. Please specify a valid path mask (format: ?? for focus stage, ?[name] for any stage, and ?{prec}[name]/?{prec}? for precision other than 0; #index selects a frame of a multi-page TIFF or .raw stack)");
 		}
 	}
 
-	img.convertTo(img, type_, scaleFac((int)img.elemSize() / img.channels(), byteCount_));
+	if (prefetchCount_ > 0)
+		cache_.Prefetch(predictPaths(curPath_, path, prefetchCount_));
 
 	bool dimChanged = (unsigned)img.cols != width_ || (unsigned)img.rows != height_;
 
 	if (dimChanged)
 	{
 		if (capturing_)
-		{
-			lastFailedPath_ = path;
-			lastFailedImg_ = img;
 			throw error_code(DEVICE_CAMERA_BUSY_ACQUIRING);
-		}
 	}
 
-	if (color_)
-	{
-		if (alphaChannel_.rows != img.rows || alphaChannel_.cols != img.cols || alphaChannel_.depth() != img.depth())
-		{
-			alphaChannel_ = cv::Mat(img.rows, img.cols, byteCount_ == 2 ? CV_16U : CV_8U);
-			alphaChannel_ = 1 << (8 * byteCount_);
-		}
-
-		if (dimChanged)
-			curImg_ = cv::Mat(img.rows, img.cols, type_);
-
-		int fromTo[] = { 0,0 , 1,1 , 2,2 , 3,3 };
-		cv::Mat from[] = { img, alphaChannel_ };
-
-		cv::mixChannels(from, 2, &curImg_, 1, fromTo, 4);
-	}
-	else
-		curImg_ = img;
+	// Shared with the cache, which never modifies a frame once stored
+	curImg_ = img;
 
 	curPath_ = path;
 
@@ -747,6 +905,19 @@ void FakeCamera::initSize(bool loadImg) const
 	}
 }
 
+FrameFormat FakeCamera::frameFormat() const
+{
+	FrameFormat format;
+	format.color = color_;
+	format.type = type_;
+	format.byteCount = byteCount_;
+	format.rawWidth = rawWidth_;
+	format.rawHeight = rawHeight_;
+	format.rawByteCount = rawByteCount_;
+	format.rawHeaderBytes = rawHeaderBytes_;
+	return format;
+}
+
 void FakeCamera::resetCurImg()
 {
 	initSize_ = false;
@@ -756,6 +927,9 @@ void FakeCamera::resetCurImg()
 	roiHeight_ = height_ = 1;
 	frameCount_ = 0;
 
+	// Frames are only dropped if they would be decoded differently now
+	cache_.SetFormat(frameFormat());
+
 	ClearROI();
 	updateROI();
 }
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "DeviceBase.h"
 
@@ -40,6 +41,7 @@
 #define CONTROLLER_ERROR 10002
 
 #include "error_code.h"
+#include "FrameCache.h"
 
 extern const char* cameraName;
 extern const char* label_CV_8U;
@@ -86,12 +88,16 @@ public:
 	int ResolvePath(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnPixelType(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnFrameCount(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCacheSize(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnPrefetch(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnRawFormat(MM::PropertyBase* pProp, MM::ActionType eAct, long field);
 
 	std::string parseUntil(const char*& it, const char delim) const throw (parse_error);
 	std::string parsePlaceholder(const char*& it) const;
 	std::pair<int, int> parsePrecision(const char*& it) const throw (parse_error);
 	static std::ostream& printNum(std::ostream& o, std::pair<int, int> precSpec, double num);
 	static std::string iif(bool test, std::string spec);
+	static std::vector<std::string> predictPaths(const std::string& prev, const std::string& cur, int count);
 	std::string parseMask(std::string mask) const throw(error_code);
 	void getImg() const;
 	void updateROI() const;
@@ -120,12 +126,18 @@ private:
 	cv::Mat emptyImg;
 
 	mutable cv::Mat curImg_;
-	mutable cv::Mat alphaChannel_;
-	mutable cv::Mat lastFailedImg_;
 	mutable cv::Mat roi_;
 	mutable std::string curPath_;
-	mutable std::string lastFailedPath_;
 
+	long cacheSizeMB_;
+	long prefetchCount_;
+	unsigned rawWidth_;
+	unsigned rawHeight_;
+	unsigned rawByteCount_;
+	unsigned rawHeaderBytes_;
+	mutable FrameCache cache_;
+
+	FrameFormat frameFormat() const;
 	void resetCurImg();
 
 	double exposure_;
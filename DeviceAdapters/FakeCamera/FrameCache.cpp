@@ -0,0 +1,428 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameCache.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Bounded cache of decoded frames for FakeCamera, filled on
+//                demand and by a background prefetch thread
+//
+// LICENSE:       Licensed under the Apache License, Version 2.0 (the "License");
+//                you may not use this file except in compliance with the License.
+//                You may obtain a copy of the License at
+//
+//                http://www.apache.org/licenses/LICENSE-2.0
+//
+//                Unless required by applicable law or agreed to in writing, software
+//                distributed under the License is distributed on an "AS IS" BASIS,
+//                WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//                See the License for the specific language governing permissions and
+//                limitations under the License.
+
+#include "FrameCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool FrameFormat::operator==(const FrameFormat& other) const
+{
+	return color == other.color && type == other.type && byteCount == other.byteCount &&
+		rawWidth == other.rawWidth && rawHeight == other.rawHeight &&
+		rawByteCount == other.rawByteCount && rawHeaderBytes == other.rawHeaderBytes;
+}
+
+MappedFile::MappedFile(const std::string& path) :
+	data_(0),
+	size_(0)
+{
+#ifdef _WIN32
+	file_ = INVALID_HANDLE_VALUE;
+	mapping_ = NULL;
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	file_ = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		return;
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+		return;
+	mapping_ = mapping;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL)
+		return;
+
+	data_ = (const unsigned char*)data;
+	size_ = (size_t)size.QuadPart;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void* data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data != MAP_FAILED)
+		{
+			data_ = (const unsigned char*)data;
+			size_ = (size_t)st.st_size;
+		}
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (data_)
+		UnmapViewOfFile(data_);
+	if (mapping_)
+		CloseHandle(mapping_);
+	if (file_ != INVALID_HANDLE_VALUE)
+		CloseHandle(file_);
+#else
+	if (data_)
+		munmap((void*)data_, size_);
+#endif
+}
+
+namespace
+{
+	double scaleFac(int bef, int aft)
+	{
+		return (double)(1 << (8 * aft)) / (1 << (8 * bef));
+	}
+
+	// Splits "file#index"; returns false if there is no index
+	bool splitIndex(const std::string& path, std::string& file, int& index)
+	{
+		size_t pos = path.find_last_of('#');
+		if (pos == std::string::npos || pos + 1 == path.size())
+			return false;
+
+		for (size_t i = pos + 1; i < path.size(); ++i)
+			if (!isdigit((unsigned char)path[i]))
+				return false;
+
+		file = path.substr(0, pos);
+		index = atoi(path.c_str() + pos + 1);
+		return true;
+	}
+
+	bool isRaw(const std::string& file)
+	{
+		if (file.size() < 4)
+			return false;
+
+		std::string ext = file.substr(file.size() - 4);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		return ext == ".raw";
+	}
+}
+
+FrameCache::FrameCache() :
+	generation_(0),
+	capacity_(0),
+	bytes_(0),
+	stop_(false)
+{
+	format_.color = false;
+	format_.type = CV_8UC1;
+	format_.byteCount = 1;
+	format_.rawWidth = 0;
+	format_.rawHeight = 0;
+	format_.rawByteCount = 1;
+	format_.rawHeaderBytes = 0;
+}
+
+FrameCache::~FrameCache()
+{
+	Stop();
+}
+
+void FrameCache::SetCapacity(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	capacity_ = bytes;
+
+	evict();
+}
+
+void FrameCache::SetFormat(const FrameFormat& format)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (format == format_)
+		return;
+
+	format_ = format;
+	clearLocked();
+}
+
+void FrameCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	clearLocked();
+}
+
+void FrameCache::clearLocked()
+{
+	// Loads in progress were started with the old files or format and must
+	// not end up in the cache
+	++generation_;
+	lru_.clear();
+	entries_.clear();
+	mappings_.clear();
+	queue_.clear();
+	bytes_ = 0;
+}
+
+cv::Mat FrameCache::Get(const std::string& path)
+{
+	FrameFormat format;
+	unsigned generation;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		// Don't decode a second time what the prefetcher is working on
+		while (loading_ == path)
+			loadDone_.wait(lock);
+
+		cv::Mat img;
+		if (lookup(path, img))
+			return img;
+
+		format = format_;
+		generation = generation_;
+	}
+
+	std::vector<Frame> frames = load(path, format);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (generation == generation_)
+	{
+		for (size_t i = 0; i < frames.size(); ++i)
+			insert(frames[i]);
+	}
+
+	return frames.empty() ? cv::Mat() : frames.back().second;
+}
+
+void FrameCache::Prefetch(const std::vector<std::string>& paths)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	queue_.clear();
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		if (entries_.find(paths[i]) == entries_.end() && paths[i] != loading_)
+			queue_.push_back(paths[i]);
+	}
+
+	if (queue_.empty())
+		return;
+
+	if (!thread_.joinable())
+		thread_ = std::thread(&FrameCache::run, this);
+
+	prefetchWanted_.notify_one();
+}
+
+void FrameCache::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+		queue_.clear();
+		prefetchWanted_.notify_one();
+	}
+
+	if (thread_.joinable())
+		thread_.join();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	stop_ = false;
+}
+
+bool FrameCache::lookup(const std::string& path, cv::Mat& img)
+{
+	std::unordered_map<std::string, std::list<Frame>::iterator>::iterator it = entries_.find(path);
+	if (it == entries_.end())
+		return false;
+
+	lru_.splice(lru_.begin(), lru_, it->second);
+	img = it->second->second;
+	return true;
+}
+
+void FrameCache::insert(const Frame& frame)
+{
+	std::unordered_map<std::string, std::list<Frame>::iterator>::iterator it = entries_.find(frame.first);
+	if (it != entries_.end())
+	{
+		bytes_ -= it->second->second.total() * it->second->second.elemSize();
+		lru_.erase(it->second);
+		entries_.erase(it);
+	}
+
+	lru_.push_front(frame);
+	entries_[frame.first] = lru_.begin();
+	bytes_ += frame.second.total() * frame.second.elemSize();
+
+	evict();
+}
+
+void FrameCache::evict()
+{
+	while (bytes_ > capacity_ && !lru_.empty())
+	{
+		bytes_ -= lru_.back().second.total() * lru_.back().second.elemSize();
+		entries_.erase(lru_.back().first);
+		lru_.pop_back();
+	}
+}
+
+void FrameCache::run()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	for (;;)
+	{
+		while (!stop_ && queue_.empty())
+			prefetchWanted_.wait(lock);
+
+		if (stop_)
+			return;
+
+		std::string path = queue_.front();
+		queue_.pop_front();
+
+		if (entries_.find(path) != entries_.end())
+			continue;
+
+		loading_ = path;
+		FrameFormat format = format_;
+		unsigned generation = generation_;
+
+		lock.unlock();
+		std::vector<Frame> frames = load(path, format);
+		lock.lock();
+
+		if (generation == generation_)
+		{
+			for (size_t i = 0; i < frames.size(); ++i)
+				insert(frames[i]);
+		}
+
+		loading_.clear();
+		loadDone_.notify_all();
+	}
+}
+
+// The requested frame is the last element, so that it is the most recently
+// used after insertion
+std::vector<FrameCache::Frame> FrameCache::load(const std::string& path, const FrameFormat& format)
+{
+	std::vector<Frame> frames;
+
+	std::string file = path;
+	int index = 0;
+	bool indexed = splitIndex(path, file, index);
+
+	int flags = cv::IMREAD_ANYDEPTH | (format.color ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
+
+	if (isRaw(file))
+	{
+		cv::Mat img = readRaw(file, index, format);
+		if (img.data != NULL)
+			frames.push_back(Frame(path, prepare(img, format)));
+	}
+	else if (indexed)
+	{
+		// OpenCV decodes a multi-page TIFF as a whole, so keep the pages
+		// following the requested one as well
+		std::vector<cv::Mat> pages;
+		if (!cv::imreadmulti(file, pages, flags) || index >= (int)pages.size())
+			return frames;
+
+		for (int i = (int)pages.size() - 1; i >= index; --i)
+		{
+			std::ostringstream key;
+			key << file << '#' << i;
+			frames.push_back(Frame(key.str(), prepare(pages[i], format)));
+		}
+		frames.back().first = path;
+	}
+	else
+	{
+		cv::Mat img = cv::imread(file, flags);
+		if (img.data != NULL)
+			frames.push_back(Frame(path, prepare(img, format)));
+	}
+
+	return frames;
+}
+
+cv::Mat FrameCache::readRaw(const std::string& file, int index, const FrameFormat& format)
+{
+	std::shared_ptr<MappedFile> mapped;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::shared_ptr<MappedFile>& entry = mappings_[file];
+		if (!entry)
+			entry = std::make_shared<MappedFile>(file);
+		mapped = entry;
+	}
+
+	size_t frameBytes = (size_t)format.rawWidth * format.rawHeight * format.rawByteCount;
+	size_t offset = format.rawHeaderBytes + (size_t)index * frameBytes;
+
+	if (frameBytes == 0 || mapped->data() == 0 || offset + frameBytes > mapped->size())
+		return cv::Mat();
+
+	cv::Mat view(format.rawHeight, format.rawWidth, format.rawByteCount == 2 ? CV_16UC1 : CV_8UC1, (void*)(mapped->data() + offset));
+
+	// Copying out of the mapping is where the page faults happen, which is
+	// what the prefetcher takes off the acquisition thread
+	return view.clone();
+}
+
+cv::Mat FrameCache::prepare(cv::Mat img, const FrameFormat& format)
+{
+	if (format.color && img.channels() == 1)
+		cv::cvtColor(img, img, cv::COLOR_GRAY2BGR);
+
+	img.convertTo(img, format.type, scaleFac((int)img.elemSize() / img.channels(), format.byteCount));
+
+	if (!format.color)
+		return img;
+
+	cv::Mat alphaChannel(img.rows, img.cols, format.byteCount == 2 ? CV_16U : CV_8U);
+	alphaChannel = 1 << (8 * format.byteCount);
+
+	cv::Mat rgba(img.rows, img.cols, format.type);
+
+	int fromTo[] = { 0,0 , 1,1 , 2,2 , 3,3 };
+	cv::Mat from[] = { img, alphaChannel };
+
+	cv::mixChannels(from, 2, &rgba, 1, fromTo, 4);
+
+	return rgba;
+}
@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameCache.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Bounded cache of decoded frames for FakeCamera, filled on
+//                demand and by a background prefetch thread
+//
+// LICENSE:       Licensed under the Apache License, Version 2.0 (the "License");
+//                you may not use this file except in compliance with the License.
+//                You may obtain a copy of the License at
+//
+//                http://www.apache.org/licenses/LICENSE-2.0
+//
+//                Unless required by applicable law or agreed to in writing, software
+//                distributed under the License is distributed on an "AS IS" BASIS,
+//                WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//                See the License for the specific language governing permissions and
+//                limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <opencv/cv.hpp>
+#else
+#include "opencv/highgui.h"
+#endif
+
+// How files are turned into frames; frames cached for one format are
+// discarded when it changes
+struct FrameFormat
+{
+	bool color;
+	int type;
+	unsigned byteCount;
+
+	// Geometry of headerless .raw stacks
+	unsigned rawWidth;
+	unsigned rawHeight;
+	unsigned rawByteCount;
+	unsigned rawHeaderBytes;
+
+	bool operator==(const FrameFormat& other) const;
+	bool operator!=(const FrameFormat& other) const { return !(*this == other); }
+};
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	const unsigned char* data() const { return data_; }
+	size_t size() const { return size_; }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const unsigned char* data_;
+	size_t size_;
+#ifdef _WIN32
+	void* file_;
+	void* mapping_;
+#endif
+};
+
+// Least recently used frames, keyed by resolved path, up to a byte budget.
+//
+// A path is an image file, or a multi-page TIFF or .raw stack followed by
+// '#' and a zero-based frame index. Frames are returned fully converted to
+// the current format, so a hit costs no decoding or copying.
+class FrameCache
+{
+public:
+	FrameCache();
+	~FrameCache();
+
+	void SetCapacity(size_t bytes);
+	void SetFormat(const FrameFormat& format);
+	void Clear();
+
+	// Returns the cached frame or loads it; returns an empty Mat if the
+	// file cannot be read
+	cv::Mat Get(const std::string& path);
+
+	// Replaces the pending prefetch requests; paths are loaded in order
+	void Prefetch(const std::vector<std::string>& paths);
+	void Stop();
+
+private:
+	typedef std::pair<std::string, cv::Mat> Frame;
+
+	bool lookup(const std::string& path, cv::Mat& img);
+	void insert(const Frame& frame);
+	void evict();
+	void clearLocked();
+	void run();
+
+	std::vector<Frame> load(const std::string& path, const FrameFormat& format);
+	cv::Mat readRaw(const std::string& file, int index, const FrameFormat& format);
+	static cv::Mat prepare(cv::Mat img, const FrameFormat& format);
+
+	std::mutex mutex_;
+	std::condition_variable prefetchWanted_;
+	std::condition_variable loadDone_;
+
+	FrameFormat format_;
+	unsigned generation_;
+	size_t capacity_;
+	size_t bytes_;
+	std::list<Frame> lru_;
+	std::unordered_map<std::string, std::list<Frame>::iterator> entries_;
+	std::map<std::string, std::shared_ptr<MappedFile> > mappings_;
+
+	std::deque<std::string> queue_;
+	std::string loading_;
+	bool stop_;
+	std::thread thread_;
+};
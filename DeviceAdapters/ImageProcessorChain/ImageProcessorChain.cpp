@@ -28,6 +28,7 @@
 #include "ModuleInterface.h"
 #include <sstream>
 #include <algorithm>
+#include <chrono>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -95,8 +96,23 @@ int ImageProcessorChain::Initialize()
       for (std::vector<std::string>::iterator iap = availableProcessors.begin();  iap != availableProcessors.end(); ++iap)
          AddAllowedValue(processorSlotName.str().c_str(), iap->c_str());
 
+      std::ostringstream timeName;
+      timeName << processorSlotName.str() << " Time (ms)";
+      pAct = new CPropertyActionEx (this, &ImageProcessorChain::OnProcessorTime, ip);
+      (void)CreateProperty(timeName.str().c_str(), "0", MM::Float, true, pAct);
    }
 
+   (void)CreateProperty("Total Time (ms)", "0", MM::Float, true,
+      new CPropertyAction(this, &ImageProcessorChain::OnTotalTime));
+
+   // With tiling, every processor runs on a band of rows before the chain
+   // moves on to the next band, so that the band is still in cache for the
+   // next processor. Only correct for processors that treat rows
+   // independently (e.g. point operations), hence off by default.
+   (void)CreateIntegerProperty("Tile Rows", 0, false,
+      new CPropertyAction(this, &ImageProcessorChain::OnTileRows));
+   SetPropertyLimits("Tile Rows", 0, 4096);
+
    return DEVICE_OK;
 }
 
@@ -136,23 +152,70 @@ int ImageProcessorChain::OnProcessor(MM::PropertyBase* pProp, MM::ActionType eAc
 }
 
 
+int ImageProcessorChain::OnTileRows(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      pProp->Set(tileRows_);
+   }
+   else if (eAct == MM::AfterSet)
+   {
+      pProp->Get(tileRows_);
+   }
+   return DEVICE_OK;
+}
+
+int ImageProcessorChain::OnProcessorTime(MM::PropertyBase* pProp, MM::ActionType eAct, long indexx)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      MMThreadGuard g(timingLock_);
+      pProp->Set(slotTimeMs_[indexx]);
+   }
+   return DEVICE_OK;
+}
+
+int ImageProcessorChain::OnTotalTime(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      MMThreadGuard g(timingLock_);
+      pProp->Set(totalTimeMs_);
+   }
+   return DEVICE_OK;
+}
+
+
 int ImageProcessorChain::Process(unsigned char *pBuffer, unsigned int width, unsigned int height, unsigned int byteDepth)
 {
+   typedef std::chrono::steady_clock Clock;
    int ret = DEVICE_OK;
    busy_ = true;
 
+   std::vector<MM::ImageProcessor*> chain(nSlots_, (MM::ImageProcessor*)NULL);
+   for (std::map<int, MM::ImageProcessor*>::iterator it = processors_.begin(); it != processors_.end(); ++it)
+      if (it->first >= 0 && it->first < nSlots_)
+         chain[it->first] = it->second;
 
-   for( int islot = 0; islot < this->nSlots_; ++islot)
+   const unsigned tileRows = (tileRows_ > 0 && (unsigned)tileRows_ < height) ?
+      (unsigned)tileRows_ : height;
+   const size_t rowBytes = (size_t)width * byteDepth;
+   std::vector<Clock::duration> elapsed(nSlots_, Clock::duration::zero());
+   const Clock::time_point frameStart = Clock::now();
+
+   for (unsigned y0 = 0; y0 < height; y0 += tileRows)
    {
-      if( processors_.end() != processors_.find(islot))
+      const unsigned rows = (std::min)(tileRows, height - y0);
+      unsigned char* pTile = pBuffer + y0 * rowBytes;
+      for( int islot = 0; islot < this->nSlots_; ++islot)
       {
-
-         MM::ImageProcessor* pP = processors_[islot];
+         MM::ImageProcessor* pP = chain[islot];
          if( NULL != pP)
          {
+            const Clock::time_point start = Clock::now();
             try
             {
-               pP->Process(pBuffer, width, height,byteDepth);
+               pP->Process(pTile, width, rows, byteDepth);
             }
             catch(...)
             {
@@ -161,11 +224,21 @@ int ImageProcessorChain::Process(unsigned char *pBuffer, unsigned int width, uns
                pP->GetName(name);
                m << "Error in processor " << name;
                LogMessage(m.str().c_str(), false);
+               chain[islot] = NULL; // Skip it for the rest of this frame
             }
+            elapsed[islot] += Clock::now() - start;
          }
       }
    }
 
+   {
+      typedef std::chrono::duration<double, std::milli> Ms;
+      MMThreadGuard g(timingLock_);
+      for (int islot = 0; islot < nSlots_; ++islot)
+         slotTimeMs_[islot] = std::chrono::duration_cast<Ms>(elapsed[islot]).count();
+      totalTimeMs_ = std::chrono::duration_cast<Ms>(Clock::now() - frameStart).count();
+   }
+
    busy_ = false;
 
    return ret;
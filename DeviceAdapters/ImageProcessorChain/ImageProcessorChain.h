@@ -31,6 +31,7 @@
 #include "DeviceThreads.h"
 #include <string>
 #include <map>
+#include <vector>
 
 
 
@@ -41,7 +42,8 @@
 class ImageProcessorChain : public CImageProcessorBase<ImageProcessorChain>
 {
 public:
-   ImageProcessorChain () : nSlots_(10), busy_(false) {}
+   ImageProcessorChain () : nSlots_(10), busy_(false), tileRows_(0),
+      slotTimeMs_(nSlots_, 0.0), totalTimeMs_(0.0) {}
    ~ImageProcessorChain () { }
 
    int Shutdown() {return DEVICE_OK;}
@@ -56,6 +58,9 @@ public:
    // action interface
    // ----------------
    int OnProcessor(MM::PropertyBase* pProp, MM::ActionType eAct, long indexx);
+   int OnTileRows(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnProcessorTime(MM::PropertyBase* pProp, MM::ActionType eAct, long indexx);
+   int OnTotalTime(MM::PropertyBase* pProp, MM::ActionType eAct);
 
 private:
    const int nSlots_;
@@ -63,6 +68,14 @@ private:
    std::map< int, std::string> processorNames_;
    std::map< int, MM::ImageProcessor*> processors_;
 
+   // Rows per tile; 0 runs each processor on the whole frame
+   long tileRows_;
+
+   // Time spent in each slot (and in total) for the last frame
+   MMThreadLock timingLock_;
+   std::vector<double> slotTimeMs_;
+   double totalTimeMs_;
+
    ImageProcessorChain& operator=( const ImageProcessorChain& ){ 
       return *this;
    };
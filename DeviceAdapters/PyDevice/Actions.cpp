@@ -1,24 +1,79 @@
 #include "pch.h"
 #include "Actions.h"
 #include "PyDevice.h"
+#include <set>
+
+// Cached actions that Python may still refer to by their handle. Only accessed while holding the GIL.
+static std::set<PyAction*> g_cached_actions;
+
+PyAction::~PyAction() {
+    if (cached_) {
+        PyLock lock;
+        g_cached_actions.erase(this);
+    }
+}
 
 /**
 * Callback that is called when a property value is read or written
+* For cached properties, reads do not call Python (or take the GIL) until the Python object reports a change.
 * @return MM result code
 */
 int PyAction::Execute(MM::PropertyBase* pProp, MM::ActionType eAct) {
-    PyLock lock;
     if (eAct != MM::BeforeGet && eAct != MM::AfterSet)
         return DEVICE_OK; // nothing to do.
 
+    if (eAct == MM::BeforeGet && cached_ && !stale_ && !prefetched_)
+        return DEVICE_OK; // MM still holds the current value
+
+    PyLock lock;
     if (eAct == MM::BeforeGet) {
-        auto value = getter_.Call();
-        set(pProp, value);
+        stale_ = false; // cleared before reading, so that a change reported while reading is not lost
+        if (prefetched_) {
+            set(pProp, prefetched_);
+            prefetched_.Clear();
+        }
+        else {
+            auto value = getter_.Call();
+            set(pProp, value);
+        }
     }
-    else 
+    else {
         setter_.Call(get(pProp));
-    
-    return check_errors_();
+        stale_ = true; // the Python object may have adjusted the value
+    }
+
+    auto result = check_errors_();
+    if (result != DEVICE_OK)
+        stale_ = true;
+    return result;
+}
+
+/**
+* Caches the value of this property in MM. The Python object reports changes through PyDevice.notify_changed (see bootstrap.py),
+* which passes the handle that is stored in the 'handle' attribute of the PyProperty object.
+*/
+void PyAction::EnableCache(const PyObj& propertyInfo) noexcept {
+    PyLock lock;
+    cached_ = true;
+    g_cached_actions.insert(this);
+    if (PyObject_SetAttrString(propertyInfo, "handle", PyObj(PyLong_FromVoidPtr(this))) != 0)
+        PyObj::ReportError();
+}
+
+/**
+* Implementation of _property_changed in bootstrap.py. Marks the cached value of a property as stale.
+* Handles of properties that no longer exist (because the device was unloaded) are ignored.
+*/
+PyObject* PyAction::PropertyChanged(PyObject* /*self*/, PyObject* handle) noexcept {
+    auto action = static_cast<PyAction*>(PyLong_AsVoidPtr(handle));
+    if (!action && PyErr_Occurred())
+        return nullptr;
+
+    if (g_cached_actions.count(action))
+        action->stale_ = true;
+
+    Py_INCREF(Py_None);
+    return Py_None;
 }
 
 void PyBoolAction::set(MM::PropertyBase* pProp, const PyObj& value) const noexcept {
@@ -1,11 +1,15 @@
 #pragma once
 #include "pch.h"
 #include "PyObj.h"
+#include <atomic>
 
 class PyAction : public MM::ActionFunctor {
     PyObj getter_;
     PyObj setter_;
     ErrorCallback check_errors_;
+    PyObj prefetched_; // value obtained by ReadAllProperties, used instead of calling the getter
+    bool cached_ = false;
+    std::atomic<bool> stale_{ true }; // for cached properties: true if the value held by MM may be outdated
 public:
     const string name; // Name of MM property
     const MM::PropertyType type;
@@ -17,7 +21,11 @@ public:
     vector<PyObj> enum_values;
 public:
     PyAction(const PyObj& getter, const PyObj& setter, const string& name, MM::PropertyType type, const ErrorCallback& callback) : getter_(getter), setter_(setter), check_errors_(callback), name(name), type(type), readonly(!setter_) {}
+    ~PyAction() override;
     int Execute(MM::PropertyBase* pProp, MM::ActionType eAct) override;
+    void EnableCache(const PyObj& propertyInfo) noexcept;
+    void Prefetch(const PyObj& value) noexcept { prefetched_ = value; }
+    static PyObject* PropertyChanged(PyObject* self, PyObject* handle) noexcept;
     virtual void set(MM::PropertyBase* pProp, const PyObj& value) const noexcept = 0;
     virtual PyObj get(MM::PropertyBase* pProp)  const noexcept = 0;
 };
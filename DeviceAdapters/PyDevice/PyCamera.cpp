@@ -10,6 +10,8 @@ const char* g_Keyword_Left = "Left";
 const char* g_Keyword_Exposure = "Exposure-ms";
 const char* g_Keyword_Binning = "Binning";
 const char* g_Method_Read = "read";
+const char* g_Method_ReadSequence = "read_sequence";
+const long g_SequenceBufferCount = 8; // maximum number of frames passed from Python per GIL acquisition
 
 /**
 * Performs exposure and grabs a single image.
@@ -21,12 +23,16 @@ const char* g_Method_Read = "read";
 int CPyCamera::ConnectMethods(const PyObj& methods)
 {
     _check_(PyCameraClass::ConnectMethods(methods));
-    read_ = methods.GetDictItem("read");
+    read_ = methods.GetDictItem(g_Method_Read);
+    readSequence_ = methods.GetDictItem(g_Method_ReadSequence); // optional, empty if not present
     return CheckError();
 }
 
 int CPyCamera::SnapImage()
 {
+    if (capturing_)
+        return DEVICE_CAMERA_BUSY_ACQUIRING;
+
     auto frame = read_.Call();
     ReleaseBuffer();
     if (PyObject_GetBuffer(frame, &lastFrame_, PyBUF_C_CONTIGUOUS) == -1)
@@ -237,16 +243,134 @@ int CPyCamera::InsertImage()
     if (!buffer)
         return DEVICE_ERR;
 
-    int ret = GetCoreCallback()->InsertImage(this, buffer, GetImageWidth(),
-                                             GetImageHeight(), GetImageBytesPerPixel(),
-                                             md.Serialize().c_str());
-    if (!isStopOnOverflow() && ret == DEVICE_BUFFER_OVERFLOW)
+    return InsertFrame(buffer, GetImageWidth(), GetImageHeight(), md.Serialize(), isStopOnOverflow());
+}
+
+int CPyCamera::InsertFrame(const unsigned char* pixels, unsigned width, unsigned height, const string& metadata, bool stopOnOverflow)
+{
+    int ret = GetCoreCallback()->InsertImage(this, pixels, width, height, GetImageBytesPerPixel(), metadata.c_str());
+    if (!stopOnOverflow && ret == DEVICE_BUFFER_OVERFLOW)
     {
         // do not stop on overflow - just reset the buffer
         GetCoreCallback()->ClearImageBuffer(this);
-        return GetCoreCallback()->InsertImage(this, buffer, GetImageWidth(),
-                                              GetImageHeight(), GetImageBytesPerPixel(),
-                                              md.Serialize().c_str());
+        return GetCoreCallback()->InsertImage(this, pixels, width, height, GetImageBytesPerPixel(), metadata.c_str());
     }
     return ret;
 }
+
+/**
+* Starts a sequence acquisition.
+* If the camera object has a read_sequence method, frames are produced by that generator (see SequenceLoop).
+* Otherwise, the default implementation is used, which calls SnapImage and InsertImage for each frame.
+*/
+int CPyCamera::StartSequenceAcquisition(long numImages, double interval_ms, bool stopOnOverflow)
+{
+    if (!readSequence_)
+        return PyCameraClass::StartSequenceAcquisition(numImages, interval_ms, stopOnOverflow);
+
+    if (IsCapturing())
+        return DEVICE_CAMERA_BUSY_ACQUIRING;
+    if (sequenceThread_.joinable()) // previous sequence finished by itself
+        sequenceThread_.join();
+
+    _check_(GetCoreCallback()->PrepareForAcq(this));
+
+    auto width = GetImageWidth();
+    auto height = GetImageHeight();
+    auto size = static_cast<Py_ssize_t>(GetImageBufferSize());
+    vector<const unsigned char*> pixels;
+    PyObj frames;
+    {
+        PyLock lock;
+        // allocate the frame buffers as bytearrays, and pass them to read_sequence, which returns a generator
+        if (sequenceBuffers_.empty() || PyByteArray_Size(sequenceBuffers_[0]) != size)
+        {
+            sequenceBuffers_.clear();
+            for (long i = 0; i < g_SequenceBufferCount; i++)
+            {
+                auto buffer = PyObj(PyByteArray_FromStringAndSize(nullptr, size));
+                if (!buffer)
+                {
+                    sequenceBuffers_.clear();
+                    CheckError();
+                    return DEVICE_OUT_OF_MEMORY;
+                }
+                sequenceBuffers_.push_back(std::move(buffer));
+            }
+        }
+        auto buffers = PyObj(PyList_New(0));
+        for (const auto& buffer : sequenceBuffers_)
+        {
+            PyList_Append(buffers, buffer);
+            pixels.push_back(reinterpret_cast<const unsigned char*>(PyByteArray_AsString(buffer)));
+        }
+        auto result = readSequence_.Call(buffers, PyObj(static_cast<long>(width)), PyObj(static_cast<long>(height)));
+        if (result)
+            frames = PyObj(PyObject_GetIter(result));
+    }
+    _check_(CheckError());
+    if (!frames)
+        return DEVICE_ERR;
+
+    stopSequence_ = false;
+    capturing_ = true;
+    sequenceThread_ = std::thread(&CPyCamera::SequenceLoop, this, std::move(frames), std::move(pixels), numImages, stopOnOverflow);
+    return DEVICE_OK;
+}
+
+int CPyCamera::StopSequenceAcquisition()
+{
+    if (!sequenceThread_.joinable())
+        return PyCameraClass::StopSequenceAcquisition();
+
+    stopSequence_ = true;
+    sequenceThread_.join();
+    return DEVICE_OK;
+}
+
+bool CPyCamera::IsCapturing()
+{
+    return capturing_ || PyCameraClass::IsCapturing();
+}
+
+/**
+* Runs the read_sequence generator and inserts the frames it produces.
+* Each step of the generator fills the first n buffers and yields n. All buffers are free again when the
+* generator is resumed. The GIL is only held while the generator runs, the frames are inserted without it.
+*/
+void CPyCamera::SequenceLoop(PyObj frames, vector<const unsigned char*> pixels, long numImages, bool stopOnOverflow)
+{
+    char label[MM::MaxStrLength];
+    this->GetLabel(label);
+    Metadata md;
+    md.put(MM::g_Keyword_Metadata_CameraLabel, label);
+    auto metadata = md.Serialize();
+    auto width = GetImageWidth();
+    auto height = GetImageHeight();
+
+    int ret = DEVICE_OK;
+    long inserted = 0;
+    while (ret == DEVICE_OK && !stopSequence_ && inserted < numImages)
+    {
+        long count;
+        {
+            PyLock lock;
+            auto next = PyObj(PyIter_Next(frames));
+            if (!next) // generator finished or raised an exception
+                break;
+            count = next.as<long>();
+        }
+        if (count < 0 || count > static_cast<long>(pixels.size()))
+        {
+            this->LogMessage("Error, read_sequence should yield the number of buffers that were filled");
+            break;
+        }
+        for (long i = 0; i < count && ret == DEVICE_OK && inserted < numImages; i++, inserted++)
+            ret = InsertFrame(pixels[i], width, height, metadata, stopOnOverflow);
+    }
+
+    frames.Clear(); // destroying the generator runs its cleanup code (finally blocks, context managers)
+    CheckError();
+    OnThreadExiting();
+    capturing_ = false;
+}
@@ -1,11 +1,18 @@
 #pragma once
 #include "PyDevice.h"
 #include "buffer.h"
+#include <atomic>
+#include <thread>
 
 using PyCameraClass = CPyDeviceTemplate<CCameraBase<std::monostate>>;
 class CPyCamera : public PyCameraClass {
     Py_buffer lastFrame_;
     PyObj read_; // the read() method of the camera object
+    PyObj readSequence_; // the optional read_sequence() generator method of the camera object
+    vector<PyObj> sequenceBuffers_; // bytearrays that read_sequence fills, owned by Python so that the views it holds stay valid
+    std::thread sequenceThread_;
+    std::atomic<bool> capturing_{ false };
+    std::atomic<bool> stopSequence_{ false };
     
 public:
     CPyCamera(const string& id) : PyCameraClass(id)
@@ -31,8 +38,14 @@ public:
     int Shutdown() override;
     int InsertImage() override;
     int ConnectMethods(const PyObj& methods) override;
+    using PyCameraClass::StartSequenceAcquisition;
+    int StartSequenceAcquisition(long numImages, double interval_ms, bool stopOnOverflow) override;
+    int StopSequenceAcquisition() override;
+    bool IsCapturing() override;
 
 private:
+    void SequenceLoop(PyObj frames, vector<const unsigned char*> pixels, long numImages, bool stopOnOverflow);
+    int InsertFrame(const unsigned char* pixels, unsigned width, unsigned height, const string& metadata, bool stopOnOverflow);
     void ReleaseBuffer()
     {
         PyLock lock;
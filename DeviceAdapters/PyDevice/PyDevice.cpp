@@ -176,6 +176,7 @@ tuple<vector<PyAction*>, PyObj> EnumerateProperties(const PyObj& deviceInfo, con
     //
     auto propertyDescriptors = vector<PyAction*>();
     auto properties = deviceInfo.Get("properties");
+    auto cached = deviceInfo.Get("cached").as<bool>(); // true if the Python object reports changes of property values
     auto property_count = PyList_Size(properties);
     for (Py_ssize_t i = 0; i < property_count; i++)
     {
@@ -221,6 +222,9 @@ tuple<vector<PyAction*>, PyObj> EnumerateProperties(const PyObj& deviceInfo, con
             }
         }
 
+        if (cached)
+            descriptor->EnableCache(pinfo);
+
         propertyDescriptors.push_back(descriptor);
     }
 
@@ -40,6 +40,8 @@ class CPyDeviceTemplate : public BaseType
 protected:
     bool initialized_ = false;
     PyObj busy_; // busy() method
+    PyObj deviceInfo_; // PyDevice object from bootstrap.py
+    vector<PyAction*> actions_; // owned by the MM properties
     string id_;
 
 public:
@@ -135,12 +137,30 @@ public:
             _check_(CheckError());
             _check_(CreateProperties(properties));
             _check_(ConnectMethods(methods));
-            _check_(this->UpdateStatus()); // load value of all properties from the Python object
+            deviceInfo_ = deviceInfo;
+            actions_ = properties;
+            _check_(ReadAllProperties()); // load value of all properties from the Python object
             initialized_ = true;
         }
         return DEVICE_OK;
     }
 
+    /**
+     * Reads the values of all properties with a single Python call (PyDevice.read_all in bootstrap.py) and a single
+     * acquisition of the GIL, and stores them in the MM properties.
+     * @return MM error code
+    */
+    int ReadAllProperties() noexcept
+    {
+        PyLock lock;
+        auto values = deviceInfo_.CallMember("read_all");
+        if (values)
+            for (auto action : actions_)
+                action->Prefetch(values.GetDictItem(action->name.c_str()));
+        _check_(CheckError());
+        return this->UpdateStatus(); // the GIL is already held, so this does not acquire it for each property
+    }
+
     long GetLongProperty(const char* property) const
     {
         long value = 0;
@@ -180,6 +200,8 @@ public:
     int Shutdown() override
     {
         initialized_ = false;
+        actions_.clear();
+        deviceInfo_.Clear();
         return DEVICE_OK;
     }
 
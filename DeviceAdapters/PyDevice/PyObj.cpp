@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "PyObj.h"
+#include "Actions.h"
 
 PyObj PyObj::g_traceback_to_string;
 PyObj PyObj::g_load_devices;
@@ -51,6 +52,11 @@ bool PyObj::Bootstrap() noexcept
     // get the um unit for use with stages
     g_traceback_to_string = g_global_scope.GetDictItem("traceback_to_string");
     g_load_devices = g_global_scope.GetDictItem("load_devices");
+
+    // replace the placeholder _property_changed by the C++ implementation that invalidates cached property values
+    static PyMethodDef property_changed = { "_property_changed", PyAction::PropertyChanged, METH_O, nullptr };
+    if (PyDict_SetItemString(g_global_scope, "_property_changed", PyObj(PyCFunction_NewEx(&property_changed, nullptr, nullptr))) != 0)
+        return ReportError();
     return ReportError();
 }
 
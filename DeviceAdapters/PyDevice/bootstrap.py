@@ -49,6 +49,11 @@ def load_devices(module_path, script_path, script_name) -> dict:
         sys.path = _original_path
 
 
+def _property_changed(handle):
+    """Marks the cached value of a property as stale. Replaced by a C++ function when running in the device adapter."""
+    pass
+
+
 def _to_title_case(name: str) -> str:
     for suffix in ['_s', '_ms', '_us', '_ns', '_m', '_cm', '_mm', '_um', '_nm', '_A', '_mA', '_uA', '_V', '_mV', '_uV',
                    '_Hz', '_kHz', '_MHz', '_GHz']:
@@ -70,6 +75,7 @@ class PyProperty:
         self.max = None
         self.options = None
         self.unit = None
+        self.handle = None  # set by the device adapter if the property value is cached
 
         if isinstance(p, property):  # property
             fset = getattr(p, 'fset', None)
@@ -183,6 +189,25 @@ class PyDevice:
 
         # The 'busy' method is optional
 
+        # Optional change notification. If the device has a `_notify_changed` attribute, it promises to call it
+        # whenever property values change by other means than setting them through Micro-Manager. Micro-Manager
+        # then caches the values, and only reads properties that were reported as changed.
+        self.cached = hasattr(device, '_notify_changed')
+        if self.cached:
+            device._notify_changed = self.notify_changed
+
+    def notify_changed(self, *names):
+        """Reports that the properties with the given (Python) names changed value, or all properties if no names are
+        given."""
+        for p in self.properties:
+            if p.handle is not None and (not names or p.python_name in names):
+                _property_changed(p.handle)
+
+    def read_all(self) -> dict:
+        """Returns the values of all properties, indexed by Micro-Manager name. Called from the C++ code to read all
+        properties in a single call."""
+        return {p.mm_name: p.get() for p in self.properties}
+
     def _init_camera(self) -> bool:
         """Checks if the device corresponds to a Camera, and prepares the camera object if it does"""
 
@@ -199,6 +224,16 @@ class PyDevice:
 
             self.properties.append(PyProperty(self, 'binning', binning))
 
+        # the read_sequence method is optional. The device adapter passes it preallocated bytearrays,
+        # which are presented to the Python code as writable (height, width) uint16 memoryviews
+        if self._has_methods('read_sequence'):
+            read_sequence = self.methods['read_sequence']
+
+            def read_sequence_into(buffers, width: int, height: int):
+                return read_sequence([memoryview(b).cast('H', (height, width)) for b in buffers])
+
+            self.methods['read_sequence'] = read_sequence_into
+
         return True
 
     def _init_xy_stage(self) -> bool:
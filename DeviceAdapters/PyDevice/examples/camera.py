@@ -37,6 +37,17 @@ class Camera:
             image = self._rng.normal(mean, std, size)
         return image.astype(np.uint16)
 
+    def read_sequence(self, buffers):
+        """Optional. Used for sequence acquisition instead of calling `read` for each frame.
+
+        Each buffer is a writable (height, width) uint16 memoryview. After filling buffers[0:n], yield n.
+        """
+        frames = [np.asarray(b) for b in buffers]
+        while True:
+            for frame in frames:
+                frame[...] = self.read()
+            yield len(frames)
+
     def busy(self):
         return False
 
@@ -149,6 +149,7 @@ struct PyMethodDef {
     int         ml_flags;
     const char* ml_doc;
 };
+#define METH_O 0x0008
 typedef struct {
     int slot;
     void* pfunc;
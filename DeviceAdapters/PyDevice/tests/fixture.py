@@ -190,6 +190,34 @@ class Camera1:
         return False
 
 
+class CachedDevice:
+    """Reports changes of its property values, so that Micro-Manager can cache them"""
+
+    def __init__(self):
+        self._position = 0.0
+        self._target = 0.0
+
+    def _notify_changed(self, *names):
+        pass  # replaced by PyDevice
+
+    @property
+    def target(self) -> float:
+        return self._target
+
+    @target.setter
+    def target(self, value):
+        self._target = value
+
+    @property
+    def position(self) -> float:
+        return self._position
+
+    def update(self):
+        """Simulates the hardware reaching the target"""
+        self._position = self._target
+        self._notify_changed('position')
+
+
 class GenericDeviceDirect:
     float_value: float
     int_value: int
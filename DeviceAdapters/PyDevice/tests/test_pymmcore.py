@@ -30,6 +30,20 @@ def test_camera():
     assert frame.shape == (333, 121)
 
 
+def test_camera_sequence():
+    mmc = pymmcore.CMMCore()
+    mmc.setDeviceAdapterSearchPaths([mm_dir])
+    mmc.loadSystemConfiguration("camera.cfg")
+    mmc.setProperty("cam", "Width", 121)
+    mmc.setProperty("cam", "Height", 333)
+    mmc.startSequenceAcquisition(20, 0.0, True)
+    while mmc.isSequenceRunning():
+        mmc.sleep(10)
+    assert mmc.getRemainingImageCount() == 20
+    frame = mmc.popNextImage()
+    assert frame.shape == (333, 121)
+
+
 def test_microscope():
     mmc = pymmcore.CMMCore()
     mmc.setDeviceAdapterSearchPaths([mm_dir])
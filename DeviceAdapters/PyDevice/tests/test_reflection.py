@@ -119,3 +119,24 @@ def test_direct():
     assert properties[5].python_name == 'meters'
     assert properties[6].python_name == 'millimeters'
     assert len(properties) == 7
+
+
+def test_cached():
+    """Checks if change notifications are passed on for cached devices"""
+    import bootstrap
+    changed = []
+    bootstrap._property_changed = changed.append
+
+    device = CachedDevice()
+    pydevice = PyDevice(device)
+    assert pydevice.cached
+    assert not PyDevice(GenericDevice()).cached
+
+    for i, p in enumerate(pydevice.properties):
+        p.handle = i
+    device.target = 2.0
+    device.update()
+    assert changed == [1]  # only 'position'
+    pydevice.notify_changed()
+    assert changed == [1, 0, 1]
+    assert pydevice.read_all() == {'Target': 2.0, 'Position': 2.0}
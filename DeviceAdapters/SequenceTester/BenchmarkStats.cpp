@@ -0,0 +1,66 @@
+// Mock device adapter for testing of device sequencing
+//
+// Copyright (C) 2014 University of California, San Francisco.
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "BenchmarkStats.h"
+
+#include <algorithm>
+#include <sstream>
+
+
+void
+BenchmarkStats::Reset()
+{
+   count_ = 0;
+   sumUs_ = 0.0;
+   samplesUs_.clear();
+}
+
+
+void
+BenchmarkStats::Record(Clock::duration d)
+{
+   const double us =
+      std::chrono::duration_cast< std::chrono::duration<double, std::micro> >(d).count();
+   ++count_;
+   sumUs_ += us;
+   if (samplesUs_.size() < MaxSamples)
+      samplesUs_.push_back(us);
+}
+
+
+std::string
+BenchmarkStats::AsJSON() const
+{
+   std::ostringstream json;
+   json << "{\"count\":" << count_;
+   if (count_ > 0)
+   {
+      std::vector<double> sorted(samplesUs_);
+      std::sort(sorted.begin(), sorted.end());
+      const size_t n = sorted.size();
+      json << ",\"mean_us\":" << sumUs_ / count_ <<
+         ",\"min_us\":" << sorted.front() <<
+         ",\"p50_us\":" << sorted[n / 2] <<
+         ",\"p99_us\":" << sorted[std::min(n - 1, n * 99 / 100)] <<
+         ",\"max_us\":" << sorted.back();
+   }
+   json << "}";
+   return json.str();
+}
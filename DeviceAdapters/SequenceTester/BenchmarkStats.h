@@ -0,0 +1,55 @@
+// Mock device adapter for testing of device sequencing
+//
+// Copyright (C) 2014 University of California, San Francisco.
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+// Durations collected during a benchmark run (e.g. trigger-to-insert latency
+// of camera frames), summarized as JSON for consumption by test scripts.
+// Not thread-safe; callers provide locking.
+class BenchmarkStats
+{
+public:
+   typedef std::chrono::steady_clock Clock;
+
+   BenchmarkStats() : count_(0), sumUs_(0.0) {}
+
+   void Reset();
+   void Record(Clock::duration d);
+
+   size_t GetCount() const { return count_; }
+
+   // JSON object with count, mean, min, median, 99th percentile and max, in
+   // microseconds. Percentiles are computed from the first MaxSamples
+   // durations; count and mean cover all of them.
+   std::string AsJSON() const;
+
+   static const size_t MaxSamples = 1 << 20;
+
+private:
+   size_t count_;
+   double sumUs_;
+   std::vector<double> samplesUs_;
+};
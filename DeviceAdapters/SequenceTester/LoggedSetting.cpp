@@ -468,7 +468,9 @@ FloatSetting::FloatSetting(SettingLogger* logger,
    min_(minimum),
    max_(maximum),
    sequenceRunning_(false),
-   nextTriggerIndex_(0)
+   nextTriggerIndex_(0),
+   streaming_(false),
+   bufferLowSignaled_(false)
 {
    GetLogger()->SetFloat(GetDevice()->GetDeviceName(), GetName(),
          initialValue, false);
@@ -505,6 +507,36 @@ FloatSetting::SetTriggerSequence(const std::vector<double>& sequence)
    if (sequence.size() > GetSequenceMaxLength())
       return DEVICE_SEQUENCE_TOO_LARGE;
    triggerSequence_ = sequence;
+   streaming_ = false;
+   return DEVICE_OK;
+}
+
+
+void
+FloatSetting::ClearTriggerSequence()
+{
+   triggerSequence_.clear();
+   streamedSequence_.clear();
+   streaming_ = false;
+   bufferLowSignaled_ = false;
+}
+
+
+int
+FloatSetting::AppendToTriggerSequence(const double* values, long count,
+      long& numAppended)
+{
+   long maxLength = GetSequenceMaxLength();
+   if (maxLength == 0)
+      return DEVICE_ERR;
+
+   streaming_ = true;
+   long room = maxLength - static_cast<long>(streamedSequence_.size());
+   numAppended = std::max(0L, std::min(count, room));
+   streamedSequence_.insert(streamedSequence_.end(),
+         values, values + numAppended);
+   if (numAppended > 0)
+      bufferLowSignaled_ = false;
    return DEVICE_OK;
 }
 
@@ -531,15 +563,38 @@ FloatSetting::StopTriggerSequence()
 void
 FloatSetting::HandleEdgeTrigger()
 {
-   if (!sequenceRunning_ || triggerSequence_.empty())
+   if (!sequenceRunning_)
       return;
 
-   double newValue = triggerSequence_[nextTriggerIndex_++];
-   if (nextTriggerIndex_ >= triggerSequence_.size())
-      nextTriggerIndex_ = 0;
+   double newValue;
+   if (streaming_)
+   {
+      // Running dry leaves the value unchanged, as with real hardware that
+      // misses its deadline
+      if (streamedSequence_.empty())
+         return;
+      newValue = streamedSequence_.front();
+      streamedSequence_.pop_front();
+   }
+   else
+   {
+      if (triggerSequence_.empty())
+         return;
+      newValue = triggerSequence_[nextTriggerIndex_++];
+      if (nextTriggerIndex_ >= triggerSequence_.size())
+         nextTriggerIndex_ = 0;
+   }
 
    GetLogger()->SetFloat(GetDevice()->GetDeviceName(), GetName(), newValue);
    FirePostSetSignal();
+
+   if (streaming_ && !bufferLowSignaled_ &&
+         static_cast<long>(streamedSequence_.size()) <=
+         GetSequenceMaxLength() / 2)
+   {
+      bufferLowSignaled_ = true;
+      bufferLowSignal_();
+   }
 }
 
 
@@ -29,6 +29,7 @@
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/signals2.hpp>
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -207,6 +208,12 @@ class FloatSetting : public LoggedSetting
    bool sequenceRunning_;
    size_t nextTriggerIndex_;
 
+   // Streamed sequences are consumed rather than repeated
+   bool streaming_;
+   std::deque<double> streamedSequence_;
+   bool bufferLowSignaled_;
+   boost::signals2::signal<void ()> bufferLowSignal_;
+
    typedef FloatSetting Self;
 
 public:
@@ -235,10 +242,19 @@ public:
    double Get() const;
 
    int SetTriggerSequence(const std::vector<double>& sequence);
+   void ClearTriggerSequence();
+   // Switches to streaming; takes as many values as fit
+   int AppendToTriggerSequence(const double* values, long count,
+         long& numAppended);
    virtual int StartTriggerSequence();
    virtual int StopTriggerSequence();
    virtual void HandleEdgeTrigger();
 
+   // Fired (once per append) when a streamed sequence is down to half the
+   // sequence max length
+   typedef boost::signals2::signal<void ()> BufferLowSignal;
+   BufferLowSignal& GetBufferLowSignal() { return bufferLowSignal_; }
+
    MM::ActionFunctor* NewPropertyAction();
 };
 
@@ -30,7 +30,10 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 #include <boost/unordered_map.hpp>
+#include <cmath>
+#include <cstring>
 #include <exception>
+#include <sstream>
 #include <string>
 #include <utility>
 
@@ -130,6 +133,10 @@ CreateDevice(const char* deviceName)
       return DeviceRetainer::CreateDevice<TesterAutofocus>(name);
    if (StartsWith("TSwitcher", name))
       return DeviceRetainer::CreateDevice<TesterSwitcher>(name);
+   if (StartsWith("TDA", name))
+      return DeviceRetainer::CreateDevice<TesterDA>(name);
+   if (StartsWith("TClock", name))
+      return DeviceRetainer::CreateDevice<TesterClock>(name);
    return 0;
 }
 
@@ -201,6 +208,10 @@ TesterHub::DetectInstalledDevices()
    AddInstalledDevice(new TesterAutofocus("TAutofocus-1"));
    AddInstalledDevice(new TesterSwitcher("TSwitcher-0"));
    AddInstalledDevice(new TesterSwitcher("TSwitcher-1"));
+   AddInstalledDevice(new TesterDA("TDA-0"));
+   AddInstalledDevice(new TesterDA("TDA-1"));
+   AddInstalledDevice(new TesterClock("TClock-0"));
+   AddInstalledDevice(new TesterClock("TClock-1"));
    return DEVICE_OK;
 }
 
@@ -241,19 +252,27 @@ TesterHub::FindPeerDevice(const std::string& name)
 TesterCamera::TesterCamera(const std::string& name) :
    Super(name),
    produceHumanReadableImages_(true),
+   produceBlankImages_(false),
    imageWidth_(384),
    imageHeight_(384),
    nextSerialNr_(0),
    nextSnapImageNr_(0),
    nextSequenceImageNr_(0),
    snapImage_(0),
-   stopSequence_(true)
+   stopSequence_(true),
+   frameTriggered_(false),
+   awaitingFrameTriggers_(false),
+   droppedFrameTriggers_(0),
+   sequenceFrames_(0),
+   exposureTriggerInput_("Exposure")
 {
    // For pre-init properties only, we use the traditional method to set up.
    CCameraBase<Self>::CreateStringProperty("ImageMode", "HumanReadable",
          false, 0, true);
    AddAllowedValue("ImageMode", "HumanReadable");
    AddAllowedValue("ImageMode", "MachineReadable");
+   // Frames carry only the frame number, for throughput benchmarking
+   AddAllowedValue("ImageMode", "Blank");
    CCameraBase<Self>::CreateIntegerProperty("ImageWidth", imageWidth_,
          false, 0, true);
    SetPropertyLimits("ImageWidth", 32, 4096);
@@ -283,6 +302,7 @@ TesterCamera::Initialize()
    char imageMode[MM::MaxStrLength];
    GetProperty("ImageMode", imageMode);
    produceHumanReadableImages_ = (imageMode == std::string("HumanReadable"));
+   produceBlankImages_ = (imageMode == std::string("Blank"));
    GetProperty("ImageWidth", imageWidth_);
    GetProperty("ImageHeight", imageHeight_);
 
@@ -298,6 +318,29 @@ TesterCamera::Initialize()
    CreateFloatProperty("Exposure", exposureSetting_);
    CreateIntegerProperty("Binning", binningSetting_);
 
+   exposureTriggerInput_.Initialize(shared_from_this(), exposureSetting_);
+
+   CreateStringProperty("ExposureTriggerSourceDevice",
+         exposureTriggerInput_.GetSourceDeviceSetting());
+   CreateStringProperty("ExposureTriggerSourcePort",
+         exposureTriggerInput_.GetSourcePortSetting());
+   CreateIntegerProperty("ExposureTriggerSequenceMaxLength",
+         exposureTriggerInput_.GetSequenceMaxLengthSetting());
+
+   frameTriggerSourceDevice_ = StringSetting::New(GetLogger(), this,
+         "FrameTriggerSourceDevice");
+   frameTriggerSourceDevice_->GetPostSetSignal().connect(
+         [this] { UpdateFrameTriggerConnection(); });
+   frameTriggerSourcePort_ = StringSetting::New(GetLogger(), this,
+         "FrameTriggerSourcePort");
+   frameTriggerSourcePort_->GetPostSetSignal().connect(
+         [this] { UpdateFrameTriggerConnection(); });
+   CreateStringProperty("FrameTriggerSourceDevice", frameTriggerSourceDevice_);
+   CreateStringProperty("FrameTriggerSourcePort", frameTriggerSourcePort_);
+
+   CCameraBase<Self>::CreateStringProperty("BenchmarkReport", "{}", true,
+         new MM::Action<Self>(this, &Self::OnBenchmarkReport));
+
    RegisterEdgeTriggerSource("ExposureStartEdge", exposureStartEdgeTrigger_);
    RegisterEdgeTriggerSource("ExposureStopEdge", exposureStopEdgeTrigger_);
 
@@ -432,6 +475,14 @@ TesterCamera::StartSequenceAcquisitionImpl(bool finite, long count,
       if (!stopSequence_)
          return DEVICE_ERR;
       stopSequence_ = false;
+
+      frameTriggered_ = frameTriggerConnection_.connected();
+      awaitingFrameTriggers_ = frameTriggered_;
+      pendingFrameTriggers_.clear();
+      droppedFrameTriggers_ = 0;
+      sequenceFrames_ = 0;
+      frameLatency_.Reset();
+      sequenceStartTime_ = BenchmarkStats::Clock::now();
    }
 
    GetCoreCallback()->PrepareForAcq(this);
@@ -462,6 +513,7 @@ TesterCamera::StopSequenceAcquisition()
          return DEVICE_OK;
       stopSequence_ = true;
    }
+   frameTriggerCond_.notify_all();
 
    // In newer Boost versions: if (sequenceFuture_.valid())
    if (sequenceFuture_.get_state() != boost::future_state::uninitialized)
@@ -503,7 +555,14 @@ TesterCamera::GenerateLogImage(bool isSequenceImage, size_t cumulativeNr,
    char* bytes = new char[bufSize];
 
    SettingLogger* logger = GetLogger();
-   if (produceHumanReadableImages_)
+   if (produceBlankImages_)
+   {
+      // Skip rendering the setting log; only the serial number is written
+      std::memset(bytes, 0, bufSize);
+      const size_t serialNr = nextSerialNr_++;
+      std::memcpy(bytes, &serialNr, sizeof(serialNr));
+   }
+   else if (produceHumanReadableImages_)
    {
       logger->DrawTextToBuffer(bytes, GetImageWidth(), GetImageHeight(),
             GetDeviceName(), isSequenceImage, nextSerialNr_++,
@@ -541,12 +600,28 @@ TesterCamera::SendSequence(bool finite, long count, bool stopOnOverflow)
    unsigned height = GetImageHeight();
    unsigned bytesPerPixel = GetImageBytesPerPixel();
 
+   bool triggered;
+   {
+      boost::lock_guard<boost::mutex> lock(sequenceMutex_);
+      triggered = frameTriggered_;
+   }
+
    for (long frame = 0; !finite || frame < count; ++frame)
    {
+      // Latency is measured from the trigger, or (when free-running) from
+      // the start of the frame, to the return of InsertImage()
+      BenchmarkStats::Clock::time_point frameStart;
+      if (triggered)
+      {
+         if (!WaitForFrameTrigger(frameStart))
+            break;
+      }
+      else
       {
          boost::lock_guard<boost::mutex> lock(sequenceMutex_);
          if (stopSequence_)
             break;
+         frameStart = BenchmarkStats::Clock::now();
       }
 
       delete[] bytes;
@@ -583,6 +658,13 @@ TesterCamera::SendSequence(bool finite, long count, bool stopOnOverflow)
             else
                break;
          }
+
+         const BenchmarkStats::Clock::time_point inserted =
+            BenchmarkStats::Clock::now();
+         boost::lock_guard<boost::mutex> lock(sequenceMutex_);
+         ++sequenceFrames_;
+         lastFrameTime_ = inserted;
+         frameLatency_.Record(inserted - frameStart);
       }
       catch (...)
       {
@@ -591,10 +673,180 @@ TesterCamera::SendSequence(bool finite, long count, bool stopOnOverflow)
       }
    }
 
+   {
+      boost::lock_guard<boost::mutex> lock(sequenceMutex_);
+      awaitingFrameTriggers_ = false;
+   }
+
    delete[] bytes;
 }
 
 
+void
+TesterCamera::UpdateFrameTriggerConnection()
+{
+   frameTriggerConnection_.disconnect();
+
+   const std::string sourceDevice = frameTriggerSourceDevice_->Get();
+   const std::string sourcePort = frameTriggerSourcePort_->Get();
+   if (sourceDevice.empty() || sourcePort.empty())
+      return;
+
+   InterDevice::Ptr device = GetHub()->FindPeerDevice(sourceDevice);
+   if (!device)
+      return;
+
+   EdgeTriggerSignal* signal = device->GetEdgeTriggerSource(sourcePort);
+   if (!signal)
+      return;
+
+   frameTriggerConnection_ = signal->connect(
+         [this] { ReceiveFrameTrigger(); });
+}
+
+
+void
+TesterCamera::ReceiveFrameTrigger()
+{
+   const BenchmarkStats::Clock::time_point now = BenchmarkStats::Clock::now();
+
+   {
+      boost::lock_guard<boost::mutex> lock(sequenceMutex_);
+      // Triggers outside of a triggered sequence are ignored
+      if (stopSequence_ || !awaitingFrameTriggers_)
+         return;
+      if (pendingFrameTriggers_.size() >= maxPendingFrameTriggers_)
+      {
+         ++droppedFrameTriggers_;
+         return;
+      }
+      pendingFrameTriggers_.push_back(now);
+   }
+   frameTriggerCond_.notify_one();
+}
+
+
+bool
+TesterCamera::WaitForFrameTrigger(
+      BenchmarkStats::Clock::time_point& triggerTime)
+{
+   boost::unique_lock<boost::mutex> lock(sequenceMutex_);
+   while (!stopSequence_ && pendingFrameTriggers_.empty())
+      frameTriggerCond_.wait(lock);
+   if (stopSequence_)
+      return false;
+
+   triggerTime = pendingFrameTriggers_.front();
+   pendingFrameTriggers_.pop_front();
+   return true;
+}
+
+
+int
+TesterCamera::OnBenchmarkReport(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct != MM::BeforeGet)
+      return DEVICE_OK;
+
+   // Covers the current or most recent sequence acquisition
+   std::ostringstream json;
+   {
+      boost::lock_guard<boost::mutex> lock(sequenceMutex_);
+      const double elapsedS = sequenceFrames_ == 0 ? 0.0 :
+         std::chrono::duration<double>(lastFrameTime_ - sequenceStartTime_).count();
+      json << "{\"frames\":" << sequenceFrames_ <<
+         ",\"triggered\":" << (frameTriggered_ ? "true" : "false") <<
+         ",\"dropped_triggers\":" << droppedFrameTriggers_ <<
+         ",\"elapsed_s\":" << elapsedS <<
+         ",\"fps\":" << (elapsedS > 0.0 ? sequenceFrames_ / elapsedS : 0.0) <<
+         ",\"latency\":" << frameLatency_.AsJSON() << "}";
+   }
+   pProp->Set(json.str().c_str());
+   return DEVICE_OK;
+}
+
+
+int
+TesterCamera::IsExposureSequenceable(bool& f) const
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   long len;
+   int err = exposureSetting_->GetSequenceMaxLength(len);
+   f = (len > 0);
+   return err;
+}
+
+
+int
+TesterCamera::GetExposureSequenceMaxLength(long& nrEvents) const
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return exposureSetting_->GetSequenceMaxLength(nrEvents);
+}
+
+
+int
+TesterCamera::StartExposureSequence()
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return exposureSetting_->StartTriggerSequence();
+}
+
+
+int
+TesterCamera::StopExposureSequence()
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return exposureSetting_->StopTriggerSequence();
+}
+
+
+int
+TesterCamera::ClearExposureSequence()
+{
+   // No locking needed for access to exposureSequenceBuffer_
+   exposureSequenceBuffer_.clear();
+
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+   exposureSetting_->ClearTriggerSequence();
+   return DEVICE_OK;
+}
+
+
+int
+TesterCamera::AddToExposureSequence(double exposureTimeMs)
+{
+   // No locking needed for access to exposureSequenceBuffer_
+   exposureSequenceBuffer_.push_back(exposureTimeMs);
+   return DEVICE_OK;
+}
+
+
+int
+TesterCamera::SendExposureSequence() const
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return exposureSetting_->SetTriggerSequence(exposureSequenceBuffer_);
+}
+
+
+int
+TesterCamera::SetExposureSequence(const double* exposureTimesMs,
+      long numExposures)
+{
+   exposureSequenceBuffer_.assign(exposureTimesMs,
+         exposureTimesMs + numExposures);
+
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+   return exposureSetting_->SetTriggerSequence(exposureSequenceBuffer_);
+}
+
+
 int
 TesterShutter::Initialize()
 {
@@ -665,6 +917,17 @@ TesterXYStage::Initialize()
    setYOrigin_ = OneShotSetting::New(GetLogger(), this, "SetYOrigin");
    setYOrigin_->SetBusySetting(GetBusySetting());
 
+   // Both axes step through their sequences on the same trigger
+   triggerInput_.Initialize(shared_from_this(), xPositionSteps_);
+   triggerInput_.AddSequencedSetting(yPositionSteps_);
+
+   CreateStringProperty("TriggerSourceDevice",
+         triggerInput_.GetSourceDeviceSetting());
+   CreateStringProperty("TriggerSourcePort",
+         triggerInput_.GetSourcePortSetting());
+   CreateIntegerProperty("TriggerSequenceMaxLength",
+         triggerInput_.GetSequenceMaxLengthSetting());
+
    return DEVICE_OK;
 }
 
@@ -774,6 +1037,95 @@ TesterXYStage::GetLimitsUm(double& xMin, double& xMax, double& yMin, double& yMa
 }
 
 
+int
+TesterXYStage::IsXYStageSequenceable(bool& isSequenceable) const
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   long len;
+   int err = xPositionSteps_->GetSequenceMaxLength(len);
+   isSequenceable = (len > 0);
+   return err;
+}
+
+
+int
+TesterXYStage::GetXYStageSequenceMaxLength(long& nrEvents) const
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return xPositionSteps_->GetSequenceMaxLength(nrEvents);
+}
+
+
+int
+TesterXYStage::StartXYStageSequence()
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   int err = xPositionSteps_->StartTriggerSequence();
+   if (err != DEVICE_OK)
+      return err;
+   return yPositionSteps_->StartTriggerSequence();
+}
+
+
+int
+TesterXYStage::StopXYStageSequence()
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   int err1 = xPositionSteps_->StopTriggerSequence();
+   int err2 = yPositionSteps_->StopTriggerSequence();
+   if (err1 != DEVICE_OK)
+      return err1;
+   return err2;
+}
+
+
+int
+TesterXYStage::ClearXYStageSequence()
+{
+   // No locking needed for access to the sequence buffers
+   xSequenceBuffer_.clear();
+   ySequenceBuffer_.clear();
+   return DEVICE_OK;
+}
+
+
+int
+TesterXYStage::AddToXYStageSequence(double positionX, double positionY)
+{
+   // No locking needed for access to the sequence buffers
+   xSequenceBuffer_.push_back(std::lround(positionX * stepsPerUm));
+   ySequenceBuffer_.push_back(std::lround(positionY * stepsPerUm));
+   return DEVICE_OK;
+}
+
+
+int
+TesterXYStage::SendXYStageSequence()
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   int err = xPositionSteps_->SetTriggerSequence(xSequenceBuffer_);
+   if (err != DEVICE_OK)
+      return err;
+   return yPositionSteps_->SetTriggerSequence(ySequenceBuffer_);
+}
+
+
+int
+TesterXYStage::SetXYStageSequence(const double* positionsX,
+      const double* positionsY, long numPositions)
+{
+   ClearXYStageSequence();
+   for (long i = 0; i < numPositions; ++i)
+      AddToXYStageSequence(positionsX[i], positionsY[i]);
+   return SendXYStageSequence();
+}
+
+
 int
 TesterZStage::Initialize()
 {
@@ -796,6 +1148,11 @@ TesterZStage::Initialize()
    CreateIntegerProperty("TriggerSequenceMaxLength",
          triggerInput_.GetSequenceMaxLengthSetting());
 
+   // Called from the trigger source (under the global mutex); the Core only
+   // takes note and appends later from its own thread
+   GetZPositionUmSetting()->GetBufferLowSignal().connect(
+         [this] { OnSequenceBufferLow(); });
+
    return DEVICE_OK;
 }
 
@@ -826,6 +1183,9 @@ TesterZStage::ClearStageSequence()
 {
    // No locking needed for access to deviceInterfaceSequenceBuffer_
    deviceInterfaceSequenceBuffer_.clear();
+
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+   GetZPositionUmSetting()->ClearTriggerSequence();
    return DEVICE_OK;
 }
 
@@ -867,6 +1227,17 @@ TesterZStage::StopStageSequence()
 }
 
 
+int
+TesterZStage::AppendToStageSequence(const double* positions,
+      long numPositions, long& numAppended)
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return GetZPositionUmSetting()->
+      AppendToTriggerSequence(positions, numPositions, numAppended);
+}
+
+
 int
 TesterAutofocus::Initialize()
 {
@@ -1086,3 +1457,389 @@ TesterSwitcher::GetGateOpen(bool& open)
 {
    return gateOpen_->Get(open);
 }
+
+
+int
+TesterDA::Initialize()
+{
+   // Guard against multiple calls
+   if (GetHub())
+      return DEVICE_OK;
+
+   int err = Super::Initialize();
+   if (err != DEVICE_OK)
+      return err;
+
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   voltage_ = FloatSetting::New(GetLogger(), this, "Voltage",
+         0.0, true, 0.0, 10.0);
+   voltage_->SetBusySetting(GetBusySetting());
+   CreateFloatProperty("Volts", voltage_);
+
+   gateOpen_ = BoolSetting::New(GetLogger(), this, "GateOpen", true);
+
+   triggerInput_.Initialize(shared_from_this(), voltage_);
+
+   CreateStringProperty("TriggerSourceDevice",
+         triggerInput_.GetSourceDeviceSetting());
+   CreateStringProperty("TriggerSourcePort",
+         triggerInput_.GetSourcePortSetting());
+   CreateIntegerProperty("TriggerSequenceMaxLength",
+         triggerInput_.GetSequenceMaxLengthSetting());
+
+   // Called from the trigger source (under the global mutex); the Core only
+   // takes note and appends later from its own thread
+   voltage_->GetBufferLowSignal().connect([this] { OnSequenceBufferLow(); });
+
+   return DEVICE_OK;
+}
+
+
+int
+TesterDA::SetGateOpen(bool open)
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   gateOpen_->MarkBusy();
+   return gateOpen_->Set(open);
+}
+
+
+int
+TesterDA::GetGateOpen(bool& open)
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return gateOpen_->Get(open);
+}
+
+
+int
+TesterDA::SetSignal(double volts)
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   voltage_->MarkBusy();
+   return voltage_->Set(volts);
+}
+
+
+int
+TesterDA::GetSignal(double& volts)
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return voltage_->Get(volts);
+}
+
+
+int
+TesterDA::GetLimits(double& minVolts, double& maxVolts)
+{
+   minVolts = voltage_->GetMin();
+   maxVolts = voltage_->GetMax();
+   return DEVICE_OK;
+}
+
+
+int
+TesterDA::IsDASequenceable(bool& isSequenceable) const
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   long len;
+   int err = voltage_->GetSequenceMaxLength(len);
+   isSequenceable = (len > 0);
+   return err;
+}
+
+
+int
+TesterDA::GetDASequenceMaxLength(long& nrEvents) const
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return voltage_->GetSequenceMaxLength(nrEvents);
+}
+
+
+int
+TesterDA::StartDASequence()
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return voltage_->StartTriggerSequence();
+}
+
+
+int
+TesterDA::StopDASequence()
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return voltage_->StopTriggerSequence();
+}
+
+
+int
+TesterDA::ClearDASequence()
+{
+   // No locking needed for access to deviceInterfaceSequenceBuffer_
+   deviceInterfaceSequenceBuffer_.clear();
+
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+   voltage_->ClearTriggerSequence();
+   return DEVICE_OK;
+}
+
+
+int
+TesterDA::AddToDASequence(double voltage)
+{
+   // No locking needed for access to deviceInterfaceSequenceBuffer_
+   deviceInterfaceSequenceBuffer_.push_back(voltage);
+   return DEVICE_OK;
+}
+
+
+int
+TesterDA::SendDASequence()
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return voltage_->SetTriggerSequence(deviceInterfaceSequenceBuffer_);
+}
+
+
+int
+TesterDA::SetDASequence(const double* voltages, long numVoltages)
+{
+   deviceInterfaceSequenceBuffer_.assign(voltages, voltages + numVoltages);
+
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+   return voltage_->SetTriggerSequence(deviceInterfaceSequenceBuffer_);
+}
+
+
+int
+TesterDA::AppendToDASequence(const double* voltages, long numVoltages,
+      long& numAppended)
+{
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   return voltage_->
+      AppendToTriggerSequence(voltages, numVoltages, numAppended);
+}
+
+
+TesterClock::TesterClock(const std::string& name) :
+   Super(name),
+   rateKHz_(1.0),
+   tickLimit_(0),
+   running_(false),
+   stopRequested_(false),
+   ticks_(0)
+{
+}
+
+
+TesterClock::~TesterClock()
+{
+   StopTicking();
+}
+
+
+int
+TesterClock::Initialize()
+{
+   // Guard against multiple calls
+   if (GetHub())
+      return DEVICE_OK;
+
+   int err = Super::Initialize();
+   if (err != DEVICE_OK)
+      return err;
+
+   TesterHub::Guard g(GetHub()->LockGlobalMutex());
+
+   // The clock's own configuration is not a logged setting: it is part of
+   // the test rig rather than of the simulated hardware state.
+   CGenericBase<Self>::CreateFloatProperty("Rate-kHz", rateKHz_, false,
+         new MM::Action<Self>(this, &Self::OnRate));
+   SetPropertyLimits("Rate-kHz", 0.001, 1000.0);
+   CGenericBase<Self>::CreateIntegerProperty("TickLimit", tickLimit_, false,
+         new MM::Action<Self>(this, &Self::OnTickLimit));
+   CGenericBase<Self>::CreateStringProperty("Running", "Off", false,
+         new MM::Action<Self>(this, &Self::OnRunning));
+   AddAllowedValue("Running", "Off");
+   AddAllowedValue("Running", "On");
+   CGenericBase<Self>::CreateStringProperty("BenchmarkReport", "{}", true,
+         new MM::Action<Self>(this, &Self::OnBenchmarkReport));
+
+   RegisterEdgeTriggerSource("Tick", tickTrigger_);
+
+   return DEVICE_OK;
+}
+
+
+int
+TesterClock::Shutdown()
+{
+   // The tick thread needs the hub (and its global mutex), so must finish
+   // first
+   StopTicking();
+   return Super::Shutdown();
+}
+
+
+int
+TesterClock::OnRate(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   // Takes effect when the clock is next started
+   if (eAct == MM::BeforeGet)
+      pProp->Set(rateKHz_);
+   else if (eAct == MM::AfterSet)
+      pProp->Get(rateKHz_);
+   return DEVICE_OK;
+}
+
+
+int
+TesterClock::OnTickLimit(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   // Takes effect when the clock is next started
+   if (eAct == MM::BeforeGet)
+   {
+      pProp->Set(tickLimit_);
+   }
+   else if (eAct == MM::AfterSet)
+   {
+      long limit;
+      pProp->Get(limit);
+      if (limit < 0)
+         return DEVICE_INVALID_PROPERTY_VALUE;
+      tickLimit_ = limit;
+   }
+   return DEVICE_OK;
+}
+
+
+int
+TesterClock::OnRunning(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      bool running;
+      {
+         std::lock_guard<std::mutex> lock(tickMutex_);
+         running = running_;
+      }
+      pProp->Set(running ? "On" : "Off");
+   }
+   else if (eAct == MM::AfterSet)
+   {
+      std::string value;
+      pProp->Get(value);
+      if (value == "On")
+         StartTicking();
+      else
+         StopTicking();
+   }
+   return DEVICE_OK;
+}
+
+
+int
+TesterClock::OnBenchmarkReport(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct != MM::BeforeGet)
+      return DEVICE_OK;
+
+   // Covers the current or most recent run
+   std::ostringstream json;
+   {
+      std::lock_guard<std::mutex> lock(tickMutex_);
+      const double elapsedMs = std::chrono::duration<double, std::milli>(
+            lastTickTime_ - startTime_).count();
+      json << "{\"ticks\":" << ticks_ <<
+         ",\"rate_khz\":" << rateKHz_ <<
+         ",\"achieved_khz\":" <<
+            (ticks_ > 1 && elapsedMs > 0.0 ? (ticks_ - 1) / elapsedMs : 0.0) <<
+         ",\"lateness\":" << lateness_.AsJSON() << "}";
+   }
+   pProp->Set(json.str().c_str());
+   return DEVICE_OK;
+}
+
+
+void
+TesterClock::StartTicking()
+{
+   StopTicking();
+
+   {
+      std::lock_guard<std::mutex> lock(tickMutex_);
+      running_ = true;
+      stopRequested_ = false;
+      ticks_ = 0;
+      lateness_.Reset();
+   }
+
+   tickThread_ = std::thread(&Self::RunTicks, this,
+         1000.0 / rateKHz_, tickLimit_);
+}
+
+
+void
+TesterClock::StopTicking()
+{
+   {
+      std::lock_guard<std::mutex> lock(tickMutex_);
+      stopRequested_ = true;
+   }
+   stopCond_.notify_all();
+
+   if (tickThread_.joinable())
+      tickThread_.join();
+}
+
+
+void
+TesterClock::RunTicks(double periodUs, long tickLimit)
+{
+   typedef BenchmarkStats::Clock Clock;
+
+   const Clock::time_point start = Clock::now();
+   {
+      std::lock_guard<std::mutex> lock(tickMutex_);
+      startTime_ = lastTickTime_ = start;
+   }
+
+   for (long tick = 0; tickLimit == 0 || tick < tickLimit; ++tick)
+   {
+      // Absolute deadlines, so that timing errors do not accumulate
+      const Clock::time_point due = start +
+         std::chrono::duration_cast<Clock::duration>(
+               std::chrono::duration<double, std::micro>(tick * periodUs));
+      {
+         std::unique_lock<std::mutex> lock(tickMutex_);
+         if (stopCond_.wait_until(lock, due, [this] { return stopRequested_; }))
+            break;
+      }
+
+      const Clock::time_point fired = Clock::now();
+      {
+         TesterHub::Guard g(GetHub()->LockGlobalMutex());
+         tickTrigger_();
+      }
+
+      std::lock_guard<std::mutex> lock(tickMutex_);
+      ++ticks_;
+      lastTickTime_ = fired;
+      lateness_.Record(fired - due);
+   }
+
+   std::lock_guard<std::mutex> lock(tickMutex_);
+   running_ = false;
+}
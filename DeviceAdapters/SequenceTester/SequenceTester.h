@@ -25,6 +25,7 @@
 
 #include "SettingLogger.h"
 
+#include "BenchmarkStats.h"
 #include "InterDevice.h"
 #include "LoggedSetting.h"
 #include "TriggerInput.h"
@@ -36,7 +37,11 @@
 #include <boost/thread.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/weak_ptr.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 
@@ -161,8 +166,16 @@ public:
    virtual int StopSequenceAcquisition();
    virtual int PrepareSequenceAcquisition() { return DEVICE_OK; }
    virtual bool IsCapturing();
-   virtual int IsExposureSequenceable(bool& f) const
-   { f = false; return DEVICE_OK; }
+
+   virtual int IsExposureSequenceable(bool& f) const;
+   virtual int GetExposureSequenceMaxLength(long& nrEvents) const;
+   virtual int StartExposureSequence();
+   virtual int StopExposureSequence();
+   virtual int ClearExposureSequence();
+   virtual int AddToExposureSequence(double exposureTimeMs);
+   virtual int SendExposureSequence() const;
+   virtual int SetExposureSequence(const double* exposureTimesMs,
+         long numExposures);
 
 private:
    // Must be called with hub global mutex held.
@@ -175,8 +188,23 @@ private:
 
    void SendSequence(bool finite, long count, bool stopOnOverflow);
 
+   // Frame trigger input: when connected, each sequence frame is generated
+   // upon a trigger from the source (e.g. a TClock) instead of free-running.
+   void UpdateFrameTriggerConnection();
+   // Called by the trigger source, with the hub global mutex held
+   void ReceiveFrameTrigger();
+   // Returns false if the sequence was stopped while waiting
+   bool WaitForFrameTrigger(BenchmarkStats::Clock::time_point& triggerTime);
+
+   int OnBenchmarkReport(MM::PropertyBase* pProp, MM::ActionType eAct);
+
 private:
+   // Triggers arriving while this many are pending are dropped (and counted),
+   // like a real camera that is not ready for the next exposure
+   static const size_t maxPendingFrameTriggers_ = 64;
+
    bool produceHumanReadableImages_;
+   bool produceBlankImages_;
    long imageWidth_;
    long imageHeight_;
 
@@ -192,6 +220,17 @@ private:
 
    bool stopSequence_; // Guarded by sequenceMutex_
 
+   // Guarded by sequenceMutex_
+   boost::condition_variable frameTriggerCond_;
+   std::deque<BenchmarkStats::Clock::time_point> pendingFrameTriggers_;
+   bool frameTriggered_;
+   bool awaitingFrameTriggers_; // False once all frames have been generated
+   size_t droppedFrameTriggers_;
+   size_t sequenceFrames_;
+   BenchmarkStats::Clock::time_point sequenceStartTime_;
+   BenchmarkStats::Clock::time_point lastFrameTime_;
+   BenchmarkStats frameLatency_;
+
    // Note: boost::future in more recent versions
    boost::unique_future<void> sequenceFuture_;
    boost::thread sequenceThread_;
@@ -199,6 +238,13 @@ private:
    FloatSetting::Ptr exposureSetting_;
    IntegerSetting::Ptr binningSetting_;
 
+   TriggerInput exposureTriggerInput_;
+   std::vector<double> exposureSequenceBuffer_;
+
+   StringSetting::Ptr frameTriggerSourceDevice_;
+   StringSetting::Ptr frameTriggerSourcePort_;
+   boost::signals2::connection frameTriggerConnection_;
+
    EdgeTriggerSignal exposureStartEdgeTrigger_;
    EdgeTriggerSignal exposureStopEdgeTrigger_;
 };
@@ -246,10 +292,22 @@ public:
    virtual int GetLimitsUm(double& xMin, double& xMax, double& yMin, double& yMax);
    virtual double GetStepSizeXUm() { return 1.0 / stepsPerUm; }
    virtual double GetStepSizeYUm() { return 1.0 / stepsPerUm; }
-   virtual int IsXYStageSequenceable(bool& isSequenceable) const
-   { isSequenceable = false; return DEVICE_OK; }
+
+   virtual int IsXYStageSequenceable(bool& isSequenceable) const;
+   virtual int GetXYStageSequenceMaxLength(long& nrEvents) const;
+   virtual int StartXYStageSequence();
+   virtual int StopXYStageSequence();
+   virtual int ClearXYStageSequence();
+   virtual int AddToXYStageSequence(double positionX, double positionY);
+   virtual int SendXYStageSequence();
+   virtual int SetXYStageSequence(const double* positionsX,
+         const double* positionsY, long numPositions);
 
 private:
+   TriggerInput triggerInput_;
+   std::vector<long> xSequenceBuffer_;
+   std::vector<long> ySequenceBuffer_;
+
    IntegerSetting::Ptr xPositionSteps_;
    IntegerSetting::Ptr yPositionSteps_;
    OneShotSetting::Ptr home_;
@@ -313,6 +371,8 @@ public:
    virtual int SendStageSequence();
    virtual int StartStageSequence();
    virtual int StopStageSequence();
+   virtual int AppendToStageSequence(const double* positions,
+         long numPositions, long& numAppended);
 
    virtual bool IsContinuousFocusDrive() const { return false; }
 
@@ -393,3 +453,85 @@ private:
    IntegerSetting::Ptr position_;
    BoolSetting::Ptr gateOpen_;
 };
+
+
+class TesterDA : public TesterBase<CSignalIOBase, TesterDA>
+{
+   typedef TesterDA Self;
+   typedef TesterBase< ::CSignalIOBase, TesterDA > Super;
+
+public:
+   TesterDA(const std::string& name) : Super(name) {}
+
+   virtual int Initialize();
+
+   virtual int SetGateOpen(bool open);
+   virtual int GetGateOpen(bool& open);
+   virtual int SetSignal(double volts);
+   virtual int GetSignal(double& volts);
+   virtual int GetLimits(double& minVolts, double& maxVolts);
+
+   virtual int IsDASequenceable(bool& isSequenceable) const;
+   virtual int GetDASequenceMaxLength(long& nrEvents) const;
+   virtual int StartDASequence();
+   virtual int StopDASequence();
+   virtual int ClearDASequence();
+   virtual int AddToDASequence(double voltage);
+   virtual int SendDASequence();
+   virtual int SetDASequence(const double* voltages, long numVoltages);
+   virtual int AppendToDASequence(const double* voltages, long numVoltages,
+         long& numAppended);
+
+private:
+   TriggerInput triggerInput_;
+   std::vector<double> deviceInterfaceSequenceBuffer_;
+   FloatSetting::Ptr voltage_;
+   BoolSetting::Ptr gateOpen_;
+};
+
+
+// Simulated hardware trigger clock. While running, fires its "Tick" edge
+// trigger at a fixed rate, so that sequenced devices (and the camera's frame
+// trigger input) can be driven at kHz rates without real hardware. Ticks are
+// scheduled at absolute times from the start; a tick that cannot be fired on
+// time is fired late rather than skipped, and the lateness is reported.
+class TesterClock : public TesterBase<CGenericBase, TesterClock>
+{
+   typedef TesterClock Self;
+   typedef TesterBase< ::CGenericBase, TesterClock > Super;
+
+public:
+   TesterClock(const std::string& name);
+   virtual ~TesterClock();
+
+   virtual int Initialize();
+   virtual int Shutdown();
+
+private:
+   int OnRate(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnTickLimit(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnRunning(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnBenchmarkReport(MM::PropertyBase* pProp, MM::ActionType eAct);
+
+   // Must not be called with the hub global mutex held
+   void StartTicking();
+   void StopTicking();
+   void RunTicks(double periodUs, long tickLimit);
+
+private:
+   double rateKHz_;
+   long tickLimit_; // Zero for unlimited
+
+   EdgeTriggerSignal tickTrigger_;
+
+   std::thread tickThread_;
+
+   std::mutex tickMutex_; // Guards the members below
+   std::condition_variable stopCond_;
+   bool running_;
+   bool stopRequested_;
+   long ticks_;
+   BenchmarkStats::Clock::time_point startTime_;
+   BenchmarkStats::Clock::time_point lastTickTime_;
+   BenchmarkStats lateness_;
+};
@@ -32,7 +32,6 @@ TriggerInput::Initialize(InterDevice::Ptr device,
       LoggedSetting::Ptr sequencedSetting)
 {
    device_ = device;
-   sequencedSetting_ = sequencedSetting;
 
    triggerSourceDevice_ = StringSetting::New(device_->GetLogger(),
          device_.get(), settingNamePrefix_ + "TriggerSourceDevice");
@@ -47,14 +46,25 @@ TriggerInput::Initialize(InterDevice::Ptr device,
    sequenceMaxLength_ = IntegerSetting::New(device_->GetLogger(),
          device_.get(), settingNamePrefix_ + "TriggerSequenceMaxLength",
          0, false);
-   sequencedSetting_->SetSequenceMaxLengthSetting(sequenceMaxLength_);
+
+   AddSequencedSetting(sequencedSetting);
+}
+
+
+void
+TriggerInput::AddSequencedSetting(LoggedSetting::Ptr sequencedSetting)
+{
+   sequencedSetting->SetSequenceMaxLengthSetting(sequenceMaxLength_);
+   sequencedSettings_.push_back(sequencedSetting);
+   UpdateTriggerConnection();
 }
 
 
 void
 TriggerInput::UpdateTriggerConnection()
 {
-   sequencedSetting_->DisconnectEdgeTriggerSource();
+   for (size_t i = 0; i < sequencedSettings_.size(); ++i)
+      sequencedSettings_[i]->DisconnectEdgeTriggerSource();
 
    const std::string sourceDevice = triggerSourceDevice_->Get();
    const std::string sourcePort = triggerSourcePort_->Get();
@@ -69,5 +79,6 @@ TriggerInput::UpdateTriggerConnection()
    if (!signal)
       return;
 
-   sequencedSetting_->ConnectToEdgeTriggerSource(*signal);
+   for (size_t i = 0; i < sequencedSettings_.size(); ++i)
+      sequencedSettings_[i]->ConnectToEdgeTriggerSource(*signal);
 }
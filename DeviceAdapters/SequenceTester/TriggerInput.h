@@ -27,6 +27,7 @@
 #include "LoggedSetting.h"
 
 #include <string>
+#include <vector>
 
 
 // Common implementation for devices that receive trigger input
@@ -35,7 +36,7 @@ class TriggerInput
    const std::string settingNamePrefix_;
 
    InterDevice::Ptr device_;
-   LoggedSetting::Ptr sequencedSetting_;
+   std::vector<LoggedSetting::Ptr> sequencedSettings_;
 
    StringSetting::Ptr triggerSourceDevice_;
    StringSetting::Ptr triggerSourcePort_;
@@ -46,10 +47,11 @@ public:
       settingNamePrefix_(settingNamePrefix)
    {}
 
-   // We may in the future need a mechanism to sequence more than one setting
-   // in parallel with the same trigger input. For now, just allow one.
    void Initialize(InterDevice::Ptr device,
          LoggedSetting::Ptr sequencedSetting);
+   // Sequences another setting in parallel with the same trigger input (e.g.
+   // the Y axis of an XY stage). Call after Initialize().
+   void AddSequencedSetting(LoggedSetting::Ptr sequencedSetting);
 
    StringSetting::Ptr GetSourceDeviceSetting()
    { return triggerSourceDevice_; }
@@ -0,0 +1,165 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          StreamedSequence-Tests.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Streamed stage sequences, longer than the device can hold,
+//                run through the sequence tester by the Core
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include <gtest/gtest.h>
+
+#include "MMCore.h"
+#include "MockDeviceAdapter.h"
+#include "ModuleInterface.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* const clockLabel = "TClock-0";
+const char* const stageLabel = "TZStage-0";
+
+// Serves the devices of this module (linked into the test) to the Core
+class SequenceTesterAdapter : public MockDeviceAdapter
+{
+public:
+   void InitializeModuleData(RegisterDeviceFunc registerDevice) override
+   { registerDevice("THub", MM::HubDevice, "Hub"); }
+   MM::Device* CreateDevice(const char* name) override
+   { return ::CreateDevice(name); }
+   void DeleteDevice(MM::Device* device) override
+   { ::DeleteDevice(device); }
+};
+
+// The Core appends from its own thread, so wait for it
+bool WaitFor(const std::function<bool()>& done)
+{
+   const auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::seconds(10);
+   while (!done())
+   {
+      if (std::chrono::steady_clock::now() > deadline)
+         return false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+   }
+   return true;
+}
+
+class StreamedSequenceTest : public ::testing::Test
+{
+protected:
+   static const long maxLength = 4;
+
+   void SetUp() override
+   {
+      core_.loadMockDeviceAdapter("SequenceTester", &adapter_);
+      core_.loadDevice("THub", "SequenceTester", "THub");
+      core_.initializeDevice("THub");
+      for (const char* device : { clockLabel, stageLabel })
+      {
+         core_.loadDevice(device, "SequenceTester", device);
+         core_.setParentLabel(device, "THub");
+         core_.initializeDevice(device);
+      }
+
+      core_.setProperty(stageLabel, "TriggerSequenceMaxLength", maxLength);
+      core_.setProperty(stageLabel, "TriggerSourceDevice", clockLabel);
+      core_.setProperty(stageLabel, "TriggerSourcePort", "Tick");
+      core_.setProperty(clockLabel, "Rate-kHz", 1000.0);
+      core_.setProperty(clockLabel, "TickLimit", 1L);
+   }
+
+   void TearDown() override
+   {
+      core_.unloadAllDevices();
+   }
+
+   // Fires a single trigger and returns once the clock has stopped
+   void Tick()
+   {
+      core_.setProperty(clockLabel, "Running", "On");
+      ASSERT_TRUE(WaitFor([&]
+         { return core_.getProperty(clockLabel, "Running") == "Off"; }));
+   }
+
+   SequenceTesterAdapter adapter_;
+   CMMCore core_;
+};
+
+} // namespace
+
+TEST_F(StreamedSequenceTest, PositionsFollowTheSequenceInOrder)
+{
+   std::vector<double> positions;
+   for (int i = 0; i < 11; ++i)
+      positions.push_back(10.0 + i);
+
+   core_.setPosition(stageLabel, -1.0);
+   core_.loadStreamingStageSequence(stageLabel, positions);
+   const long total = static_cast<long>(positions.size());
+   EXPECT_EQ(total - maxLength,
+      core_.getStreamingStageSequenceRemaining(stageLabel));
+   core_.startStageSequence(stageLabel);
+
+   // Follow the device buffer: the stage asks for more once it is down to
+   // half, and the Core then fills it up again
+   long buffered = maxLength;
+   long remaining = total - maxLength;
+   for (long i = 0; i < total; ++i)
+   {
+      Tick();
+      EXPECT_EQ(positions[i], core_.getPosition(stageLabel)) << "tick " << i;
+
+      --buffered;
+      if (buffered <= maxLength / 2 && remaining > 0)
+      {
+         const long refill = (std::min)(maxLength - buffered, remaining);
+         buffered += refill;
+         remaining -= refill;
+      }
+      ASSERT_TRUE(WaitFor([&] {
+         return core_.getStreamingStageSequenceRemaining(stageLabel) ==
+            remaining;
+      })) << "tick " << i;
+   }
+
+   // Used once, not repeated: running dry keeps the last position
+   Tick();
+   EXPECT_EQ(positions.back(), core_.getPosition(stageLabel));
+
+   core_.stopStageSequence(stageLabel);
+}
+
+TEST_F(StreamedSequenceTest, StoppingCancelsTheStream)
+{
+   std::vector<double> positions(3 * maxLength, 5.0);
+   core_.loadStreamingStageSequence(stageLabel, positions);
+   core_.startStageSequence(stageLabel);
+   Tick();
+   EXPECT_EQ(5.0, core_.getPosition(stageLabel));
+
+   core_.stopStageSequence(stageLabel);
+   EXPECT_EQ(0, core_.getStreamingStageSequenceRemaining(stageLabel));
+}
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
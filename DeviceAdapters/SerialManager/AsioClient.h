@@ -28,7 +28,10 @@
 #include <boost/asio.hpp>
 #include <boost/asio/serial_port.hpp>
 #include <boost/bind/bind.hpp>
+#include <boost/chrono.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <deque>
 #include <exception>
@@ -62,7 +65,8 @@ public:
       serialPortImplementation_(ioService, nativeHandle),
       pSerialPortAdapter_(pPort),
       device_(deviceName),
-      shutDownInProgress_(false)
+      shutDownInProgress_(false),
+      eventDrivenReads_(false)
    {
       Construct(deviceName, baud, flow, parity, stopBits, dataBits);
    }
@@ -81,7 +85,8 @@ public:
       serialPortImplementation_(ioService, deviceName),
       pSerialPortAdapter_(pPort),
       device_(deviceName),
-      shutDownInProgress_(false)
+      shutDownInProgress_(false),
+      eventDrivenReads_(false)
    {
       Construct(deviceName, baud, flow, parity, stopBits, dataBits);
    }
@@ -304,7 +309,7 @@ public:
    {
       // clear read buffer;
       {
-         MMThreadGuard g(readBufferLock_);
+         boost::lock_guard<boost::mutex> g(readBufferLock_);
          data_read_.clear();
       }
 
@@ -320,7 +325,7 @@ public:
    bool ReadOneCharacter(char& msg)
    {
       bool retval = false;
-      MMThreadGuard g(readBufferLock_);
+      boost::lock_guard<boost::mutex> g(readBufferLock_);
       if (0 < data_read_.size())
       {
          retval = true;
@@ -330,8 +335,32 @@ public:
       return retval;
    }
 
+   // read one character, waiting for it to arrive if the buffer is empty;
+   // ret. is false if no character arrived before the deadline.
+   bool ReadOneCharacter(char& msg,
+         const boost::chrono::steady_clock::time_point& deadline)
+   {
+      boost::unique_lock<boost::mutex> g(readBufferLock_);
+      while (data_read_.empty())
+      {
+         if (dataAvailable_.wait_until(g, deadline) == boost::cv_status::timeout)
+         {
+            if (data_read_.empty())
+               return false;
+         }
+      }
+      msg = data_read_.front();
+      data_read_.pop_front();
+      return true;
+   }
+
    void ShutDownInProgress(const bool v){ shutDownInProgress_ = v;};
 
+   // When enabled, the read loop restarts immediately after each completed
+   // read instead of yielding for 1 ms, so that waiting readers are woken
+   // as soon as the data arrives.
+   void EventDrivenReads(const bool v){ eventDrivenReads_ = v;};
+
 
 private:
    // Call the owning device's LogMessage(). This is the only reason to keep a
@@ -363,13 +392,15 @@ private:
       if (!error)
       { // read completed, so process the data
          {
-            MMThreadGuard g(readBufferLock_);
+            boost::lock_guard<boost::mutex> g(readBufferLock_);
             for(unsigned int ib = 0; ib < bytes_transferred; ++ib)
             {
                data_read_.push_back(read_msg_[ib]);
             }
          }
-         CDeviceUtils::SleepMs(1);
+         dataAvailable_.notify_all();
+         if (!eventDrivenReads_)
+            CDeviceUtils::SleepMs(1);
          ReadStart(); // start waiting for another asynchronous read again
       }
       else
@@ -466,8 +497,10 @@ private:
    SerialPort* pSerialPortAdapter_;
    std::string device_;
 
-   MMThreadLock readBufferLock_;
+   boost::mutex readBufferLock_;
+   boost::condition_variable dataAvailable_; // signaled when data_read_ grows
    MMThreadLock writeBufferLock_;
    MMThreadLock implementationLock_;
    bool shutDownInProgress_;
+   bool eventDrivenReads_;
 };
@@ -39,6 +39,7 @@
 #endif
 
 #include <boost/bind/bind.hpp>
+#include <boost/chrono.hpp>
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
@@ -92,6 +93,9 @@ const char* g_Parity_Even = "Even";
 const char* g_Parity_Mark = "Mark";
 const char* g_Parity_Space = "Space";
 
+const char* g_EventDrivenRead_Enable = "Enable";
+const char* g_EventDrivenRead_Disable = "Disable";
+
 
 /*
  * Tests whether given serial port can be used by opening it
@@ -370,7 +374,8 @@ SerialPort::SerialPort(const char* portName) :
    pService_(0),
    pPort_(0),
    pThread_(0),
-   verbose_(true)
+   verbose_(true),
+   eventDrivenReads_(false)
 #ifdef WIN32
    ,
    dtrEnable_(false),
@@ -466,6 +471,13 @@ SerialPort::SerialPort(const char* portName) :
    (void)CreateProperty("Verbose", (verbose_?"1":"0"), MM::Integer, false, pActTD, true);
    AddAllowedValue("Verbose", "0");
    AddAllowedValue("Verbose", "1");
+
+   // wait for incoming data instead of polling for it in GetAnswer()
+   CPropertyAction* pActEventDriven = new CPropertyAction(this, &SerialPort::OnEventDrivenRead);
+   ret = CreateProperty("EventDrivenRead", g_EventDrivenRead_Disable, MM::String, false, pActEventDriven, true);
+   assert(ret == DEVICE_OK);
+   AddAllowedValue("EventDrivenRead", g_EventDrivenRead_Disable);
+   AddAllowedValue("EventDrivenRead", g_EventDrivenRead_Enable);
 }
 
 SerialPort::~SerialPort()
@@ -554,6 +566,7 @@ int SerialPort::Initialize()
       LogMessage(e.what());
       return ERR_OPEN_FAILED;
    }
+   pPort_->EventDrivenReads(eventDrivenReads_);
 
    try
    {
@@ -771,6 +784,9 @@ int SerialPort::GetAnswer(char* answer, unsigned bufLen, const char* term)
       LogMessage("BUFFER_OVERRUN error occured!");
       return ERR_BUFFER_OVERRUN;
    }
+   if (eventDrivenReads_)
+      return GetAnswerEventDriven(answer, bufLen, term);
+
    std::ostringstream logMsg;
    unsigned long answerOffset = 0;
    memset(answer,0,bufLen);
@@ -837,6 +853,71 @@ int SerialPort::GetAnswer(char* answer, unsigned bufLen, const char* term)
    return ERR_TERM_TIMEOUT;
 }
 
+// Same as the polling loop in GetAnswer(), except that we sleep on the
+// AsioClient's read buffer until the next character arrives, so the answer is
+// returned as soon as the terminator has been received. Timing is based on the
+// steady clock rather than the core's clock.
+int SerialPort::GetAnswerEventDriven(char* answer, unsigned bufLen, const char* term)
+{
+   typedef boost::chrono::steady_clock Clock;
+
+   unsigned long answerOffset = 0;
+   memset(answer, 0, bufLen);
+   char theData = 0;
+
+   const bool hasTerm = term && term[0];
+   const Clock::time_point startTime = Clock::now();
+   Clock::time_point deadline = startTime +
+      boost::chrono::microseconds(static_cast<long long>(answerTimeoutMs_ * 1000.0));
+   // For bug-compatibility with the polling loop, whose 5.0 * 1000.0 is in
+   // microseconds (MM::MMTime), not milliseconds
+   const Clock::time_point nonTerminatedDeadline = startTime +
+      boost::chrono::microseconds(5000);
+   if (!hasTerm && nonTerminatedDeadline < deadline)
+      deadline = nonTerminatedDeadline;
+
+   while (pPort_->ReadOneCharacter(theData, deadline))
+   {
+      if (bufLen <= answerOffset)
+      {
+         if (bufLen > 0)
+            answer[bufLen - 1] = '\0';
+         LogMessage("BUFFER_OVERRUN error occured!");
+         return ERR_BUFFER_OVERRUN;
+      }
+      answer[answerOffset++] = theData;
+
+      if (hasTerm)
+      {
+         char* termPos = strstr(answer, term);
+         if (termPos != 0) // found the terminator
+         {
+            LogAsciiCommunication("GetAnswer", true, answer);
+
+            // erase the terminator from the answer:
+            *termPos = '\0';
+
+            return DEVICE_OK;
+         }
+      }
+   }
+
+   if (!hasTerm && deadline == nonTerminatedDeadline)
+   {
+      LogAsciiCommunication("GetAnswer", true, answer);
+      const long long millisecs =
+         boost::chrono::duration_cast<boost::chrono::milliseconds>(
+               Clock::now() - startTime).count();
+      LogMessage(("GetAnswer without terminator returning after " +
+               boost::lexical_cast<std::string>(millisecs) +
+               "msec").c_str(), true);
+      return DEVICE_OK;
+   }
+
+   LogMessage("TERM_TIMEOUT error occured!");
+   return ERR_TERM_TIMEOUT;
+}
+
 int SerialPort::Write(const unsigned char* buf, unsigned long bufLen)
 {
    if (!initialized_)
@@ -1081,6 +1162,25 @@ int SerialPort::OnVerbose(MM::PropertyBase* pProp, MM::ActionType eAct)
 }
 
 
+int SerialPort::OnEventDrivenRead(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      pProp->Set(eventDrivenReads_ ? g_EventDrivenRead_Enable : g_EventDrivenRead_Disable);
+   }
+   else if (eAct == MM::AfterSet)
+   {
+      std::string value;
+      pProp->Get(value);
+      eventDrivenReads_ = (value == g_EventDrivenRead_Enable);
+      if (initialized_)
+         pPort_->EventDrivenReads(eventDrivenReads_);
+   }
+
+   return DEVICE_OK;
+}
+
+
 int SerialPort::OnDelayBetweenCharsMs(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
    if (eAct == MM::BeforeGet)
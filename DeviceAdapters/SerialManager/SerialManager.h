@@ -113,6 +113,7 @@ public:
    int OnTimeout(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnDelayBetweenCharsMs(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnVerbose(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnEventDrivenRead(MM::PropertyBase* pProp, MM::ActionType eAct);
 
    void AddReference() {refCount_++;}
    void RemoveReference() {refCount_--;}
@@ -146,6 +147,7 @@ private:
    // the worker thread
    boost::thread* pThread_;
    bool verbose_; // if false, turn off LogBinaryMessage even in Debug Log
+   bool eventDrivenReads_; // if true, GetAnswer() blocks on arrival of data instead of polling
 
 
 #ifdef _WIN32
@@ -155,6 +157,7 @@ private:
    int OnDTR(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnFastUSB2Serial(MM::PropertyBase* pProp, MM::ActionType eAct);
 #endif
+   int GetAnswerEventDriven(char* answer, unsigned bufLength, const char* term);
    void LogAsciiCommunication(const char* prefix, bool isInput, const std::string& content);
    void LogBinaryCommunication(const char* prefix, bool isInput, const unsigned char* content, std::size_t length);
 };
@@ -0,0 +1,227 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          PtyRoundTrip-Tests.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Command/response tests for SerialPort against a simulated
+//                device on a pseudo-terminal (Linux/Unix only)
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include <gtest/gtest.h>
+
+#include "SerialManager.h"
+
+#include <boost/chrono.hpp>
+#include <boost/thread.hpp>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <iostream>
+#include <string>
+
+
+// The master side of a pseudo-terminal pair, acting as a device that answers
+// each '\r'-terminated command with a fixed 20-byte response.
+class PtyResponder
+{
+   int masterFd_;
+   std::string slaveName_;
+   std::string response_;
+   std::atomic<bool> stop_;
+   boost::thread thread_;
+
+public:
+   explicit PtyResponder(const std::string& response) :
+      masterFd_(-1),
+      response_(response),
+      stop_(false)
+   {
+      masterFd_ = posix_openpt(O_RDWR | O_NOCTTY);
+      if (masterFd_ < 0 || grantpt(masterFd_) != 0 ||
+            unlockpt(masterFd_) != 0)
+         return;
+      slaveName_ = ptsname(masterFd_);
+   }
+
+   ~PtyResponder()
+   {
+      Stop();
+      if (masterFd_ >= 0)
+         close(masterFd_);
+   }
+
+   bool IsOpen() const { return !slaveName_.empty(); }
+   const std::string& SlaveName() const { return slaveName_; }
+
+   void Start()
+   { thread_ = boost::thread(boost::bind(&PtyResponder::Run, this)); }
+
+   void Stop()
+   {
+      stop_ = true;
+      if (thread_.joinable())
+         thread_.join();
+   }
+
+private:
+   void Run()
+   {
+      std::string command;
+      while (!stop_)
+      {
+         struct pollfd pfd = { masterFd_, POLLIN, 0 };
+         if (poll(&pfd, 1, 10) <= 0)
+            continue;
+         char buf[256];
+         ssize_t n = read(masterFd_, buf, sizeof(buf));
+         if (n <= 0)
+            continue;
+         for (ssize_t i = 0; i < n; ++i)
+         {
+            if (buf[i] == '\r')
+            {
+               if (command != "SILENT")
+                  (void)write(masterFd_, response_.data(), response_.size());
+               command.clear();
+            }
+            else
+               command += buf[i];
+         }
+      }
+   }
+};
+
+
+class PtyTest : public ::testing::Test
+{
+protected:
+   static const std::string response_;
+   PtyResponder* responder_;
+   SerialPort* port_;
+
+   PtyTest() : responder_(0), port_(0) {}
+
+   void OpenPort(bool eventDriven)
+   {
+      responder_ = new PtyResponder(response_);
+      ASSERT_TRUE(responder_->IsOpen());
+      responder_->Start();
+
+      port_ = new SerialPort(responder_->SlaveName().c_str());
+      ASSERT_EQ(DEVICE_OK, port_->SetProperty("EventDrivenRead",
+               eventDriven ? "Enable" : "Disable"));
+      ASSERT_EQ(DEVICE_OK, port_->SetProperty("AnswerTimeout", "200"));
+      ASSERT_EQ(DEVICE_OK, port_->SetProperty("Verbose", "0"));
+      ASSERT_EQ(DEVICE_OK, port_->Initialize());
+   }
+
+   virtual void TearDown()
+   {
+      delete port_;
+      delete responder_;
+   }
+};
+
+// 19 characters plus the terminator
+const std::string PtyTest::response_ = "0123456789ABCDEFGHI\n";
+
+
+class PtyRoundTripTest : public PtyTest,
+   public ::testing::WithParamInterface<bool>
+{
+protected:
+   virtual void SetUp() { OpenPort(GetParam()); }
+};
+
+
+// Without a core callback, the polling mode has no clock to time out with, so
+// timeouts are only tested in event-driven mode.
+TEST_F(PtyTest, EventDrivenTimesOutWhenNoAnswer)
+{
+   OpenPort(true);
+   ASSERT_EQ(DEVICE_OK, port_->SetCommand("SILENT", "\r"));
+   char answer[64];
+   EXPECT_EQ(ERR_TERM_TIMEOUT, port_->GetAnswer(answer, sizeof(answer), "\n"));
+}
+
+TEST_P(PtyRoundTripTest, StripsTerminatorFromAnswer)
+{
+   ASSERT_EQ(DEVICE_OK, port_->SetCommand("STATUS", "\r"));
+   char answer[64];
+   ASSERT_EQ(DEVICE_OK, port_->GetAnswer(answer, sizeof(answer), "\n"));
+   EXPECT_EQ(std::string("0123456789ABCDEFGHI"), answer);
+}
+
+TEST_P(PtyRoundTripTest, RoundTripLatency)
+{
+   typedef boost::chrono::steady_clock Clock;
+   const int nRoundTrips = 200;
+   char answer[64];
+
+   // 20-byte command (including terminator) and 20-byte response
+   const std::string command = "ABCDEFGHIJKLMNOPQRS";
+
+   Clock::time_point start = Clock::now();
+   for (int i = 0; i < nRoundTrips; ++i)
+   {
+      ASSERT_EQ(DEVICE_OK, port_->SetCommand(command.c_str(), "\r"));
+      ASSERT_EQ(DEVICE_OK, port_->GetAnswer(answer, sizeof(answer), "\n"));
+   }
+   double usPerRoundTrip = boost::chrono::duration<double, boost::micro>(
+         Clock::now() - start).count() / nRoundTrips;
+
+   std::cout << (GetParam() ? "Event-driven" : "Polling") <<
+      " round trip: " << usPerRoundTrip << " us" << std::endl;
+}
+
+// Writing all commands before reading the first answer, as
+// CMMCore::transactSerialPortCommands() does, pays one round trip per batch
+// instead of one per command.
+TEST_P(PtyRoundTripTest, PipelinedRoundTripLatency)
+{
+   typedef boost::chrono::steady_clock Clock;
+   const int nBatches = 50;
+   const int batchSize = 4;
+   char answer[64];
+
+   Clock::time_point start = Clock::now();
+   for (int i = 0; i < nBatches; ++i)
+   {
+      for (int j = 0; j < batchSize; ++j)
+         ASSERT_EQ(DEVICE_OK, port_->SetCommand("ABCDEFGHIJKLMNOPQRS", "\r"));
+      for (int j = 0; j < batchSize; ++j)
+      {
+         ASSERT_EQ(DEVICE_OK, port_->GetAnswer(answer, sizeof(answer), "\n"));
+         ASSERT_EQ(std::string("0123456789ABCDEFGHI"), answer);
+      }
+   }
+   double usPerCommand = boost::chrono::duration<double, boost::micro>(
+         Clock::now() - start).count() / (nBatches * batchSize);
+
+   std::cout << (GetParam() ? "Event-driven" : "Polling") <<
+      " pipelined: " << usPerCommand << " us per command" << std::endl;
+}
+
+INSTANTIATE_TEST_CASE_P(ReadModeCase, PtyRoundTripTest,
+   ::testing::Values(false, true));
+
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
@@ -30,6 +30,9 @@
 
 #include "Util.h"
 
+#include <algorithm>
+#include <future>
+
 using boost::asio::ip::tcp;
 
 const char* deviceName = "TCP/IP serial port adapter";
@@ -42,7 +45,10 @@ TCPIPPort::TCPIPPort(int index) :
 	port_(0),
 	initialized_(false),
 	sock_(ios_),
-	answerTimeoutMs_(500)
+	answerTimeoutMs_(500),
+	noDelay_(false),
+	socketBufferSize_(0),
+	rxBuffer_(65536)
 {
 	SetErrorText(ERR_BUFFER_OVERRUN, "Buffer overrun occured during read");
 	SetErrorText(ERR_TERM_TIMEOUT, "Timeout occured during init or read");
@@ -52,10 +58,19 @@ TCPIPPort::TCPIPPort(int index) :
 	CreateProperty("Host", "127.0.0.1", MM::String, false, new CPropertyAction(this, &TCPIPPort::OnHost), true);
 	CreateProperty("TCP Port", "0", MM::Integer, false, new CPropertyAction(this, &TCPIPPort::OnPort), true);
 	CreateProperty("Answer timeout", "500", MM::Integer, false, new CPropertyAction(this, &TCPIPPort::OnAnswerTimeout), false);
+
+	// Disable Nagle's algorithm, so that short commands are sent immediately
+	CreateProperty("TCP no delay", "0", MM::Integer, false, new CPropertyAction(this, &TCPIPPort::OnNoDelay), true);
+	AddAllowedValue("TCP no delay", "0");
+	AddAllowedValue("TCP no delay", "1");
+
+	// Kernel send/receive buffer size in bytes (0: leave the system default)
+	CreateProperty("Socket buffer size", "0", MM::Integer, false, new CPropertyAction(this, &TCPIPPort::OnSocketBufferSize), true);
 }
 
 TCPIPPort::~TCPIPPort()
 {
+	Shutdown();
 }
 
 bool TCPIPPort::Busy()
@@ -82,7 +97,10 @@ ERRH_START
 
 	boost::asio::deadline_timer deadline(ios_);
 	deadline.expires_from_now(boost::posix_time::millisec(answerTimeoutMs_));
-	deadline.async_wait(boost::lambda::bind(&TCPIPPort::close_sock, this));
+	deadline.async_wait([this](const boost::system::error_code& e) {
+		if (!e) // Not cancelled
+			close_sock();
+	});
 	
 	boost::asio::async_connect(sock_, it, boost::lambda::var(ec) = boost::lambda::_1);
 
@@ -90,6 +108,25 @@ ERRH_START
 
 	if (ec || !sock_.is_open())
 		return ERR_TERM_TIMEOUT;
+	deadline.cancel();
+
+	if (noDelay_)
+		sock_.set_option(tcp::no_delay(true));
+	if (socketBufferSize_ > 0)
+	{
+		sock_.set_option(boost::asio::socket_base::receive_buffer_size(socketBufferSize_));
+		sock_.set_option(boost::asio::socket_base::send_buffer_size(socketBufferSize_));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(rxMutex_);
+		rxBuffer_.clear();
+		rxError_ = boost::system::error_code();
+	}
+	ios_.reset();
+	ioWork_.reset(new boost::asio::io_service::work(ios_));
+	StartReceive();
+	ioThread_ = std::thread([this] { ios_.run(); });
 
 	initialized_ = true;
 
@@ -104,13 +141,62 @@ ERRH_START
 	if (!initialized_)
 		return DEVICE_OK;
 
-	sock_.shutdown(tcp::socket::shutdown_both);
-	sock_.close();
-
 	initialized_ = false;
+
+	ioWork_.reset();
+	ios_.stop();
+	if (ioThread_.joinable())
+		ioThread_.join();
+
+	boost::system::error_code ec;
+	sock_.shutdown(tcp::socket::shutdown_both, ec); // Peer may have closed already
+	sock_.close();
 ERRH_END
 }
 
+void TCPIPPort::StartReceive()
+{
+	sock_.async_read_some(boost::asio::buffer(rxChunk_, sizeof(rxChunk_)),
+		[this](const boost::system::error_code& ec, std::size_t bytes) {
+			OnReceive(ec, bytes);
+		});
+}
+
+void TCPIPPort::OnReceive(const boost::system::error_code& ec, std::size_t bytes)
+{
+	{
+		std::lock_guard<std::mutex> lock(rxMutex_);
+		if (bytes > rxBuffer_.reserve())
+			rxBuffer_.set_capacity((std::max)(2 * rxBuffer_.capacity(), rxBuffer_.size() + bytes));
+		rxBuffer_.insert(rxBuffer_.end(), rxChunk_, rxChunk_ + bytes);
+		if (ec)
+			rxError_ = ec;
+	}
+	rxCond_.notify_all();
+
+	if (!ec)
+		StartReceive();
+	else if (ec != boost::asio::error::operation_aborted)
+		LogMessage(("Receive failed: " + ec.message()).c_str());
+}
+
+// Writes asynchronously on the I/O thread (so that receiving continues while
+// a large write is in progress) and waits for the write to finish.
+// Throws boost::system::system_error on failure.
+void TCPIPPort::WriteOnIoThread(const void* buf, std::size_t len)
+{
+	std::promise<boost::system::error_code> result;
+	ios_.post([&] {
+		boost::asio::async_write(sock_, boost::asio::buffer(buf, len),
+			[&](const boost::system::error_code& ec, std::size_t) {
+				result.set_value(ec);
+			});
+	});
+	boost::system::error_code ec = result.get_future().get();
+	if (ec)
+		throw boost::system::system_error(ec);
+}
+
 void TCPIPPort::GetName(char* name) const
 {
 	strcpy(name, GetStringName().c_str());
@@ -137,7 +223,7 @@ int TCPIPPort::SetCommand(const char* command, const char* term)
 	if (term != 0)
 		cmd += term;
 
-	boost::asio::write(sock_, boost::asio::buffer(cmd));
+	WriteOnIoThread(cmd.data(), cmd.size());
 
 	LogAsciiCommunication("SetCommand", false, cmd);
 	ERRH_END
@@ -155,71 +241,70 @@ ERRH_START
 		LogMessage("BUFFER_OVERRUN error occured!");
 		return ERR_BUFFER_OVERRUN;
 	}
-	std::ostringstream logMsg;
 	unsigned long answerOffset = 0;
 	memset(txt, 0, maxChars);
-	char theData = 0;
 
-	MM::MMTime startTime = GetCurrentMMTime();
-	MM::MMTime answerTimeout(answerTimeoutMs_ * 1000.0);
-	MM::MMTime nonTerminatedAnswerTimeout(5.0 * 1000.0); // For bug-compatibility
-	while ((GetCurrentMMTime() - startTime) < answerTimeout)
+	typedef std::chrono::steady_clock Clock;
+	const bool hasTerm = term && term[0];
+	const Clock::time_point startTime = Clock::now();
+	Clock::time_point deadline = startTime + std::chrono::milliseconds(answerTimeoutMs_);
+	const Clock::time_point nonTerminatedDeadline = startTime + std::chrono::milliseconds(5); // For bug-compatibility
+	if (!hasTerm && nonTerminatedDeadline < deadline)
+		deadline = nonTerminatedDeadline;
+
+	// Consume received characters one at a time, so that anything after the
+	// terminator is left for the next call.
+	std::unique_lock<std::mutex> lock(rxMutex_);
+	for (;;)
 	{
-		boost::asio::socket_base::bytes_readable command(true);
-		sock_.io_control(command);
-		size_t bytes_readable = command.get();
-
-		if (bytes_readable > 0)
+		while (!rxBuffer_.empty())
 		{
-			sock_.read_some(boost::asio::buffer(&theData, 1));
-
 			if (maxChars <= answerOffset)
 			{
-				txt[answerOffset] = '\0';
+				txt[answerOffset - 1] = '\0';
 				LogMessage("BUFFER_OVERRUN error occured!");
 				return ERR_BUFFER_OVERRUN;
 			}
-			txt[answerOffset++] = theData;
-		}
-		else
-		{
-			//Yield to other threads:
-			CDeviceUtils::SleepMs(1);
-		}
+			txt[answerOffset++] = rxBuffer_.front();
+			rxBuffer_.pop_front();
 
-		// look for the terminator, if any
-		if (term && term[0])
-		{
-			// check for terminating sequence
-			char* termPos = strstr(txt, term);
-			if (termPos != 0) // found the terminator
+			if (hasTerm)
 			{
-				LogAsciiCommunication("GetAnswer", true, txt);
+				// check for terminating sequence
+				char* termPos = strstr(txt, term);
+				if (termPos != 0) // found the terminator
+				{
+					lock.unlock();
+					LogAsciiCommunication("GetAnswer", true, txt);
 
-				// erase the terminator from the answer:
-				*termPos = '\0';
+					// erase the terminator from the answer:
+					*termPos = '\0';
 
-				return DEVICE_OK;
+					return DEVICE_OK;
+				}
 			}
 		}
-		else
-		{
-			// XXX Shouldn't it be an error to not have a terminator?
-			// TODO Make it a precondition check (immediate error) once we've made
-			// sure that no device adapter calls us without a terminator. For now,
-			// keep the behavior for the sake of bug-compatibility.
 
-			MM::MMTime elapsed = GetCurrentMMTime() - startTime;
-			if (elapsed > nonTerminatedAnswerTimeout)
-			{
-				LogAsciiCommunication("GetAnswer", true, txt);
-				long millisecs = static_cast<long>(elapsed.getMsec());
-				LogMessage(("GetAnswer without terminator returning after " +
-					boost::lexical_cast<std::string>(millisecs) +
-					"msec").c_str(), true);
-				return DEVICE_OK;
-			}
-		}
+		if (rxError_)
+			break;
+		if (rxCond_.wait_until(lock, deadline) == std::cv_status::timeout && rxBuffer_.empty())
+			break;
+	}
+	lock.unlock();
+
+	if (!hasTerm && deadline == nonTerminatedDeadline)
+	{
+		// XXX Shouldn't it be an error to not have a terminator?
+		// TODO Make it a precondition check (immediate error) once we've made
+		// sure that no device adapter calls us without a terminator. For now,
+		// keep the behavior for the sake of bug-compatibility.
+		LogAsciiCommunication("GetAnswer", true, txt);
+		long millisecs = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+			Clock::now() - startTime).count());
+		LogMessage(("GetAnswer without terminator returning after " +
+			boost::lexical_cast<std::string>(millisecs) +
+			"msec").c_str(), true);
+		return DEVICE_OK;
 	}
 
 	LogMessage("TERM_TIMEOUT error occured!");
@@ -233,7 +318,7 @@ int TCPIPPort::Write(const unsigned char* buf, unsigned long bufLen)
 		if (!initialized_)
 			return ERR_PORT_NOTINITIALIZED;
 
-	boost::asio::write(sock_, boost::asio::buffer(buf, bufLen));
+	WriteOnIoThread(buf, bufLen);
 
 	LogBinaryCommunication("Write", false, buf, bufLen);
 	ERRH_END
@@ -250,7 +335,13 @@ int TCPIPPort::Read(unsigned char* buf, unsigned long bufLen, unsigned long& cha
 
 	memset(buf, 0, bufLen);
 
-	charsRead = (unsigned long)boost::asio::read(sock_, boost::asio::buffer(buf, bufLen));
+	// Return whatever has already been received, without waiting
+	{
+		std::lock_guard<std::mutex> lock(rxMutex_);
+		charsRead = (unsigned long)(std::min)((std::size_t)bufLen, rxBuffer_.size());
+		std::copy(rxBuffer_.begin(), rxBuffer_.begin() + charsRead, buf);
+		rxBuffer_.erase_begin(charsRead);
+	}
 
 	if (charsRead > 0)
 		LogBinaryCommunication("Read", true, buf, charsRead);
@@ -259,6 +350,8 @@ int TCPIPPort::Read(unsigned char* buf, unsigned long bufLen, unsigned long& cha
 
 int TCPIPPort::Purge()
 {
+	std::lock_guard<std::mutex> lock(rxMutex_);
+	rxBuffer_.clear();
 	return DEVICE_OK;
 }
 
@@ -320,6 +413,50 @@ int TCPIPPort::OnAnswerTimeout(MM::PropertyBase* pProp, MM::ActionType eAct)
 	return DEVICE_OK;
 }
 
+int TCPIPPort::OnNoDelay(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(noDelay_ ? 1L : 0L);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (initialized_)
+		{
+			// revert
+			pProp->Set(noDelay_ ? 1L : 0L);
+			return ERR_PORT_CHANGE_FORBIDDEN;
+		}
+		long v;
+		pProp->Get(v);
+		noDelay_ = (v != 0);
+	}
+
+	return DEVICE_OK;
+}
+
+int TCPIPPort::OnSocketBufferSize(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(socketBufferSize_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (initialized_)
+		{
+			// revert
+			pProp->Set(socketBufferSize_);
+			return ERR_PORT_CHANGE_FORBIDDEN;
+		}
+		long v;
+		pProp->Get(v);
+		socketBufferSize_ = (std::max)(0L, v);
+	}
+
+	return DEVICE_OK;
+}
+
 int TCPIPPort::GetCount()
 {
 	return count_;
@@ -431,12 +568,18 @@ void TCPIPPort::LogAsciiCommunication(const char* prefix, bool isInput, const st
 
 static void FormatBinaryContent(std::ostream& strm, const unsigned char* begin, const unsigned char* end)
 {
+	// Format by hand; boost::format per byte dominates the cost of large reads
+	static const char digits[] = "0123456789abcdef";
+	std::string hex;
+	hex.reserve(3 * (end - begin));
 	for (const unsigned char* p = begin; p != end; ++p)
 	{
 		if (p != begin)
-			strm << ' ';
-		strm << boost::format("%02x") % static_cast<unsigned int>(*p);
+			hex += ' ';
+		hex += digits[*p >> 4];
+		hex += digits[*p & 0x0f];
 	}
+	strm << hex;
 }
 
 void TCPIPPort::LogBinaryCommunication(const char* prefix, bool isInput, const unsigned char* pdata, std::size_t length)
@@ -24,8 +24,14 @@
 #pragma once
 
 #include "boost/asio.hpp"
+#include "boost/circular_buffer.hpp"
 
+#include <chrono>
+#include <condition_variable>
 #include <istream>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "MMDevice.h"
 #include "DeviceBase.h"
@@ -67,6 +73,8 @@ public:
 	int OnHost(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnPort(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnAnswerTimeout(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnNoDelay(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSocketBufferSize(MM::PropertyBase* pProp, MM::ActionType eAct);
 
 	void close_sock();
 
@@ -84,6 +92,23 @@ private:
 	std::string host_;
 	unsigned short port_;
 	unsigned int answerTimeoutMs_;
+	bool noDelay_;
+	long socketBufferSize_; // 0 = system default
+
+	// Once connected, ios_ runs on ioThread_, which drains the socket into
+	// rxBuffer_ as soon as data arrives. Writes are also carried out on
+	// ioThread_, since the socket must not be used from two threads at once.
+	std::unique_ptr<boost::asio::io_service::work> ioWork_;
+	std::thread ioThread_;
+	char rxChunk_[4096];
+	std::mutex rxMutex_;
+	std::condition_variable rxCond_; // Notified when rxBuffer_ grows or the connection ends
+	boost::circular_buffer<char> rxBuffer_;
+	boost::system::error_code rxError_; // Set when the connection ends
+
+	void StartReceive();
+	void OnReceive(const boost::system::error_code& ec, std::size_t bytes);
+	void WriteOnIoThread(const void* buf, std::size_t len);
 
 	void LogAsciiCommunication(const char * prefix, bool isInput, const std::string & data);
 	void LogBinaryCommunication(const char* prefix, bool isInput, const unsigned char* content, std::size_t length);
@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <sstream>
 #include <string>
 
 template <typename T>
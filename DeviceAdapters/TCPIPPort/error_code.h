@@ -23,8 +23,8 @@
 
 #pragma once
 
-#include "boost\system\system_error.hpp"
-#include "..\MMDevice\DeviceBase.h"
+#include "boost/system/system_error.hpp"
+#include "DeviceBase.h"
 #include <exception>
 #include <string>
 
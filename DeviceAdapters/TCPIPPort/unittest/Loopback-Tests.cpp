@@ -0,0 +1,207 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          Loopback-Tests.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Command/response and throughput tests for TCPIPPort against
+//                a local echo server
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include <gtest/gtest.h>
+
+#include "TCPIPPort.h"
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using boost::asio::ip::tcp;
+
+
+// Accepts a single connection and echoes back everything it receives.
+class EchoServer
+{
+	boost::asio::io_service ios_;
+	tcp::acceptor acceptor_;
+	std::thread thread_;
+
+public:
+	EchoServer() :
+		acceptor_(ios_, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0))
+	{}
+
+	~EchoServer()
+	{
+		boost::system::error_code ec;
+		acceptor_.close(ec);
+		if (thread_.joinable())
+			thread_.join();
+	}
+
+	unsigned short Port() const { return acceptor_.local_endpoint().port(); }
+
+	void Start() { thread_ = std::thread([this] { Run(); }); }
+
+private:
+	void Run()
+	{
+		tcp::socket sock(ios_);
+		boost::system::error_code ec;
+		acceptor_.accept(sock, ec);
+		if (ec)
+			return;
+		sock.set_option(tcp::no_delay(true));
+		char buf[8192];
+		for (;;)
+		{
+			std::size_t n = sock.read_some(boost::asio::buffer(buf), ec);
+			if (ec)
+				return;
+			boost::asio::write(sock, boost::asio::buffer(buf, n), ec);
+			if (ec)
+				return;
+		}
+	}
+};
+
+
+class LoopbackTest : public ::testing::Test
+{
+protected:
+	EchoServer server_;
+	TCPIPPort port_;
+
+	LoopbackTest() : port_(1) {}
+
+	void SetUp()
+	{
+		server_.Start();
+		ASSERT_EQ(DEVICE_OK, port_.SetProperty("TCP Port",
+			std::to_string(server_.Port()).c_str()));
+		ASSERT_EQ(DEVICE_OK, port_.SetProperty("TCP no delay", "1"));
+		ASSERT_EQ(DEVICE_OK, port_.Initialize());
+	}
+
+	void TearDown()
+	{
+		port_.Shutdown();
+	}
+};
+
+
+TEST_F(LoopbackTest, CommandResponse)
+{
+	char answer[64];
+	ASSERT_EQ(DEVICE_OK, port_.SetCommand("VER", "\r"));
+	ASSERT_EQ(DEVICE_OK, port_.GetAnswer(answer, sizeof(answer), "\r"));
+	EXPECT_EQ(std::string("VER"), answer);
+}
+
+TEST_F(LoopbackTest, AnswersAreSplitAtTerminator)
+{
+	char answer[64];
+	ASSERT_EQ(DEVICE_OK, port_.SetCommand("A\rB", "\r"));
+	ASSERT_EQ(DEVICE_OK, port_.GetAnswer(answer, sizeof(answer), "\r"));
+	EXPECT_EQ(std::string("A"), answer);
+	ASSERT_EQ(DEVICE_OK, port_.GetAnswer(answer, sizeof(answer), "\r"));
+	EXPECT_EQ(std::string("B"), answer);
+}
+
+TEST_F(LoopbackTest, TimesOutWhenNoAnswer)
+{
+	ASSERT_EQ(DEVICE_OK, port_.SetProperty("Answer timeout", "50"));
+	char answer[64];
+	auto start = std::chrono::steady_clock::now();
+	EXPECT_NE(DEVICE_OK, port_.GetAnswer(answer, sizeof(answer), "\r"));
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+	EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+}
+
+TEST_F(LoopbackTest, PurgeDiscardsPendingData)
+{
+	char answer[64];
+	ASSERT_EQ(DEVICE_OK, port_.SetCommand("stale", "\r"));
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	ASSERT_EQ(DEVICE_OK, port_.Purge());
+	ASSERT_EQ(DEVICE_OK, port_.SetCommand("fresh", "\r"));
+	ASSERT_EQ(DEVICE_OK, port_.GetAnswer(answer, sizeof(answer), "\r"));
+	EXPECT_EQ(std::string("fresh"), answer);
+}
+
+TEST_F(LoopbackTest, ReadDoesNotBlock)
+{
+	unsigned char buf[16];
+	unsigned long read = 1;
+	auto start = std::chrono::steady_clock::now();
+	ASSERT_EQ(DEVICE_OK, port_.Read(buf, sizeof(buf), read));
+	EXPECT_EQ(0u, read);
+	EXPECT_LT(std::chrono::steady_clock::now() - start,
+		std::chrono::milliseconds(100));
+}
+
+TEST_F(LoopbackTest, RoundTripLatency)
+{
+	const int n = 2000;
+	char answer[64];
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < n; ++i)
+	{
+		ASSERT_EQ(DEVICE_OK, port_.SetCommand("?POS", "\r"));
+		ASSERT_EQ(DEVICE_OK, port_.GetAnswer(answer, sizeof(answer), "\r"));
+	}
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	std::cout << "Mean round trip: " << (double)us / n << " us\n";
+}
+
+TEST_F(LoopbackTest, BinaryThroughput)
+{
+	// Larger than the initial receive buffer, to exercise its growth
+	const std::size_t total = 1 << 20;
+	std::vector<unsigned char> out(total);
+	for (std::size_t i = 0; i < total; ++i)
+		out[i] = (unsigned char)(i * 31);
+
+	auto start = std::chrono::steady_clock::now();
+	ASSERT_EQ(DEVICE_OK, port_.Write(out.data(), (unsigned long)total));
+
+	std::vector<unsigned char> in(total);
+	std::size_t received = 0;
+	while (received < total)
+	{
+		unsigned long n = 0;
+		ASSERT_EQ(DEVICE_OK, port_.Read(in.data() + received,
+			(unsigned long)(total - received), n));
+		received += n;
+		ASSERT_LT(std::chrono::steady_clock::now() - start,
+			std::chrono::seconds(10));
+		if (n == 0)
+			std::this_thread::yield();
+	}
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	EXPECT_EQ(out, in);
+	std::cout << "Echoed " << total << " bytes at " <<
+		(double)total / (us > 0 ? us : 1) << " MB/s\n";
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -187,6 +187,7 @@ public:
    int SendDASequence();
    int ClearDASequence();
    int AddToDASequence(double voltage);
+   int SetDASequence(const double* voltages, long numVoltages);
 
    int OnVolts(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnVoltRange(MM::PropertyBase* pProp, MM::ActionType eAct);
@@ -265,17 +265,14 @@ int CTriggerScopeMMDAC::OnVolts(MM::PropertyBase* pProp, MM::ActionType eAct)
       if (sequence.size() > nrEvents_)
          return DEVICE_SEQUENCE_TOO_LARGE;
 
-      ClearDASequence(); // also empties sequence_
-
-      double val;
+      std::vector<double> voltages(sequence.size());
       for (unsigned int i=0; i < sequence.size(); i++)
       {
          std::istringstream os (sequence[i]);
-         os >> val;
+         os >> voltages[i];
          // Check range?
-         sequence_.push_back(val);
       }
-      return SendDASequence();
+      return SetDASequence(voltages.data(), (long) voltages.size());
    }
    else if (eAct == MM::StartSequence)
    { 
@@ -471,6 +468,17 @@ int CTriggerScopeMMDAC::ClearDASequence()
    return pHub_->SendAndReceive(str);
 }
 
+// Uploads the whole sequence with one clear and one load command, instead
+// of the separate clear that ClearDASequence() sends
+int CTriggerScopeMMDAC::SetDASequence(const double* voltages, long numVoltages)
+{
+   if (numVoltages > nrEvents_)
+      return DEVICE_SEQUENCE_TOO_LARGE;
+
+   sequence_.assign(voltages, voltages + numVoltages);
+   return SendDASequence();
+}
+
 int CTriggerScopeMMDAC::AddToDASequence(double voltage)
 {
    if (sequence_.size() < nrEvents_)
@@ -32,7 +32,9 @@
 
 #include "Utilities.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <thread>
 #include <vector>
 
@@ -40,14 +42,101 @@
 extern const char* g_NoDevice;
 extern const char* g_DeviceNameDAGalvoDevice;
 
+const char* g_PropWaveformMode = "Waveform Mode";
+const char* g_WaveformSoftware = "Software";
+const char* g_WaveformDASequence = "DA Sequence (external trigger)";
+
+void DAPolygon::rasterize(double spacing, std::vector<double>& xs,
+      std::vector<double>& ys) const
+{
+   const size_t n = polygon_.size();
+   const size_t firstSpot = xs.size();
+
+   if (n == 2 && spacing > 0.0)
+   {
+      const std::pair<double, double> a = polygon_[0];
+      const std::pair<double, double> b = polygon_[1];
+      const double length = std::hypot(b.first - a.first, b.second - a.second);
+      const long steps = std::max(1L, (long)std::ceil(length / spacing));
+      for (long k = 0; k <= steps; ++k)
+      {
+         const double t = (double)k / steps;
+         xs.push_back(a.first + t * (b.first - a.first));
+         ys.push_back(a.second + t * (b.second - a.second));
+      }
+   }
+   else if (n > 2 && spacing > 0.0)
+   {
+      double yMin = polygon_[0].second;
+      double yMax = yMin;
+      for (const auto& v : polygon_)
+      {
+         yMin = std::min(yMin, v.second);
+         yMax = std::max(yMax, v.second);
+      }
+
+      // Scan lines through the middle of equal bands no wider than spacing,
+      // filling between pairs of edge crossings (even-odd rule). Alternate
+      // lines run in opposite directions to keep galvo jumps short.
+      const long lines = std::max(1L, (long)std::ceil((yMax - yMin) / spacing));
+      const double lineSpacing = (yMax - yMin) / lines;
+      std::vector<double> crossings;
+      std::vector<double> lineSpots;
+      for (long k = 0; k < lines; ++k)
+      {
+         const double y = yMin + (k + 0.5) * lineSpacing;
+         crossings.clear();
+         for (size_t i = 0; i < n; ++i)
+         {
+            const std::pair<double, double>& p0 = polygon_[i];
+            const std::pair<double, double>& p1 = polygon_[(i + 1) % n];
+            if ((p0.second <= y && y < p1.second) || (p1.second <= y && y < p0.second))
+               crossings.push_back(p0.first +
+                     (y - p0.second) * (p1.first - p0.first) / (p1.second - p0.second));
+         }
+         std::sort(crossings.begin(), crossings.end());
+
+         lineSpots.clear();
+         for (size_t j = 0; j + 1 < crossings.size(); j += 2)
+         {
+            const double width = crossings[j + 1] - crossings[j];
+            const long count = std::max(1L, (long)std::ceil(width / spacing));
+            for (long m = 0; m < count; ++m)
+               lineSpots.push_back(crossings[j] + (m + 0.5) * width / count);
+         }
+         if (k % 2 == 1)
+            std::reverse(lineSpots.begin(), lineSpots.end());
+         for (double x : lineSpots)
+         {
+            xs.push_back(x);
+            ys.push_back(y);
+         }
+      }
+   }
+
+   // Points, spacing 0, and polygons without area
+   if (xs.size() == firstSpot)
+   {
+      for (const auto& v : polygon_)
+      {
+         xs.push_back(v.first);
+         ys.push_back(v.second);
+      }
+   }
+}
+
 DAGalvo::DAGalvo() :
    daXDevice_(g_NoDevice),
    daYDevice_(g_NoDevice),
-   shutter_(g_NoDevice),
+   initialized_(false),
+   nrRepetitions_(1),
    pulseIntervalUs_(100000),
-   initialized_(false)
+   rasterSpacing_(0.0),
+   useDASequence_(false),
+   shutter_(g_NoDevice),
+   waveformValid_(false),
+   waveformInHardware_(false)
 {
-   polygons_ = new std::vector<DAPolygon*>();
 }
 
 DAGalvo::~DAGalvo()
@@ -105,6 +194,25 @@ int DAGalvo::Initialize()
          break;
    }
 
+   // Distance between spots when filling polygons, in DA units (0: use the
+   // vertices only)
+   pAct = new CPropertyAction(this, &DAGalvo::OnRasterSpacing);
+   ret = CreateFloatProperty("Raster Spacing", rasterSpacing_, false, pAct);
+   if (ret != DEVICE_OK)
+      return ret;
+   SetPropertyLimits("Raster Spacing", 0.0, 1.0);
+
+   // The DA sequence mode needs both DAs to be sequenceable and to be
+   // stepped by a hardware trigger (e.g. a pulse generator or camera output
+   // wired to the DA trigger inputs) running at the spot interval. DAGalvo
+   // does not generate or configure that trigger.
+   pAct = new CPropertyAction(this, &DAGalvo::OnWaveformMode);
+   ret = CreateStringProperty(g_PropWaveformMode, g_WaveformSoftware, false, pAct);
+   if (ret != DEVICE_OK)
+      return ret;
+   AddAllowedValue(g_PropWaveformMode, g_WaveformSoftware);
+   AddAllowedValue(g_PropWaveformMode, g_WaveformDASequence);
+
    return DEVICE_OK;
 }
 
@@ -245,27 +353,37 @@ double DAGalvo::GetYMinimum()
 int DAGalvo::AddPolygonVertex(int index, double x, double y)
 {
    if (index >= 0) {
-      size_t nrPolygons = polygons_->size();
-      if (index < nrPolygons) {
-         DAPolygon* polygon = polygons_->at(index);
-         polygon->addVertex(x, y);
+      size_t nrPolygons = polygons_.size();
+      if ((size_t)index < nrPolygons) {
+         polygons_[index].addVertex(x, y);
+         waveformValid_ = false;
          return DEVICE_OK;
       }
-      else if (index == nrPolygons) {
-         DAPolygon* polygon = new DAPolygon(x, y);
-         polygons_->push_back(polygon);
+      else if ((size_t)index == nrPolygons) {
+         polygons_.push_back(DAPolygon(x, y));
+         waveformValid_ = false;
          return DEVICE_OK;
       }
    }
    return DEVICE_UNKNOWN_POSITION; // the index is more than nrPolygons and our vector does not accomodate this
 }
 
-int DAGalvo::DeletePolygons()
+int DAGalvo::AddPolygonVertices(int index, const double* xs, const double* ys,
+   long numVertices)
 {
-   for (int i = 0; i < polygons_->size(); i++) {
-      delete(polygons_->at(i));
+   for (long i = 0; i < numVertices; ++i)
+   {
+      int ret = AddPolygonVertex(index, xs[i], ys[i]);
+      if (ret != DEVICE_OK)
+         return ret;
    }
-   polygons_->clear();
+   return DEVICE_OK;
+}
+
+int DAGalvo::DeletePolygons()
+{
+   polygons_.clear();
+   waveformValid_ = false;
    return DEVICE_OK;
 }
 
@@ -274,24 +392,200 @@ int DAGalvo::RunSequence()
    return DEVICE_NOT_YET_IMPLEMENTED;
 }
 
+void DAGalvo::Rasterize()
+{
+   waveformX_.clear();
+   waveformY_.clear();
+   polygonStarts_.clear();
+   for (const DAPolygon& polygon : polygons_)
+   {
+      polygonStarts_.push_back(waveformX_.size());
+      polygon.rasterize(rasterSpacing_, waveformX_, waveformY_);
+   }
+   waveformValid_ = true;
+}
+
+int DAGalvo::UploadWaveform(MM::SignalIO* da, const std::vector<double>& voltages)
+{
+   int ret = da->SetDASequence(voltages.data(), (long)voltages.size());
+   if (ret != DEVICE_UNSUPPORTED_COMMAND)
+      return ret;
+
+   ret = da->ClearDASequence();
+   if (ret != DEVICE_OK)
+      return ret;
+   for (double v : voltages)
+   {
+      ret = da->AddToDASequence(v);
+      if (ret != DEVICE_OK)
+         return ret;
+   }
+   return da->SendDASequence();
+}
+
+/*
+* Rasterizes the polygons and, in the DA sequence waveform mode, loads one
+* repetition of the waveform into both DAs. If the DAs cannot hold it,
+* RunPolygons() steps through the waveform from software instead.
+*/
 int DAGalvo::LoadPolygons()
 {
-   return DEVICE_OK; // Not sure how we can benefit, this is supposed to load the polygons to the device
+   Rasterize();
+   waveformInHardware_ = false;
+   if (!useDASequence_)
+      return DEVICE_OK;
+
+   MM::SignalIO* dax = static_cast<MM::SignalIO*>(GetDevice(daXDevice_.c_str()));
+   MM::SignalIO* day = static_cast<MM::SignalIO*>(GetDevice(daYDevice_.c_str()));
+   if (!dax || !day || waveformX_.empty())
+      return DEVICE_OK;
+
+   bool xSequenceable = false;
+   bool ySequenceable = false;
+   if (dax->IsDASequenceable(xSequenceable) != DEVICE_OK || !xSequenceable ||
+         day->IsDASequenceable(ySequenceable) != DEVICE_OK || !ySequenceable)
+   {
+      LogMessage("DAs are not sequenceable; running the polygon waveform "
+            "from software", true);
+      return DEVICE_OK;
+   }
+
+   long xMaxLength = 0;
+   long yMaxLength = 0;
+   if (dax->GetDASequenceMaxLength(xMaxLength) != DEVICE_OK ||
+         day->GetDASequenceMaxLength(yMaxLength) != DEVICE_OK)
+      return DEVICE_OK;
+   if (waveformX_.size() > (size_t)std::min(xMaxLength, yMaxLength))
+   {
+      LogMessage("Polygon waveform is longer than the DA sequences; "
+            "running it from software", true);
+      return DEVICE_OK;
+   }
+
+   int ret = UploadWaveform(dax, waveformX_);
+   if (ret != DEVICE_OK)
+      return ret;
+   ret = UploadWaveform(day, waveformY_);
+   if (ret != DEVICE_OK)
+      return ret;
+   waveformInHardware_ = true;
+   return DEVICE_OK;
 }
 
 int DAGalvo::SetPolygonRepetitions(int repetitions)
 {
    nrRepetitions_ = repetitions;
+   waveformValid_ = false;
 
    return DEVICE_OK;
 }
 
 int DAGalvo::RunPolygons()
 {
-   for (int i = 0; i < polygons_->size(); i++) {
-      DAPolygon* polygon = polygons_->at(i);
-      std::pair<double, double> xyPair = polygon->getVertex(0);
-      this->PointAndFire(xyPair.first, xyPair.second, pulseIntervalUs_);
+   if (!waveformValid_)
+   {
+      int ret = LoadPolygons();
+      if (ret != DEVICE_OK)
+         return ret;
+   }
+   if (waveformX_.empty())
+      return DEVICE_OK;
+
+   MM::SignalIO* dax = static_cast<MM::SignalIO*>(GetDevice(daXDevice_.c_str()));
+   MM::SignalIO* day = static_cast<MM::SignalIO*>(GetDevice(daYDevice_.c_str()));
+   if (!dax || !day)
+      return ERR_NO_DA_DEVICE_FOUND;
+
+   if (waveformInHardware_)
+      return RunWaveformInHardware(dax, day);
+   return RunWaveformInSoftware();
+}
+
+/*
+* The DAs step through the waveform on external hardware triggers, which
+* must arrive at the spot interval; like other Micro-Manager sequences, the
+* DA sequences wrap around to the start, so the repetitions are given by how
+* long the run lasts. We only open the shutter for the duration. Jumps
+* between polygons are not blanked.
+*/
+int DAGalvo::RunWaveformInHardware(MM::SignalIO* dax, MM::SignalIO* day)
+{
+   MM::Shutter* s = static_cast<MM::Shutter*>(GetDevice(shutter_.c_str()));
+   if (!s)
+      return ERR_NO_SHUTTER_DEVICE_FOUND;
+
+   int ret = SetPosition(waveformX_[0], waveformY_[0]);
+   if (ret != DEVICE_OK)
+      return ret;
+   bool open = false;
+   ret = s->GetOpen(open);
+   if (ret != DEVICE_OK)
+      return ret;
+
+   ret = dax->StartDASequence();
+   if (ret != DEVICE_OK)
+      return ret;
+   ret = day->StartDASequence();
+   if (ret == DEVICE_OK)
+      ret = s->SetOpen(true);
+   if (ret == DEVICE_OK)
+   {
+      const double durationUs = pulseIntervalUs_ *
+            waveformX_.size() * std::max(1L, nrRepetitions_);
+      std::this_thread::sleep_for(std::chrono::microseconds((long long)durationUs));
+      ret = s->SetOpen(open);
+   }
+
+   int stopRet = dax->StopDASequence();
+   if (ret == DEVICE_OK)
+      ret = stopRet;
+   stopRet = day->StopDASequence();
+   if (ret == DEVICE_OK)
+      ret = stopRet;
+   return ret;
+}
+
+/*
+* Moves to each spot in turn, with the shutter open while within a polygon.
+*/
+int DAGalvo::RunWaveformInSoftware()
+{
+   MM::Shutter* s = static_cast<MM::Shutter*>(GetDevice(shutter_.c_str()));
+   if (!s)
+      return ERR_NO_SHUTTER_DEVICE_FOUND;
+
+   bool open = false;
+   int ret = s->GetOpen(open);
+   if (ret != DEVICE_OK)
+      return ret;
+
+   const std::chrono::microseconds dwell((long long)pulseIntervalUs_);
+   for (long r = 0; r < std::max(1L, nrRepetitions_); ++r)
+   {
+      for (size_t p = 0; p < polygonStarts_.size(); ++p)
+      {
+         const size_t begin = polygonStarts_[p];
+         const size_t end = (p + 1 < polygonStarts_.size()) ?
+               polygonStarts_[p + 1] : waveformX_.size();
+         for (size_t i = begin; i < end; ++i)
+         {
+            ret = SetPosition(waveformX_[i], waveformY_[i]);
+            if (ret != DEVICE_OK)
+               break;
+            if (i == begin)
+            {
+               ret = s->SetOpen(true);
+               if (ret != DEVICE_OK)
+                  break;
+            }
+            std::this_thread::sleep_for(dwell);
+         }
+         int closeRet = s->SetOpen(open);
+         if (ret == DEVICE_OK)
+            ret = closeRet;
+         if (ret != DEVICE_OK)
+            return ret;
+      }
    }
    return DEVICE_OK;
 }
@@ -324,6 +618,7 @@ int DAGalvo::OnDAX(MM::PropertyBase* pProp, MM::ActionType eAct)
       }
       else
          daXDevice_ = g_NoDevice;
+      waveformValid_ = false;
    }
    return DEVICE_OK;
 }
@@ -344,6 +639,7 @@ int DAGalvo::OnDAY(MM::PropertyBase* pProp, MM::ActionType eAct)
       }
       else
          daYDevice_ = g_NoDevice;
+      waveformValid_ = false;
    }
    return DEVICE_OK;
 }
@@ -367,3 +663,33 @@ int DAGalvo::OnShutter(MM::PropertyBase* pProp, MM::ActionType eAct)
    }
    return DEVICE_OK;
 }
+
+int DAGalvo::OnRasterSpacing(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      pProp->Set(rasterSpacing_);
+   }
+   else if (eAct == MM::AfterSet)
+   {
+      pProp->Get(rasterSpacing_);
+      waveformValid_ = false;
+   }
+   return DEVICE_OK;
+}
+
+int DAGalvo::OnWaveformMode(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      pProp->Set(useDASequence_ ? g_WaveformDASequence : g_WaveformSoftware);
+   }
+   else if (eAct == MM::AfterSet)
+   {
+      std::string mode;
+      pProp->Get(mode);
+      useDASequence_ = (mode == g_WaveformDASequence);
+      waveformValid_ = false;
+   }
+   return DEVICE_OK;
+}
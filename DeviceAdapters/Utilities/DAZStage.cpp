@@ -321,14 +321,7 @@ int DAZStage::AddToStageSequence(double pos)
    if (da == 0)
       return ERR_NO_DA_DEVICE;
 
-   double voltage = (pos - minStagePos_) / (maxStagePos_ - minStagePos_) * (maxStageVolt_ - minStageVolt_) + minStageVolt_;
-
-   if (voltage > maxStageVolt_)
-      voltage = maxStageVolt_;
-   else if (voltage < minStageVolt_)
-      voltage = minStageVolt_;
-
-   return da->AddToDASequence(voltage);
+   return da->AddToDASequence(SequenceVoltage(pos));
 }
 
 int DAZStage::SendStageSequence()
@@ -339,6 +332,59 @@ int DAZStage::SendStageSequence()
    return da->SendDASequence();
 }
 
+int DAZStage::SetStageSequence(const double* positions, long numPositions)
+{
+   MM::SignalIO* da = (MM::SignalIO*)GetDevice(DADeviceName_.c_str());
+   if (da == 0)
+      return ERR_NO_DA_DEVICE;
+
+   std::vector<double> voltages(positions, positions + numPositions);
+   for (double& v : voltages)
+      v = SequenceVoltage(v);
+
+   int ret = da->SetDASequence(voltages.data(), numPositions);
+   if (ret != DEVICE_UNSUPPORTED_COMMAND)
+      return ret;
+
+   // The DA takes one voltage at a time; still only look it up once
+   ret = da->ClearDASequence();
+   if (ret != DEVICE_OK)
+      return ret;
+   for (double v : voltages)
+   {
+      ret = da->AddToDASequence(v);
+      if (ret != DEVICE_OK)
+         return ret;
+   }
+   return da->SendDASequence();
+}
+
+int DAZStage::AppendToStageSequence(const double* positions, long numPositions,
+   long& numAppended)
+{
+   MM::SignalIO* da = (MM::SignalIO*)GetDevice(DADeviceName_.c_str());
+   if (da == 0)
+      return ERR_NO_DA_DEVICE;
+
+   // The DA reports buffer room to the Core itself
+   std::vector<double> voltages(positions, positions + numPositions);
+   for (double& v : voltages)
+      v = SequenceVoltage(v);
+   return da->AppendToDASequence(voltages.data(), numPositions, numAppended);
+}
+
+double DAZStage::SequenceVoltage(double pos) const
+{
+   double voltage = (pos - minStagePos_) / (maxStagePos_ - minStagePos_) * (maxStageVolt_ - minStageVolt_) + minStageVolt_;
+
+   if (voltage > maxStageVolt_)
+      voltage = maxStageVolt_;
+   else if (voltage < minStageVolt_)
+      voltage = minStageVolt_;
+
+   return voltage;
+}
+
 
 ///////////////////////////////////////
 // Action Interface
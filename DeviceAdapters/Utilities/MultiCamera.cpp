@@ -33,21 +33,139 @@
 #include "Utilities.h"
 
 #include <algorithm>
+#include <system_error>
 
 extern const char* g_DeviceNameMultiCamera;
 extern const char* g_Undefined;
 
+const char* g_SequenceReadout = "Sequence Readout";
+const char* g_ReadoutPerCamera = "Per Camera";
+const char* g_ReadoutCombined = "Combined Frames";
+
+
+CameraSnapThread::CameraSnapThread() :
+   pending_(false),
+   quit_(false),
+   camera_(0),
+   dest_(0),
+   destWidth_(0),
+   destHeight_(0),
+   bytesPerPixel_(0),
+   result_(DEVICE_OK)
+{
+}
+
+CameraSnapThread::~CameraSnapThread()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      quit_ = true;
+   }
+   cond_.notify_all();
+   if (thread_.joinable())
+      thread_.join();
+}
+
+void CameraSnapThread::Start(MM::Camera* camera, unsigned char* dest,
+   unsigned destWidth, unsigned destHeight, unsigned bytesPerPixel)
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      camera_ = camera;
+      dest_ = dest;
+      destWidth_ = destWidth;
+      destHeight_ = destHeight;
+      bytesPerPixel_ = bytesPerPixel;
+      pending_ = true;
+      if (thread_.joinable())
+      {
+         cond_.notify_all();
+         return;
+      }
+   }
+
+   try
+   {
+      thread_ = std::thread(&CameraSnapThread::Run, this);
+   }
+   catch (const std::system_error&)
+   {
+      // Out of threads: snap on the calling thread instead
+      int ret = SnapAndCopy();
+      std::lock_guard<std::mutex> lock(mutex_);
+      result_ = ret;
+      pending_ = false;
+   }
+}
+
+int CameraSnapThread::Wait()
+{
+   std::unique_lock<std::mutex> lock(mutex_);
+   cond_.wait(lock, [this] { return !pending_; });
+   return result_;
+}
+
+void CameraSnapThread::Run()
+{
+   std::unique_lock<std::mutex> lock(mutex_);
+   for (;;)
+   {
+      cond_.wait(lock, [this] { return pending_ || quit_; });
+      if (quit_)
+         return;
+
+      lock.unlock();
+      int ret = SnapAndCopy();
+      lock.lock();
+
+      result_ = ret;
+      pending_ = false;
+      cond_.notify_all();
+   }
+}
+
+int CameraSnapThread::SnapAndCopy()
+{
+   snapStart_ = std::chrono::steady_clock::now();
+   int ret = camera_->SnapImage();
+   snapEnd_ = std::chrono::steady_clock::now();
+   if (ret != DEVICE_OK || dest_ == 0)
+      return ret;
+
+   const unsigned char* pixels = camera_->GetImageBuffer();
+   if (pixels == 0)
+      return DEVICE_ERR;
+
+   const std::size_t srcLine = (std::size_t)camera_->GetImageWidth() * bytesPerPixel_;
+   const std::size_t destLine = (std::size_t)destWidth_ * bytesPerPixel_;
+   const std::size_t copyLine = (std::min)(srcLine, destLine);
+   const unsigned copyHeight = (std::min)(camera_->GetImageHeight(), destHeight_);
+   unsigned char* dest = dest_;
+   for (unsigned k = 0; k < copyHeight; k++, dest += destLine)
+   {
+      memcpy(dest, pixels + k * srcLine, copyLine);
+      memset(dest + copyLine, 0, destLine - copyLine);
+   }
+   memset(dest, 0, (destHeight_ - copyHeight) * destLine);
+   return DEVICE_OK;
+}
+
 
 MultiCamera::MultiCamera() :
    imageBuffer_(0),
    nrCamerasInUse_(0),
-   initialized_(false)
+   initialized_(false),
+   combinedReadout_(false),
+   frameWidth_(0),
+   frameHeight_(0),
+   frameBytesPerPixel_(0)
 {
    InitializeDefaultErrorMessages();
 
    SetErrorText(ERR_INVALID_DEVICE_NAME, "Please select a valid camera");
    SetErrorText(ERR_NO_PHYSICAL_CAMERA, "No physical camera assigned");
    SetErrorText(ERR_NO_EQUAL_SIZE, "Cameras differ in image size");
+   SetErrorText(ERR_NO_EQUAL_PIXEL_TYPE, "Cameras differ in bytes per pixel");
 
    // Name                                                                   
    CreateProperty(MM::g_Keyword_Name, g_DeviceNameMultiCamera, MM::String, true);
@@ -68,6 +186,10 @@ MultiCamera::~MultiCamera()
 
 int MultiCamera::Shutdown()
 {
+   // The sequence thread uses the snap threads, stop it while they exist
+   if (CCameraBase<MultiCamera>::IsCapturing())
+      CCameraBase<MultiCamera>::StopSequenceAcquisition();
+
    delete imageBuffer_;
    // Rely on the cameras to shut themselves down
    return DEVICE_OK;
@@ -117,6 +239,13 @@ int MultiCamera::Initialize()
    CPropertyAction* pAct = new CPropertyAction(this, &MultiCamera::OnBinning);
    CreateProperty(MM::g_Keyword_Binning, "1", MM::Integer, false, pAct, false);
 
+   // "Combined Frames" streams one multi-channel frame per snap of all
+   // cameras instead of letting each camera run its own sequence
+   pAct = new CPropertyAction(this, &MultiCamera::OnSequenceReadout);
+   CreateProperty(g_SequenceReadout, g_ReadoutPerCamera, MM::String, false, pAct, false);
+   AddAllowedValue(g_SequenceReadout, g_ReadoutPerCamera);
+   AddAllowedValue(g_SequenceReadout, g_ReadoutCombined);
+
    initialized_ = true;
 
    return DEVICE_OK;
@@ -135,20 +264,49 @@ int MultiCamera::SnapImage()
    if (!ImageSizesAreEqual())
       return ERR_NO_EQUAL_SIZE;
 
-   CameraSnapThread t[MAX_NUMBER_PHYSICAL_CAMERAS];
+   return SnapAll(false);
+}
+
+/**
+ * Snaps all cameras in parallel on their snap threads and waits for them.
+ * With assembleFrame, each thread also copies its image into its channel of
+ * frame_, so that the frame is complete when all snaps are.
+ * Returns the first error reported by a camera.
+ */
+int MultiCamera::SnapAll(bool assembleFrame)
+{
+   const std::size_t channelSize =
+      (std::size_t)frameWidth_ * frameHeight_ * frameBytesPerPixel_;
+   bool started[MAX_NUMBER_PHYSICAL_CAMERAS] = { false };
+   unsigned channel = 0;
    for (unsigned int i = 0; i < usedCameras_.size(); i++)
    {
+      if (usedCameras_[i] == g_Undefined)
+         continue;
       MM::Camera* camera = (MM::Camera*)GetDevice(usedCameras_[i].c_str());
       if (camera != 0)
       {
-         t[i].SetCamera(camera);
-         t[i].Start();
+         if (assembleFrame)
+            snapThreads_[i].Start(camera, &frame_[channel * channelSize],
+               frameWidth_, frameHeight_, frameBytesPerPixel_);
+         else
+            snapThreads_[i].Start(camera);
+         started[i] = true;
       }
+      channel++;
    }
-   // I think that the CameraSnapThread destructor waits until the SnapImage function is done
-   // So, we are likely to be waiting here until all cameras are done snapping
 
-   return DEVICE_OK;
+   int result = DEVICE_OK;
+   for (unsigned int i = 0; i < usedCameras_.size(); i++)
+   {
+      if (started[i])
+      {
+         int ret = snapThreads_[i].Wait();
+         if (result == DEVICE_OK)
+            result = ret;
+      }
+   }
+   return result;
 }
 
 /**
@@ -195,7 +353,8 @@ const unsigned char* MultiCamera::GetImageBuffer(unsigned channelNr)
                const unsigned char* pixels = camera->GetImageBuffer();
                for (unsigned k = 0; k < thisHeight; k++)
                {
-                  memcpy(img_.GetPixelsRW() + k * width, pixels + k * thisWidth, thisWidth);
+                  memcpy(img_.GetPixelsRW() + k * width * pixDepth,
+                     pixels + k * thisWidth * pixDepth, thisWidth * pixDepth);
                }
             }
             return img_.GetPixels();
@@ -207,6 +366,9 @@ const unsigned char* MultiCamera::GetImageBuffer(unsigned channelNr)
 
 bool MultiCamera::IsCapturing()
 {
+   if (CCameraBase<MultiCamera>::IsCapturing())
+      return true;
+
    std::vector<std::string>::iterator iter;
    for (iter = usedCameras_.begin(); iter != usedCameras_.end(); iter++) {
       MM::Camera* camera = (MM::Camera*)GetDevice((*iter).c_str());
@@ -456,6 +618,9 @@ int MultiCamera::StartSequenceAcquisition(double interval)
    if (nrCamerasInUse_ < 1)
       return ERR_NO_PHYSICAL_CAMERA;
 
+   if (combinedReadout_)
+      return StartSequenceAcquisition(LONG_MAX, interval, false);
+
    if (!ImageSizesAreEqual())
       return ERR_NO_EQUAL_SIZE;
 
@@ -484,6 +649,26 @@ int MultiCamera::StartSequenceAcquisition(long numImages, double interval_ms, bo
    if (nrCamerasInUse_ < 1)
       return ERR_NO_PHYSICAL_CAMERA;
 
+   if (combinedReadout_)
+   {
+      if (IsCapturing())
+         return DEVICE_CAMERA_BUSY_ACQUIRING;
+
+      // The circular buffer is set up from our (largest) width and height
+      // and one channel per camera; smaller images are zero-padded
+      frameBytesPerPixel_ = GetImageBytesPerPixel();
+      if (frameBytesPerPixel_ == 0)
+         return ERR_NO_EQUAL_PIXEL_TYPE;
+      frameWidth_ = GetImageWidth();
+      frameHeight_ = GetImageHeight();
+      frame_.assign((std::size_t)nrCamerasInUse_ * frameWidth_ * frameHeight_ *
+         frameBytesPerPixel_, 0);
+
+      sequenceStart_ = std::chrono::steady_clock::now();
+      return CCameraBase<MultiCamera>::StartSequenceAcquisition(numImages,
+         interval_ms, stopOnOverflow);
+   }
+
    for (unsigned int i = 0; i < usedCameras_.size(); i++)
    {
       MM::Camera* camera = (MM::Camera*)GetDevice(usedCameras_[i].c_str());
@@ -506,6 +691,9 @@ int MultiCamera::StartSequenceAcquisition(long numImages, double interval_ms, bo
 
 int MultiCamera::StopSequenceAcquisition()
 {
+   if (CCameraBase<MultiCamera>::IsCapturing())
+      return CCameraBase<MultiCamera>::StopSequenceAcquisition();
+
    for (unsigned int i = 0; i < usedCameras_.size(); i++)
    {
       MM::Camera* camera = (MM::Camera*)GetDevice(usedCameras_[i].c_str());
@@ -527,6 +715,50 @@ int MultiCamera::StopSequenceAcquisition()
    return DEVICE_OK;
 }
 
+/**
+ * One cycle of a combined-frame sequence acquisition: snap all cameras and
+ * send their images to the core as a single multi-channel frame
+ */
+int MultiCamera::ThreadRun()
+{
+   int ret = SnapAll(true);
+   if (ret != DEVICE_OK)
+      return ret;
+   return InsertImage();
+}
+
+int MultiCamera::InsertImage()
+{
+   char label[MM::MaxStrLength];
+   GetLabel(label);
+   Metadata md;
+   md.PutImageTag(MM::g_Keyword_Metadata_CameraLabel, label);
+
+   // Snap start and end of each camera, on one clock, in ms since the start
+   // of the sequence
+   for (unsigned int i = 0; i < usedCameras_.size(); i++)
+   {
+      if (usedCameras_[i] == g_Undefined)
+         continue;
+      typedef std::chrono::duration<double, std::milli> Ms;
+      md.PutImageTag(usedCameras_[i] + "-SnapStart-ms",
+         Ms(snapThreads_[i].SnapStart() - sequenceStart_).count());
+      md.PutImageTag(usedCameras_[i] + "-SnapEnd-ms",
+         Ms(snapThreads_[i].SnapEnd() - sequenceStart_).count());
+   }
+
+   int ret = GetCoreCallback()->InsertMultiChannel(this, &frame_[0],
+      nrCamerasInUse_, frameWidth_, frameHeight_, frameBytesPerPixel_, &md);
+   if (!isStopOnOverflow() && ret == DEVICE_BUFFER_OVERFLOW)
+   {
+      // do not stop on overflow - just reset the buffer
+      GetCoreCallback()->ClearImageBuffer(this);
+      ret = GetCoreCallback()->InsertMultiChannel(this, &frame_[0],
+         nrCamerasInUse_, frameWidth_, frameHeight_, frameBytesPerPixel_, &md);
+   }
+   return ret;
+}
+
 int MultiCamera::GetBinning() const
 {
    MM::Camera* camera0 = (MM::Camera*)GetDevice(usedCameras_[0].c_str());
@@ -680,4 +912,19 @@ int MultiCamera::OnBinning(MM::PropertyBase* pProp, MM::ActionType eAct)
    return DEVICE_OK;
 }
 
-
+int MultiCamera::OnSequenceReadout(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      pProp->Set(combinedReadout_ ? g_ReadoutCombined : g_ReadoutPerCamera);
+   }
+   else if (eAct == MM::AfterSet)
+   {
+      if (IsCapturing())
+         return DEVICE_CAMERA_BUSY_ACQUIRING;
+      std::string readout;
+      pProp->Get(readout);
+      combinedReadout_ = (readout == g_ReadoutCombined);
+   }
+   return DEVICE_OK;
+}
@@ -27,8 +27,12 @@
 #include "MMDevice.h"
 #include "DeviceBase.h"
 #include "ImgBuffer.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <map>
+#include <thread>
 #include <vector>
 
 //////////////////////////////////////////////////////////////////////////////
@@ -49,6 +53,7 @@
 #define ERR_AUTOFOCUS_NOT_SUPPORTED        10012
 #define ERR_NO_PHYSICAL_STAGE              10013
 #define ERR_NO_SHUTTER_DEVICE_FOUND        10014
+#define ERR_NO_EQUAL_PIXEL_TYPE            10015
 #define ERR_TIMEOUT                        10021
 
 
@@ -112,27 +117,47 @@ private:
 };
 
 /**
- * CameraSnapThread: helper thread for MultiCamera
+ * CameraSnapThread: persistent helper thread for MultiCamera. Snaps one
+ * physical camera per request and can copy the result into one channel of
+ * a combined frame, so that cameras are read out in parallel.
  */
-class CameraSnapThread : public MMDeviceThreadBase
+class CameraSnapThread
 {
    public:
-      CameraSnapThread() :
-         camera_(0),
-         started_(false)
-      {}
+      CameraSnapThread();
+      ~CameraSnapThread();
 
-      ~CameraSnapThread() { if (started_) wait(); }
+      // Starts snapping on the worker thread (created on first use). If dest
+      // is not null, the image is then copied to dest, a destWidth x
+      // destHeight buffer, cropping or zero-padding at the right and bottom.
+      void Start(MM::Camera* camera, unsigned char* dest = 0,
+         unsigned destWidth = 0, unsigned destHeight = 0,
+         unsigned bytesPerPixel = 0);
 
-      void SetCamera(MM::Camera* camera) { camera_ = camera; }
+      // Waits until the last snap (and copy) is done; returns its error code
+      int Wait();
 
-      int svc() { camera_->SnapImage(); return 0; }
-
-      void Start() { activate(); started_ = true; }
+      // When the camera's SnapImage() of the last snap began and returned
+      std::chrono::steady_clock::time_point SnapStart() const { return snapStart_; }
+      std::chrono::steady_clock::time_point SnapEnd() const { return snapEnd_; }
 
    private:
+      void Run();
+      int SnapAndCopy();
+
+      std::thread thread_;
+      std::mutex mutex_;
+      std::condition_variable cond_;
+      bool pending_;
+      bool quit_;
       MM::Camera* camera_;
-      bool started_;
+      unsigned char* dest_;
+      unsigned destWidth_;
+      unsigned destHeight_;
+      unsigned bytesPerPixel_;
+      int result_;
+      std::chrono::steady_clock::time_point snapStart_;
+      std::chrono::steady_clock::time_point snapEnd_;
 };
 
 /*
@@ -178,10 +203,17 @@ public:
    // ---------------
    int OnPhysicalCamera(MM::PropertyBase* pProp, MM::ActionType eAct, long nr);
    int OnBinning(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnSequenceReadout(MM::PropertyBase* pProp, MM::ActionType eAct);
+
+protected:
+   // Combined-frame sequence acquisition (run by the base class thread)
+   int ThreadRun();
+   int InsertImage();
 
 private:
    int Logical2Physical(int logical);
    bool ImageSizesAreEqual();
+   int SnapAll(bool assembleFrame);
    unsigned char* imageBuffer_;
 
    std::vector<std::string> availableCameras_;
@@ -191,6 +223,16 @@ private:
    unsigned int nrCamerasInUse_;
    bool initialized_;
    ImgBuffer img_;
+
+   CameraSnapThread snapThreads_[MAX_NUMBER_PHYSICAL_CAMERAS];
+   bool combinedReadout_;
+   // Multi-channel frame assembled by the snap threads: one channel per
+   // camera in use, each padded or cropped to frameWidth_ x frameHeight_
+   std::vector<unsigned char> frame_;
+   unsigned frameWidth_;
+   unsigned frameHeight_;
+   unsigned frameBytesPerPixel_;
+   std::chrono::steady_clock::time_point sequenceStart_;
 };
 
 
@@ -489,8 +531,12 @@ public:
    int ClearStageSequence();
    int AddToStageSequence(double position);
    int SendStageSequence();
+   int SetStageSequence(const double* positions, long numPositions);
+   int AppendToStageSequence(const double* positions, long numPositions, long& numAppended);
 
 private:
+   double SequenceVoltage(double pos) const;
+
    std::vector<std::string> availableDAs_;
    std::string DADeviceName_;
    bool initialized_;
@@ -645,22 +691,23 @@ public:
       polygon_.push_back(std::make_pair(x, y));
    }
 
-   bool hasVertex(size_t index) {
-      return polygon_.size() <= index + 1;
+   bool hasVertex(size_t index) const {
+      return index < polygon_.size();
    }
 
-   std::pair<double, double> getVertex(size_t index) {
-      if (polygon_.size() <= index + 1) {
-         return polygon_[index];
-      }
-      else { 
-         // TODO: throw exception
-      }
+   std::pair<double, double> getVertex(size_t index) const {
+      return polygon_.at(index);
    }
 
-   size_t getNumberOfVertices() {
+   size_t getNumberOfVertices() const {
       return polygon_.size();
    }
+
+   // Appends the spots that cover the polygon: the vertex itself for a
+   // point, evenly spaced points for a line, and a back-and-forth raster
+   // of the interior otherwise. A spacing of 0 gives the vertices only.
+   void rasterize(double spacing, std::vector<double>& xs,
+         std::vector<double>& ys) const;
 };
 
       
@@ -686,6 +733,7 @@ public:
    double GetYRange();
    double GetYMinimum();
    int AddPolygonVertex(int polygonIndex, double x, double y);
+   int AddPolygonVertices(int polygonIndex, const double* xs, const double* ys, long numVertices);
    int DeletePolygons();
    int RunSequence();
    int LoadPolygons();
@@ -698,15 +746,34 @@ private:
    int OnDAX(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnDAY(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnShutter(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnRasterSpacing(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnWaveformMode(MM::PropertyBase* pProp, MM::ActionType eAct);
+
+   void Rasterize();
+   int UploadWaveform(MM::SignalIO* da, const std::vector<double>& voltages);
+   int RunWaveformInHardware(MM::SignalIO* dax, MM::SignalIO* day);
+   int RunWaveformInSoftware();
 
    std::string daXDevice_;
    std::string daYDevice_;
    bool initialized_;
    long nrRepetitions_;
    double pulseIntervalUs_;
+   double rasterSpacing_;
+   // Run the waveform as DA sequences stepped by external triggers, rather
+   // than setting each spot from software
+   bool useDASequence_;
    std::string shutter_;
-   std::vector<DAPolygon*> *polygons_;
-
+   std::vector<DAPolygon> polygons_;
+
+   // Spots of all polygons (one repetition), and where each polygon starts.
+   // Rebuilt by LoadPolygons() whenever the polygons or settings change.
+   std::vector<double> waveformX_;
+   std::vector<double> waveformY_;
+   std::vector<size_t> polygonStarts_;
+   bool waveformValid_;
+   // The DAs hold the waveform (one repetition) as their sequences
+   bool waveformInHardware_;
 };
 
 // Use several DA (SignalIO) devices as a state device with adjustable voltage
@@ -39,6 +39,11 @@ strace -f java -Djava.library.path=/usr/lib/micro-manager -classpath /usr/share/
 *              - USB ID 1871:7670 Aveo Technology Corp. (uvcvideo) - COLEMETER(R) USB 2.0 Digital Microscope
 *              - USB ID 046d:0826 Logitech, Inc. HD Webcam C525
 *
+*            - Sequence acquisition runs its own capture thread that waits on the device and keeps
+*              the driver's buffers queued, instead of snapping image by image.
+*            - Buffers can be allocated by us and handed to the driver (V4L2_MEMORY_USERPTR).
+*              Both can be tried with the vivid virtual driver (modprobe vivid).
+*
 */
 // LICENSE:       This file is distributed under the "LGPL" license.
 //
@@ -58,6 +63,7 @@ strace -f java -Djava.library.path=/usr/lib/micro-manager -classpath /usr/share/
 #include "DeviceBase.h"
 #include "ModuleInterface.h"
 #include "ImgBuffer.h"
+#include "PixelConversion.h"
 #include <sstream>
 #include <map>
 #include <vector>
@@ -72,8 +78,10 @@ strace -f java -Djava.library.path=/usr/lib/micro-manager -classpath /usr/share/
 #include <cstring>
 #include <cerrno>
 #include <sys/mman.h>
+#include <poll.h>
 
-#include <pthread.h>
+#include <atomic>
+#include <thread>
 
 using namespace std;
 
@@ -83,10 +91,15 @@ const char
   *gPropertyDevicePath = "DevicePath",
   *gPropertyDevicePathDefault = "/dev/video0",
   *gPropertyNameResolution = "Resolution",
-  *gResolutionDefault = "640x480";
+  *gResolutionDefault = "640x480",
+  *gPropertyBufferMemory = "BufferMemory",
+  *gBufferMemoryMmap = "MMAP",
+  *gBufferMemoryUserPtr = "USERPTR",
+  *gPropertyBufferCount = "BufferCount";
 
 const long gWidthDefault = 640,
-           gHeightDefault = 480;
+           gHeightDefault = 480,
+           gBufferCountDefault = 4;
 
 struct VidBuffer {
   void *start;
@@ -97,6 +110,8 @@ struct VidBuffer {
 typedef struct State State;
 struct State {
   int W, H, fd;
+  size_t sizeimage;
+  unsigned int memory; // V4L2_MEMORY_MMAP or V4L2_MEMORY_USERPTR
   struct VidBuffer *buffers;
   unsigned int buffers_count;
   struct v4l2_buffer *buf;
@@ -135,13 +150,8 @@ class PixelType8Bit : public PixelType {
 
     virtual void convertV4l2ToOutput(
         State *state, unsigned char* in, unsigned char* output) const {
-      int i,j;
-      for (j = 0; j < state->H; j++) {
-        int wj = state->W * j;
-        for (i = 0; i < state->W; i++) {
-          output[i + wj] = in[2*i + 2*wj];
-        }
-      }
+      // Keep the luma
+      PixelConversion::YUYVToGray8(output, in, state->W * state->H);
     }
 };
 string PixelType8Bit::PROPERTY_VALUE = "8bit";
@@ -159,37 +169,7 @@ class PixelTypeYUYV : public PixelType {
         State *state, unsigned char* ptrIn, unsigned char* ptrOut) const {
       /* Convert YUYV to RGBA32, apparently mm does only display colors
        * in this format */
-      for (int i = 0;  i < state->W * state->H / 2; ++i) {
-        int y0 = ptrIn[0];
-        int u0 = ptrIn[1];
-        int y1 = ptrIn[2];
-        int v0 = ptrIn[3];
-        ptrIn += 4;
-        int c = y0 - 16;
-        int d = u0 - 128;
-        int e = v0 - 128;
-
-        ptrOut[0] = clip((298 * c + 516 * d + 128) >> 8); // blue
-        ptrOut[1] = clip((298 * c - 100 * d - 208 * e + 128) >> 8); // green
-        ptrOut[2] = clip((298 * c + 409 * e + 128) >> 8); // red
-        ptrOut[4] = 255; // alpha
-        c = y1 - 16;
-        ptrOut[4] = clip((298 * c + 516 * d + 128) >> 8); // blue
-        ptrOut[5] = clip((298 * c - 100 * d - 208 * e + 128) >> 8); // green
-        ptrOut[6] = clip((298 * c + 409 * e + 128) >> 8); // red
-        ptrOut[7] = 255; // alpha
-        ptrOut += 8;
-      }
-    }
-
-  private:
-    inline unsigned char clip(int val) const {
-      if (val <= 0)
-        return 0;
-      else if (val >= 255)
-        return 255;
-      else
-        return val;
+      PixelConversion::YUYVToRGB32(ptrOut, ptrIn, state->W * state->H);
     }
 };
 string PixelTypeYUYV::PROPERTY_VALUE = "YUYV";
@@ -204,9 +184,12 @@ public:
   // little as possible, don't access hardware, do everything else in
   // Initialize()
   V4L2() :
+    capturing_(false),
+    stopCapture_(false),
     pixelType(&PIXELTYPE_8BIT)
   {
     initialized_ = 0;
+    memset(state, 0, sizeof(state));
   }
 
   // Shutdown is always called before destructor, in any case release
@@ -241,6 +224,27 @@ public:
     if (nRet != DEVICE_OK)
       return nRet;
 
+    // Buffers
+    pAct = new CPropertyAction(this, &V4L2::OnBufferSetup);
+    nRet = CreateProperty(
+        gPropertyBufferMemory, gBufferMemoryMmap, MM::String, false, pAct);
+    if (nRet != DEVICE_OK)
+      return nRet;
+
+    vector<string> memoryTypes;
+    memoryTypes.push_back(gBufferMemoryMmap);
+    memoryTypes.push_back(gBufferMemoryUserPtr);
+    nRet = SetAllowedValues(gPropertyBufferMemory, memoryTypes);
+    if (nRet != DEVICE_OK)
+      return nRet;
+
+    pAct = new CPropertyAction(this, &V4L2::OnBufferSetup);
+    nRet = CreateProperty(gPropertyBufferCount,
+        CDeviceUtils::ConvertToString(gBufferCountDefault), MM::Integer, false, pAct);
+    if (nRet != DEVICE_OK)
+      return nRet;
+    SetPropertyLimits(gPropertyBufferCount, 2, 32);
+
     // Binning
     pAct = new CPropertyAction(this, &V4L2::OnBinning);
     nRet = CreateProperty(MM::g_Keyword_Binning, "1", MM::Integer, false, pAct);
@@ -287,6 +291,7 @@ public:
   // afterwards, unload device, release all resources
   int Shutdown()
   {
+    StopSequenceAcquisition();
     if (initialized_) {
       VideoClose();
     }
@@ -302,12 +307,51 @@ public:
   // blocks until exposure is finished
   int SnapImage()
   {
+    if (IsCapturing())
+      return DEVICE_CAMERA_BUSY_ACQUIRING;
+
     unsigned char* data = VideoTakeBuffer();
     pixelType->convertV4l2ToOutput(state, data, const_cast<unsigned char*>(imageBuffer.GetPixels()));
     VideoReturnBuffer();
     return DEVICE_OK;
   }
 
+  int StartSequenceAcquisition(long numImages, double interval_ms, bool stopOnOverflow)
+  {
+    (void) interval_ms; // the device delivers frames at its own rate
+
+    if (IsCapturing())
+      return DEVICE_CAMERA_BUSY_ACQUIRING;
+    if (!initialized_)
+      return DEVICE_NOT_CONNECTED;
+
+    int ret = GetCoreCallback()->PrepareForAcq(this);
+    if (ret != DEVICE_OK)
+      return ret;
+
+    // A thread that finished by itself still needs to be joined
+    if (captureThread_.joinable())
+      captureThread_.join();
+
+    stopCapture_ = false;
+    capturing_ = true;
+    captureThread_ = std::thread(&V4L2::CaptureLoop, this, numImages, stopOnOverflow);
+    return DEVICE_OK;
+  }
+
+  int StopSequenceAcquisition()
+  {
+    stopCapture_ = true;
+    if (captureThread_.joinable())
+      captureThread_.join();
+    return DEVICE_OK;
+  }
+
+  bool IsCapturing()
+  {
+    return capturing_;
+  }
+
   // waits for camera readout
   const unsigned char* GetImageBuffer()
   {
@@ -427,6 +471,22 @@ public:
     return DEVICE_OK;
   }
 
+  int OnBufferSetup(MM::PropertyBase* pProp, MM::ActionType eAct)
+  {
+    if (eAct == MM::AfterSet) {
+      if (IsCapturing())
+         return DEVICE_CAMERA_BUSY_ACQUIRING;
+
+      string value;
+      pProp->Get(value);
+
+      LogMessage(pProp->GetName() + " changed to " + value);
+      return reinitializeDeviceIfRunning();
+    }
+
+    return DEVICE_OK;
+  }
+
   int OnBinning(MM::PropertyBase* pProp, MM::ActionType eAct)
   {
     if(eAct == MM::BeforeGet){
@@ -510,23 +570,67 @@ private:
       return false;
     }
 
+    char memoryString[MM::MaxStrLength];
+    ret = GetProperty(gPropertyBufferMemory, memoryString);
+    if (ret != DEVICE_OK) {
+      LogMessage("could not read buffer memory property");
+      return false;
+    }
+
+    long requestedBuffers = gBufferCountDefault;
+    ret = GetProperty(gPropertyBufferCount, requestedBuffers);
+    if (ret != DEVICE_OK) {
+      LogMessage("could not read buffer count property");
+      return false;
+    }
+
     ret = initDevice(devicePath, requestedWidth, requestedHeight);
     if (ret != DEVICE_OK)
       return false;
 
+    state->buf = (struct v4l2_buffer*) malloc(sizeof(struct v4l2_buffer));
+
+    bool userPtr = strcmp(memoryString, gBufferMemoryUserPtr) == 0;
+    if (userPtr && !requestBuffers(V4L2_MEMORY_USERPTR, (unsigned) requestedBuffers)) {
+      LogMessage("falling back to memory mapped buffers");
+      userPtr = false;
+    }
+    if (!userPtr && !requestBuffers(V4L2_MEMORY_MMAP, (unsigned) requestedBuffers))
+      return false;
+
+    ret = this->resizeBuffer();
+    if (ret != DEVICE_OK)
+      return false;
+
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE; 
+    if (-1 == tryIoctl(state->fd, VIDIOC_STREAMON, &type)) {
+      LogMessage("could not initialize stream");
+      return false;
+    }
+
+    LogMessage("initialized data stream");
+    return true;
+  }
+
+  // Requests, allocates or maps, and enqueues the driver buffers
+  bool
+  requestBuffers(unsigned int memory, unsigned int count)
+  {
+    const char* memoryName = memory == V4L2_MEMORY_USERPTR ? "user pointer" : "memory map";
+
     struct v4l2_requestbuffers reqbuf;
     memset(&reqbuf, 0, sizeof(reqbuf));
     reqbuf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    reqbuf.memory = V4L2_MEMORY_MMAP;
-    reqbuf.count = 4;
+    reqbuf.memory = memory;
+    reqbuf.count = count;
 
     if (-1 == tryIoctl(state->fd, VIDIOC_REQBUFS, &reqbuf)) {
       ostringstream msg;
       if (EINVAL == errno) {
-        msg << "error: the device does not support memory mapping";
+        msg << "error: the device does not support " << memoryName << " buffers";
       }
       else {
-        msg << "error: could not request memory map buffers: "
+        msg << "error: could not request " << memoryName << " buffers: "
             << strerror(errno) << " (errno " << errno << ")";
       }
       LogMessage(msg.str().c_str());
@@ -534,7 +638,8 @@ private:
     }
 
     ostringstream bufMsg;
-    bufMsg << "got " << reqbuf.count << " out of 4 requested buffers";
+    bufMsg << "got " << reqbuf.count << " out of " << count << " requested "
+           << memoryName << " buffers";
     LogMessage(bufMsg.str().c_str());
 
     state->buffers = (struct VidBuffer*)calloc(reqbuf.count, sizeof(*(state->buffers)));
@@ -542,8 +647,11 @@ private:
       LogMessage("could not allocate buffer(s)");
       return false;
     }
+    state->memory = memory;
 
-    state->buf = (struct v4l2_buffer*) malloc(sizeof(struct v4l2_buffer));
+    // The driver writes whole pages
+    const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t userLength = (state->sizeimage + pageSize - 1) / pageSize * pageSize;
 
     unsigned int i;
     for (i = 0; i < reqbuf.count; i++) {
@@ -551,43 +659,77 @@ private:
       memset(&buf, 0 , sizeof(buf));
 
       buf.type = reqbuf.type;
-      buf.memory = V4L2_MEMORY_MMAP;
+      buf.memory = memory;
       buf.index = i;
-      if (-1 == tryIoctl(state->fd, VIDIOC_QUERYBUF, &buf)) {
-        LogMessage("could not query the buffer state");
-        return false;
+
+      if (memory == V4L2_MEMORY_USERPTR) {
+        void* start = 0;
+        if (0 != posix_memalign(&start, pageSize, userLength)) {
+          LogMessage("could not allocate user pointer buffer");
+          releaseBuffers();
+          return false;
+        }
+        state->buffers[i].start = start;
+        state->buffers[i].length = userLength;
+        state->buffers_count = i + 1; // so that VideoClose frees what we have
+
+        buf.m.userptr = (unsigned long) start;
+        buf.length = userLength;
       }
+      else {
+        if (-1 == tryIoctl(state->fd, VIDIOC_QUERYBUF, &buf)) {
+          LogMessage("could not query the buffer state");
+          releaseBuffers();
+          return false;
+        }
 
-      state->buffers[i].length = buf.length; // remember for munmap
-      state->buffers[i].start = mmap(NULL, buf.length,
-          PROT_READ | PROT_WRITE,
-          MAP_SHARED, state->fd, buf.m.offset);
+        state->buffers[i].length = buf.length; // remember for munmap
+        state->buffers[i].start = mmap(NULL, buf.length,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED, state->fd, buf.m.offset);
 
-      if (state->buffers[i].start == MAP_FAILED) {
-        LogMessage("memory map failed");
-        return false;
+        if (state->buffers[i].start == MAP_FAILED) {
+          LogMessage("memory map failed");
+          releaseBuffers();
+          return false;
+        }
+        state->buffers_count = i + 1;
       }
 
       if (-1 == tryIoctl(state->fd, VIDIOC_QBUF, &buf)) {
-        LogMessage("could not enqueue buffer");
+        ostringstream msg;
+        msg << "could not enqueue buffer: " << strerror(errno);
+        LogMessage(msg.str().c_str());
+        releaseBuffers();
         return false;
       }
     }
 
-    state->buffers_count = reqbuf.count;
-
-    ret = this->resizeBuffer();
-    if (ret != DEVICE_OK)
-      return false;
+    return true;
+  }
 
-    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE; 
-    if (-1 == tryIoctl(state->fd, VIDIOC_STREAMON, &type)) {
-      LogMessage("could not initialize stream");
-      return false;
+  void
+  releaseBuffers()
+  {
+    unsigned int i;
+    for (i = 0; i < state->buffers_count; i++) {
+      if (state->memory == V4L2_MEMORY_USERPTR)
+        free(state->buffers[i].start);
+      else
+        munmap(state->buffers[i].start, state->buffers[i].length);
     }
+    free(state->buffers);
+    state->buffers = 0;
+    state->buffers_count = 0;
 
-    LogMessage("initialized data stream");
-    return true;
+    // Lets the driver drop its references to the buffers, and allows
+    // requesting buffers of another kind
+    struct v4l2_requestbuffers reqbuf;
+    memset(&reqbuf, 0, sizeof(reqbuf));
+    reqbuf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    reqbuf.memory = state->memory;
+    reqbuf.count = 0;
+    ioctl(state->fd, VIDIOC_REQBUFS, &reqbuf);
   }
 
   int
@@ -627,8 +769,8 @@ private:
     fmt.type                = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
     fmt.fmt.pix.field       = V4L2_FIELD_INTERLACED;
-    fmt.fmt.pix.height      = (unsigned) requestedWidth;
-    fmt.fmt.pix.width       = (unsigned) requestedHeight;
+    fmt.fmt.pix.width       = (unsigned) requestedWidth;
+    fmt.fmt.pix.height      = (unsigned) requestedHeight;
 
     if (-1 == tryIoctl(state->fd, VIDIOC_S_FMT, &fmt)) {
       ostringstream msg;
@@ -655,6 +797,7 @@ private:
 
     state->W = fmt.fmt.pix.width;
     state->H = fmt.fmt.pix.height;
+    state->sizeimage = fmt.fmt.pix.sizeimage;
 
     ostringstream formatMsg;
     formatMsg << "device is configured for " << state->W << "x" << state->H << " pixel"
@@ -675,17 +818,14 @@ private:
       // not fatal
     }
   
-    unsigned int i;
-    for (i = 0; i < state->buffers_count; i++)
-      munmap(state->buffers[i].start, state->buffers[i].length);
+    releaseBuffers();
     close(state->fd);
     free(state->buf);
   
     state->fd = 0;
     state->W = 0;
     state->H = 0;
-    state->buffers_count = 0;
-    state->buffers = 0;
+    state->buf = 0;
   
     return true;
   }
@@ -696,7 +836,7 @@ private:
   {
     memset(state->buf, 0, sizeof(struct v4l2_buffer));
     state->buf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    state->buf->memory = V4L2_MEMORY_MMAP;
+    state->buf->memory = state->memory;
     // By default VIDIOC_DQBUF blocks when no buffer is in the outgoing queue
     if (-1 == tryIoctl(state->fd, VIDIOC_DQBUF, state->buf)) {
       ostringstream msg;
@@ -720,6 +860,85 @@ private:
     }
   }
 
+  // Runs on its own thread during sequence acquisition. All buffers but the
+  // one being converted stay with the driver, so frames are only lost if
+  // conversion falls behind the device's frame rate.
+  void
+  CaptureLoop(long numImages, bool stopOnOverflow)
+  {
+    const unsigned width = GetImageWidth();
+    const unsigned height = GetImageHeight();
+    const unsigned bytesPerPixel = GetImageBytesPerPixel();
+    vector<unsigned char> frame(width * height * bytesPerPixel);
+
+    char label[MM::MaxStrLength];
+    GetLabel(label);
+    Metadata md;
+    md.put(MM::g_Keyword_Metadata_CameraLabel, label);
+    const string serializedMetadata = md.Serialize();
+
+    long imageCounter = 0;
+    while (!stopCapture_ && imageCounter < numImages) {
+      // Wake up regularly to notice a stop request
+      struct pollfd pfd;
+      pfd.fd = state->fd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      int result = poll(&pfd, 1, 100);
+      if (0 == result)
+        continue;
+      if (-1 == result) {
+        if (EINTR == errno)
+          continue;
+        ostringstream msg;
+        msg << "error: waiting for a frame failed: " << strerror(errno);
+        LogMessage(msg.str().c_str());
+        break;
+      }
+
+      struct v4l2_buffer buf;
+      memset(&buf, 0, sizeof(buf));
+      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buf.memory = state->memory;
+      if (-1 == ioctl(state->fd, VIDIOC_DQBUF, &buf)) {
+        if (EAGAIN == errno || EINTR == errno)
+          continue;
+        ostringstream msg;
+        msg << "error: could not dequeue image buffer: " << strerror(errno);
+        LogMessage(msg.str().c_str());
+        break;
+      }
+
+      assert(buf.index < state->buffers_count);
+      pixelType->convertV4l2ToOutput(state,
+          (unsigned char*)state->buffers[buf.index].start, &frame[0]);
+
+      // Hand the buffer back before the core copies the frame
+      if (-1 == ioctl(state->fd, VIDIOC_QBUF, &buf)) {
+        ostringstream msg;
+        msg << "error: could not enqueue image buffer: " << strerror(errno);
+        LogMessage(msg.str().c_str());
+        break;
+      }
+
+      int ret = GetCoreCallback()->InsertImage(this, &frame[0], width, height,
+          bytesPerPixel, serializedMetadata.c_str());
+      if (!stopOnOverflow && ret == DEVICE_BUFFER_OVERFLOW) {
+        // do not stop on overflow - just reset the buffer
+        GetCoreCallback()->ClearImageBuffer(this);
+        ret = GetCoreCallback()->InsertImage(this, &frame[0], width, height,
+            bytesPerPixel, serializedMetadata.c_str());
+      }
+      if (ret != DEVICE_OK)
+        break;
+
+      ++imageCounter;
+    }
+
+    capturing_ = false;
+    OnThreadExiting();
+  }
+
   int reinitializeDeviceIfRunning() {
     if (initialized_) {
       LogMessage("closing current device");
@@ -794,6 +1013,9 @@ private:
   }
 
   bool initialized_;
+  std::atomic<bool> capturing_;
+  std::atomic<bool> stopCapture_;
+  std::thread captureThread_;
   State state[1];
   ImgBuffer imageBuffer;
   PixelType *pixelType;
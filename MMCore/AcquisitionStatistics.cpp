@@ -0,0 +1,383 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          AcquisitionStatistics.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Frame counts, frame rate and latency histograms of the image
+//                path from camera to application.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "AcquisitionStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+namespace mm {
+
+namespace {
+
+const std::uint64_t NoMin = (std::numeric_limits<std::uint64_t>::max)();
+
+unsigned HighestBit(std::uint64_t v)
+{
+   unsigned bit = 0;
+   for (unsigned shift = 32; shift > 0; shift /= 2)
+   {
+      if (v >> shift)
+      {
+         v >>= shift;
+         bit += shift;
+      }
+   }
+   return bit;
+}
+
+std::int64_t Ticks(std::chrono::steady_clock::time_point t)
+{
+   return t.time_since_epoch().count();
+}
+
+std::uint64_t Microseconds(std::chrono::steady_clock::duration d)
+{
+   const auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+   return us > 0 ? std::uint64_t(us) : 0;
+}
+
+template <typename T>
+void StoreMax(std::atomic<T>& target, T value)
+{
+   T current = target.load(std::memory_order_relaxed);
+   while (value > current &&
+         !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+   {
+   }
+}
+
+template <typename T>
+void StoreMin(std::atomic<T>& target, T value)
+{
+   T current = target.load(std::memory_order_relaxed);
+   while (value < current &&
+         !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+   {
+   }
+}
+
+const char* const LatencyNames[] = {
+   "cameraToInsert",
+   "processing",
+   "copy",
+   "insertToPop",
+   "frameInterval",
+};
+
+} // anonymous namespace
+
+const std::uint64_t LogLinearHistogram::MaxTrackableValue;
+
+LogLinearHistogram::LogLinearHistogram()
+{
+   Reset();
+}
+
+unsigned LogLinearHistogram::BucketIndex(std::uint64_t value)
+{
+   if (value < SubBucketCount)
+      return unsigned(value);
+   const unsigned msb = HighestBit(value);
+   const unsigned sub = unsigned(value >> (msb - SubBucketBits)) & (SubBucketCount - 1);
+   return (msb - SubBucketBits + 1) * SubBucketCount + sub;
+}
+
+std::uint64_t LogLinearHistogram::BucketMidpoint(unsigned index)
+{
+   if (index < SubBucketCount)
+      return index;
+   const unsigned msb = index / SubBucketCount + SubBucketBits - 1;
+   const std::uint64_t sub = index % SubBucketCount;
+   const unsigned widthBits = msb - SubBucketBits;
+   const std::uint64_t low = (SubBucketCount + sub) << widthBits;
+   return low + ((std::uint64_t(1) << widthBits) - 1) / 2;
+}
+
+void LogLinearHistogram::Record(std::uint64_t value)
+{
+   value = (std::min)(value, MaxTrackableValue);
+   buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+   sum_.fetch_add(value, std::memory_order_relaxed);
+   StoreMin(min_, value);
+   StoreMax(max_, value);
+   count_.fetch_add(1, std::memory_order_release);
+}
+
+void LogLinearHistogram::Reset()
+{
+   for (auto& b : buckets_)
+      b.store(0, std::memory_order_relaxed);
+   sum_.store(0, std::memory_order_relaxed);
+   min_.store(NoMin, std::memory_order_relaxed);
+   max_.store(0, std::memory_order_relaxed);
+   count_.store(0, std::memory_order_release);
+}
+
+std::uint64_t LogLinearHistogram::Count() const
+{
+   return count_.load(std::memory_order_acquire);
+}
+
+std::uint64_t LogLinearHistogram::Min() const
+{
+   const std::uint64_t m = min_.load(std::memory_order_relaxed);
+   return m == NoMin ? 0 : m;
+}
+
+std::uint64_t LogLinearHistogram::Max() const
+{
+   return max_.load(std::memory_order_relaxed);
+}
+
+double LogLinearHistogram::Mean() const
+{
+   const std::uint64_t n = Count();
+   return n ? double(sum_.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+std::uint64_t LogLinearHistogram::Percentile(double percent) const
+{
+   // Sum the buckets rather than trusting count_, which may lag or lead them
+   std::uint64_t total = 0;
+   for (const auto& b : buckets_)
+      total += b.load(std::memory_order_relaxed);
+   if (total == 0)
+      return 0;
+
+   percent = (std::max)(0.0, (std::min)(100.0, percent));
+   const std::uint64_t rank = (std::max)(std::uint64_t(1),
+      std::uint64_t(std::ceil(percent / 100.0 * total)));
+   if (rank >= total)
+      return Max();
+   std::uint64_t seen = 0;
+   unsigned index = 0;
+   for (; index < BucketCount; ++index)
+   {
+      seen += buckets_[index].load(std::memory_order_relaxed);
+      if (seen >= rank)
+         break;
+   }
+   const std::uint64_t value = BucketMidpoint((std::min)(index, BucketCount - 1));
+   return (std::max)(Min(), (std::min)(Max(), value));
+}
+
+std::string LogLinearHistogram::ToJSON() const
+{
+   std::ostringstream json;
+   json << "{\"count\":" << Count() <<
+      ",\"min\":" << Min() <<
+      ",\"mean\":" << std::llround(Mean()) <<
+      ",\"p50\":" << Percentile(50.0) <<
+      ",\"p90\":" << Percentile(90.0) <<
+      ",\"p99\":" << Percentile(99.0) <<
+      ",\"max\":" << Max() << '}';
+   return json.str();
+}
+
+const char* const AcquisitionStatistics::FramesInsertedProperty = "StatisticsFramesInserted";
+const char* const AcquisitionStatistics::FramesPoppedProperty = "StatisticsFramesPopped";
+const char* const AcquisitionStatistics::OverflowsProperty = "StatisticsOverflows";
+const char* const AcquisitionStatistics::FrameRateProperty = "StatisticsFrameRate";
+const char* const AcquisitionStatistics::MaxQueueDepthProperty = "StatisticsMaxQueueDepth";
+const char* const AcquisitionStatistics::CameraToInsertP99Property = "StatisticsCameraToInsertP99Us";
+const char* const AcquisitionStatistics::ProcessingP99Property = "StatisticsProcessingP99Us";
+const char* const AcquisitionStatistics::CopyP99Property = "StatisticsCopyP99Us";
+const char* const AcquisitionStatistics::InsertToPopP99Property = "StatisticsInsertToPopP99Us";
+const char* const AcquisitionStatistics::LogIntervalProperty = "StatisticsLogIntervalMs";
+
+AcquisitionStatistics::AcquisitionStatistics(logging::Logger logger) :
+   logger_(std::move(logger)),
+   logIntervalMs_(0),
+   nextLogTicks_(0)
+{
+   Reset();
+}
+
+void AcquisitionStatistics::RecordLatency(Latency which,
+   std::chrono::steady_clock::duration d)
+{
+   latencies_[which].Record(Microseconds(d));
+}
+
+void AcquisitionStatistics::RecordLatency(Latency which,
+   std::chrono::steady_clock::time_point since)
+{
+   RecordLatency(which, std::chrono::steady_clock::now() - since);
+}
+
+void AcquisitionStatistics::RecordInsert(unsigned long queueDepth)
+{
+   const auto now = std::chrono::steady_clock::now();
+   const std::int64_t ticks = Ticks(now);
+   const std::int64_t previous = lastInsertTicks_.exchange(ticks, std::memory_order_relaxed);
+   if (previous != 0)
+      latencies_[FrameInterval].Record(Microseconds(
+         std::chrono::steady_clock::duration(ticks - previous)));
+   else
+   {
+      std::int64_t none = 0;
+      firstInsertTicks_.compare_exchange_strong(none, ticks, std::memory_order_relaxed);
+   }
+
+   framesInserted_.fetch_add(1, std::memory_order_relaxed);
+   queueDepth_.store(queueDepth, std::memory_order_relaxed);
+   StoreMax(maxQueueDepth_, queueDepth);
+   queueDepths_.Record(queueDepth);
+
+   if (logIntervalMs_.load(std::memory_order_relaxed) > 0)
+      MaybeLog(now);
+}
+
+void AcquisitionStatistics::RecordPop(unsigned long queueDepth)
+{
+   framesPopped_.fetch_add(1, std::memory_order_relaxed);
+   queueDepth_.store(queueDepth, std::memory_order_relaxed);
+}
+
+void AcquisitionStatistics::RecordOverflow()
+{
+   overflows_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AcquisitionStatistics::Reset()
+{
+   framesInserted_.store(0);
+   framesPopped_.store(0);
+   overflows_.store(0);
+   queueDepth_.store(0);
+   maxQueueDepth_.store(0);
+   firstInsertTicks_.store(0);
+   lastInsertTicks_.store(0);
+   for (auto& h : latencies_)
+      h.Reset();
+   queueDepths_.Reset();
+}
+
+std::string AcquisitionStatistics::ToJSON() const
+{
+   const std::uint64_t inserted = framesInserted_.load();
+   const std::int64_t first = firstInsertTicks_.load();
+   const std::int64_t last = lastInsertTicks_.load();
+   double meanRate = 0.0;
+   if (inserted > 1 && last > first)
+   {
+      const double seconds = std::chrono::duration<double>(
+         std::chrono::steady_clock::duration(last - first)).count();
+      meanRate = (inserted - 1) / seconds;
+   }
+
+   std::ostringstream json;
+   json << "{\"framesInserted\":" << inserted <<
+      ",\"framesPopped\":" << framesPopped_.load() <<
+      ",\"overflows\":" << overflows_.load() <<
+      ",\"frameRate\":{\"mean\":" << meanRate <<
+      ",\"recent\":" << GetPropertyValue(FrameRateProperty) << '}' <<
+      ",\"queueDepth\":{\"current\":" << queueDepth_.load() <<
+      ",\"max\":" << maxQueueDepth_.load() <<
+      ",\"histogram\":" << queueDepths_.ToJSON() << '}' <<
+      ",\"latencyUs\":{";
+   for (int i = 0; i < LatencyCount; ++i)
+   {
+      if (i > 0)
+         json << ',';
+      json << '"' << LatencyNames[i] << "\":" << latencies_[i].ToJSON();
+   }
+   json << "}}";
+   return json.str();
+}
+
+std::vector<std::string> AcquisitionStatistics::GetPropertyNames()
+{
+   return {
+      FramesInsertedProperty,
+      FramesPoppedProperty,
+      OverflowsProperty,
+      FrameRateProperty,
+      MaxQueueDepthProperty,
+      CameraToInsertP99Property,
+      ProcessingP99Property,
+      CopyP99Property,
+      InsertToPopP99Property,
+   };
+}
+
+bool AcquisitionStatistics::IsStatisticsProperty(const std::string& name)
+{
+   const std::vector<std::string> names = GetPropertyNames();
+   return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+std::string AcquisitionStatistics::GetPropertyValue(const std::string& name) const
+{
+   std::ostringstream value;
+   if (name == FramesInsertedProperty)
+      value << framesInserted_.load();
+   else if (name == FramesPoppedProperty)
+      value << framesPopped_.load();
+   else if (name == OverflowsProperty)
+      value << overflows_.load();
+   else if (name == FrameRateProperty)
+   {
+      // From the median interval, which is not skewed by pauses between
+      // acquisitions the way the mean rate is
+      const std::uint64_t us = latencies_[FrameInterval].Percentile(50.0);
+      value << (us > 0 ? std::round(1e7 / us) / 10.0 : 0.0);
+   }
+   else if (name == MaxQueueDepthProperty)
+      value << maxQueueDepth_.load();
+   else if (name == CameraToInsertP99Property)
+      value << latencies_[CameraToInsert].Percentile(99.0);
+   else if (name == ProcessingP99Property)
+      value << latencies_[Processing].Percentile(99.0);
+   else if (name == CopyP99Property)
+      value << latencies_[Copy].Percentile(99.0);
+   else if (name == InsertToPopP99Property)
+      value << latencies_[InsertToPop].Percentile(99.0);
+   return value.str();
+}
+
+void AcquisitionStatistics::SetLogIntervalMs(long ms)
+{
+   logIntervalMs_.store((std::max)(ms, 0L));
+   nextLogTicks_.store(0);
+}
+
+void AcquisitionStatistics::MaybeLog(std::chrono::steady_clock::time_point now)
+{
+   const long intervalMs = logIntervalMs_.load(std::memory_order_relaxed);
+   std::int64_t next = nextLogTicks_.load(std::memory_order_relaxed);
+   if (next != 0 && Ticks(now) < next)
+      return;
+
+   // Only the thread that advances the deadline writes the entry
+   const std::int64_t following = Ticks(now + std::chrono::milliseconds(intervalMs));
+   if (!nextLogTicks_.compare_exchange_strong(next, following,
+         std::memory_order_relaxed))
+      return;
+   if (next == 0)
+      return; // Interval just (re)started; first dump one interval from now
+
+   LOG_INFO(logger_) << "Acquisition statistics: " << ToJSON();
+}
+
+} // namespace mm
@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          AcquisitionStatistics.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Frame counts, frame rate and latency histograms of the image
+//                path from camera to application.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include "Logging/Logger.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mm {
+
+// Histogram of non-negative integers (e.g. microseconds) with log-linear
+// buckets, in the manner of HdrHistogram: values below 16 are counted
+// exactly, and each power-of-two range above that is split into 16 buckets,
+// so that any percentile is reported to within about 3%.
+//
+// Record() is lock-free and may be called from any number of threads. Reads
+// are not synchronized with concurrent records, so a summary taken during
+// acquisition may be off by the frames being recorded at that moment.
+class LogLinearHistogram
+{
+public:
+   LogLinearHistogram();
+
+   void Record(std::uint64_t value);
+   void Reset();
+
+   std::uint64_t Count() const;
+   std::uint64_t Min() const; // 0 if empty
+   std::uint64_t Max() const;
+   double Mean() const;
+   // Value at or below which the given percentage (0-100) of values fall
+   std::uint64_t Percentile(double percent) const;
+
+   // {"count":...,"min":...,"mean":...,"p50":...,"p90":...,"p99":...,"max":...}
+   std::string ToJSON() const;
+
+   // Values above this are counted as this
+   static const std::uint64_t MaxTrackableValue = (std::uint64_t(1) << 40) - 1;
+
+private:
+   static const unsigned SubBucketBits = 4;
+   static const unsigned SubBucketCount = 1 << SubBucketBits;
+   static const unsigned BucketCount = (40 - SubBucketBits + 1) * SubBucketCount;
+
+   static unsigned BucketIndex(std::uint64_t value);
+   static std::uint64_t BucketMidpoint(unsigned index);
+
+   std::array<std::atomic<std::uint64_t>, BucketCount> buckets_;
+   std::atomic<std::uint64_t> count_;
+   std::atomic<std::uint64_t> sum_;
+   std::atomic<std::uint64_t> min_;
+   std::atomic<std::uint64_t> max_;
+};
+
+// Statistics of the frames passing through the Core, shared by the camera
+// callback, the image processing pipeline and the circular buffer, which
+// record into it on their own threads without locking.
+class AcquisitionStatistics
+{
+public:
+   enum Latency
+   {
+      CameraToInsert, // From the camera's insert call to the frame being in the buffer
+      Processing,     // ImageProcessor::Process()
+      Copy,           // Copying the frame into the circular buffer
+      InsertToPop,    // Time spent in the circular buffer until popped
+      FrameInterval,  // Between successive insertions
+      LatencyCount
+   };
+
+   // Names of the read-only Core properties reporting the statistics
+   static const char* const FramesInsertedProperty;
+   static const char* const FramesPoppedProperty;
+   static const char* const OverflowsProperty;
+   static const char* const FrameRateProperty;
+   static const char* const MaxQueueDepthProperty;
+   static const char* const CameraToInsertP99Property;
+   static const char* const ProcessingP99Property;
+   static const char* const CopyP99Property;
+   static const char* const InsertToPopP99Property;
+   // Writable Core property for the periodic log dump (0 disables it)
+   static const char* const LogIntervalProperty;
+
+   explicit AcquisitionStatistics(logging::Logger logger);
+
+   AcquisitionStatistics(const AcquisitionStatistics&) = delete;
+   AcquisitionStatistics& operator=(const AcquisitionStatistics&) = delete;
+
+   void RecordLatency(Latency which, std::chrono::steady_clock::duration d);
+   void RecordLatency(Latency which, std::chrono::steady_clock::time_point since);
+   // Called by the circular buffer after each insertion, with the number of
+   // frames now waiting to be popped
+   void RecordInsert(unsigned long queueDepth);
+   void RecordPop(unsigned long queueDepth);
+   void RecordOverflow();
+
+   void Reset();
+
+   std::uint64_t GetFramesInserted() const { return framesInserted_.load(); }
+   std::uint64_t GetFramesPopped() const { return framesPopped_.load(); }
+   std::uint64_t GetOverflows() const { return overflows_.load(); }
+   const LogLinearHistogram& GetHistogram(Latency which) const
+   { return latencies_[which]; }
+
+   // Summary of all counters and histograms as a JSON object
+   std::string ToJSON() const;
+
+   static std::vector<std::string> GetPropertyNames();
+   static bool IsStatisticsProperty(const std::string& name);
+   // Current value of one of the read-only properties
+   std::string GetPropertyValue(const std::string& name) const;
+
+   // Write ToJSON() to the log at most this often while frames are being
+   // inserted; 0 disables the dump
+   void SetLogIntervalMs(long ms);
+   long GetLogIntervalMs() const { return logIntervalMs_.load(); }
+
+private:
+   void MaybeLog(std::chrono::steady_clock::time_point now);
+
+   logging::Logger logger_;
+
+   std::atomic<std::uint64_t> framesInserted_;
+   std::atomic<std::uint64_t> framesPopped_;
+   std::atomic<std::uint64_t> overflows_;
+   std::atomic<unsigned long> queueDepth_;
+   std::atomic<unsigned long> maxQueueDepth_;
+   // steady_clock ticks; 0 before the first insertion
+   std::atomic<std::int64_t> firstInsertTicks_;
+   std::atomic<std::int64_t> lastInsertTicks_;
+   LogLinearHistogram latencies_[LatencyCount];
+   LogLinearHistogram queueDepths_;
+
+   std::atomic<long> logIntervalMs_;
+   std::atomic<std::int64_t> nextLogTicks_;
+};
+
+} // namespace mm
@@ -24,6 +24,7 @@
 // AUTHOR:        Nenad Amodaj, nenad@amodaj.com, 01/05/2007
 // 
 #include "CircularBuffer.h"
+#include "AcquisitionStatistics.h"
 #include "CoreUtils.h"
 
 #include "TaskSet_CopyMemory.h"
@@ -35,6 +36,7 @@
 #include <ctime>
 #include <memory>
 #include <string>
+#include <utility>
 
 const long long bytesInMB = 1 << 20;
 const long adjustThreshold = LONG_MAX / 2;
@@ -44,7 +46,8 @@ const long adjustThreshold = LONG_MAX / 2;
 // division by zero can be added.
 const unsigned long maxCBSize = 10000000;
 
-CircularBuffer::CircularBuffer(unsigned int memorySizeMB) :
+CircularBuffer::CircularBuffer(unsigned int memorySizeMB,
+      std::shared_ptr<mm::AcquisitionStatistics> stats) :
    width_(0), 
    height_(0), 
    pixDepth_(0), 
@@ -54,7 +57,8 @@ CircularBuffer::CircularBuffer(unsigned int memorySizeMB) :
    memorySizeMB_(memorySizeMB), 
    overflow_(false),
    threadPool_(std::make_shared<ThreadPool>()),
-   tasksMemCopy_(std::make_shared<TaskSet_CopyMemory>(threadPool_))
+   tasksMemCopy_(std::make_shared<TaskSet_CopyMemory>(threadPool_)),
+   stats_(std::move(stats))
 {
 }
 
@@ -76,6 +80,10 @@ bool CircularBuffer::Initialize(unsigned channels, unsigned int w, unsigned int
          if (frameArray_.size() > 0)
             return true; // nothing to change
 
+      // Reallocating would invalidate pinned pixels
+      if (!pinnedImages_.empty())
+         return false;
+
       width_ = w;
       height_ = h;
       pixDepth_ = pixDepth;
@@ -107,6 +115,8 @@ bool CircularBuffer::Initialize(unsigned channels, unsigned int w, unsigned int
          frameArray_[i].Clear();
 
       // allocate buffers  - could conceivably throw an out-of-memory exception
+      framePinCounts_.assign(cbSize, 0);
+      insertTimes_.resize(cbSize);
       frameArray_.resize(cbSize);
       for (unsigned long i=0; i<frameArray_.size(); i++)
       {
@@ -118,6 +128,8 @@ bool CircularBuffer::Initialize(unsigned channels, unsigned int w, unsigned int
    catch( ... /* std::bad_alloc& ex */)
    {
       frameArray_.resize(0);
+      framePinCounts_.clear();
+      insertTimes_.clear();
       ret = false;
    }
    return ret;
@@ -223,12 +235,17 @@ bool CircularBuffer::InsertMultiChannel(const unsigned char* pixArray, unsigned
        if (width != width_ || height != height_ || byteDepth != pixDepth_)
           throw CMMError("Incompatible image dimensions in the circular buffer", MMERR_CircularBufferIncompatibleImage);
  
-       bool overflowed = (insertIndex_ - saveIndex_) >= static_cast<long>(frameArray_.size());
+       bool overflowed = (insertIndex_ - saveIndex_) >= static_cast<long>(frameArray_.size()) ||
+          framePinCounts_[insertIndex_ % frameArray_.size()] > 0;
        if (overflowed) {
           overflow_ = true;
+          if (stats_)
+             stats_->RecordOverflow();
           return false;
        }
     }
+
+    std::chrono::steady_clock::duration copyTime{};
  
     for (unsigned i=0; i<numChannels; i++)
     {
@@ -297,13 +314,17 @@ bool CircularBuffer::InsertMultiChannel(const unsigned char* pixArray, unsigned
       //       It would be better to have something like ImgBuffer::GetPixelsRW() in MMDevice.
       //       Or even better - pass tasksMemCopy_ to ImgBuffer constructor
       //       and utilize parallel copy also in single snap acquisitions.
+      const auto copyStart = std::chrono::steady_clock::now();
       tasksMemCopy_->MemCopy((void*)pImg->GetPixels(),
             pixArray + i * singleChannelSize, singleChannelSize);
+      copyTime += std::chrono::steady_clock::now() - copyStart;
    }
 
+   unsigned long queueDepth;
    {
       MMThreadGuard guard(g_bufferLock);
 
+      insertTimes_[insertIndex_ % frameArray_.size()] = std::chrono::steady_clock::now();
       imageCounter_++;
       insertIndex_++;
       if ((insertIndex_ - (long)frameArray_.size()) > adjustThreshold && (saveIndex_- (long)frameArray_.size()) > adjustThreshold)
@@ -312,6 +333,13 @@ bool CircularBuffer::InsertMultiChannel(const unsigned char* pixArray, unsigned
          insertIndex_ -= adjustThreshold;
          saveIndex_ -= adjustThreshold;
       }
+      queueDepth = (unsigned long)(insertIndex_ - saveIndex_);
+   }
+
+   if (stats_)
+   {
+      stats_->RecordLatency(mm::AcquisitionStatistics::Copy, copyTime);
+      stats_->RecordInsert(queueDepth);
    }
 
    return true;
@@ -371,5 +399,82 @@ const mm::ImgBuffer* CircularBuffer::GetNextImageBuffer(unsigned channel)
 
    long targetIndex = saveIndex_ % frameArray_.size();
    ++saveIndex_;
+   RecordPop(targetIndex);
    return frameArray_[targetIndex].FindImage(channel);
 }
+
+void CircularBuffer::RecordPop(long frameIndex)
+{
+   // Caller holds g_bufferLock
+   if (!stats_)
+      return;
+   stats_->RecordLatency(mm::AcquisitionStatistics::InsertToPop,
+      insertTimes_[frameIndex]);
+   stats_->RecordPop((unsigned long)(insertIndex_ - saveIndex_));
+}
+
+const mm::ImgBuffer* CircularBuffer::PinFrameImage(long frameIndex, unsigned channel)
+{
+   // Caller holds g_bufferLock
+   mm::ImgBuffer* img = frameArray_[frameIndex].FindImage(channel);
+   if (!img)
+      return 0;
+   std::pair<long, unsigned>& pin = pinnedImages_[img->GetPixels()];
+   pin.first = frameIndex;
+   ++pin.second;
+   ++framePinCounts_[frameIndex];
+   return img;
+}
+
+const mm::ImgBuffer* CircularBuffer::PinNthFromTopImageBuffer(long n,
+      unsigned channel)
+{
+   MMThreadGuard guard(g_bufferLock);
+
+   long availableImages = insertIndex_ - saveIndex_;
+   if (n + 1 > availableImages)
+      return 0;
+
+   long targetIndex = insertIndex_ - n - 1L;
+   while (targetIndex < 0)
+      targetIndex += (long) frameArray_.size();
+   targetIndex %= frameArray_.size();
+
+   return PinFrameImage(targetIndex, channel);
+}
+
+const mm::ImgBuffer* CircularBuffer::PinNextImageBuffer(unsigned channel)
+{
+   MMThreadGuard guard(g_bufferLock);
+
+   long availableImages = insertIndex_ - saveIndex_;
+   if (availableImages < 1)
+      return 0;
+
+   long targetIndex = saveIndex_ % frameArray_.size();
+   ++saveIndex_;
+   RecordPop(targetIndex);
+   return PinFrameImage(targetIndex, channel);
+}
+
+bool CircularBuffer::UnpinImage(const unsigned char* pixels)
+{
+   MMThreadGuard guard(g_bufferLock);
+
+   auto it = pinnedImages_.find(pixels);
+   if (it == pinnedImages_.end())
+      return false;
+   --framePinCounts_[it->second.first];
+   if (--it->second.second == 0)
+      pinnedImages_.erase(it);
+   return true;
+}
+
+unsigned long CircularBuffer::GetPinnedImageCount() const
+{
+   MMThreadGuard guard(g_bufferLock);
+   unsigned long count = 0;
+   for (const auto& pin : pinnedImages_)
+      count += pin.second.second;
+   return count;
+}
@@ -32,16 +32,25 @@
 #include "../MMDevice/MMDevice.h"
 
 #include <chrono>
+#include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 class ThreadPool;
 class TaskSet_CopyMemory;
 
+namespace mm {
+   class AcquisitionStatistics;
+}
+
 class CircularBuffer
 {
 public:
-   CircularBuffer(unsigned int memorySizeMB);
+   // stats, if given, receives copy times, queue depths, the time frames
+   // wait before being popped, and overflows
+   CircularBuffer(unsigned int memorySizeMB,
+      std::shared_ptr<mm::AcquisitionStatistics> stats = nullptr);
    ~CircularBuffer();
 
    unsigned GetMemorySizeMB() const { return memorySizeMB_; }
@@ -67,6 +76,13 @@ public:
    const mm::ImgBuffer* GetNextImageBuffer(unsigned channel);
    void Clear(); 
 
+   // Pinned images are not overwritten (insertion reports overflow instead)
+   // until unpinned, so that their pixels can be used without copying.
+   const mm::ImgBuffer* PinNthFromTopImageBuffer(long n, unsigned channel);
+   const mm::ImgBuffer* PinNextImageBuffer(unsigned channel);
+   bool UnpinImage(const unsigned char* pixels);
+   unsigned long GetPinnedImageCount() const;
+
    bool Overflow() {MMThreadGuard guard(g_bufferLock); return overflow_;}
 
    mutable MMThreadLock g_bufferLock;
@@ -91,6 +107,16 @@ private:
    bool overflow_;
    std::vector<mm::FrameBuffer> frameArray_;
 
+   // Pin count of each pinned image, and the frameArray_ index it belongs to
+   std::map<const unsigned char*, std::pair<long, unsigned>> pinnedImages_;
+   std::vector<unsigned> framePinCounts_; // Same size as frameArray_
+   // Insertion time of each frame, for statistics; same size as frameArray_
+   std::vector<std::chrono::steady_clock::time_point> insertTimes_;
+
+   const mm::ImgBuffer* PinFrameImage(long frameIndex, unsigned channel);
+   void RecordPop(long frameIndex);
+
    std::shared_ptr<ThreadPool> threadPool_;
    std::shared_ptr<TaskSet_CopyMemory> tasksMemCopy_;
+   std::shared_ptr<mm::AcquisitionStatistics> stats_;
 };
@@ -0,0 +1,252 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ConfigSnapshot.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Parsing of system configuration files, and a binary cache
+//                ("snapshot") of the parsed commands.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "ConfigSnapshot.h"
+
+#include "../MMDevice/DeviceUtils.h"
+#include "../MMDevice/MMDeviceConstants.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+// Snapshot file layout (all integers little-endian):
+//    char[8]  magic "MMCFGSNP"
+//    uint32   format version
+//    uint64   size of the configuration text
+//    uint64   FNV-1a hash of the configuration text
+//    uint32   number of lines, followed by each line as:
+//       uint32   line number
+//       string   text
+//       uint32   number of tokens, followed by each token as a string
+// where each string is a uint32 byte count followed by the bytes.
+
+namespace mm {
+
+namespace {
+
+const char snapshotMagic[8] = { 'M', 'M', 'C', 'F', 'G', 'S', 'N', 'P' };
+const std::uint32_t snapshotVersion = 1;
+
+std::uint64_t HashText(const std::string& text)
+{
+   std::uint64_t hash = 14695981039346656037ULL;
+   for (unsigned char ch : text)
+   {
+      hash ^= ch;
+      hash *= 1099511628211ULL;
+   }
+   return hash;
+}
+
+class Writer
+{
+   std::string buf_;
+
+public:
+   void U32(std::uint32_t v)
+   {
+      for (int i = 0; i < 4; ++i)
+         buf_.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+   }
+
+   void U64(std::uint64_t v)
+   {
+      for (int i = 0; i < 8; ++i)
+         buf_.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+   }
+
+   void Str(const std::string& s)
+   {
+      U32(static_cast<std::uint32_t>(s.size()));
+      buf_ += s;
+   }
+
+   void Raw(const char* p, std::size_t n) { buf_.append(p, n); }
+
+   const std::string& Data() const { return buf_; }
+};
+
+class Reader
+{
+   const std::string& buf_;
+   std::size_t pos_ = 0;
+   bool ok_ = true;
+
+   bool Have(std::size_t n)
+   {
+      if (!ok_ || buf_.size() - pos_ < n)
+         ok_ = false;
+      return ok_;
+   }
+
+public:
+   explicit Reader(const std::string& buf) : buf_(buf) {}
+
+   bool Ok() const { return ok_; }
+   bool AtEnd() const { return pos_ == buf_.size(); }
+
+   std::uint32_t U32()
+   {
+      std::uint32_t v = 0;
+      if (Have(4))
+      {
+         for (int i = 0; i < 4; ++i)
+            v |= static_cast<std::uint32_t>(
+                  static_cast<unsigned char>(buf_[pos_++])) << (8 * i);
+      }
+      return v;
+   }
+
+   std::uint64_t U64()
+   {
+      std::uint64_t v = 0;
+      if (Have(8))
+      {
+         for (int i = 0; i < 8; ++i)
+            v |= static_cast<std::uint64_t>(
+                  static_cast<unsigned char>(buf_[pos_++])) << (8 * i);
+      }
+      return v;
+   }
+
+   std::string Str()
+   {
+      std::uint32_t n = U32();
+      if (!Have(n))
+         return std::string();
+      std::string s = buf_.substr(pos_, n);
+      pos_ += n;
+      return s;
+   }
+
+   bool Match(const char* p, std::size_t n)
+   {
+      if (!Have(n) || buf_.compare(pos_, n, p, n) != 0)
+         return ok_ = false;
+      pos_ += n;
+      return true;
+   }
+};
+
+} // anonymous namespace
+
+std::vector<ConfigLine> ParseConfigText(const std::string& text)
+{
+   std::vector<ConfigLine> lines;
+   int lineNumber = 0;
+   std::string::size_type start = 0;
+   while (start < text.size())
+   {
+      std::string::size_type end = text.find('\n', start);
+      if (end == std::string::npos)
+         end = text.size();
+      ++lineNumber;
+
+      // Anything from a CR onwards is ignored (this also handles DOS line
+      // endings). Search this line only, not the rest of the text.
+      const std::string::size_type contentEnd =
+         std::find(text.begin() + start, text.begin() + end, '\r') -
+         text.begin();
+
+      if (contentEnd > start && text[start] != '#')
+      {
+         ConfigLine line;
+         line.lineNumber = lineNumber;
+         line.text = text.substr(start, contentEnd - start);
+         CDeviceUtils::Tokenize(line.text, line.tokens, MM::g_FieldDelimiters);
+         lines.push_back(std::move(line));
+      }
+      start = end + 1;
+   }
+   return lines;
+}
+
+std::string ConfigSnapshotPath(const std::string& configPath)
+{
+   return configPath + ".snapshot";
+}
+
+bool WriteConfigSnapshot(const std::string& snapshotPath,
+      const std::string& configText, const std::vector<ConfigLine>& lines)
+{
+   Writer w;
+   w.Raw(snapshotMagic, sizeof(snapshotMagic));
+   w.U32(snapshotVersion);
+   w.U64(configText.size());
+   w.U64(HashText(configText));
+   w.U32(static_cast<std::uint32_t>(lines.size()));
+   for (const ConfigLine& line : lines)
+   {
+      w.U32(static_cast<std::uint32_t>(line.lineNumber));
+      w.Str(line.text);
+      w.U32(static_cast<std::uint32_t>(line.tokens.size()));
+      for (const std::string& token : line.tokens)
+         w.Str(token);
+   }
+
+   std::ofstream os(snapshotPath.c_str(),
+         std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+   if (!os.is_open())
+      return false;
+   os.write(w.Data().data(), w.Data().size());
+   os.close();
+   return !os.fail();
+}
+
+bool ReadConfigSnapshot(const std::string& snapshotPath,
+      const std::string& configText, std::vector<ConfigLine>& lines)
+{
+   lines.clear();
+
+   std::ifstream is(snapshotPath.c_str(),
+         std::ios_base::in | std::ios_base::binary);
+   if (!is.is_open())
+      return false;
+   const std::string data((std::istreambuf_iterator<char>(is)),
+         std::istreambuf_iterator<char>());
+
+   Reader r(data);
+   if (!r.Match(snapshotMagic, sizeof(snapshotMagic)) ||
+         r.U32() != snapshotVersion ||
+         r.U64() != configText.size() ||
+         r.U64() != HashText(configText) ||
+         !r.Ok())
+      return false;
+
+   std::vector<ConfigLine> result;
+   std::uint32_t numLines = r.U32();
+   for (std::uint32_t i = 0; i < numLines && r.Ok(); ++i)
+   {
+      ConfigLine line;
+      line.lineNumber = static_cast<int>(r.U32());
+      line.text = r.Str();
+      std::uint32_t numTokens = r.U32();
+      for (std::uint32_t j = 0; j < numTokens && r.Ok(); ++j)
+         line.tokens.push_back(r.Str());
+      result.push_back(std::move(line));
+   }
+   if (!r.Ok() || !r.AtEnd())
+      return false;
+
+   lines.swap(result);
+   return true;
+}
+
+} // namespace mm
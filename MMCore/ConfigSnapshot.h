@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ConfigSnapshot.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Parsing of system configuration files, and a binary cache
+//                ("snapshot") of the parsed commands.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mm {
+
+// One non-empty, non-comment line of a configuration file
+struct ConfigLine
+{
+   int lineNumber = 0; // 1-based
+   std::string text; // Without line terminator
+   std::vector<std::string> tokens;
+};
+
+// Splits configuration file text into lines and tokens. Comment lines and
+// empty lines are dropped; lines consisting only of delimiters are kept (with
+// no tokens) so that the caller can report them.
+std::vector<ConfigLine> ParseConfigText(const std::string& text);
+
+// The snapshot for a configuration file is stored next to it, under this name.
+std::string ConfigSnapshotPath(const std::string& configPath);
+
+// Writes the parsed form of the given configuration text. Returns false if
+// the file could not be written.
+bool WriteConfigSnapshot(const std::string& snapshotPath,
+      const std::string& configText, const std::vector<ConfigLine>& lines);
+
+// Reads a snapshot written by WriteConfigSnapshot(). Returns false (leaving
+// lines empty) if the snapshot is missing, corrupt, written by a different
+// format version, or was not made from exactly the given configuration text.
+bool ReadConfigSnapshot(const std::string& snapshotPath,
+      const std::string& configText, std::vector<ConfigLine>& lines);
+
+} // namespace mm
@@ -28,9 +28,13 @@
 #include "../MMDevice/DeviceThreads.h"
 #include "../MMDevice/DeviceUtils.h"
 #include "../MMDevice/ImgBuffer.h"
+#include "AcquisitionStatistics.h"
 #include "CircularBuffer.h"
 #include "CoreCallback.h"
+#include "CoreFeatures.h"
 #include "DeviceManager.h"
+#include "ImageProcessingPipeline.h"
+#include "SequenceStreamer.h"
 
 #include <cassert>
 #include <chrono>
@@ -251,6 +255,7 @@ int CoreCallback::InsertImage(const MM::Device* caller, const unsigned char* buf
 
 int CoreCallback::InsertImage(const MM::Device* caller, const unsigned char* buf, unsigned width, unsigned height, unsigned byteDepth, const Metadata* pMd, bool doProcess)
 {
+   const auto received = std::chrono::steady_clock::now();
    try 
    {
       Metadata md = AddCameraMetadata(caller, pMd);
@@ -258,13 +263,18 @@ int CoreCallback::InsertImage(const MM::Device* caller, const unsigned char* buf
       if(doProcess)
       {
          MM::ImageProcessor* ip = GetImageProcessor(caller);
+         if (ip && mm::features::flags().asyncImageProcessing)
+            return SubmitForProcessing(ip, buf, width, height, byteDepth, 1, 1, md, received);
          if( NULL != ip)
          {
-            ip->Process(const_cast<unsigned char*>(buf), width, height, byteDepth);
+            RunImageProcessor(ip, buf, width, height, byteDepth);
          }
       }
       if (core_->cbuf_->InsertImage(buf, width, height, byteDepth, &md))
+      {
+         RecordInserted(received);
          return DEVICE_OK;
+      }
       else
          return DEVICE_BUFFER_OVERFLOW;
    }
@@ -283,6 +293,7 @@ int CoreCallback::InsertImage(const MM::Device* caller, const unsigned char* buf
 
 int CoreCallback::InsertImage(const MM::Device* caller, const unsigned char* buf, unsigned width, unsigned height, unsigned byteDepth, unsigned nComponents, const Metadata* pMd, bool doProcess)
 {
+   const auto received = std::chrono::steady_clock::now();
    try 
    {
       Metadata md = AddCameraMetadata(caller, pMd);
@@ -290,13 +301,18 @@ int CoreCallback::InsertImage(const MM::Device* caller, const unsigned char* buf
       if(doProcess)
       {
          MM::ImageProcessor* ip = GetImageProcessor(caller);
+         if (ip && mm::features::flags().asyncImageProcessing)
+            return SubmitForProcessing(ip, buf, width, height, byteDepth, nComponents, 1, md, received);
          if( NULL != ip)
          {
-            ip->Process(const_cast<unsigned char*>(buf), width, height, byteDepth);
+            RunImageProcessor(ip, buf, width, height, byteDepth);
          }
       }
       if (core_->cbuf_->InsertImage(buf, width, height, byteDepth, nComponents, &md))
+      {
+         RecordInserted(received);
          return DEVICE_OK;
+      }
       else
          return DEVICE_BUFFER_OVERFLOW;
    }
@@ -308,20 +324,55 @@ int CoreCallback::InsertImage(const MM::Device* caller, const unsigned char* buf
 
 int CoreCallback::InsertImage(const MM::Device* caller, const ImgBuffer & imgBuf)
 {
+   // The overload called below runs the image processor (previously it was
+   // also run here, processing each image twice).
    Metadata md = imgBuf.GetMetadata();
-   unsigned char* p = const_cast<unsigned char*>(imgBuf.GetPixels());
-   MM::ImageProcessor* ip = GetImageProcessor(caller);
-   if( NULL != ip)
-   {
-      ip->Process(p, imgBuf.Width(), imgBuf.Height(), imgBuf.Depth());
-   }
-
    return InsertImage(caller, imgBuf.GetPixels(), imgBuf.Width(), 
       imgBuf.Height(), imgBuf.Depth(), &md);
 }
 
+/**
+ * Hands an image to the asynchronous image processing pipeline, which runs
+ * the processor and inserts the result into the circular buffer on its own
+ * threads. Errors that the synchronous path would report from the insertion
+ * are checked here, as far as possible, so that the camera still sees them.
+ */
+int CoreCallback::SubmitForProcessing(MM::ImageProcessor* ip,
+      const unsigned char* buf, unsigned width, unsigned height,
+      unsigned byteDepth, unsigned nComponents, unsigned numChannels,
+      const Metadata& md, std::chrono::steady_clock::time_point received)
+{
+   CircularBuffer* cbuf = core_->cbuf_;
+   if (width != cbuf->Width() || height != cbuf->Height() ||
+         byteDepth != cbuf->Depth())
+      return DEVICE_INCOMPATIBLE_IMAGE;
+   if (cbuf->Overflow())
+      return DEVICE_BUFFER_OVERFLOW;
+
+   core_->imageProcessingPipeline_->Submit(ip, buf, width, height, byteDepth,
+         nComponents, numChannels, md, received);
+   return DEVICE_OK;
+}
+
+void CoreCallback::RunImageProcessor(MM::ImageProcessor* ip,
+      const unsigned char* buf, unsigned width, unsigned height,
+      unsigned byteDepth)
+{
+   const auto start = std::chrono::steady_clock::now();
+   ip->Process(const_cast<unsigned char*>(buf), width, height, byteDepth);
+   core_->acqStatistics_->RecordLatency(mm::AcquisitionStatistics::Processing,
+         start);
+}
+
+void CoreCallback::RecordInserted(std::chrono::steady_clock::time_point received)
+{
+   core_->acqStatistics_->RecordLatency(
+         mm::AcquisitionStatistics::CameraToInsert, received);
+}
+
 void CoreCallback::ClearImageBuffer(const MM::Device* /*caller*/)
 {
+   core_->imageProcessingPipeline_->Drain();
    core_->cbuf_->Clear();
 }
 
@@ -332,6 +383,7 @@ bool CoreCallback::InitializeImageBuffer(unsigned channels, unsigned slices,
    if (slices != 1)
       return false;
 
+   core_->imageProcessingPipeline_->Drain();
    return core_->cbuf_->Initialize(channels, w, h, pixDepth);
 }
 
@@ -343,17 +395,23 @@ int CoreCallback::InsertMultiChannel(const MM::Device* caller,
                               unsigned byteDepth,
                               Metadata* pMd)
 {
+   const auto received = std::chrono::steady_clock::now();
    try
    {
       Metadata md = AddCameraMetadata(caller, pMd);
 
       MM::ImageProcessor* ip = GetImageProcessor(caller);
+      if (ip && mm::features::flags().asyncImageProcessing)
+         return SubmitForProcessing(ip, buf, width, height, byteDepth, 1, numChannels, md, received);
       if( NULL != ip)
       {
-         ip->Process( const_cast<unsigned char*>(buf), width, height, byteDepth);
+         RunImageProcessor(ip, buf, width, height, byteDepth);
       }
       if (core_->cbuf_->InsertMultiChannel(buf, numChannels, width, height, byteDepth, &md))
+      {
+         RecordInserted(received);
          return DEVICE_OK;
+      }
       else
          return DEVICE_BUFFER_OVERFLOW;
    }
@@ -425,6 +483,9 @@ int CoreCallback::AcqFinished(const MM::Device* caller, int /*statusCode*/)
       }
    }
 
+   // Images still being processed belong to the finished sequence
+   core_->imageProcessingPipeline_->Drain();
+
    // Notify that sequence acquisition has stopped
    if (core_->externalCallback_)
    {
@@ -489,7 +550,7 @@ int CoreCallback::OnPropertyChanged(const MM::Device* device, const char* propNa
       const PropertySetting* ps = new PropertySetting(label, propName, value, readOnly);
       {
          MMThreadGuard scg(core_->stateCacheLock_);
-         core_->stateCache_.addSetting(*ps);
+         core_->addStateCacheSetting(*ps);
       }
       core_->externalCallback_->onPropertyChanged(label, propName, value);
 
@@ -622,6 +683,17 @@ int CoreCallback::OnXYStagePositionChanged(const MM::Device* device, double xPos
    return DEVICE_OK;
 }
 
+/**
+ * Handler for a streamed sequence having room for more values
+ */
+int CoreCallback::OnSequenceBufferLow(const MM::Device* /* caller */)
+{
+   // Streams are refilled from the streamer's thread, never from the
+   // device's (which may be holding its own locks)
+   core_->sequenceStreamer_->Notify();
+   return DEVICE_OK;
+}
+
 /**
  * Handler for exposure update
  * 
@@ -697,6 +769,19 @@ int CoreCallback::SetSerialProperties(const char* portName,
    return DEVICE_OK;
 }
 
+/**
+ * Identifies the device using a serial port, for the port's scheduler.
+ */
+std::string CoreCallback::GetCallerLabel(const MM::Device* caller)
+{
+   if (!caller)
+      return std::string();
+   char label[MM::MaxStrLength];
+   label[0] = '\0';
+   caller->GetLabel(label);
+   return label;
+}
+
 /**
  * Sends an array of bytes to the port.
  */
@@ -720,7 +805,7 @@ int CoreCallback::WriteToSerial(const MM::Device* caller, const char* portName,
    if (pSerial->GetRawPtr() == caller)
       return DEVICE_SELF_REFERENCE;
 
-   return pSerial->Write(buf, length);
+   return pSerial->Write(GetCallerLabel(caller), buf, length);
 }
    
 /**
@@ -746,7 +831,7 @@ int CoreCallback::ReadFromSerial(const MM::Device* caller, const char* portName,
    if (pSerial->GetRawPtr() == caller)
       return DEVICE_SELF_REFERENCE;
 
-   return pSerial->Read(buf, bufLength, bytesRead);
+   return pSerial->Read(GetCallerLabel(caller), buf, bufLength, bytesRead);
 }
 
 /**
@@ -772,16 +857,16 @@ int CoreCallback::PurgeSerial(const MM::Device* caller, const char* portName)
    if (pSerial->GetRawPtr() == caller)
       return DEVICE_SELF_REFERENCE;
 
-   return pSerial->Purge();
+   return pSerial->Purge(GetCallerLabel(caller));
 }
 
 /**
  * Sends an ASCII command terminated by the specified character sequence.
  */
-int CoreCallback::SetSerialCommand(const MM::Device*, const char* portName, const char* command, const char* term)
+int CoreCallback::SetSerialCommand(const MM::Device* caller, const char* portName, const char* command, const char* term)
 {
    try {
-      core_->setSerialPortCommand(portName, command, term);
+      core_->setSerialPortCommandImpl(GetCallerLabel(caller), portName, command, term);
    }
    catch (...)
    {
@@ -796,11 +881,11 @@ int CoreCallback::SetSerialCommand(const MM::Device*, const char* portName, cons
  * The terminator string is stripped of the answer. If the termination code is not
  * received within the com port timeout and error will be flagged.
  */
-int CoreCallback::GetSerialAnswer(const MM::Device*, const char* portName, unsigned long ansLength, char* answerTxt, const char* term)
+int CoreCallback::GetSerialAnswer(const MM::Device* caller, const char* portName, unsigned long ansLength, char* answerTxt, const char* term)
 {
    std::string answer;
    try {
-      answer = core_->getSerialPortAnswer(portName, term);
+      answer = core_->getSerialPortAnswerImpl(GetCallerLabel(caller), portName, term);
       if (answer.length() >= ansLength)
          return DEVICE_SERIAL_BUFFER_OVERRUN;
    }
@@ -813,6 +898,87 @@ int CoreCallback::GetSerialAnswer(const MM::Device*, const char* portName, unsig
    return DEVICE_OK;
 }
 
+/**
+ * Sends several ASCII commands and receives their answers, in order.
+ * Each answer is written to its own ansLength-sized slot in answers.
+ */
+int CoreCallback::TransactSerialCommands(const MM::Device* caller, const char* portName, const char* const* commands, unsigned numCommands, const char* commandTerm, unsigned long ansLength, char* answers, const char* answerTerm)
+{
+   std::vector<std::string> answerList;
+   try {
+      answerList = core_->transactSerialPortCommandsImpl(GetCallerLabel(caller), portName,
+            std::vector<std::string>(commands, commands + numCommands),
+            commandTerm, answerTerm);
+      for (const std::string& answer : answerList)
+      {
+         if (answer.length() >= ansLength)
+            return DEVICE_SERIAL_BUFFER_OVERRUN;
+      }
+   }
+   catch (...)
+   {
+      // trap all exceptions and return generic serial error
+      return DEVICE_SERIAL_COMMAND_FAILED;
+   }
+   for (std::size_t i = 0; i < answerList.size(); ++i)
+      strcpy(answers + i * ansLength, answerList[i].c_str());
+   return DEVICE_OK;
+}
+
+/**
+ * Keeps the port for the caller until EndSerialTransaction().
+ */
+int CoreCallback::BeginSerialTransaction(const MM::Device* caller, const char* portName)
+{
+   std::shared_ptr<SerialInstance> pSerial;
+   try
+   {
+      pSerial = core_->deviceManager_->GetDeviceOfType<SerialInstance>(portName);
+   }
+   catch (CMMError& err)
+   {
+      return err.getCode();
+   }
+   catch (...)
+   {
+      return DEVICE_SERIAL_COMMAND_FAILED;
+   }
+
+   // don't allow self reference
+   if (pSerial->GetRawPtr() == caller)
+      return DEVICE_SELF_REFERENCE;
+
+   pSerial->BeginTransaction(GetCallerLabel(caller));
+   return DEVICE_OK;
+}
+
+/**
+ * Releases the port kept by BeginSerialTransaction().
+ */
+int CoreCallback::EndSerialTransaction(const MM::Device* caller, const char* portName)
+{
+   std::shared_ptr<SerialInstance> pSerial;
+   try
+   {
+      pSerial = core_->deviceManager_->GetDeviceOfType<SerialInstance>(portName);
+   }
+   catch (CMMError& err)
+   {
+      return err.getCode();
+   }
+   catch (...)
+   {
+      return DEVICE_SERIAL_COMMAND_FAILED;
+   }
+
+   // don't allow self reference
+   if (pSerial->GetRawPtr() == caller)
+      return DEVICE_SELF_REFERENCE;
+
+   pSerial->EndTransaction(GetCallerLabel(caller));
+   return DEVICE_OK;
+}
+
 const char* CoreCallback::GetImage()
 {
    try
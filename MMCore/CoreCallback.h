@@ -30,6 +30,8 @@
 #include "MMEventCallback.h"
 #include "../MMDevice/DeviceUtils.h"
 
+#include <chrono>
+
 namespace mm
 {
    class DeviceManager;
@@ -75,6 +77,9 @@ public:
    int PurgeSerial(const MM::Device* caller, const char* portName);
    int SetSerialCommand(const MM::Device*, const char* portName, const char* command, const char* term);
    int GetSerialAnswer(const MM::Device*, const char* portName, unsigned long ansLength, char* answerTxt, const char* term);
+   int TransactSerialCommands(const MM::Device*, const char* portName, const char* const* commands, unsigned numCommands, const char* commandTerm, unsigned long ansLength, char* answers, const char* answerTerm);
+   int BeginSerialTransaction(const MM::Device* caller, const char* portName);
+   int EndSerialTransaction(const MM::Device* caller, const char* portName);
 
    /*Deprecated*/ unsigned long GetClockTicksUs(const MM::Device* caller);
 
@@ -117,6 +122,7 @@ public:
    int OnPropertyChanged(const MM::Device* device, const char* propName, const char* value);
    int OnStagePositionChanged(const MM::Device* device, double pos);
    int OnXYStagePositionChanged(const MM::Device* device, double xpos, double ypos);
+   int OnSequenceBufferLow(const MM::Device* caller);
    int OnExposureChanged(const MM::Device* device, double newExposure);
    int OnSLMExposureChanged(const MM::Device* device, double newExposure);
    int OnMagnifierChanged(const MM::Device* device);
@@ -141,6 +147,14 @@ private:
    MMThreadLock* pValueChangeLock_;
 
    Metadata AddCameraMetadata(const MM::Device* caller, const Metadata* pMd);
+   int SubmitForProcessing(MM::ImageProcessor* ip, const unsigned char* buf,
+         unsigned width, unsigned height, unsigned byteDepth,
+         unsigned nComponents, unsigned numChannels, const Metadata& md,
+         std::chrono::steady_clock::time_point received);
+   void RunImageProcessor(MM::ImageProcessor* ip, const unsigned char* buf,
+         unsigned width, unsigned height, unsigned byteDepth);
+   void RecordInserted(std::chrono::steady_clock::time_point received);
+   static std::string GetCallerLabel(const MM::Device* caller);
 
    int OnConfigGroupChanged(const char* groupName, const char* newConfigName);
    int OnPixelSizeChanged(double newPixelSizeUm);
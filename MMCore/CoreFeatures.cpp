@@ -118,6 +118,25 @@ const auto& featureMap() {
             [](bool e) { g_flags.ParallelDeviceInitialization = e; }
          }
       },
+      {
+         "ConfigSnapshots", {
+            [] { return g_flags.configSnapshots; },
+            [](bool e) { g_flags.configSnapshots = e; }
+            // Off by default because skipping property writes relies on
+            // devices reporting their actual state, which is not true of
+            // every device adapter.
+         }
+      },
+      {
+         "AsyncImageProcessing", {
+            [] { return g_flags.asyncImageProcessing; },
+            [](bool e) { g_flags.asyncImageProcessing = e; }
+            // Off by default because errors thrown by the circular buffer
+            // are only logged (not returned to the camera) for images
+            // already queued, and because image processors then run on a
+            // thread other than the camera's.
+         }
+      },
       // How to add a new Core feature: see the comment at the top of this file.
       // Features (the string names) must never be removed once added!
    };
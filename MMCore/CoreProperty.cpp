@@ -25,6 +25,7 @@
 //
 
 #include "CoreProperty.h"
+#include "AcquisitionStatistics.h"
 #include "CoreUtils.h"
 #include "MMCore.h"
 #include "Error.h"
@@ -160,6 +161,10 @@ void CorePropertyCollection::Execute(const char* propName, const char* value)
    {
       core_->setChannelGroup(value);
    }
+   else if (strcmp(propName, mm::AcquisitionStatistics::LogIntervalProperty) == 0)
+   {
+      core_->setAcquisitionStatisticsLogInterval(atol(value));
+   }
    // unknown property
    else
    {
@@ -181,6 +186,8 @@ std::string CorePropertyCollection::Get(const char* propName) const
             ToString(propName) + ")",
             MMERR_InvalidCoreProperty);
 
+   if (mm::AcquisitionStatistics::IsStatisticsProperty(propName))
+      return core_->acqStatistics_->GetPropertyValue(propName);
    return it->second.Get();
 }
 
@@ -241,6 +248,10 @@ void CorePropertyCollection::Refresh()
    // Channel group
    Set(MM::g_Keyword_CoreChannelGroup, core_->getChannelGroup().c_str());
 
+   // Statistics log interval (the statistics themselves are read on demand)
+   Set(mm::AcquisitionStatistics::LogIntervalProperty,
+      CDeviceUtils::ConvertToString(core_->getAcquisitionStatisticsLogInterval()));
+
 }
 
 bool CorePropertyCollection::IsReadOnly(const char* propName) const
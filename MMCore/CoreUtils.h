@@ -88,4 +88,32 @@ inline std::string ToQuotedString<const char*>(char const* const& d)
    if (!d) // Don't quote if null
       return ToString(d);
    return "\"" + ToString(d) + "\"";
+}
+
+// Appends str to json as a quoted JSON string
+inline void AppendJSONString(std::string& json, const std::string& str)
+{
+   static const char hex[] = "0123456789abcdef";
+   json += '"';
+   for (char ch : str)
+   {
+      switch (ch)
+      {
+         case '"': json += "\\\""; break;
+         case '\\': json += "\\\\"; break;
+         case '\n': json += "\\n"; break;
+         case '\r': json += "\\r"; break;
+         case '\t': json += "\\t"; break;
+         default:
+            if (static_cast<unsigned char>(ch) < 0x20)
+            {
+               json += "\\u00";
+               json += hex[(ch >> 4) & 0x0f];
+               json += hex[ch & 0x0f];
+            }
+            else
+               json += ch;
+      }
+   }
+   json += '"';
 }
\ No newline at end of file
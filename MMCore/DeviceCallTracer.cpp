@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          DeviceCallTracer.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Records the timing of calls from the Core into device
+//                adapters, for export as a Chrome trace.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "DeviceCallTracer.h"
+
+#include "CoreUtils.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace mm {
+
+namespace {
+
+std::atomic<std::uint32_t> g_nextThreadId{1};
+thread_local std::uint32_t t_threadId = 0;
+thread_local std::int64_t t_pendingLockWait = 0;
+
+std::uint32_t CurrentThreadId()
+{
+   if (t_threadId == 0)
+      t_threadId = g_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+   return t_threadId;
+}
+
+std::size_t RoundUpToPowerOf2(std::size_t n)
+{
+   std::size_t p = 1;
+   while (p < n)
+      p *= 2;
+   return p;
+}
+
+void AppendMicroseconds(std::string& json, std::int64_t ticks)
+{
+   const double us = std::chrono::duration<double, std::micro>(
+      DeviceCallTracer::Clock::duration(ticks)).count();
+   char buf[32];
+   std::snprintf(buf, sizeof(buf), "%.3f", us);
+   json += buf;
+}
+
+struct CallRecord
+{
+   const char* method;
+   std::uint32_t labelId;
+   std::uint32_t threadId;
+   std::int64_t start;
+   std::int64_t duration;
+   std::int64_t lockWait;
+};
+
+} // anonymous namespace
+
+DeviceCallTracer::DeviceCallTracer(std::size_t capacity) :
+   capacity_(RoundUpToPowerOf2((std::max)(capacity, std::size_t(1)))),
+   slots_(new Slot[capacity_]),
+   enabled_(false),
+   next_(0),
+   clearedAt_(0),
+   epoch_(Clock::now())
+{
+}
+
+std::uint32_t DeviceCallTracer::RegisterLabel(const std::string& label)
+{
+   std::lock_guard<std::mutex> lock(labelMutex_);
+   auto it = std::find(labels_.begin(), labels_.end(), label);
+   if (it != labels_.end())
+      return static_cast<std::uint32_t>(it - labels_.begin());
+   labels_.push_back(label);
+   return static_cast<std::uint32_t>(labels_.size() - 1);
+}
+
+void DeviceCallTracer::Record(const char* method, std::uint32_t labelId,
+   Clock::time_point start, Clock::time_point end, Clock::duration lockWait)
+{
+   const std::uint64_t index = next_.fetch_add(1, std::memory_order_relaxed);
+   Slot& slot = slots_[index & (capacity_ - 1)];
+   slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+   slot.method.store(method, std::memory_order_relaxed);
+   slot.labelId.store(labelId, std::memory_order_relaxed);
+   slot.threadId.store(CurrentThreadId(), std::memory_order_relaxed);
+   slot.start.store((start - epoch_).count(), std::memory_order_relaxed);
+   slot.duration.store((end - start).count(), std::memory_order_relaxed);
+   slot.lockWait.store(lockWait.count(), std::memory_order_relaxed);
+   slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+void DeviceCallTracer::Clear()
+{
+   clearedAt_.store(next_.load());
+}
+
+std::size_t DeviceCallTracer::GetRecordCount() const
+{
+   const std::uint64_t end = next_.load();
+   const std::uint64_t begin = (std::max)(clearedAt_.load(),
+      end > capacity_ ? end - capacity_ : std::uint64_t(0));
+   return static_cast<std::size_t>(end - begin);
+}
+
+std::string DeviceCallTracer::ToChromeTraceJSON() const
+{
+   const std::uint64_t end = next_.load(std::memory_order_acquire);
+   const std::uint64_t begin = (std::max)(clearedAt_.load(),
+      end > capacity_ ? end - capacity_ : std::uint64_t(0));
+
+   std::vector<CallRecord> records;
+   records.reserve(static_cast<std::size_t>(end - begin));
+   for (std::uint64_t index = begin; index < end; ++index)
+   {
+      const Slot& slot = slots_[index & (capacity_ - 1)];
+      const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence != 2 * index + 2)
+         continue; // Still being written, or already overwritten
+      CallRecord r;
+      r.method = slot.method.load(std::memory_order_relaxed);
+      r.labelId = slot.labelId.load(std::memory_order_relaxed);
+      r.threadId = slot.threadId.load(std::memory_order_relaxed);
+      r.start = slot.start.load(std::memory_order_relaxed);
+      r.duration = slot.duration.load(std::memory_order_relaxed);
+      r.lockWait = slot.lockWait.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+         continue;
+      records.push_back(r);
+   }
+
+   // Calls are recorded when they return; viewers expect start order
+   std::stable_sort(records.begin(), records.end(),
+      [](const CallRecord& a, const CallRecord& b) { return a.start < b.start; });
+
+   std::vector<std::string> labels;
+   {
+      std::lock_guard<std::mutex> lock(labelMutex_);
+      labels.assign(labels_.begin(), labels_.end());
+   }
+
+   std::string json;
+   json.reserve(64 + 160 * records.size());
+   json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+   json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+      "\"args\":{\"name\":\"MMCore device calls\"}}";
+   for (const CallRecord& r : records)
+   {
+      const std::string label = r.labelId < labels.size() ?
+         labels[r.labelId] : std::string();
+      json += ",{\"name\":";
+      AppendJSONString(json, r.method ? r.method : "");
+      json += ",\"cat\":";
+      AppendJSONString(json, label);
+      json += ",\"ph\":\"X\",\"ts\":";
+      AppendMicroseconds(json, r.start);
+      json += ",\"dur\":";
+      AppendMicroseconds(json, r.duration);
+      json += ",\"pid\":1,\"tid\":";
+      json += std::to_string(r.threadId);
+      json += ",\"args\":{\"device\":";
+      AppendJSONString(json, label);
+      json += ",\"lockWaitUs\":";
+      AppendMicroseconds(json, r.lockWait);
+      json += "}}";
+   }
+   json += "]}";
+   return json;
+}
+
+void DeviceCallTracer::SetPendingLockWait(Clock::duration wait)
+{
+   t_pendingLockWait = wait.count();
+}
+
+DeviceCallTracer::Clock::duration DeviceCallTracer::TakePendingLockWait()
+{
+   const std::int64_t wait = t_pendingLockWait;
+   t_pendingLockWait = 0;
+   return Clock::duration(wait);
+}
+
+} // namespace mm
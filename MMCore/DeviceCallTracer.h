@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          DeviceCallTracer.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Records the timing of calls from the Core into device
+//                adapters, for export as a Chrome trace.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace mm {
+
+// Fixed-size ring of device call records. While enabled, DeviceInstance
+// records every call it makes into the device adapter: the method, the device
+// label, the start time and duration, the calling thread, and how long the
+// caller waited for the adapter's module lock beforehand.
+//
+// Record() is lock-free and may be called from any thread; once the ring is
+// full the oldest records are overwritten. Export may run concurrently with
+// recording and skips records that are being overwritten.
+class DeviceCallTracer
+{
+public:
+   using Clock = std::chrono::steady_clock;
+
+   // capacity is rounded up to a power of 2
+   explicit DeviceCallTracer(std::size_t capacity = 65536);
+
+   DeviceCallTracer(const DeviceCallTracer&) = delete;
+   DeviceCallTracer& operator=(const DeviceCallTracer&) = delete;
+
+   void Enable(bool enable) { enabled_.store(enable); }
+   bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+   std::size_t GetCapacity() const { return capacity_; }
+
+   // Returns a small id for a device label; the same label always gets the
+   // same id. Called when a device is loaded, not per call.
+   std::uint32_t RegisterLabel(const std::string& label);
+
+   // method must have static storage duration (e.g. __func__)
+   void Record(const char* method, std::uint32_t labelId,
+      Clock::time_point start, Clock::time_point end,
+      Clock::duration lockWait);
+
+   // Discard all records made so far
+   void Clear();
+
+   // Number of records currently held (at most the capacity)
+   std::size_t GetRecordCount() const;
+
+   // The records in Chrome trace-event format (a JSON object with a
+   // "traceEvents" array of complete events), loadable by chrome://tracing
+   // and Perfetto. Timestamps are microseconds since the tracer was created.
+   std::string ToChromeTraceJSON() const;
+
+   // Hand-off of the module lock wait from DeviceModuleLockGuard to the
+   // next call recorded on the same thread
+   static void SetPendingLockWait(Clock::duration wait);
+   static Clock::duration TakePendingLockWait();
+
+private:
+   struct Slot
+   {
+      // 2 * index + 1 while being written, 2 * index + 2 when complete
+      std::atomic<std::uint64_t> sequence{0};
+      std::atomic<const char*> method{nullptr};
+      std::atomic<std::uint32_t> labelId{0};
+      std::atomic<std::uint32_t> threadId{0};
+      std::atomic<std::int64_t> start{0};
+      std::atomic<std::int64_t> duration{0};
+      std::atomic<std::int64_t> lockWait{0};
+   };
+
+   const std::size_t capacity_; // A power of 2
+   std::unique_ptr<Slot[]> slots_;
+   std::atomic<bool> enabled_;
+   std::atomic<std::uint64_t> next_;
+   std::atomic<std::uint64_t> clearedAt_;
+   const Clock::time_point epoch_;
+
+   mutable std::mutex labelMutex_;
+   std::deque<std::string> labels_;
+};
+
+} // namespace mm
@@ -19,6 +19,7 @@
 
 #include "Devices/HubInstance.h"
 #include "CoreUtils.h"
+#include "DeviceCallTracer.h"
 #include "Devices/DeviceInstance.h"
 #include "Error.h"
 #include "LoadableModules/LoadedDeviceAdapter.h"
@@ -294,8 +295,22 @@ DeviceManager::GetParentDevice(std::shared_ptr<DeviceInstance> device) const
 
 
 DeviceModuleLockGuard::DeviceModuleLockGuard(std::shared_ptr<DeviceInstance> device) :
+   traced_(device->IsCallTracingEnabled()),
+   start_(traced_ ? std::chrono::steady_clock::now() :
+         std::chrono::steady_clock::time_point()),
    g_(device->GetAdapterModule()->GetLock())
-{}
+{
+   if (traced_)
+      DeviceCallTracer::SetPendingLockWait(
+            std::chrono::steady_clock::now() - start_);
+}
+
+DeviceModuleLockGuard::~DeviceModuleLockGuard()
+{
+   if (traced_)
+      DeviceCallTracer::SetPendingLockWait(
+            std::chrono::steady_clock::duration::zero());
+}
 
 
 } // namespace mm
@@ -24,6 +24,7 @@
 #include "Error.h"
 #include "Logging/Logger.h"
 
+#include <chrono>
 #include <map>
 #include <memory>
 #include <string>
@@ -132,12 +133,17 @@ public:
 };
 
 
-// Scoped acquisition of a device's module's lock
+// Scoped acquisition of a device's module's lock. While call tracing is
+// enabled, the time spent waiting for the lock is attributed to the next
+// device call made on this thread.
 class DeviceModuleLockGuard
 {
+   const bool traced_;
+   const std::chrono::steady_clock::time_point start_;
    MMThreadGuard g_;
 public:
    explicit DeviceModuleLockGuard(std::shared_ptr<DeviceInstance> device);
+   ~DeviceModuleLockGuard();
 };
 
 } // namespace mm
@@ -82,4 +82,5 @@ public:
    int ClearExposureSequence();
    int AddToExposureSequence(double exposureTime_ms);
    int SendExposureSequence() const;
+   int SetExposureSequence(const double* exposureTimes_ms, long numExposures);
 };
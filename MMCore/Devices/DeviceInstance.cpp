@@ -24,6 +24,7 @@
 #include "../../MMDevice/MMDevice.h"
 #include "../CoreFeatures.h"
 #include "../CoreUtils.h"
+#include "../DeviceCallTracer.h"
 #include "../Error.h"
 #include "../LoadableModules/LoadedDeviceAdapter.h"
 #include "../Logging/Logger.h"
@@ -55,6 +56,12 @@ DeviceInstance::DeviceInstance(CMMCore* core,
    deviceLogger_(deviceLogger),
    coreLogger_(coreLogger)
 {
+   if (core_)
+   {
+      callTracer_ = core_->deviceCallTracer_;
+      callTraceLabelId_ = callTracer_->RegisterLabel(label_);
+   }
+
    const std::string actualName = GetName();
    if (actualName != name)
    {
@@ -142,6 +149,56 @@ DeviceInstance::RequireInitialized(const char* operation) const
    }
 }
 
+bool
+DeviceInstance::IsCallTracingEnabled() const
+{
+   return callTracer_ && callTracer_->IsEnabled();
+}
+
+DeviceInstance::TracedCall::TracedCall(mm::DeviceCallTracer* tracer,
+      const char* method, std::uint32_t labelId) :
+   tracer_(tracer),
+   method_(method),
+   labelId_(labelId)
+{
+   if (tracer_)
+   {
+      lockWait_ = mm::DeviceCallTracer::TakePendingLockWait();
+      start_ = std::chrono::steady_clock::now();
+   }
+}
+
+DeviceInstance::TracedCall::TracedCall(TracedCall&& other) :
+   tracer_(other.tracer_),
+   method_(other.method_),
+   labelId_(other.labelId_),
+   start_(other.start_),
+   lockWait_(other.lockWait_)
+{
+   other.tracer_ = nullptr;
+}
+
+DeviceInstance::TracedCall::~TracedCall()
+{
+   if (tracer_)
+      tracer_->Record(method_, labelId_, start_,
+            std::chrono::steady_clock::now(), lockWait_);
+}
+
+DeviceInstance::TracedCall
+DeviceInstance::TraceCall(const char* method) const
+{
+   return TracedCall(IsCallTracingEnabled() ? callTracer_.get() : nullptr,
+         method, callTraceLabelId_);
+}
+
+DeviceInstance::TracedCall
+DeviceInstance::BeginCall(const char* method) const
+{
+   RequireInitialized(method);
+   return TraceCall(method);
+}
+
 void
 DeviceInstance::DeviceStringBuffer::ThrowBufferOverflowError() const
 {
@@ -164,12 +221,13 @@ DeviceInstance::GetPropertyNames() const
 
 unsigned
 DeviceInstance::GetNumberOfProperties() const
-{ return pImpl_->GetNumberOfProperties(); }
+{ auto call = TraceCall(__func__); return pImpl_->GetNumberOfProperties(); }
 
 std::string
 DeviceInstance::GetProperty(const std::string& name) const
 {
    DeviceStringBuffer valueBuf(this, "GetProperty");
+   auto call = TraceCall(__func__);
    int err = pImpl_->GetProperty(name.c_str(), valueBuf.GetBuffer());
    ThrowIfError(err, "Cannot get value of property " +
          ToQuotedString(name));
@@ -198,6 +256,7 @@ DeviceInstance::SetProperty(const std::string& name,
    LOG_DEBUG(Logger()) << "Will set property \"" << name << "\" to \"" <<
       value << "\"";
 
+   auto call = TraceCall(__func__);
    int err = pImpl_->SetProperty(name.c_str(), value.c_str());
 
    ThrowIfError(err, "Cannot set property " + ToQuotedString(name) +
@@ -209,12 +268,13 @@ DeviceInstance::SetProperty(const std::string& name,
 
 bool
 DeviceInstance::HasProperty(const std::string& name) const
-{ return pImpl_->HasProperty(name.c_str()); }
+{ auto call = TraceCall(__func__); return pImpl_->HasProperty(name.c_str()); }
 
 std::string
 DeviceInstance::GetPropertyName(size_t idx) const
 {
    DeviceStringBuffer nameBuf(this, "GetPropertyName");
+   auto call = TraceCall(__func__);
    bool ok = pImpl_->GetPropertyName(static_cast<unsigned>(idx), nameBuf.GetBuffer());
    if (!ok)
       ThrowError("Cannot get property name at index " + ToString(idx));
@@ -225,6 +285,7 @@ bool
 DeviceInstance::GetPropertyReadOnly(const char* name) const
 {
    bool readOnly;
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->GetPropertyReadOnly(name, readOnly));
    return readOnly;
 }
@@ -233,6 +294,7 @@ bool
 DeviceInstance::GetPropertyInitStatus(const char* name) const
 {
    bool isPreInit;
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->GetPropertyInitStatus(name, isPreInit));
    return isPreInit;
 }
@@ -241,6 +303,7 @@ bool
 DeviceInstance::HasPropertyLimits(const char* name) const
 {
    bool hasLimits;
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->HasPropertyLimits(name, hasLimits));
    return hasLimits;
 }
@@ -249,6 +312,7 @@ double
 DeviceInstance::GetPropertyLowerLimit(const char* name) const
 {
    double lowLimit;
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->GetPropertyLowerLimit(name, lowLimit));
    return lowLimit;
 }
@@ -257,6 +321,7 @@ double
 DeviceInstance::GetPropertyUpperLimit(const char* name) const
 {
    double highLimit;
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->GetPropertyUpperLimit(name, highLimit));
    return highLimit;
 }
@@ -265,18 +330,20 @@ MM::PropertyType
 DeviceInstance::GetPropertyType(const char* name) const
 {
    MM::PropertyType propType;
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->GetPropertyType(name, propType));
    return propType;
 }
 
 unsigned
 DeviceInstance::GetNumberOfPropertyValues(const char* propertyName) const
-{ return pImpl_->GetNumberOfPropertyValues(propertyName); }
+{ auto call = TraceCall(__func__); return pImpl_->GetNumberOfPropertyValues(propertyName); }
 
 std::string
 DeviceInstance::GetPropertyValueAt(const std::string& propertyName, unsigned index) const
 {
    DeviceStringBuffer valueBuf(this, "GetPropertyValueAt");
+   auto call = TraceCall(__func__);
    bool ok = pImpl_->GetPropertyValueAt(propertyName.c_str(), index,
          valueBuf.GetBuffer());
    if (!ok)
@@ -293,6 +360,7 @@ bool
 DeviceInstance::IsPropertySequenceable(const char* name) const
 {
    bool isSequenceable;
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->IsPropertySequenceable(name, isSequenceable));
    return isSequenceable;
 }
@@ -301,6 +369,7 @@ long
 DeviceInstance::GetPropertySequenceMaxLength(const char* propertyName) const
 {
    long nrEvents;
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->GetPropertySequenceMaxLength(propertyName, nrEvents));
    return nrEvents;
 }
@@ -308,37 +377,55 @@ DeviceInstance::GetPropertySequenceMaxLength(const char* propertyName) const
 void
 DeviceInstance::StartPropertySequence(const char* propertyName)
 {
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->StartPropertySequence(propertyName));
 }
 
 void
 DeviceInstance::StopPropertySequence(const char* propertyName)
 {
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->StopPropertySequence(propertyName));
 }
 
 void
 DeviceInstance::ClearPropertySequence(const char* propertyName)
 {
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->ClearPropertySequence(propertyName));
 }
 
 void
 DeviceInstance::AddToPropertySequence(const char* propertyName, const char* value)
 {
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->AddToPropertySequence(propertyName, value));
 }
 
 void
 DeviceInstance::SendPropertySequence(const char* propertyName)
 {
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->SendPropertySequence(propertyName));
 }
 
+bool
+DeviceInstance::SetPropertySequence(const char* propertyName,
+      const char* const* values, long numValues)
+{
+   auto call = TraceCall(__func__);
+   int err = pImpl_->SetPropertySequence(propertyName, values, numValues);
+   if (err == DEVICE_UNSUPPORTED_COMMAND)
+      return false;
+   ThrowIfError(err);
+   return true;
+}
+
 std::string
 DeviceInstance::GetErrorText(int code) const
 {
    DeviceStringBuffer msgBuf(this, "GetErrorText");
+   auto call = TraceCall(__func__);
    bool ok = pImpl_->GetErrorText(code, msgBuf.GetBuffer());
    if (ok)
    {
@@ -352,21 +439,21 @@ DeviceInstance::GetErrorText(int code) const
 bool
 DeviceInstance::Busy()
 {
-   RequireInitialized(__func__);
+   auto call = BeginCall(__func__);
    return pImpl_->Busy();
 }
 
 double
 DeviceInstance::GetDelayMs() const
-{ return pImpl_->GetDelayMs(); }
+{ auto call = TraceCall(__func__); return pImpl_->GetDelayMs(); }
 
 void
 DeviceInstance::SetDelayMs(double delay)
-{ pImpl_->SetDelayMs(delay); }
+{ auto call = TraceCall(__func__); pImpl_->SetDelayMs(delay); }
 
 bool
 DeviceInstance::UsesDelay()
-{ return pImpl_->UsesDelay(); }
+{ auto call = TraceCall(__func__); return pImpl_->UsesDelay(); }
 
 void
 DeviceInstance::Initialize()
@@ -375,6 +462,7 @@ DeviceInstance::Initialize()
    if (initializeCalled_)
       ThrowError("Device already initialized (or initialization already attempted)");
    initializeCalled_ = true;
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->Initialize());
    initialized_ = true;
 }
@@ -384,17 +472,19 @@ DeviceInstance::Shutdown()
 {
    // Note we do not require device to be initialized before calling Shutdown().
    initialized_ = false;
+   auto call = TraceCall(__func__);
    ThrowIfError(pImpl_->Shutdown());
 }
 
 MM::DeviceType
 DeviceInstance::GetType() const
-{ return pImpl_->GetType(); }
+{ auto call = TraceCall(__func__); return pImpl_->GetType(); }
 
 std::string
 DeviceInstance::GetName() const
 {
    DeviceStringBuffer nameBuf(this, "GetName");
+   auto call = TraceCall(__func__);
    pImpl_->GetName(nameBuf.GetBuffer());
    return nameBuf.Get();
 }
@@ -407,21 +497,23 @@ DeviceInstance::SetCallback(MM::Core* callback) {
 bool
 DeviceInstance::SupportsDeviceDetection()
 {
+    auto call = TraceCall(__func__);
     return pImpl_->SupportsDeviceDetection();
 }
 
 MM::DeviceDetectionStatus
 DeviceInstance::DetectDevice()
-{ return pImpl_->DetectDevice(); }
+{ auto call = TraceCall(__func__); return pImpl_->DetectDevice(); }
 
 void
 DeviceInstance::SetParentID(const char* parentId)
-{ pImpl_->SetParentID(parentId); }
+{ auto call = TraceCall(__func__); pImpl_->SetParentID(parentId); }
 
 std::string
 DeviceInstance::GetParentID() const
 {
    DeviceStringBuffer nameBuf(this, "GetParentID");
+   auto call = TraceCall(__func__);
    pImpl_->GetParentID(nameBuf.GetBuffer());
    return nameBuf.Get();
 }
@@ -23,6 +23,8 @@
 #include "../Error.h"
 #include "../Logging/Logger.h"
 
+#include <chrono>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <memory>
@@ -37,6 +39,10 @@ namespace MM
    class Core;
    class Device;
 }
+namespace mm
+{
+   class DeviceCallTracer;
+}
 
 typedef std::function<void (MM::Device*)> DeleteDeviceFunction;
 
@@ -73,6 +79,8 @@ private:
    mm::logging::Logger coreLogger_;
    bool initializeCalled_ = false;
    bool initialized_ = false;
+   std::shared_ptr<mm::DeviceCallTracer> callTracer_;
+   std::uint32_t callTraceLabelId_ = 0;
 
 public:
    DeviceInstance(const DeviceInstance&) = delete;
@@ -93,6 +101,8 @@ public:
    bool IsInitialized() const { return initialized_; }
    bool HasInitializationBeenAttempted() const { return initializeCalled_; }
 
+   bool IsCallTracingEnabled() const;
+
 protected:
    // The DeviceInstance object owns the raw device pointer (pDevice) as soon
    // as the constructor is called, even if the constructor throws.
@@ -119,6 +129,37 @@ protected:
    void ThrowIfError(int code, const std::string& message) const;
    void RequireInitialized(const char *) const;
 
+   /// Records a call into the device adapter, if call tracing is enabled.
+   /**
+    * The call is timed from construction to destruction, so the object
+    * should be created at the start of the wrapper function:
+    *
+    *    auto call = BeginCall(__func__);
+    *    return GetImpl()->Foo();
+    */
+   class TracedCall
+   {
+      mm::DeviceCallTracer* tracer_; // Null if not tracing
+      const char* method_;
+      std::uint32_t labelId_;
+      std::chrono::steady_clock::time_point start_;
+      std::chrono::steady_clock::duration lockWait_;
+
+   public:
+      TracedCall(mm::DeviceCallTracer* tracer, const char* method,
+            std::uint32_t labelId);
+      TracedCall(TracedCall&& other);
+      ~TracedCall();
+
+      TracedCall(const TracedCall&) = delete;
+      TracedCall& operator=(const TracedCall&) = delete;
+   };
+
+   // method must have static storage duration (normally __func__)
+   TracedCall TraceCall(const char* method) const;
+   // RequireInitialized() followed by TraceCall()
+   TracedCall BeginCall(const char* method) const;
+
    /// Utility class for getting fixed-length strings from the device interface.
    /**
     * This class should be used in all places where a device member function
@@ -206,6 +247,9 @@ public:
    void ClearPropertySequence(const char* propertyName);
    void AddToPropertySequence(const char* propertyName, const char* value);
    void SendPropertySequence(const char* propertyName);
+   // Returns false if the device requires the values to be added one by one
+   bool SetPropertySequence(const char* propertyName,
+         const char* const* values, long numValues);
    std::string GetErrorText(int code) const;
    bool Busy();
    double GetDelayMs() const;
@@ -46,6 +46,8 @@ public:
    double GetYRange();
    double GetYMinimum();
    int AddPolygonVertex(int polygonIndex, double x, double y);
+   int AddPolygonVertices(int polygonIndex, const double* xs, const double* ys,
+         long numVertices);
    int DeletePolygons();
    int RunSequence();
    int LoadPolygons();
@@ -33,7 +33,7 @@
 std::vector<std::string>
 HubInstance::GetInstalledPeripheralNames()
 {
-   RequireInitialized(__func__);
+   auto call = BeginCall(__func__);
 
    std::vector<MM::Device*> peripherals = GetInstalledPeripherals();
 
@@ -61,7 +61,7 @@ HubInstance::GetInstalledPeripheralNames()
 std::string
 HubInstance::GetInstalledPeripheralDescription(const std::string& peripheralName)
 {
-   RequireInitialized(__func__);
+   auto call = BeginCall(__func__);
 
    std::vector<MM::Device*> peripherals = GetInstalledPeripherals();
    for (std::vector<MM::Device*>::iterator it = peripherals.begin(), end = peripherals.end();
@@ -101,6 +101,7 @@ void HubInstance::DetectInstalledDevices()
 
    if (!hasDetectedInstalledDevices_)
    {
+      auto call = TraceCall(__func__);
       detectInstalledDevicesStatus_ = GetImpl()->DetectInstalledDevices();
       hasDetectedInstalledDevices_ = true;
    }
@@ -108,10 +109,11 @@ void HubInstance::DetectInstalledDevices()
          "Failed to detect installed peripheral devices");
 }
 
-unsigned HubInstance::GetNumberOfInstalledDevices() { return GetImpl()->GetNumberOfInstalledDevices(); }
+unsigned HubInstance::GetNumberOfInstalledDevices() { auto call = TraceCall(__func__); return GetImpl()->GetNumberOfInstalledDevices(); }
 
 MM::Device* HubInstance::GetInstalledDevice(int devIdx)
 {
+   auto call = TraceCall(__func__);
    MM::Device* peripheral = GetImpl()->GetInstalledDevice(devIdx);
    if (!peripheral)
       throw CMMError("Hub " + ToQuotedString(GetLabel()) +
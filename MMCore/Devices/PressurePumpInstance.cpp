@@ -23,8 +23,8 @@
 #include "../../MMDevice/MMDeviceConstants.h"
 
 // General pump functions
-int PressurePumpInstance::Stop() { RequireInitialized(__func__); return GetImpl()->Stop(); }
-int PressurePumpInstance::Calibrate() { RequireInitialized(__func__); return GetImpl()->Calibrate(); }
-bool PressurePumpInstance::RequiresCalibration() { RequireInitialized(__func__); return GetImpl()->RequiresCalibration(); }
-int PressurePumpInstance::SetPressureKPa(double pressure) { RequireInitialized(__func__); return GetImpl()->SetPressureKPa(pressure); }
-int PressurePumpInstance::GetPressureKPa(double& pressure) { RequireInitialized(__func__); return GetImpl()->GetPressureKPa(pressure); }
\ No newline at end of file
+int PressurePumpInstance::Stop() { auto call = BeginCall(__func__); return GetImpl()->Stop(); }
+int PressurePumpInstance::Calibrate() { auto call = BeginCall(__func__); return GetImpl()->Calibrate(); }
+bool PressurePumpInstance::RequiresCalibration() { auto call = BeginCall(__func__); return GetImpl()->RequiresCalibration(); }
+int PressurePumpInstance::SetPressureKPa(double pressure) { auto call = BeginCall(__func__); return GetImpl()->SetPressureKPa(pressure); }
+int PressurePumpInstance::GetPressureKPa(double& pressure) { auto call = BeginCall(__func__); return GetImpl()->GetPressureKPa(pressure); }
\ No newline at end of file
@@ -22,26 +22,31 @@
 #include "SLMInstance.h"
 
 
-int SLMInstance::SetImage(unsigned char* pixels) { RequireInitialized(__func__); return GetImpl()->SetImage(pixels); }
-int SLMInstance::SetImage(unsigned int* pixels) { RequireInitialized(__func__); return GetImpl()->SetImage(pixels); }
-int SLMInstance::DisplayImage() { RequireInitialized(__func__); return GetImpl()->DisplayImage(); }
-int SLMInstance::SetPixelsTo(unsigned char intensity) { RequireInitialized(__func__); return GetImpl()->SetPixelsTo(intensity); }
-int SLMInstance::SetPixelsTo(unsigned char red, unsigned char green, unsigned char blue) { RequireInitialized(__func__); return GetImpl()->SetPixelsTo(red, green, blue); }
-int SLMInstance::SetExposure(double interval_ms) { RequireInitialized(__func__); return GetImpl()->SetExposure(interval_ms); }
-double SLMInstance::GetExposure() { RequireInitialized(__func__); return GetImpl()->GetExposure(); }
-unsigned SLMInstance::GetWidth() { RequireInitialized(__func__); return GetImpl()->GetWidth(); }
-unsigned SLMInstance::GetHeight() { RequireInitialized(__func__); return GetImpl()->GetHeight(); }
-unsigned SLMInstance::GetNumberOfComponents() { RequireInitialized(__func__); return GetImpl()->GetNumberOfComponents(); }
-unsigned SLMInstance::GetBytesPerPixel() { RequireInitialized(__func__); return GetImpl()->GetBytesPerPixel(); }
+int SLMInstance::SetImage(unsigned char* pixels) { auto call = BeginCall(__func__); return GetImpl()->SetImage(pixels); }
+int SLMInstance::SetImage(unsigned int* pixels) { auto call = BeginCall(__func__); return GetImpl()->SetImage(pixels); }
+int SLMInstance::DisplayImage() { auto call = BeginCall(__func__); return GetImpl()->DisplayImage(); }
+int SLMInstance::SetPixelsTo(unsigned char intensity) { auto call = BeginCall(__func__); return GetImpl()->SetPixelsTo(intensity); }
+int SLMInstance::SetPixelsTo(unsigned char red, unsigned char green, unsigned char blue) { auto call = BeginCall(__func__); return GetImpl()->SetPixelsTo(red, green, blue); }
+int SLMInstance::SetExposure(double interval_ms) { auto call = BeginCall(__func__); return GetImpl()->SetExposure(interval_ms); }
+double SLMInstance::GetExposure() { auto call = BeginCall(__func__); return GetImpl()->GetExposure(); }
+unsigned SLMInstance::GetWidth() { auto call = BeginCall(__func__); return GetImpl()->GetWidth(); }
+unsigned SLMInstance::GetHeight() { auto call = BeginCall(__func__); return GetImpl()->GetHeight(); }
+unsigned SLMInstance::GetNumberOfComponents() { auto call = BeginCall(__func__); return GetImpl()->GetNumberOfComponents(); }
+unsigned SLMInstance::GetBytesPerPixel() { auto call = BeginCall(__func__); return GetImpl()->GetBytesPerPixel(); }
 int SLMInstance::IsSLMSequenceable(bool& isSequenceable)
-{ RequireInitialized(__func__); return GetImpl()->IsSLMSequenceable(isSequenceable); }
+{ auto call = BeginCall(__func__); return GetImpl()->IsSLMSequenceable(isSequenceable); }
 int SLMInstance::GetSLMSequenceMaxLength(long& nrEvents)
-{ RequireInitialized(__func__); return GetImpl()->GetSLMSequenceMaxLength(nrEvents); }
-int SLMInstance::StartSLMSequence() { RequireInitialized(__func__); return GetImpl()->StartSLMSequence(); }
-int SLMInstance::StopSLMSequence() { RequireInitialized(__func__); return GetImpl()->StopSLMSequence(); }
-int SLMInstance::ClearSLMSequence() { RequireInitialized(__func__); return GetImpl()->ClearSLMSequence(); }
+{ auto call = BeginCall(__func__); return GetImpl()->GetSLMSequenceMaxLength(nrEvents); }
+int SLMInstance::StartSLMSequence() { auto call = BeginCall(__func__); return GetImpl()->StartSLMSequence(); }
+int SLMInstance::StopSLMSequence() { auto call = BeginCall(__func__); return GetImpl()->StopSLMSequence(); }
+int SLMInstance::ClearSLMSequence() { auto call = BeginCall(__func__); return GetImpl()->ClearSLMSequence(); }
 int SLMInstance::AddToSLMSequence(const unsigned char * pixels)
-{ RequireInitialized(__func__); return GetImpl()->AddToSLMSequence(pixels); }
+{ auto call = BeginCall(__func__); return GetImpl()->AddToSLMSequence(pixels); }
 int SLMInstance::AddToSLMSequence(const unsigned int * pixels)
-{ RequireInitialized(__func__); return GetImpl()->AddToSLMSequence(pixels); }
-int SLMInstance::SendSLMSequence() { RequireInitialized(__func__); return GetImpl()->SendSLMSequence(); }
+{ auto call = BeginCall(__func__); return GetImpl()->AddToSLMSequence(pixels); }
+int SLMInstance::AddPatternToSLMSequence(long patternId, const unsigned char * pixels)
+{ auto call = BeginCall(__func__); return GetImpl()->AddPatternToSLMSequence(patternId, pixels); }
+int SLMInstance::SetImageRegion(const unsigned char * pixels,
+      unsigned x, unsigned y, unsigned width, unsigned height)
+{ auto call = BeginCall(__func__); return GetImpl()->SetImageRegion(pixels, x, y, width, height); }
+int SLMInstance::SendSLMSequence() { auto call = BeginCall(__func__); return GetImpl()->SendSLMSequence(); }
@@ -54,5 +54,8 @@ public:
    int ClearSLMSequence();
    int AddToSLMSequence(const unsigned char * pixels);
    int AddToSLMSequence(const unsigned int * pixels);
+   int AddPatternToSLMSequence(long patternId, const unsigned char * pixels);
+   int SetImageRegion(const unsigned char * pixels,
+         unsigned x, unsigned y, unsigned width, unsigned height);
    int SendSLMSequence();
 };
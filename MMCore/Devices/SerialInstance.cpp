@@ -22,9 +22,102 @@
 #include "SerialInstance.h"
 
 
-MM::PortType SerialInstance::GetPortType() const { RequireInitialized(__func__); return GetImpl()->GetPortType(); }
-int SerialInstance::SetCommand(const char* command, const char* term) { RequireInitialized(__func__); return GetImpl()->SetCommand(command, term); }
-int SerialInstance::GetAnswer(char* txt, unsigned maxChars, const char* term) { RequireInitialized(__func__); return GetImpl()->GetAnswer(txt, maxChars, term); }
-int SerialInstance::Write(const unsigned char* buf, unsigned long bufLen) { RequireInitialized(__func__); return GetImpl()->Write(buf, bufLen); }
-int SerialInstance::Read(unsigned char* buf, unsigned long bufLen, unsigned long& charsRead) { RequireInitialized(__func__); return GetImpl()->Read(buf, bufLen, charsRead); }
-int SerialInstance::Purge() { RequireInitialized(__func__); return GetImpl()->Purge(); }
+MM::PortType SerialInstance::GetPortType() const { auto call = BeginCall(__func__); return GetImpl()->GetPortType(); }
+int SerialInstance::SetCommand(const std::string& client, const char* command, const char* term)
+{
+   auto call = BeginCall(__func__);
+   mm::SerialPortScheduler::Slot slot(scheduler_, client);
+   int ret = GetImpl()->SetCommand(command, term);
+   // Keep the port for the answer, if one is read soon
+   slot.KeepHold(ret == DEVICE_OK);
+   return ret;
+}
+
+int SerialInstance::GetAnswer(const std::string& client, char* txt, unsigned maxChars, const char* term)
+{
+   auto call = BeginCall(__func__);
+   mm::SerialPortScheduler::Slot slot(scheduler_, client);
+   return GetImpl()->GetAnswer(txt, maxChars, term);
+}
+
+int SerialInstance::Write(const std::string& client, const unsigned char* buf, unsigned long bufLen)
+{
+   auto call = BeginCall(__func__);
+   mm::SerialPortScheduler::Slot slot(scheduler_, client);
+   int ret = GetImpl()->Write(buf, bufLen);
+   slot.KeepHold(ret == DEVICE_OK);
+   return ret;
+}
+
+int SerialInstance::Read(const std::string& client, unsigned char* buf, unsigned long bufLen, unsigned long& charsRead)
+{
+   auto call = BeginCall(__func__);
+   mm::SerialPortScheduler::Slot slot(scheduler_, client);
+   int ret = GetImpl()->Read(buf, bufLen, charsRead);
+   // A reply that has not started to arrive is still awaited; once data has
+   // been read, the exchange is over unless a transaction is open
+   slot.KeepHold(slot.WasHeld() && ret == DEVICE_OK && charsRead == 0);
+   return ret;
+}
+
+int SerialInstance::Purge(const std::string& client)
+{
+   auto call = BeginCall(__func__);
+   mm::SerialPortScheduler::Slot slot(scheduler_, client);
+   return GetImpl()->Purge();
+}
+
+void SerialInstance::BeginTransaction(const std::string& client)
+{
+   scheduler_.BeginTransaction(client);
+}
+
+void SerialInstance::EndTransaction(const std::string& client)
+{
+   scheduler_.EndTransaction(client);
+}
+
+int SerialInstance::Transact(const std::string& client,
+      const std::vector<std::string>& commands,
+      const char* commandTerm, const char* answerTerm,
+      std::vector<std::string>& answers)
+{
+   auto call = BeginCall(__func__);
+   mm::SerialPortScheduler::Slot slot(scheduler_, client);
+
+   answers.clear();
+   const unsigned bufLen = 1024;
+   char answerBuf[bufLen];
+
+   std::size_t sent = 0;
+   for (const std::string& command : commands)
+   {
+      int ret = GetImpl()->SetCommand(command.c_str(), commandTerm);
+      if (ret != DEVICE_OK)
+      {
+         // Don't leave the answers to the commands already sent for the
+         // next caller to read as answers to its own commands
+         for (std::size_t i = 0; i < sent; ++i)
+         {
+            if (GetImpl()->GetAnswer(answerBuf, bufLen, answerTerm) != DEVICE_OK)
+               break;
+         }
+         GetImpl()->Purge();
+         return ret;
+      }
+      ++sent;
+   }
+
+   for (std::size_t i = 0; i < commands.size(); ++i)
+   {
+      int ret = GetImpl()->GetAnswer(answerBuf, bufLen, answerTerm);
+      if (ret != DEVICE_OK)
+      {
+         // Any answers still to come are out of step; drop what has arrived
+         GetImpl()->Purge();
+         return ret;
+      }
+      answers.push_back(answerBuf);
+   }
+   return DEVICE_OK;
+}
@@ -20,6 +20,10 @@
 #pragma once
 
 #include "DeviceInstanceBase.h"
+#include "../SerialPortScheduler.h"
+
+#include <string>
+#include <vector>
 
 
 class SerialInstance : public DeviceInstanceBase<MM::Serial>
@@ -36,10 +40,34 @@ public:
       DeviceInstanceBase<MM::Serial>(core, adapter, name, pDevice, deleteFunction, label, deviceLogger, coreLogger)
    {}
 
+   // The client is the label of the device (or "Core" for the application)
+   // on whose behalf the port is used. Calls from different clients are
+   // arbitrated by the port's scheduler: SetCommand and Write hold the port
+   // for the client until GetAnswer, or a Read that returns data, ends the
+   // exchange (see mm::SerialPortScheduler).
    MM::PortType GetPortType() const;
-   int SetCommand(const char* command, const char* term);
-   int GetAnswer(char* txt, unsigned maxChars, const char* term);
-   int Write(const unsigned char* buf, unsigned long bufLen);
-   int Read(unsigned char* buf, unsigned long bufLen, unsigned long& charsRead);
-   int Purge();
+   int SetCommand(const std::string& client, const char* command, const char* term);
+   int GetAnswer(const std::string& client, char* txt, unsigned maxChars, const char* term);
+   int Write(const std::string& client, const unsigned char* buf, unsigned long bufLen);
+   int Read(const std::string& client, unsigned char* buf, unsigned long bufLen, unsigned long& charsRead);
+   int Purge(const std::string& client);
+
+   // Keep the port for the client across any number of calls, until
+   // EndTransaction()
+   void BeginTransaction(const std::string& client);
+   void EndTransaction(const std::string& client);
+
+   // Write all commands, then read one answer per command, holding the port
+   // throughout, so that answers stay matched to commands.
+   int Transact(const std::string& client,
+         const std::vector<std::string>& commands,
+         const char* commandTerm, const char* answerTerm,
+         std::vector<std::string>& answers);
+
+   std::vector<mm::SerialPortScheduler::ClientStatistics> GetSchedulingStatistics() const
+   { return scheduler_.GetStatistics(); }
+   void ResetSchedulingStatistics() { scheduler_.ResetStatistics(); }
+
+private:
+   mm::SerialPortScheduler scheduler_;
 };
@@ -22,6 +22,6 @@
 #include "ShutterInstance.h"
 
 
-int ShutterInstance::SetOpen(bool open) { RequireInitialized(__func__); return GetImpl()->SetOpen(open); }
-int ShutterInstance::GetOpen(bool& open) { RequireInitialized(__func__); return GetImpl()->GetOpen(open); }
-int ShutterInstance::Fire(double deltaT) { RequireInitialized(__func__); return GetImpl()->Fire(deltaT); }
+int ShutterInstance::SetOpen(bool open) { auto call = BeginCall(__func__); return GetImpl()->SetOpen(open); }
+int ShutterInstance::GetOpen(bool& open) { auto call = BeginCall(__func__); return GetImpl()->GetOpen(open); }
+int ShutterInstance::Fire(double deltaT) { auto call = BeginCall(__func__); return GetImpl()->Fire(deltaT); }
@@ -48,4 +48,6 @@ public:
    int ClearDASequence();
    int AddToDASequence(double voltage);
    int SendDASequence();
+   int SetDASequence(const double* voltages, long numVoltages);
+   int AppendToDASequence(const double* voltages, long numVoltages, long& numAppended);
 };
@@ -22,17 +22,17 @@
 #include "StageInstance.h"
 
 
-int StageInstance::SetPositionUm(double pos) { RequireInitialized(__func__); return GetImpl()->SetPositionUm(pos); }
-int StageInstance::SetRelativePositionUm(double d) { RequireInitialized(__func__); return GetImpl()->SetRelativePositionUm(d); }
-int StageInstance::Move(double velocity) { RequireInitialized(__func__); return GetImpl()->Move(velocity); }
-int StageInstance::Stop() { RequireInitialized(__func__); return GetImpl()->Stop(); }
-int StageInstance::Home() { RequireInitialized(__func__); return GetImpl()->Home(); }
-int StageInstance::SetAdapterOriginUm(double d) { RequireInitialized(__func__); return GetImpl()->SetAdapterOriginUm(d); }
-int StageInstance::GetPositionUm(double& pos) { RequireInitialized(__func__); return GetImpl()->GetPositionUm(pos); }
-int StageInstance::SetPositionSteps(long steps) { RequireInitialized(__func__); return GetImpl()->SetPositionSteps(steps); }
-int StageInstance::GetPositionSteps(long& steps) { RequireInitialized(__func__); return GetImpl()->GetPositionSteps(steps); }
-int StageInstance::SetOrigin() { RequireInitialized(__func__); return GetImpl()->SetOrigin(); }
-int StageInstance::GetLimits(double& lower, double& upper) { RequireInitialized(__func__); return GetImpl()->GetLimits(lower, upper); }
+int StageInstance::SetPositionUm(double pos) { auto call = BeginCall(__func__); return GetImpl()->SetPositionUm(pos); }
+int StageInstance::SetRelativePositionUm(double d) { auto call = BeginCall(__func__); return GetImpl()->SetRelativePositionUm(d); }
+int StageInstance::Move(double velocity) { auto call = BeginCall(__func__); return GetImpl()->Move(velocity); }
+int StageInstance::Stop() { auto call = BeginCall(__func__); return GetImpl()->Stop(); }
+int StageInstance::Home() { auto call = BeginCall(__func__); return GetImpl()->Home(); }
+int StageInstance::SetAdapterOriginUm(double d) { auto call = BeginCall(__func__); return GetImpl()->SetAdapterOriginUm(d); }
+int StageInstance::GetPositionUm(double& pos) { auto call = BeginCall(__func__); return GetImpl()->GetPositionUm(pos); }
+int StageInstance::SetPositionSteps(long steps) { auto call = BeginCall(__func__); return GetImpl()->SetPositionSteps(steps); }
+int StageInstance::GetPositionSteps(long& steps) { auto call = BeginCall(__func__); return GetImpl()->GetPositionSteps(steps); }
+int StageInstance::SetOrigin() { auto call = BeginCall(__func__); return GetImpl()->SetOrigin(); }
+int StageInstance::GetLimits(double& lower, double& upper) { auto call = BeginCall(__func__); return GetImpl()->GetLimits(lower, upper); }
 
 MM::FocusDirection
 StageInstance::GetFocusDirection()
@@ -41,6 +41,7 @@ StageInstance::GetFocusDirection()
    if (!focusDirectionHasBeenSet_)
    {
       MM::FocusDirection direction;
+      auto call = TraceCall(__func__);
       int err = GetImpl()->GetFocusDirection(direction);
       ThrowIfError(err, "Cannot get focus direction");
 
@@ -57,14 +58,16 @@ StageInstance::SetFocusDirection(MM::FocusDirection direction)
    focusDirectionHasBeenSet_ = true;
 }
 
-int StageInstance::IsStageSequenceable(bool& isSequenceable) const { RequireInitialized(__func__); return GetImpl()->IsStageSequenceable(isSequenceable); }
-int StageInstance::IsStageLinearSequenceable(bool& isSequenceable) const { RequireInitialized(__func__); return GetImpl()->IsStageLinearSequenceable(isSequenceable); }
-bool StageInstance::IsContinuousFocusDrive() const { RequireInitialized(__func__); return GetImpl()->IsContinuousFocusDrive(); }
-int StageInstance::GetStageSequenceMaxLength(long& nrEvents) const { RequireInitialized(__func__); return GetImpl()->GetStageSequenceMaxLength(nrEvents); }
-int StageInstance::StartStageSequence() { RequireInitialized(__func__); return GetImpl()->StartStageSequence(); }
-int StageInstance::StopStageSequence() { RequireInitialized(__func__); return GetImpl()->StopStageSequence(); }
-int StageInstance::ClearStageSequence() { RequireInitialized(__func__); return GetImpl()->ClearStageSequence(); }
-int StageInstance::AddToStageSequence(double position) { RequireInitialized(__func__); return GetImpl()->AddToStageSequence(position); }
-int StageInstance::SendStageSequence() { RequireInitialized(__func__); return GetImpl()->SendStageSequence(); }
+int StageInstance::IsStageSequenceable(bool& isSequenceable) const { auto call = BeginCall(__func__); return GetImpl()->IsStageSequenceable(isSequenceable); }
+int StageInstance::IsStageLinearSequenceable(bool& isSequenceable) const { auto call = BeginCall(__func__); return GetImpl()->IsStageLinearSequenceable(isSequenceable); }
+bool StageInstance::IsContinuousFocusDrive() const { auto call = BeginCall(__func__); return GetImpl()->IsContinuousFocusDrive(); }
+int StageInstance::GetStageSequenceMaxLength(long& nrEvents) const { auto call = BeginCall(__func__); return GetImpl()->GetStageSequenceMaxLength(nrEvents); }
+int StageInstance::StartStageSequence() { auto call = BeginCall(__func__); return GetImpl()->StartStageSequence(); }
+int StageInstance::StopStageSequence() { auto call = BeginCall(__func__); return GetImpl()->StopStageSequence(); }
+int StageInstance::ClearStageSequence() { auto call = BeginCall(__func__); return GetImpl()->ClearStageSequence(); }
+int StageInstance::AddToStageSequence(double position) { auto call = BeginCall(__func__); return GetImpl()->AddToStageSequence(position); }
+int StageInstance::SendStageSequence() { auto call = BeginCall(__func__); return GetImpl()->SendStageSequence(); }
+int StageInstance::SetStageSequence(const double* positions, long numPositions) { auto call = BeginCall(__func__); return GetImpl()->SetStageSequence(positions, numPositions); }
+int StageInstance::AppendToStageSequence(const double* positions, long numPositions, long& numAppended) { auto call = BeginCall(__func__); return GetImpl()->AppendToStageSequence(positions, numPositions, numAppended); }
 int StageInstance::SetStageLinearSequence(double dZ_um, long nSlices)
-{ RequireInitialized(__func__); return GetImpl()->SetStageLinearSequence(dZ_um, nSlices); }
\ No newline at end of file
+{ auto call = BeginCall(__func__); return GetImpl()->SetStageLinearSequence(dZ_um, nSlices); }
\ No newline at end of file
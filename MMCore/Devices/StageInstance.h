@@ -61,5 +61,7 @@ public:
    int ClearStageSequence();
    int AddToStageSequence(double position);
    int SendStageSequence();
+   int SetStageSequence(const double* positions, long numPositions);
+   int AppendToStageSequence(const double* positions, long numPositions, long& numAppended);
    int SetStageLinearSequence(double dZ_um, long nSlices);
 };
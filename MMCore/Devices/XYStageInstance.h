@@ -60,4 +60,5 @@ public:
    int ClearXYStageSequence();
    int AddToXYStageSequence(double positionX, double positionY);
    int SendXYStageSequence();
+   int SetXYStageSequence(const double* positionsX, const double* positionsY, long numPositions);
 };
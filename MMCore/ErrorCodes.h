@@ -78,4 +78,5 @@
 #define MMERR_CreatePeripheralFailed   50
 #define MMERR_PropertyNotInCache       51
 #define MMERR_BadAffineTransform       52
+#define MMERR_CircularBufferImagesPinned 53
 #endif //_ERRORCODES_H_
@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ImageProcessingPipeline.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Runs the image processor on inserted frames off the camera
+//                thread.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "ImageProcessingPipeline.h"
+
+#include "AcquisitionStatistics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+namespace mm {
+
+ImageProcessingPipeline::ImageProcessingPipeline(PublishFunc publish,
+      std::size_t maxFramesInFlight,
+      std::shared_ptr<AcquisitionStatistics> stats) :
+   publish_(std::move(publish)),
+   maxFramesInFlight_((std::max)(maxFramesInFlight, std::size_t(1))),
+   acqStats_(std::move(stats))
+{
+}
+
+ImageProcessingPipeline::~ImageProcessingPipeline()
+{
+   Drain();
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+   }
+   processCv_.notify_all();
+   publishCv_.notify_all();
+   if (processThread_.joinable())
+      processThread_.join();
+   if (publishThread_.joinable())
+      publishThread_.join();
+}
+
+void ImageProcessingPipeline::Submit(MM::ImageProcessor* processor,
+   const unsigned char* pixels, unsigned width, unsigned height,
+   unsigned byteDepth, unsigned nComponents, unsigned numChannels,
+   const Metadata& metadata, std::chrono::steady_clock::time_point received)
+{
+   std::unique_ptr<Frame> frame;
+   {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!processThread_.joinable())
+      {
+         processThread_ = std::thread([this] { ProcessLoop(); });
+         publishThread_ = std::thread([this] { PublishLoop(); });
+      }
+      if (inFlight_ >= maxFramesInFlight_)
+      {
+         ++stats_.submitWaits;
+         doneCv_.wait(lock, [&] { return inFlight_ < maxFramesInFlight_; });
+      }
+      ++inFlight_;
+      if (!freeFrames_.empty())
+      {
+         frame = std::move(freeFrames_.back());
+         freeFrames_.pop_back();
+      }
+   }
+
+   if (!frame)
+      frame.reset(new Frame());
+   // byteDepth is per pixel, including all components
+   const std::size_t bytes = std::size_t(width) * height * byteDepth * numChannels;
+   frame->pixels.resize(bytes); // No reallocation once the pool is warm
+   std::memcpy(frame->pixels.data(), pixels, bytes);
+   frame->processor = processor;
+   frame->width = width;
+   frame->height = height;
+   frame->byteDepth = byteDepth;
+   frame->nComponents = nComponents;
+   frame->numChannels = numChannels;
+   frame->metadata = metadata;
+   frame->received = received;
+
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      toProcess_.push_back(std::move(frame));
+   }
+   processCv_.notify_one();
+}
+
+void ImageProcessingPipeline::Drain()
+{
+   std::unique_lock<std::mutex> lock(mutex_);
+   doneCv_.wait(lock, [&] { return inFlight_ == 0; });
+}
+
+std::size_t ImageProcessingPipeline::GetFramesInFlight() const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return inFlight_;
+}
+
+ImageProcessingPipeline::Statistics
+ImageProcessingPipeline::GetStatistics() const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return stats_;
+}
+
+void ImageProcessingPipeline::ProcessLoop()
+{
+   for (;;)
+   {
+      std::unique_ptr<Frame> frame;
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         processCv_.wait(lock, [&] { return stopping_ || !toProcess_.empty(); });
+         if (toProcess_.empty())
+            return;
+         frame = std::move(toProcess_.front());
+         toProcess_.pop_front();
+      }
+
+      if (frame->processor)
+      {
+         const auto start = std::chrono::steady_clock::now();
+         // As in the synchronous path, multi-channel frames are passed with
+         // the dimensions of a single channel.
+         try
+         {
+            frame->processor->Process(frame->pixels.data(), frame->width,
+               frame->height, frame->byteDepth);
+         }
+         catch (...)
+         {
+            // Publish unprocessed rather than lose the frame (or the thread)
+         }
+         const auto elapsed = std::chrono::steady_clock::now() - start;
+         const double ms =
+            std::chrono::duration<double, std::milli>(elapsed).count();
+         if (acqStats_)
+            acqStats_->RecordLatency(AcquisitionStatistics::Processing, elapsed);
+
+         std::lock_guard<std::mutex> lock(mutex_);
+         ++stats_.framesProcessed;
+         stats_.lastProcessMs = ms;
+         stats_.maxProcessMs = (std::max)(stats_.maxProcessMs, ms);
+         stats_.totalProcessMs += ms;
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         toPublish_.push_back(std::move(frame));
+      }
+      publishCv_.notify_one();
+   }
+}
+
+void ImageProcessingPipeline::PublishLoop()
+{
+   for (;;)
+   {
+      std::unique_ptr<Frame> frame;
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         publishCv_.wait(lock, [&] { return stopping_ || !toPublish_.empty(); });
+         if (toPublish_.empty())
+            return;
+         frame = std::move(toPublish_.front());
+         toPublish_.pop_front();
+      }
+
+      publish_(*frame);
+
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         freeFrames_.push_back(std::move(frame));
+         --inFlight_;
+      }
+      doneCv_.notify_all();
+   }
+}
+
+} // namespace mm
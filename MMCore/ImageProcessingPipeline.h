@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ImageProcessingPipeline.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Runs the image processor on inserted frames off the camera
+//                thread.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include "../MMDevice/ImageMetadata.h"
+#include "../MMDevice/MMDevice.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mm {
+
+class AcquisitionStatistics;
+
+// Two-stage pipeline between image insertion by a camera and publication to
+// the sequence buffer.
+//
+// Submit() copies the frame into a recycled buffer and returns; one worker
+// thread runs the image processor on it in place, and a second worker
+// publishes processed frames, so that frame N+1 is being processed while
+// frame N is published. A single processing thread keeps processor calls
+// serialized (image processors are not required to be reentrant) and frames
+// in insertion order.
+//
+// Submit() waits only when maxFramesInFlight frames are already queued, i.e.
+// when processing is persistently slower than acquisition.
+//
+// The worker threads are started by the first Submit(), so a pipeline that is
+// never used costs no threads.
+class ImageProcessingPipeline
+{
+public:
+   struct Frame
+   {
+      MM::ImageProcessor* processor = nullptr; // May be null
+      std::vector<unsigned char> pixels;
+      unsigned width = 0;
+      unsigned height = 0;
+      unsigned byteDepth = 0;
+      unsigned nComponents = 1;
+      unsigned numChannels = 1;
+      Metadata metadata;
+      // When the camera handed the frame to the Core
+      std::chrono::steady_clock::time_point received;
+   };
+
+   struct Statistics
+   {
+      std::uint64_t framesProcessed = 0;
+      double lastProcessMs = 0.0;
+      double maxProcessMs = 0.0;
+      double totalProcessMs = 0.0;
+      std::uint64_t submitWaits = 0; // Times Submit() found the pipeline full
+   };
+
+   // Called on the publishing thread, in submission order
+   using PublishFunc = std::function<void(const Frame&)>;
+
+   // stats, if given, receives the time spent in the image processor
+   explicit ImageProcessingPipeline(PublishFunc publish,
+      std::size_t maxFramesInFlight = 16,
+      std::shared_ptr<AcquisitionStatistics> stats = nullptr);
+   ~ImageProcessingPipeline();
+
+   ImageProcessingPipeline(const ImageProcessingPipeline&) = delete;
+   ImageProcessingPipeline& operator=(const ImageProcessingPipeline&) = delete;
+
+   void Submit(MM::ImageProcessor* processor, const unsigned char* pixels,
+      unsigned width, unsigned height, unsigned byteDepth,
+      unsigned nComponents, unsigned numChannels, const Metadata& metadata,
+      std::chrono::steady_clock::time_point received =
+         std::chrono::steady_clock::now());
+
+   // Block until every submitted frame has been published
+   void Drain();
+
+   std::size_t GetFramesInFlight() const;
+   Statistics GetStatistics() const;
+
+private:
+   void ProcessLoop();
+   void PublishLoop();
+
+   const PublishFunc publish_;
+   const std::size_t maxFramesInFlight_;
+   const std::shared_ptr<AcquisitionStatistics> acqStats_;
+
+   mutable std::mutex mutex_;
+   std::condition_variable processCv_;
+   std::condition_variable publishCv_;
+   std::condition_variable doneCv_; // Frame published or buffer recycled
+   std::deque<std::unique_ptr<Frame>> toProcess_;
+   std::deque<std::unique_ptr<Frame>> toPublish_;
+   std::vector<std::unique_ptr<Frame>> freeFrames_;
+   std::size_t inFlight_ = 0;
+   bool stopping_ = false;
+   Statistics stats_;
+
+   std::thread processThread_; // Both started together, under mutex_
+   std::thread publishThread_;
+};
+
+} // namespace mm
@@ -41,19 +41,25 @@
 #include "../MMDevice/DeviceUtils.h"
 #include "../MMDevice/ImageMetadata.h"
 #include "../MMDevice/ModuleInterface.h"
+#include "AcquisitionStatistics.h"
 #include "CircularBuffer.h"
 #include "ConfigGroup.h"
+#include "ConfigSnapshot.h"
 #include "Configuration.h"
 #include "CoreCallback.h"
 #include "CoreFeatures.h"
 #include "CoreProperty.h"
 #include "CoreUtils.h"
+#include "DeviceCallTracer.h"
 #include "DeviceManager.h"
 #include "Devices/DeviceInstances.h"
+#include "ImageProcessingPipeline.h"
 #include "LogManager.h"
 #include "MMCore.h"
 #include "MMEventCallback.h"
 #include "PluginManager.h"
+#include "SLMPatternStore.h"
+#include "SequenceStreamer.h"
 
 #include <algorithm>
 #include <cassert>
@@ -62,6 +68,7 @@
 #include <deque>
 #include <fstream>
 #include <future>
+#include <iomanip>
 #include <map>
 #include <set>
 #include <sstream>
@@ -103,7 +110,7 @@
  * (Keep the 3 numbers on one line to make it easier to look at diffs when
  * merging/rebasing.)
  */
-const int MMCore_versionMajor = 11, MMCore_versionMinor = 9, MMCore_versionPatch = 0;
+const int MMCore_versionMajor = 11, MMCore_versionMinor = 18, MMCore_versionPatch = 0;
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -128,9 +135,15 @@ CMMCore::CMMCore() :
    properties_(0),
    externalCallback_(0),
    pixelSizeGroup_(0),
+   acqStatistics_(std::make_shared<mm::AcquisitionStatistics>(
+      logManager_->NewLogger("Core:Statistics"))),
    cbuf_(0),
    pluginManager_(new CPluginManager()),
    deviceManager_(new mm::DeviceManager()),
+   deviceCallTracer_(std::make_shared<mm::DeviceCallTracer>()),
+   sequenceStreamer_(new mm::SequenceStreamer(
+      logManager_->NewLogger("Core:SequenceStreamer"))),
+   slmPatternStore_(new mm::SLMPatternStore()),
    pPostedErrorsLock_(NULL)
 {
    configGroups_ = new ConfigGroupCollection();
@@ -142,7 +155,25 @@ CMMCore::CMMCore() :
    callback_ = new CoreCallback(this);
 
    const unsigned seqBufMegabytes = (sizeof(void*) > 4) ? 250 : 25;
-   cbuf_ = new CircularBuffer(seqBufMegabytes);
+   cbuf_ = new CircularBuffer(seqBufMegabytes, acqStatistics_);
+
+   imageProcessingPipeline_.reset(new mm::ImageProcessingPipeline(
+      [this](const mm::ImageProcessingPipeline::Frame& frame) {
+         try
+         {
+            if (cbuf_->InsertMultiChannel(frame.pixels.data(),
+                  frame.numChannels, frame.width, frame.height,
+                  frame.byteDepth, frame.nComponents, &frame.metadata))
+               acqStatistics_->RecordLatency(
+                  mm::AcquisitionStatistics::CameraToInsert, frame.received);
+            else
+               LOG_DEBUG(coreLogger_) << "Processed image dropped: circular buffer overflow";
+         }
+         catch (const CMMError& e)
+         {
+            LOG_ERROR(coreLogger_) << "Cannot insert processed image: " << e.getMsg();
+         }
+      }, 16, acqStatistics_));
 
    nullAffine_ = new std::vector<double>(6);
    for (int i = 0; i < 6; i++) {
@@ -180,6 +211,8 @@ CMMCore::~CMMCore()
       LOG_ERROR(coreLogger_) << "Exception caught in CMMCore destructor.";
    }
 
+   imageProcessingPipeline_.reset(); // Publishes to cbuf_
+
    delete callback_;
    delete configGroups_;
    delete properties_;
@@ -207,6 +240,23 @@ CMMCore::~CMMCore()
  *   multiple threads, one per device module.  Early testing shows this to be 
  *   reliable, but switch this off when issues are encountered during 
  *   device initialization.
+ * - "ConfigSnapshots" (default: disabled) When enabled,
+ *   saveSystemConfiguration() also writes a binary snapshot of the parsed
+ *   file (the file name with ".snapshot" appended). When
+ *   loadSystemConfiguration() finds a snapshot matching the file's current
+ *   contents, it uses it instead of parsing the text, and skips Property
+ *   commands (and System/Startup preset settings) that would set an
+ *   initialized device's property to the value the device already reports.
+ *   Disable this for devices whose reported property values do not reflect
+ *   the hardware state.
+ * - "AsyncImageProcessing" (default: disabled) When enabled, images
+ *   inserted by cameras during sequence acquisition are copied and handed to
+ *   worker threads that run the current image processor and then insert the
+ *   result into the circular buffer, so that the camera's thread does not
+ *   wait for processing (unless 16 frames are already queued). Images appear
+ *   in the buffer in insertion order. isSequenceRunning() and
+ *   stopSequenceAcquisition() wait until all queued images have been
+ *   inserted. Has no effect when no image processor is set.
  *
  * Permanently enabled features:
  * - None so far.
@@ -366,6 +416,57 @@ void CMMCore::stopSecondaryLogFile(int handle) MMCORE_LEGACY_THROW(CMMError)
    logManager_->RemoveSecondaryLogFile(h);
 }
 
+/**
+ * Enables or disables tracing of device calls.
+ *
+ * While enabled, every call that the Core makes into a device adapter is
+ * recorded with the method name, device label, calling thread, start time,
+ * duration, and the time spent waiting for the device adapter's module lock
+ * beforehand. The most recent 65536 calls are kept; retrieve them with
+ * getDeviceCallTraceJSON().
+ *
+ * Tracing adds well under a microsecond to each device call; when disabled,
+ * the overhead is negligible.
+ */
+void CMMCore::enableDeviceCallTracing(bool enable)
+{
+   deviceCallTracer_->Enable(enable);
+   LOG_INFO(coreLogger_) << "Device call tracing " <<
+      (enable ? "enabled" : "disabled");
+}
+
+/**
+ * Returns whether device call tracing is enabled.
+ */
+bool CMMCore::isDeviceCallTracingEnabled() const
+{
+   return deviceCallTracer_->IsEnabled();
+}
+
+/**
+ * Discards the device calls recorded so far.
+ */
+void CMMCore::clearDeviceCallTrace()
+{
+   deviceCallTracer_->Clear();
+}
+
+/**
+ * Returns the recorded device calls in Chrome trace-event format.
+ *
+ * Save the string to a .json file and open it in chrome://tracing or
+ * https://ui.perfetto.dev to see the calls on a timeline, one row per
+ * thread. Each event is named after the device method and has the device
+ * label as its category; its arguments give the label and the module lock
+ * wait in microseconds. Timestamps are in microseconds.
+ *
+ * Can be called while tracing is enabled.
+ */
+std::string CMMCore::getDeviceCallTraceJSON() const
+{
+   return deviceCallTracer_->ToChromeTraceJSON();
+}
+
 /**
  * Displays core version.
  */
@@ -525,6 +626,63 @@ Configuration CMMCore::getSystemStateCache() const
    return stateCache_;
 }
 
+/**
+ * Returns a number that changes whenever the system state cache changes.
+ *
+ * Callers that attach the state cache to every image (such as MMCoreJ's
+ * tagged images) can compare this number with the one they last saw, and
+ * only call getSystemStateCacheJSON() when it differs.
+ */
+long CMMCore::getSystemStateCacheVersion() const
+{
+   MMThreadGuard scg(stateCacheLock_);
+   return stateCacheVersion_;
+}
+
+/**
+ * Returns the system state cache as a JSON object, mapping
+ * "<device label>-<property name>" to the property value (the same keys that
+ * are used for image metadata tags).
+ *
+ * The string is built only once per change of the cache (see
+ * getSystemStateCacheVersion()), so repeated calls are cheap.
+ */
+std::string CMMCore::getSystemStateCacheJSON() const
+{
+   MMThreadGuard scg(stateCacheLock_);
+   if (stateCacheJSONVersion_ != stateCacheVersion_)
+   {
+      std::string json;
+      json.reserve(64 * stateCache_.size());
+      json += '{';
+      for (size_t i = 0; i < stateCache_.size(); ++i)
+      {
+         const PropertySetting s = stateCache_.getSetting(i);
+         if (i > 0)
+            json += ',';
+         AppendJSONString(json, s.getDeviceLabel() + "-" + s.getPropertyName());
+         json += ':';
+         AppendJSONString(json, s.getPropertyValue());
+      }
+      json += '}';
+      stateCacheJSON_.swap(json);
+      stateCacheJSONVersion_ = stateCacheVersion_;
+   }
+   return stateCacheJSON_;
+}
+
+/*
+ * Updates one entry of the state cache; the caller must hold stateCacheLock_.
+ */
+void CMMCore::addStateCacheSetting(const PropertySetting& setting)
+{
+   // Rewriting the same value keeps the version (and serialized form)
+   const bool changed = !stateCache_.isSettingIncluded(setting);
+   stateCache_.addSetting(setting);
+   if (changed)
+      ++stateCacheVersion_;
+}
+
 /**
  * Returns a partial state of the system, only for devices included in the
  * specified configuration.
@@ -818,6 +976,8 @@ void CMMCore::unloadDevice(const char* label///< the name of the device to unloa
       removeDeviceRole(pDevice);
 
       mm::DeviceModuleLockGuard guard(pDevice);
+      sequenceStreamer_->Cancel(pDevice.get());
+      slmPatternStore_->ForgetDisplayed(label);
       LOG_DEBUG(coreLogger_) << "Will unload device " << label;
       deviceManager_->UnloadDevice(pDevice);
       LOG_DEBUG(coreLogger_) << "Did unload device " << label;
@@ -856,6 +1016,8 @@ void CMMCore::unloadAllDevices() MMCORE_LEGACY_THROW(CMMError)
       }
 
       LOG_DEBUG(coreLogger_) << "Will unload all devices";
+      sequenceStreamer_->CancelAll();
+      slmPatternStore_->ForgetAllDisplayed();
       deviceManager_->UnloadAllDevices();
       LOG_INFO(coreLogger_) << "Did unload all devices";
 
@@ -1162,6 +1324,7 @@ void CMMCore::updateSystemStateCache()
    {
       MMThreadGuard scg(stateCacheLock_);
       stateCache_ = wk;
+      ++stateCacheVersion_;
    }
    LOG_INFO(coreLogger_) << "Did update system state cache";
 }
@@ -2251,7 +2414,16 @@ void CMMCore::loadExposureSequence(const char* cameraLabel, std::vector<double>
 
    mm::DeviceModuleLockGuard guard(pCamera);
 
-   int ret;
+   int ret = pCamera->SetExposureSequence(exposureTime_ms.data(),
+         static_cast<long>(exposureTime_ms.size()));
+   if (ret != DEVICE_UNSUPPORTED_COMMAND)
+   {
+      if (ret != DEVICE_OK)
+         throw CMMError(getDeviceErrorText(ret, pCamera));
+      return;
+   }
+
+   // The camera does not take the whole sequence at once
    ret = pCamera->ClearExposureSequence();
    if (ret != DEVICE_OK)
       throw CMMError(getDeviceErrorText(ret, pCamera));
@@ -2340,6 +2512,7 @@ void CMMCore::stopStageSequence(const char* label) MMCORE_LEGACY_THROW(CMMError)
 
    mm::DeviceModuleLockGuard guard(pStage);
 
+   sequenceStreamer_->Cancel(pStage.get());
    int ret = pStage->StopStageSequence();
    if (ret != DEVICE_OK)
       throw CMMError(getDeviceErrorText(ret, pStage));
@@ -2378,7 +2551,17 @@ void CMMCore::loadStageSequence(const char* label, std::vector<double> positionS
 
    mm::DeviceModuleLockGuard guard(pStage);
 
-   int ret;
+   sequenceStreamer_->Cancel(pStage.get());
+   int ret = pStage->SetStageSequence(positionSequence.data(),
+         static_cast<long>(positionSequence.size()));
+   if (ret != DEVICE_UNSUPPORTED_COMMAND)
+   {
+      if (ret != DEVICE_OK)
+         throw CMMError(getDeviceErrorText(ret, pStage));
+      return;
+   }
+
+   // The stage does not take the whole sequence at once
    ret = pStage->ClearStageSequence();
    if (ret != DEVICE_OK)
       throw CMMError(getDeviceErrorText(ret, pStage));
@@ -2415,12 +2598,66 @@ void CMMCore::setStageLinearSequence(const char* label, double dZ_um, int nSlice
 
    mm::DeviceModuleLockGuard guard(pStage);
 
+   sequenceStreamer_->Cancel(pStage.get());
    int ret;
    ret = pStage->SetStageLinearSequence(dZ_um, nSlices);
    if (ret != DEVICE_OK)
       throw CMMError(getDeviceErrorText(ret, pStage));
 }
 
+/**
+ * Transfer a sequence of stage positions that may be longer than
+ * getStageSequenceMaxLength().
+ *
+ * The Core loads as many positions as fit in the stage's sequence buffer
+ * and, while the sequence runs, appends the rest whenever the stage reports
+ * that half of its buffer is free. Unlike with loadStageSequence(), each
+ * position is used once; the sequence does not repeat. Stopping the sequence
+ * discards any positions not yet passed to the stage.
+ *
+ * This requires a stage that supports streamed sequences.
+ * @param label              the stage device label
+ * @param positionSequence   the positions that the stage will execute in response to external triggers
+ */
+void CMMCore::loadStreamingStageSequence(const char* label, std::vector<double> positionSequence) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<StageInstance> pStage =
+      deviceManager_->GetDeviceOfType<StageInstance>(label);
+
+   mm::DeviceModuleLockGuard guard(pStage);
+
+   sequenceStreamer_->Cancel(pStage.get());
+   int ret = pStage->ClearStageSequence();
+   if (ret != DEVICE_OK)
+      throw CMMError(getDeviceErrorText(ret, pStage));
+
+   StageInstance* stage = pStage.get();
+   ret = sequenceStreamer_->Start(pStage,
+      [stage](const double* positions, long count, long& numAppended) {
+         return stage->AppendToStageSequence(positions, count, numAppended);
+      }, std::move(positionSequence));
+   if (ret == DEVICE_UNSUPPORTED_COMMAND)
+      throw CMMError("Stage " + ToQuotedString(label) +
+            " does not support streamed sequences");
+   if (ret != DEVICE_OK)
+      throw CMMError(getDeviceErrorText(ret, pStage));
+}
+
+/**
+ * Returns the number of positions of a streamed stage sequence that have not
+ * yet been passed to the stage.
+ * @param label    the stage device label
+ * @return   the number of positions still held by the Core (0 if no streamed
+ *           sequence is loaded, or if all positions have been passed on)
+ */
+long CMMCore::getStreamingStageSequenceRemaining(const char* label) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<StageInstance> pStage =
+      deviceManager_->GetDeviceOfType<StageInstance>(label);
+
+   return static_cast<long>(sequenceStreamer_->GetRemaining(pStage.get()));
+}
+
 /**
  * Queries XY stage if it can be used in a sequence
  * @param label    the XY stage device label
@@ -2513,7 +2750,18 @@ void CMMCore::loadXYStageSequence(const char* label,
 
    mm::DeviceModuleLockGuard guard(pStage);
 
-   int ret;
+   const long length = static_cast<long>(
+         (std::min)(xSequence.size(), ySequence.size()));
+   int ret = pStage->SetXYStageSequence(xSequence.data(), ySequence.data(),
+         length);
+   if (ret != DEVICE_UNSUPPORTED_COMMAND)
+   {
+      if (ret != DEVICE_OK)
+         throw CMMError(getDeviceErrorText(ret, pStage));
+      return;
+   }
+
+   // The stage does not take the whole sequence at once
    ret = pStage->ClearXYStageSequence();
    if (ret != DEVICE_OK)
       throw CMMError(getDeviceErrorText(ret, pStage));
@@ -2626,7 +2874,7 @@ void CMMCore::setAutoShutter(bool state)
    autoShutter_ = state;
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreAutoShutter, state ? "1" : "0"));
+      addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreAutoShutter, state ? "1" : "0"));
    }
    LOG_DEBUG(coreLogger_) << "Autoshutter turned " << (state ? "on" : "off");
 }
@@ -2662,7 +2910,7 @@ void CMMCore::setShutterOpen(const char* shutterLabel, bool state) MMCORE_LEGACY
       {
          {
             MMThreadGuard scg(stateCacheLock_);
-            stateCache_.addSetting(PropertySetting(shutterLabel, MM::g_Keyword_State, CDeviceUtils::ConvertToString(state)));
+            addStateCacheSetting(PropertySetting(shutterLabel, MM::g_Keyword_State, CDeviceUtils::ConvertToString(state)));
          }
       }
    }
@@ -2883,6 +3131,7 @@ void CMMCore::startSequenceAcquisition(long numImages, double intervalMs, bool s
 
 		try
 		{
+			imageProcessingPipeline_->Drain();
 			if (!cbuf_->Initialize(camera->GetNumberOfChannels(), camera->GetImageWidth(), camera->GetImageHeight(), camera->GetImageBytesPerPixel()))
 			{
 				logError(getDeviceName(camera).c_str(), getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str());
@@ -2928,6 +3177,7 @@ void CMMCore::startSequenceAcquisition(const char* label, long numImages, double
       throw CMMError(getCoreErrorText(MMERR_NotAllowedDuringSequenceAcquisition).c_str(),
                      MMERR_NotAllowedDuringSequenceAcquisition);
 
+   imageProcessingPipeline_->Drain();
    if (!cbuf_->Initialize(pCam->GetNumberOfChannels(), pCam->GetImageWidth(), pCam->GetImageHeight(), pCam->GetImageBytesPerPixel()))
    {
       logError(getDeviceName(pCam).c_str(), getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str());
@@ -2980,6 +3230,7 @@ void CMMCore::initializeCircularBuffer() MMCORE_LEGACY_THROW(CMMError)
    if (camera)
    {
       mm::DeviceModuleLockGuard guard(camera);
+      imageProcessingPipeline_->Drain();
       if (!cbuf_->Initialize(camera->GetNumberOfChannels(), camera->GetImageWidth(), camera->GetImageHeight(), camera->GetImageBytesPerPixel()))
       {
          logError(getDeviceName(camera).c_str(), getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str());
@@ -3012,6 +3263,7 @@ void CMMCore::stopSequenceAcquisition(const char* label) MMCORE_LEGACY_THROW(CMM
       throw CMMError(getDeviceErrorText(nRet, pCam).c_str(), MMERR_DEVICE_GENERIC);
    }
 
+   imageProcessingPipeline_->Drain();
    LOG_DEBUG(coreLogger_) << "Did stop sequence acquisition from camera " << label;
    // onSequenceAcquisitionStopped will be called by CoreCallback::AcqFinished
 }
@@ -3033,6 +3285,7 @@ void CMMCore::startContinuousSequenceAcquisition(double intervalMs) MMCORE_LEGAC
             ,MMERR_NotAllowedDuringSequenceAcquisition);
       }
 
+      imageProcessingPipeline_->Drain();
       if (!cbuf_->Initialize(camera->GetNumberOfChannels(), camera->GetImageWidth(), camera->GetImageHeight(), camera->GetImageBytesPerPixel()))
       {
          logError(getDeviceName(camera).c_str(), getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str());
@@ -3076,6 +3329,7 @@ void CMMCore::stopSequenceAcquisition() MMCORE_LEGACY_THROW(CMMError)
       throw CMMError(getCoreErrorText(MMERR_CameraNotAvailable).c_str(), MMERR_CameraNotAvailable);
    }
 
+   imageProcessingPipeline_->Drain();
    LOG_DEBUG(coreLogger_) << "Did stop sequence acquisition from current camera";
    // onSequenceAcquisitionStopped will be called by CoreCallback::AcqFinished
 }
@@ -3092,13 +3346,16 @@ bool CMMCore::isSequenceRunning() MMCORE_NOEXCEPT
       try
       {
          mm::DeviceModuleLockGuard guard(camera);
-         return camera->IsCapturing();
+         if (camera->IsCapturing())
+            return true;
       }
       catch (const CMMError&) // Possibly uninitialized camera
       {
          // Fall through
       }
    }
+   // Once the sequence is reported done, all its images must be available
+   imageProcessingPipeline_->Drain();
    return false;
 };
 
@@ -3111,8 +3368,13 @@ bool CMMCore::isSequenceRunning(const char* label) MMCORE_LEGACY_THROW(CMMError)
    std::shared_ptr<CameraInstance> pCam =
       deviceManager_->GetDeviceOfType<CameraInstance>(label);
 
-   mm::DeviceModuleLockGuard guard(pCam);
-   return pCam->IsCapturing();
+   {
+      mm::DeviceModuleLockGuard guard(pCam);
+      if (pCam->IsCapturing())
+         return true;
+   }
+   imageProcessingPipeline_->Drain();
+   return false;
 };
 
 /**
@@ -3253,6 +3515,66 @@ void* CMMCore::popNextImageMD(Metadata& md) MMCORE_LEGACY_THROW(CMMError)
    return popNextImageMD(0, 0, md);
 }
 
+/**
+ * Gets the last image from the circular buffer and pins it, so that the
+ * buffer does not reuse its memory until releasePinnedImage() is called.
+ *
+ * This allows the pixels to be used in place instead of being copied (for
+ * example, MMCoreJ returns a direct ByteBuffer). While an image is pinned, a
+ * running sequence acquisition reports buffer overflow when it reaches the
+ * pinned slot, and the buffer cannot be reallocated. Each pinned image must
+ * be released exactly once.
+ */
+void* CMMCore::getLastImagePinned() MMCORE_LEGACY_THROW(CMMError)
+{
+   const mm::ImgBuffer* pBuf = cbuf_->PinNthFromTopImageBuffer(0, 0);
+   if (pBuf == 0)
+      throw CMMError(getCoreErrorText(MMERR_CircularBufferEmpty).c_str(), MMERR_CircularBufferEmpty);
+   return const_cast<unsigned char*>(pBuf->GetPixels());
+}
+
+/**
+ * Gets and removes the next image from the circular buffer, and pins it (see
+ * getLastImagePinned()).
+ */
+void* CMMCore::popNextImagePinned() MMCORE_LEGACY_THROW(CMMError)
+{
+   Metadata md;
+   return popNextImageMDPinned(0, md);
+}
+
+/**
+ * Gets and removes the next image (and metadata) from the circular buffer,
+ * and pins it (see getLastImagePinned()).
+ */
+void* CMMCore::popNextImageMDPinned(unsigned channel, Metadata& md) MMCORE_LEGACY_THROW(CMMError)
+{
+   const mm::ImgBuffer* pBuf = cbuf_->PinNextImageBuffer(channel);
+   if (pBuf == 0)
+      throw CMMError(getCoreErrorText(MMERR_CircularBufferEmpty).c_str(), MMERR_CircularBufferEmpty);
+   md = pBuf->GetMetadata();
+   return const_cast<unsigned char*>(pBuf->GetPixels());
+}
+
+/**
+ * Releases an image returned by getLastImagePinned(), popNextImagePinned(),
+ * or popNextImageMDPinned(), allowing the circular buffer to reuse its
+ * memory. The pixels must not be accessed afterwards.
+ */
+void CMMCore::releasePinnedImage(void* pinnedPixels) MMCORE_LEGACY_THROW(CMMError)
+{
+   if (!cbuf_->UnpinImage(static_cast<const unsigned char*>(pinnedPixels)))
+      throw CMMError("Image is not pinned");
+}
+
+/**
+ * Returns the number of pinned images that have not been released.
+ */
+long CMMCore::getPinnedImageCount()
+{
+   return static_cast<long>(cbuf_->GetPinnedImageCount());
+}
+
 /**
  * Removes all images from the circular buffer.
  *
@@ -3261,21 +3583,87 @@ void* CMMCore::popNextImageMD(Metadata& md) MMCORE_LEGACY_THROW(CMMError)
  */
 void CMMCore::clearCircularBuffer() MMCORE_LEGACY_THROW(CMMError)
 {
+   imageProcessingPipeline_->Drain();
    cbuf_->Clear();
 }
 
+/**
+ * Returns statistics of the images acquired since the Core was created or
+ * resetAcquisitionStatistics() was last called, as a JSON object.
+ *
+ * The object holds the number of frames inserted into and popped from the
+ * circular buffer, the number of frames dropped because it was full, the
+ * mean and recent (median) frame rate, the queue depth of the buffer, and
+ * histogram summaries (count, min, mean, p50, p90, p99 and max, in
+ * microseconds) of:
+ * - cameraToInsert: from the camera handing over a frame to the frame being
+ *   in the circular buffer, including image processing
+ * - processing: time spent in the image processor
+ * - copy: copying the frame into the circular buffer
+ * - insertToPop: time frames wait in the buffer until popped
+ * - frameInterval: time between successive insertions
+ *
+ * The statistics are collected without locking, so they can be read at any
+ * time, including during sequence acquisition, without disturbing it. The
+ * main numbers are also available as read-only Core properties.
+ */
+std::string CMMCore::getAcquisitionStatistics() const
+{
+   return acqStatistics_->ToJSON();
+}
+
+/**
+ * Clears all counters and histograms reported by getAcquisitionStatistics().
+ */
+void CMMCore::resetAcquisitionStatistics()
+{
+   acqStatistics_->Reset();
+   LOG_DEBUG(coreLogger_) << "Did reset acquisition statistics";
+}
+
+/**
+ * Enables a periodic dump of getAcquisitionStatistics() to the log.
+ *
+ * While images are being inserted into the circular buffer, the statistics
+ * are logged at most once per interval. Also available as the Core property
+ * StatisticsLogIntervalMs.
+ *
+ * @param intervalMs  the minimum time between dumps; 0 (the default)
+ *                    disables the dump
+ */
+void CMMCore::setAcquisitionStatisticsLogInterval(long intervalMs)
+{
+   acqStatistics_->SetLogIntervalMs(intervalMs);
+   properties_->Set(mm::AcquisitionStatistics::LogIntervalProperty,
+      CDeviceUtils::ConvertToString(acqStatistics_->GetLogIntervalMs()));
+   LOG_DEBUG(coreLogger_) << "Acquisition statistics log interval set to " <<
+      acqStatistics_->GetLogIntervalMs() << " ms";
+}
+
+/**
+ * Returns the interval set by setAcquisitionStatisticsLogInterval().
+ */
+long CMMCore::getAcquisitionStatisticsLogInterval() const
+{
+   return acqStatistics_->GetLogIntervalMs();
+}
+
 /**
  * Reserve memory for the circular buffer.
  */
 void CMMCore::setCircularBufferMemoryFootprint(unsigned sizeMB ///< n megabytes
                                                ) MMCORE_LEGACY_THROW(CMMError)
 {
+   if (cbuf_->GetPinnedImageCount() > 0)
+      throw CMMError(getCoreErrorText(MMERR_CircularBufferImagesPinned).c_str(),
+            MMERR_CircularBufferImagesPinned);
+   imageProcessingPipeline_->Drain();
    delete cbuf_; // discard old buffer
    LOG_DEBUG(coreLogger_) << "Will set circular buffer size to " <<
       sizeMB << " MB";
 	try
 	{
-		cbuf_ = new CircularBuffer(sizeMB);
+		cbuf_ = new CircularBuffer(sizeMB, acqStatistics_);
 	}
 	catch (std::bad_alloc& ex)
 	{
@@ -3459,7 +3847,7 @@ void CMMCore::setAutoFocusDevice(const char* autofocusLabel) MMCORE_LEGACY_THROW
    properties_->Set(MM::g_Keyword_CoreAutoFocus, newAutofocusLabel.c_str());
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreAutoFocus, newAutofocusLabel.c_str()));
+      addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreAutoFocus, newAutofocusLabel.c_str()));
    }
 }
 
@@ -3511,6 +3899,8 @@ std::string CMMCore::getGalvoDevice()
  */
 void CMMCore::setImageProcessorDevice(const char* procLabel) MMCORE_LEGACY_THROW(CMMError)
 {
+   // Queued frames hold a pointer to the current processor
+   imageProcessingPipeline_->Drain();
    if (procLabel && strlen(procLabel)>0)
    {
       currentImageProcessor_ =
@@ -3526,7 +3916,7 @@ void CMMCore::setImageProcessorDevice(const char* procLabel) MMCORE_LEGACY_THROW
    properties_->Set(MM::g_Keyword_CoreImageProcessor, newProcLabel.c_str());
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreImageProcessor, newProcLabel.c_str()));
+      addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreImageProcessor, newProcLabel.c_str()));
    }
 }
 
@@ -3550,7 +3940,7 @@ void CMMCore::setSLMDevice(const char* slmLabel) MMCORE_LEGACY_THROW(CMMError)
    properties_->Set(MM::g_Keyword_CoreSLM, newSLMLabel.c_str());
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreSLM, newSLMLabel.c_str()));
+      addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreSLM, newSLMLabel.c_str()));
    }
 }
 
@@ -3575,7 +3965,7 @@ void CMMCore::setGalvoDevice(const char* galvoLabel) MMCORE_LEGACY_THROW(CMMErro
    properties_->Set(MM::g_Keyword_CoreGalvo, newGalvoLabel.c_str());
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreGalvo, newGalvoLabel.c_str()));
+      addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreGalvo, newGalvoLabel.c_str()));
    }
 }
 
@@ -3602,7 +3992,7 @@ void CMMCore::setChannelGroup(const char* chGroup) MMCORE_LEGACY_THROW(CMMError)
 
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreChannelGroup, channelGroup_.c_str()));
+      addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreChannelGroup, channelGroup_.c_str()));
    }
    if (externalCallback_ != 0) 
    {
@@ -3664,7 +4054,7 @@ void CMMCore::setShutterDevice(const char* shutterLabel) MMCORE_LEGACY_THROW(CMM
    properties_->Set(MM::g_Keyword_CoreShutter, newShutterLabel.c_str());
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreShutter, newShutterLabel.c_str()));
+      addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreShutter, newShutterLabel.c_str()));
    }
 }
 
@@ -3689,7 +4079,7 @@ void CMMCore::setFocusDevice(const char* focusLabel) MMCORE_LEGACY_THROW(CMMErro
    properties_->Set(MM::g_Keyword_CoreFocus, newFocusLabel.c_str());
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreFocus, newFocusLabel.c_str()));
+      addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreFocus, newFocusLabel.c_str()));
    }
 }
 
@@ -3713,7 +4103,7 @@ void CMMCore::setXYStageDevice(const char* xyDeviceLabel) MMCORE_LEGACY_THROW(CM
    properties_->Set(MM::g_Keyword_CoreXYStage, newXYStageLabel.c_str());
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreXYStage, newXYStageLabel.c_str()));
+      addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreXYStage, newXYStageLabel.c_str()));
    }
 }
 
@@ -3752,7 +4142,7 @@ void CMMCore::setCameraDevice(const char* cameraLabel) MMCORE_LEGACY_THROW(CMMEr
    properties_->Set(MM::g_Keyword_CoreCamera, newCameraLabel.c_str());
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreCamera, newCameraLabel.c_str()));
+      addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, MM::g_Keyword_CoreCamera, newCameraLabel.c_str()));
    }
 }
 
@@ -3856,7 +4246,7 @@ std::string CMMCore::getProperty(const char* label, const char* propName) MMCORE
    PropertySetting s(label, propName, value.c_str());
    {
       MMThreadGuard scg(stateCacheLock_);
-      stateCache_.addSetting(s);
+      addStateCacheSetting(s);
    }
 
    return value;
@@ -3909,7 +4299,7 @@ void CMMCore::setProperty(const char* label, const char* propName,
       properties_->Execute(propName, propValue);
       {
          MMThreadGuard scg(stateCacheLock_);
-         stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, propName, propValue));
+         addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, propName, propValue));
       }
 
       LOG_DEBUG(coreLogger_) << "Did set Core property: " <<
@@ -3925,7 +4315,7 @@ void CMMCore::setProperty(const char* label, const char* propName,
 
       {
          MMThreadGuard scg(stateCacheLock_);
-         stateCache_.addSetting(PropertySetting(label, propName, propValue));
+         addStateCacheSetting(PropertySetting(label, propName, propValue));
       }
    }
 }
@@ -4163,17 +4553,22 @@ void CMMCore::loadPropertySequence(const char* label, const char* propName, std:
    std::shared_ptr<DeviceInstance> pDevice = deviceManager_->GetDevice(label);
    CheckPropertyName(propName);
 
-   mm::DeviceModuleLockGuard guard(pDevice);
-   pDevice->ClearPropertySequence(propName);
-
-   for (std::vector<std::string>::const_iterator it = eventSequence.begin(),
-         end = eventSequence.end();
-         it < end; ++it)
+   std::vector<const char*> values;
+   values.reserve(eventSequence.size());
+   for (const std::string& value : eventSequence)
    {
-      CheckPropertyValue(it->c_str());
-      pDevice->AddToPropertySequence(propName, it->c_str());
+      CheckPropertyValue(value.c_str());
+      values.push_back(value.c_str());
    }
 
+   mm::DeviceModuleLockGuard guard(pDevice);
+   if (pDevice->SetPropertySequence(propName, values.data(),
+            static_cast<long>(values.size())))
+      return;
+
+   pDevice->ClearPropertySequence(propName);
+   for (const char* value : values)
+      pDevice->AddToPropertySequence(propName, value);
    pDevice->SendPropertySequence(propName);
 }
 
@@ -4393,7 +4788,7 @@ void CMMCore::setExposure(const char* label, double dExp) MMCORE_LEGACY_THROW(CM
       {
          {
             MMThreadGuard scg(stateCacheLock_);
-            stateCache_.addSetting(PropertySetting(label, MM::g_Keyword_Exposure, CDeviceUtils::ConvertToString(dExp)));
+            addStateCacheSetting(PropertySetting(label, MM::g_Keyword_Exposure, CDeviceUtils::ConvertToString(dExp)));
          }
       }
    }
@@ -4472,6 +4867,7 @@ void CMMCore::setROI(int x, int y, int xSize, int ySize) MMCORE_LEGACY_THROW(CMM
       // inconsistent with the current image size. There is no way to "fix"
       // popNextImage() to handle this correctly, so we need to make sure we
       // discard such images.
+      imageProcessingPipeline_->Drain();
       cbuf_->Clear();
    }
    else
@@ -4551,6 +4947,7 @@ void CMMCore::setROI(const char* label, int x, int y, int xSize, int ySize) MMCO
      // inconsistent with the current image size. There is no way to "fix"
      // popNextImage() to handle this correctly, so we need to make sure we
      // discard such images.
+     imageProcessingPipeline_->Drain();
      cbuf_->Clear();
   }
   else
@@ -4610,6 +5007,7 @@ void CMMCore::clearROI() MMCORE_LEGACY_THROW(CMMError)
       // inconsistent with the current image size. There is no way to "fix"
       // popNextImage() to handle this correctly, so we need to make sure we
       // discard such images.
+      imageProcessingPipeline_->Drain();
       cbuf_->Clear();
    }
 }
@@ -4750,7 +5148,7 @@ void CMMCore::setState(const char* deviceLabel, long state) MMCORE_LEGACY_THROW(
    {
       {
          MMThreadGuard scg(stateCacheLock_);
-         stateCache_.addSetting(PropertySetting(deviceLabel, MM::g_Keyword_State, CDeviceUtils::ConvertToString(state)));
+         addStateCacheSetting(PropertySetting(deviceLabel, MM::g_Keyword_State, CDeviceUtils::ConvertToString(state)));
       }
    }
    if (pStateDev->HasProperty(MM::g_Keyword_Label))
@@ -4759,7 +5157,7 @@ void CMMCore::setState(const char* deviceLabel, long state) MMCORE_LEGACY_THROW(
 
       {
          MMThreadGuard scg(stateCacheLock_);
-         stateCache_.addSetting(PropertySetting(deviceLabel, MM::g_Keyword_Label, posLbl.c_str()));
+         addStateCacheSetting(PropertySetting(deviceLabel, MM::g_Keyword_Label, posLbl.c_str()));
       }
    }
 
@@ -4831,7 +5229,7 @@ void CMMCore::setStateLabel(const char* deviceLabel, const char* stateLabel) MMC
    {
       {
          MMThreadGuard scg(stateCacheLock_);
-         stateCache_.addSetting(PropertySetting(deviceLabel, MM::g_Keyword_Label, stateLabel));
+         addStateCacheSetting(PropertySetting(deviceLabel, MM::g_Keyword_Label, stateLabel));
       }
    }
    if (pStateDev->HasProperty(MM::g_Keyword_State))
@@ -4839,7 +5237,7 @@ void CMMCore::setStateLabel(const char* deviceLabel, const char* stateLabel) MMC
       long state = getStateFromLabel(deviceLabel, stateLabel);
       {
          MMThreadGuard scg(stateCacheLock_);
-         stateCache_.addSetting(PropertySetting(deviceLabel, MM::g_Keyword_State,
+         addStateCacheSetting(PropertySetting(deviceLabel, MM::g_Keyword_State,
                   CDeviceUtils::ConvertToString(state)));
       }
    }
@@ -6082,6 +6480,11 @@ void CMMCore::setSerialProperties(const char* portName,
  * sequence.
  */
 void CMMCore::setSerialPortCommand(const char* portLabel, const char* command, const char* term) MMCORE_LEGACY_THROW(CMMError)
+{
+   setSerialPortCommandImpl(MM::g_Keyword_CoreDevice, portLabel, command, term);
+}
+
+void CMMCore::setSerialPortCommandImpl(const std::string& client, const char* portLabel, const char* command, const char* term) MMCORE_LEGACY_THROW(CMMError)
 {
    std::shared_ptr<SerialInstance> pSerial =
       deviceManager_->GetDeviceOfType<SerialInstance>(portLabel);
@@ -6090,7 +6493,7 @@ void CMMCore::setSerialPortCommand(const char* portLabel, const char* command, c
    if (!term)
       term = "";
 
-   int ret = pSerial->SetCommand(command, term);
+   int ret = pSerial->SetCommand(client, command, term);
    if (ret != DEVICE_OK)
    {
       logError(portLabel, getDeviceErrorText(ret, pSerial).c_str());
@@ -6102,6 +6505,11 @@ void CMMCore::setSerialPortCommand(const char* portLabel, const char* command, c
  * Continuously read from the serial port until the terminating sequence is encountered.
  */
 std::string CMMCore::getSerialPortAnswer(const char* portLabel, const char* term) MMCORE_LEGACY_THROW(CMMError)
+{
+   return getSerialPortAnswerImpl(MM::g_Keyword_CoreDevice, portLabel, term);
+}
+
+std::string CMMCore::getSerialPortAnswerImpl(const std::string& client, const char* portLabel, const char* term) MMCORE_LEGACY_THROW(CMMError)
 {
    std::shared_ptr<SerialInstance> pSerial =
       deviceManager_->GetDeviceOfType<SerialInstance>(portLabel);
@@ -6110,7 +6518,7 @@ std::string CMMCore::getSerialPortAnswer(const char* portLabel, const char* term
 
    const int bufLen = 1024;
    char answerBuf[bufLen];
-   int ret = pSerial->GetAnswer(answerBuf, bufLen, term);
+   int ret = pSerial->GetAnswer(client, answerBuf, bufLen, term);
    if (ret != DEVICE_OK)
    {
       std::string errText = getDeviceErrorText(ret, pSerial).c_str();
@@ -6121,6 +6529,51 @@ std::string CMMCore::getSerialPortAnswer(const char* portLabel, const char* term
    return std::string(answerBuf);
 }
 
+/**
+ * Send several commands to the serial port back to back and return their
+ * answers, in order.
+ *
+ * All commands are written before the first answer is read, so the device
+ * can process them without waiting for a round trip per command. No other
+ * command or answer on the same port is interleaved with the transaction.
+ *
+ * @param portLabel     the serial port
+ * @param commands      the commands to send
+ * @param commandTerm   the terminating sequence appended to each command
+ * @param answerTerm    the terminating sequence of each answer
+ * @return the answers, without the terminating sequence
+ */
+std::vector<std::string> CMMCore::transactSerialPortCommands(const char* portLabel,
+      const std::vector<std::string>& commands, const char* commandTerm,
+      const char* answerTerm) MMCORE_LEGACY_THROW(CMMError)
+{
+   return transactSerialPortCommandsImpl(MM::g_Keyword_CoreDevice, portLabel,
+         commands, commandTerm, answerTerm);
+}
+
+std::vector<std::string> CMMCore::transactSerialPortCommandsImpl(
+      const std::string& client, const char* portLabel,
+      const std::vector<std::string>& commands, const char* commandTerm,
+      const char* answerTerm) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<SerialInstance> pSerial =
+      deviceManager_->GetDeviceOfType<SerialInstance>(portLabel);
+   if (!commandTerm)
+      commandTerm = "";
+   if (!answerTerm || answerTerm[0] == '\0')
+      throw CMMError("Null or empty terminator; cannot delimit received message");
+
+   std::vector<std::string> answers;
+   int ret = pSerial->Transact(client, commands, commandTerm, answerTerm, answers);
+   if (ret != DEVICE_OK)
+   {
+      std::string errText = getDeviceErrorText(ret, pSerial).c_str();
+      logError(portLabel, errText.c_str());
+      throw CMMError(errText);
+   }
+   return answers;
+}
+
 /**
  * Sends an array of characters to the serial port and returns immediately.
  */
@@ -6129,7 +6582,7 @@ void CMMCore::writeToSerialPort(const char* portLabel, const std::vector<char> &
    std::shared_ptr<SerialInstance> pSerial =
       deviceManager_->GetDeviceOfType<SerialInstance>(portLabel);
 
-   int ret = pSerial->Write((unsigned char*)(&(data[0])), (unsigned long)data.size());
+   int ret = pSerial->Write(MM::g_Keyword_CoreDevice, (unsigned char*)(&(data[0])), (unsigned long)data.size());
    if (ret != DEVICE_OK)
    {
       logError(portLabel, getDeviceErrorText(ret, pSerial).c_str());
@@ -6148,7 +6601,7 @@ std::vector<char> CMMCore::readFromSerialPort(const char* portLabel) MMCORE_LEGA
    const int bufLen = 1024; // internal chunk size limit
    unsigned char answerBuf[bufLen];
    unsigned long read;
-   int ret = pSerial->Read(answerBuf, bufLen, read);
+   int ret = pSerial->Read(MM::g_Keyword_CoreDevice, answerBuf, bufLen, read);
    if (ret != DEVICE_OK)
    {
       logError(portLabel, getDeviceErrorText(ret, pSerial).c_str());
@@ -6163,6 +6616,43 @@ std::vector<char> CMMCore::readFromSerialPort(const char* portLabel) MMCORE_LEGA
    return data;
 }
 
+/**
+ * Report how the serial port has been shared among the devices using it.
+ *
+ * Calls on a serial port from different devices (and from the application,
+ * reported as "Core") are arbitrated by a scheduler that serves each device
+ * in turn, devices that recently held the port only briefly (such as for
+ * status queries) first. A device keeps the port from sending a command
+ * until it has read the answer, so that replies are not read by the wrong
+ * device.
+ *
+ * The returned text contains one line per device: the number of times the
+ * port was granted, and the mean and maximum time the port was held and the
+ * device waited to get it, in milliseconds.
+ *
+ * @param portLabel     the serial port
+ * @param reset         if true, clear the statistics after reading them
+ */
+std::string CMMCore::getSerialPortStatistics(const char* portLabel, bool reset) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<SerialInstance> pSerial =
+      deviceManager_->GetDeviceOfType<SerialInstance>(portLabel);
+
+   std::ostringstream txt;
+   txt << std::fixed << std::setprecision(3);
+   for (const auto& stats : pSerial->GetSchedulingStatistics())
+   {
+      const double n = stats.slices > 0 ? double(stats.slices) : 1.0;
+      txt << stats.client << ": " << stats.slices << " slices, hold " <<
+         stats.totalHoldMs / n << " ms mean / " << stats.maxHoldMs <<
+         " ms max, wait " << stats.totalWaitMs / n << " ms mean / " <<
+         stats.maxWaitMs << " ms max\n";
+   }
+   if (reset)
+      pSerial->ResetSchedulingStatistics();
+   return txt.str();
+}
+
 
 /**
  * Write an 8-bit monochrome image to the SLM.
@@ -6174,6 +6664,7 @@ void CMMCore::setSLMImage(const char* deviceLabel, unsigned char* pixels) MMCORE
    if (!pixels)
       throw CMMError("Null image");
    mm::DeviceModuleLockGuard guard(pSLM);
+   slmPatternStore_->ForgetDisplayed(deviceLabel);
    int ret = pSLM->SetImage(pixels);
    if (ret != DEVICE_OK)
    {
@@ -6192,6 +6683,7 @@ void CMMCore::setSLMImage(const char* deviceLabel, imgRGB32 pixels) MMCORE_LEGAC
    if (!pixels)
       throw CMMError("Null image");
    mm::DeviceModuleLockGuard guard(pSLM);
+   slmPatternStore_->ForgetDisplayed(deviceLabel);
    int ret = pSLM->SetImage((unsigned int *) pixels);
    if (ret != DEVICE_OK)
    {
@@ -6209,6 +6701,7 @@ void CMMCore::setSLMPixelsTo(const char* deviceLabel, unsigned char intensity) M
       deviceManager_->GetDeviceOfType<SLMInstance>(deviceLabel);
 
    mm::DeviceModuleLockGuard guard(pSLM);
+   slmPatternStore_->ForgetDisplayed(deviceLabel);
    int ret = pSLM->SetPixelsTo(intensity);
    if (ret != DEVICE_OK)
    {
@@ -6226,6 +6719,7 @@ void CMMCore::setSLMPixelsTo(const char* deviceLabel, unsigned char red, unsigne
       deviceManager_->GetDeviceOfType<SLMInstance>(deviceLabel);
 
    mm::DeviceModuleLockGuard guard(pSLM);
+   slmPatternStore_->ForgetDisplayed(deviceLabel);
    int ret = pSLM->SetPixelsTo(red, green, blue);
    if (ret != DEVICE_OK)
    {
@@ -6370,6 +6864,7 @@ void CMMCore::startSLMSequence(const char* deviceLabel) MMCORE_LEGACY_THROW(CMME
       deviceManager_->GetDeviceOfType<SLMInstance>(deviceLabel);
 
    mm::DeviceModuleLockGuard guard(pSLM);
+   slmPatternStore_->ForgetDisplayed(deviceLabel);
    int ret = pSLM->StartSLMSequence();
    if (ret != DEVICE_OK)
       throw CMMError(getDeviceErrorText(ret, pSLM));
@@ -6404,6 +6899,7 @@ void CMMCore::loadSLMSequence(const char* deviceLabel, std::vector<unsigned char
 
 
    mm::DeviceModuleLockGuard guard(pSLM);
+   slmPatternStore_->ForgetDisplayed(deviceLabel);
    int ret = pSLM->ClearSLMSequence();
    if (ret != DEVICE_OK)
       throw CMMError(getDeviceErrorText(ret, pSLM));
@@ -6422,51 +6918,298 @@ void CMMCore::loadSLMSequence(const char* deviceLabel, std::vector<unsigned char
       throw CMMError(getDeviceErrorText(ret, pSLM));
 }
 
-/* GALVO CODE */
-
 /**
- * Set the Galvo to an x,y position and fire the laser for a predetermined duration.
+ * Add an 8-bit monochrome pattern to the Core's SLM pattern store
+ *
+ * Patterns in the store are referred to by ID (see setSLMPattern() and
+ * loadSLMPatternSequence()). Adding a pattern that is already stored returns
+ * the ID of the stored copy. Binary patterns are stored at one bit per pixel.
+ *
+ * As with setSLMImage(), the pattern has one byte per pixel whatever the
+ * SLM's pixel format, and the SLM converts it when it is written.
+ *
+ * @param slmLabel   the SLM whose image size the pattern has
+ * @param pixels     width * height bytes
+ * @return the pattern ID
  */
-void CMMCore::pointGalvoAndFire(const char* deviceLabel, double x, double y, double pulseTime_us) MMCORE_LEGACY_THROW(CMMError)
+long CMMCore::addSLMPattern(const char* slmLabel, unsigned char* pixels) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<GalvoInstance> pGalvo =
-      deviceManager_->GetDeviceOfType<GalvoInstance>(deviceLabel);
-
-   mm::DeviceModuleLockGuard guard(pGalvo);
-
-   int ret = pGalvo->PointAndFire(x,y,pulseTime_us);
-
-   if (ret != DEVICE_OK)
-   {
-      logError(deviceLabel, getDeviceErrorText(ret, pGalvo).c_str());
-      throw CMMError(getDeviceErrorText(ret, pGalvo));
-   }
+   return addSLMPatternImpl(slmLabel, pixels, 1);
 }
 
-void CMMCore::setGalvoSpotInterval(const char* deviceLabel, double pulseTime_us) MMCORE_LEGACY_THROW(CMMError)
+/**
+ * Add a 32-bit color pattern to the Core's SLM pattern store
+ *
+ * See the 8-bit version. Color patterns can only be used with SLMs that have
+ * 4 bytes per pixel.
+ *
+ * @param slmLabel   the SLM whose image size the pattern has
+ * @param pixels     width * height 32-bit pixels, as for setSLMImage()
+ * @return the pattern ID
+ */
+long CMMCore::addSLMPattern(const char* slmLabel, imgRGB32 pixels) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<GalvoInstance> pGalvo =
-      deviceManager_->GetDeviceOfType<GalvoInstance>(deviceLabel);
-
-   mm::DeviceModuleLockGuard guard(pGalvo);
+   return addSLMPatternImpl(slmLabel,
+      reinterpret_cast<const unsigned char*>(pixels), 4);
+}
 
-   int ret = pGalvo->SetSpotInterval(pulseTime_us);
+long CMMCore::addSLMPatternImpl(const char* slmLabel,
+      const unsigned char* pixels, unsigned bytesPerPixel) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<SLMInstance> pSLM =
+      deviceManager_->GetDeviceOfType<SLMInstance>(slmLabel);
+   if (!pixels)
+      throw CMMError("Null image");
 
-   if (ret != DEVICE_OK)
+   mm::SLMPatternStore::Geometry geometry;
    {
-      logError(deviceLabel, getDeviceErrorText(ret, pGalvo).c_str());
-      throw CMMError(getDeviceErrorText(ret, pGalvo));
+      mm::DeviceModuleLockGuard guard(pSLM);
+      geometry.width = pSLM->GetWidth();
+      geometry.height = pSLM->GetHeight();
    }
+   geometry.bytesPerPixel = bytesPerPixel;
+   return slmPatternStore_->Add(pixels, geometry);
 }
 
+/**
+ * Remove a pattern from the SLM pattern store
+ *
+ * A pattern that was added several times is kept until it has been deleted
+ * as many times.
+ */
+void CMMCore::deleteSLMPattern(long patternId) MMCORE_LEGACY_THROW(CMMError)
+{
+   if (!slmPatternStore_->Remove(patternId))
+      throw CMMError("No SLM pattern with ID " + ToString(patternId));
+}
 
 /**
- * Set the Galvo to an x,y position
+ * Remove all patterns from the SLM pattern store
  */
-void CMMCore::setGalvoPosition(const char* deviceLabel, double x, double y) MMCORE_LEGACY_THROW(CMMError)
+void CMMCore::deleteSLMPatterns()
 {
-   std::shared_ptr<GalvoInstance> pGalvo =
-      deviceManager_->GetDeviceOfType<GalvoInstance>(deviceLabel);
+   slmPatternStore_->Clear();
+}
+
+/**
+ * Returns the number of distinct patterns in the SLM pattern store
+ */
+long CMMCore::getNumberOfSLMPatterns()
+{
+   return static_cast<long>(slmPatternStore_->GetNumberOfPatterns());
+}
+
+/**
+ * Returns the memory, in bytes, taken by the pixels of stored SLM patterns
+ */
+long CMMCore::getSLMPatternStorageBytes()
+{
+   return static_cast<long>(slmPatternStore_->GetStoredBytes());
+}
+
+/**
+ * Write a stored pattern to the SLM
+ *
+ * If the previous image was also set with this function, only the
+ * rectangle containing the changed pixels is sent to SLMs that support
+ * partial updates (and nothing is sent if no pixels changed). As with
+ * setSLMImage(), call displaySLMImage() to display it.
+ */
+void CMMCore::setSLMPattern(const char* slmLabel, long patternId) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<SLMInstance> pSLM =
+      deviceManager_->GetDeviceOfType<SLMInstance>(slmLabel);
+
+   mm::DeviceModuleLockGuard guard(pSLM);
+   checkSLMPattern(pSLM, patternId);
+   mm::SLMPatternStore::Geometry geometry;
+   slmPatternStore_->GetGeometry(patternId, geometry);
+   // Partial updates are in the SLM's own pixel format
+   const bool nativeFormat =
+      geometry.bytesPerPixel == pSLM->GetBytesPerPixel();
+   std::vector<unsigned char> pixels;
+   slmPatternStore_->Unpack(patternId, pixels);
+
+   int ret = DEVICE_UNSUPPORTED_COMMAND;
+   std::vector<unsigned char> previous;
+   const long previousId = slmPatternStore_->GetDisplayed(slmLabel);
+   mm::SLMPatternStore::Geometry previousGeometry;
+   if (previousId == patternId)
+   {
+      ret = DEVICE_OK;
+   }
+   else if (nativeFormat && previousId != 0 &&
+         slmPatternStore_->GetGeometry(previousId, previousGeometry) &&
+         previousGeometry == geometry &&
+         slmPatternStore_->Unpack(previousId, previous))
+   {
+      const mm::SLMPatternStore::Rect r = mm::SLMPatternStore::ChangedArea(
+         previous.data(), pixels.data(), geometry);
+      if (r.IsEmpty())
+      {
+         ret = DEVICE_OK;
+      }
+      else
+      {
+         const std::size_t bpp = geometry.bytesPerPixel;
+         const std::size_t rowBytes = (r.right - r.left) * bpp;
+         std::vector<unsigned char> region;
+         region.reserve(rowBytes * (r.bottom - r.top));
+         for (unsigned y = r.top; y < r.bottom; ++y)
+         {
+            const unsigned char* row =
+               &pixels[(std::size_t(y) * geometry.width + r.left) * bpp];
+            region.insert(region.end(), row, row + rowBytes);
+         }
+         ret = pSLM->SetImageRegion(region.data(), r.left, r.top,
+            r.right - r.left, r.bottom - r.top);
+      }
+   }
+
+   if (ret == DEVICE_UNSUPPORTED_COMMAND)
+   {
+      if (geometry.bytesPerPixel == 4)
+         ret = pSLM->SetImage(reinterpret_cast<unsigned int*>(pixels.data()));
+      else
+         ret = pSLM->SetImage(pixels.data());
+   }
+   if (ret != DEVICE_OK)
+   {
+      slmPatternStore_->ForgetDisplayed(slmLabel);
+      logError(slmLabel, getDeviceErrorText(ret, pSLM).c_str());
+      throw CMMError(getDeviceErrorText(ret, pSLM));
+   }
+   slmPatternStore_->SetDisplayed(slmLabel, patternId);
+}
+
+unsigned CMMCore::checkSLMPattern(std::shared_ptr<SLMInstance> pSLM, long patternId) MMCORE_LEGACY_THROW(CMMError)
+{
+   mm::SLMPatternStore::Geometry geometry;
+   if (!slmPatternStore_->GetGeometry(patternId, geometry))
+      throw CMMError("No SLM pattern with ID " + ToString(patternId));
+   // 8-bit patterns suit any SLM, as with setSLMImage()
+   if (geometry.width != pSLM->GetWidth() ||
+         geometry.height != pSLM->GetHeight() ||
+         (geometry.bytesPerPixel != 1 &&
+          geometry.bytesPerPixel != pSLM->GetBytesPerPixel()))
+      throw CMMError("SLM pattern " + ToString(patternId) +
+            " does not match the image size or pixel format of " +
+            ToQuotedString(pSLM->GetLabel()));
+   return geometry.bytesPerPixel;
+}
+
+/**
+ * Load a sequence of stored patterns into the SLM
+ *
+ * Equivalent to loadSLMSequence() with the patterns' pixels, but each
+ * distinct pattern is unpacked only once, and SLMs that support it receive
+ * pattern IDs so that repeated patterns need not be stored again.
+ *
+ * @param slmLabel     name of the SLM
+ * @param patternIds   IDs returned by addSLMPattern()
+ */
+void CMMCore::loadSLMPatternSequence(const char* slmLabel, std::vector<long> patternIds) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<SLMInstance> pSLM =
+      deviceManager_->GetDeviceOfType<SLMInstance>(slmLabel);
+
+   mm::DeviceModuleLockGuard guard(pSLM);
+
+   std::map<long, std::vector<unsigned char>> unpacked;
+   std::map<long, unsigned> bytesPerPixel;
+   for (long id : patternIds)
+   {
+      if (unpacked.count(id))
+         continue;
+      bytesPerPixel[id] = checkSLMPattern(pSLM, id);
+      slmPatternStore_->Unpack(id, unpacked[id]);
+   }
+
+   // Pattern IDs are only passed for patterns in the SLM's own format
+   const unsigned slmBytesPerPixel = pSLM->GetBytesPerPixel();
+   bool byId = true;
+   for (const auto& entry : bytesPerPixel)
+   {
+      if (entry.second != slmBytesPerPixel)
+         byId = false;
+   }
+
+   // Uploading a sequence may change what the SLM shows
+   slmPatternStore_->ForgetDisplayed(slmLabel);
+   int ret = pSLM->ClearSLMSequence();
+   if (ret != DEVICE_OK)
+      throw CMMError(getDeviceErrorText(ret, pSLM));
+
+   for (long id : patternIds)
+   {
+      const unsigned char* pixels = unpacked[id].data();
+      ret = DEVICE_UNSUPPORTED_COMMAND;
+      if (byId)
+      {
+         ret = pSLM->AddPatternToSLMSequence(id, pixels);
+         byId = (ret != DEVICE_UNSUPPORTED_COMMAND);
+      }
+      if (!byId)
+      {
+         if (bytesPerPixel[id] == 4)
+            ret = pSLM->AddToSLMSequence(reinterpret_cast<const unsigned int*>(pixels));
+         else
+            ret = pSLM->AddToSLMSequence(pixels);
+      }
+      if (ret != DEVICE_OK)
+         throw CMMError(getDeviceErrorText(ret, pSLM));
+   }
+
+   ret = pSLM->SendSLMSequence();
+   if (ret != DEVICE_OK)
+      throw CMMError(getDeviceErrorText(ret, pSLM));
+}
+
+/* GALVO CODE */
+
+/**
+ * Set the Galvo to an x,y position and fire the laser for a predetermined duration.
+ */
+void CMMCore::pointGalvoAndFire(const char* deviceLabel, double x, double y, double pulseTime_us) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<GalvoInstance> pGalvo =
+      deviceManager_->GetDeviceOfType<GalvoInstance>(deviceLabel);
+
+   mm::DeviceModuleLockGuard guard(pGalvo);
+
+   int ret = pGalvo->PointAndFire(x,y,pulseTime_us);
+
+   if (ret != DEVICE_OK)
+   {
+      logError(deviceLabel, getDeviceErrorText(ret, pGalvo).c_str());
+      throw CMMError(getDeviceErrorText(ret, pGalvo));
+   }
+}
+
+void CMMCore::setGalvoSpotInterval(const char* deviceLabel, double pulseTime_us) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<GalvoInstance> pGalvo =
+      deviceManager_->GetDeviceOfType<GalvoInstance>(deviceLabel);
+
+   mm::DeviceModuleLockGuard guard(pGalvo);
+
+   int ret = pGalvo->SetSpotInterval(pulseTime_us);
+
+   if (ret != DEVICE_OK)
+   {
+      logError(deviceLabel, getDeviceErrorText(ret, pGalvo).c_str());
+      throw CMMError(getDeviceErrorText(ret, pGalvo));
+   }
+}
+
+
+/**
+ * Set the Galvo to an x,y position
+ */
+void CMMCore::setGalvoPosition(const char* deviceLabel, double x, double y) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<GalvoInstance> pGalvo =
+      deviceManager_->GetDeviceOfType<GalvoInstance>(deviceLabel);
 
    mm::DeviceModuleLockGuard guard(pGalvo);
 
@@ -6625,6 +7368,65 @@ void CMMCore::loadGalvoPolygons(const char* deviceLabel) MMCORE_LEGACY_THROW(CMM
    }
 }
 
+/**
+ * Replace the galvo polygons and load them to the device
+ *
+ * Equivalent to deleteGalvoPolygons(), addGalvoPolygonVertex() for each
+ * vertex, then loadGalvoPolygons(), but passes each polygon to the device in
+ * one call when the device supports it.
+ *
+ * @param deviceLabel   the galvo device label
+ * @param vertexCounts  the number of vertices of each polygon
+ * @param xs            the x coordinates of all vertices, polygon by polygon
+ * @param ys            the y coordinates of all vertices, polygon by polygon
+ */
+void CMMCore::loadGalvoPolygons(const char* deviceLabel,
+      const std::vector<long>& vertexCounts,
+      const std::vector<double>& xs,
+      const std::vector<double>& ys) MMCORE_LEGACY_THROW(CMMError)
+{
+   if (xs.size() != ys.size())
+      throw CMMError("Galvo polygon x and y coordinates differ in number");
+   size_t total = 0;
+   for (long count : vertexCounts)
+   {
+      if (count <= 0)
+         throw CMMError("Galvo polygons must have at least one vertex");
+      total += static_cast<size_t>(count);
+   }
+   if (total != xs.size())
+      throw CMMError("Galvo polygon vertex counts do not match the number of coordinates");
+
+   std::shared_ptr<GalvoInstance> pGalvo =
+      deviceManager_->GetDeviceOfType<GalvoInstance>(deviceLabel);
+
+   mm::DeviceModuleLockGuard guard(pGalvo);
+
+   int ret = pGalvo->DeletePolygons();
+   size_t first = 0;
+   for (size_t i = 0; ret == DEVICE_OK && i < vertexCounts.size(); ++i)
+   {
+      const int index = static_cast<int>(i);
+      const long count = vertexCounts[i];
+      ret = pGalvo->AddPolygonVertices(index, &xs[first], &ys[first], count);
+      if (ret == DEVICE_UNSUPPORTED_COMMAND)
+      {
+         ret = DEVICE_OK;
+         for (long j = 0; ret == DEVICE_OK && j < count; ++j)
+            ret = pGalvo->AddPolygonVertex(index, xs[first + j], ys[first + j]);
+      }
+      first += static_cast<size_t>(count);
+   }
+   if (ret == DEVICE_OK)
+      ret = pGalvo->LoadPolygons();
+
+   if (ret != DEVICE_OK)
+   {
+      logError(deviceLabel, getDeviceErrorText(ret, pGalvo).c_str());
+      throw CMMError(getDeviceErrorText(ret, pGalvo));
+   }
+}
+
 /**
  * Set the number of times to loop galvo polygons
  */
@@ -7350,6 +8152,20 @@ void CMMCore::saveSystemConfiguration(const char* fileName) MMCORE_LEGACY_THROW(
    {
       os << MM::g_CFGCommand_Property << ',' << MM::g_Keyword_CoreDevice << ',' << MM::g_Keyword_CoreFocus << ',' << focus->GetLabel() << '\n';
    }
+   os.close();
+
+   if (mm::features::flags().configSnapshots)
+   {
+      std::ifstream is(fileName, std::ios_base::in | std::ios_base::binary);
+      const std::string text((std::istreambuf_iterator<char>(is)),
+            std::istreambuf_iterator<char>());
+      const std::string snapshotPath = mm::ConfigSnapshotPath(fileName);
+      if (!mm::WriteConfigSnapshot(snapshotPath, text, mm::ParseConfigText(text)))
+      {
+         LOG_WARNING(coreLogger_) << "Failed to write configuration snapshot " <<
+            ToQuotedString(snapshotPath);
+      }
+   }
 }
 
 /**
@@ -7414,6 +8230,33 @@ void CMMCore::loadSystemConfiguration(const char* fileName) MMCORE_LEGACY_THROW(
 }
 
 
+/*
+ * Whether an initialized device already reports the given property value,
+ * so that setting it can be skipped. Core properties and pre-init properties
+ * are never considered current.
+ */
+bool CMMCore::isPropertyValueCurrent(const std::string& label,
+      const std::string& propName, const std::string& value)
+{
+   if (label == MM::g_Keyword_CoreDevice)
+      return false;
+   try
+   {
+      std::shared_ptr<DeviceInstance> pDevice = deviceManager_->GetDevice(label);
+      mm::DeviceModuleLockGuard guard(pDevice);
+      if (!pDevice->IsInitialized() ||
+            pDevice->GetPropertyInitStatus(propName.c_str()) ||
+            !pDevice->HasProperty(propName))
+         return false;
+      return pDevice->GetProperty(propName) == value;
+   }
+   catch (const CMMError&)
+   {
+      return false;
+   }
+}
+
+
 void CMMCore::loadSystemConfigurationImpl(const char* fileName) MMCORE_LEGACY_THROW(CMMError)
 {
    if (!fileName)
@@ -7422,7 +8265,7 @@ void CMMCore::loadSystemConfigurationImpl(const char* fileName) MMCORE_LEGACY_TH
    LOG_INFO(coreLogger_) << "Loading system configuration from:" << ToQuotedString(fileName);
 
    std::ifstream is;
-   is.open(fileName, std::ios_base::in);
+   is.open(fileName, std::ios_base::in | std::ios_base::binary);
    if (!is.is_open())
    {
       logError(fileName, getCoreErrorText(MMERR_FileOpenFailed).c_str());
@@ -7430,227 +8273,229 @@ void CMMCore::loadSystemConfigurationImpl(const char* fileName) MMCORE_LEGACY_TH
             MMERR_FileOpenFailed);
    }
 
-   // Process commands
-   const int maxLineLength = 4 * MM::MaxStrLength + 4; // accommodate up to 4 strings and delimiters
-   char line[maxLineLength+1];
-   std::vector<std::string> tokens;
-
-   int lineCount = 0;
+   const std::string text((std::istreambuf_iterator<char>(is)),
+         std::istreambuf_iterator<char>());
 
-   while(is.getline(line, maxLineLength, '\n'))
+   // With a snapshot that matches the file, skip parsing; also skip property
+   // writes that would not change anything
+   std::vector<mm::ConfigLine> cfgLines;
+   bool useSnapshot = false;
+   if (mm::features::flags().configSnapshots)
    {
-      // strip a potential Windows/dos CR
-      std::istringstream il(line);
-      il.getline(line, maxLineLength, '\r');
+      useSnapshot = mm::ReadConfigSnapshot(mm::ConfigSnapshotPath(fileName),
+            text, cfgLines);
+      LOG_DEBUG(coreLogger_) << "Configuration snapshot " <<
+         (useSnapshot ? "is" : "is not") << " up to date";
+   }
+   if (!useSnapshot)
+      cfgLines = mm::ParseConfigText(text);
+   int skippedWrites = 0;
 
-      lineCount++;
-      if (strlen(line) > 0)
+   // Process commands
+   for (const mm::ConfigLine& cfgLine : cfgLines)
+   {
+      const std::vector<std::string>& tokens = cfgLine.tokens;
+      const char* line = cfgLine.text.c_str();
+      const int lineCount = cfgLine.lineNumber;
+      try
       {
-         if (line[0] == '#')
-         {
-            // comment, so skip processing
-            continue;
-         }
 
-         // parse tokens
-         tokens.clear();
-         CDeviceUtils::Tokenize(line, tokens, MM::g_FieldDelimiters);
+         // non-empty and non-comment lines mush have at least one token
+         if (tokens.size() < 1)
+            throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                  ToQuotedString(line) + ")",
+                  MMERR_InvalidCFGEntry);
 
-         try
+         if(tokens[0].compare(MM::g_CFGCommand_Device) == 0)
          {
-
-            // non-empty and non-comment lines mush have at least one token
-            if (tokens.size() < 1)
+            // load device command
+            // -------------------
+            if (tokens.size() != 4)
                throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
                      ToQuotedString(line) + ")",
                      MMERR_InvalidCFGEntry);
-
-            if(tokens[0].compare(MM::g_CFGCommand_Device) == 0)
-            {
-               // load device command
-               // -------------------
-               if (tokens.size() != 4)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-               loadDevice(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str());
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_Property) == 0)
-            {
-               // set property command
-               // --------------------
-               if (tokens.size() == 4)
-                  setProperty(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str());
-               else if (tokens.size() == 3)
-                  // ...assuming here that the last missing toke represents an empty string
-                  setProperty(tokens[1].c_str(), tokens[2].c_str(), "");
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_Delay) == 0)
-            {
-               // set delay command
-               // -----------------
-               if (tokens.size() != 3)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-               setDeviceDelayMs(tokens[1].c_str(), atof(tokens[2].c_str()));
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_FocusDirection) == 0)
-            {
-               // set focus direction command
-               // ---------------------------
-               if (tokens.size() != 3)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-               setFocusDirection(tokens[1].c_str(), atol(tokens[2].c_str()));
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_Label) == 0)
-            {
-               // define label command
-               // --------------------
-               if (tokens.size() != 4)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-               defineStateLabel(tokens[1].c_str(), atol(tokens[2].c_str()), tokens[3].c_str());
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_Configuration) == 0)
-            {
-               // define configuration command
-               // ----------------------------
-               if (tokens.size() != 5)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-               LOG_WARNING(coreLogger_) << "Obsolete command " << tokens[0] <<
-                  " ignored in configuration file";
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_ConfigGroup) == 0)
-            {
-               // define grouped configuration command
-               // ------------------------------------
-               if (tokens.size() == 6)
-                  defineConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str(), tokens[5].c_str());
-               else if (tokens.size() == 5)
-               {
-                  // we will assume here that the last (missing) token is representing an empty string
-                  defineConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str(), "");
-               }
-               else if (tokens.size() == 2)
-                  defineConfigGroup(tokens[1].c_str());
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_ConfigPixelSize) == 0)
+            loadDevice(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str());
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_Property) == 0)
+         {
+            // set property command
+            // --------------------
+            if (tokens.size() == 4 || tokens.size() == 3)
             {
-               // define pixel size configuration command
-               // ---------------------------------------
-               if (tokens.size() == 5)
-                  definePixelSizeConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str());
+               // ...assuming here that the last missing toke represents an empty string
+               const std::string value = tokens.size() == 4 ? tokens[3] : "";
+               if (useSnapshot &&
+                     isPropertyValueCurrent(tokens[1], tokens[2], value))
+                  ++skippedWrites;
                else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
+                  setProperty(tokens[1].c_str(), tokens[2].c_str(), value.c_str());
             }
-            else if(tokens[0].compare(MM::g_CFGCommand_PixelSize_um) == 0)
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_Delay) == 0)
+         {
+            // set delay command
+            // -----------------
+            if (tokens.size() != 3)
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+            setDeviceDelayMs(tokens[1].c_str(), atof(tokens[2].c_str()));
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_FocusDirection) == 0)
+         {
+            // set focus direction command
+            // ---------------------------
+            if (tokens.size() != 3)
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+            setFocusDirection(tokens[1].c_str(), atol(tokens[2].c_str()));
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_Label) == 0)
+         {
+            // define label command
+            // --------------------
+            if (tokens.size() != 4)
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+            defineStateLabel(tokens[1].c_str(), atol(tokens[2].c_str()), tokens[3].c_str());
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_Configuration) == 0)
+         {
+            // define configuration command
+            // ----------------------------
+            if (tokens.size() != 5)
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+            LOG_WARNING(coreLogger_) << "Obsolete command " << tokens[0] <<
+               " ignored in configuration file";
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_ConfigGroup) == 0)
+         {
+            // define grouped configuration command
+            // ------------------------------------
+            if (tokens.size() == 6)
+               defineConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str(), tokens[5].c_str());
+            else if (tokens.size() == 5)
             {
-               // set pixel size
-               // --------------
-               if (tokens.size() == 3)
-                  setPixelSizeUm(tokens[1].c_str(), atof(tokens[2].c_str()));
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
+               // we will assume here that the last (missing) token is representing an empty string
+               defineConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str(), "");
             }
-            else if(tokens[0].compare(MM::g_CFGCommand_PixelSizeAffine) == 0)
+            else if (tokens.size() == 2)
+               defineConfigGroup(tokens[1].c_str());
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_ConfigPixelSize) == 0)
+         {
+            // define pixel size configuration command
+            // ---------------------------------------
+            if (tokens.size() == 5)
+               definePixelSizeConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str());
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_PixelSize_um) == 0)
+         {
+            // set pixel size
+            // --------------
+            if (tokens.size() == 3)
+               setPixelSizeUm(tokens[1].c_str(), atof(tokens[2].c_str()));
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_PixelSizeAffine) == 0)
+         {
+            // set affine transform
+            // --------------
+            //
+            if (tokens.size() == 8)
             {
-               // set affine transform
-               // --------------
-               //
-               if (tokens.size() == 8)
+               std::vector<double> *affineT = new std::vector<double>(6);
+               for (int i = 0; i < 6; i++)
                {
-                  std::vector<double> *affineT = new std::vector<double>(6);
-                  for (int i = 0; i < 6; i++)
-                  {
-                     affineT->at(i) = atof(tokens[i + 2].c_str());
-                  }
-                  setPixelSizeAffine(tokens[1].c_str(), *affineT);
-                  delete affineT;
+                  affineT->at(i) = atof(tokens[i + 2].c_str());
                }
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
+               setPixelSizeAffine(tokens[1].c_str(), *affineT);
+               delete affineT;
             }
-            else if (tokens[0].compare(MM::g_CFGCommand_PixelSizedxdz) == 0)
-            {
-               if (tokens.size() == 3)
-                  setPixelSizedxdz(tokens[1].c_str(), atof(tokens[2].c_str()));
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if (tokens[0].compare(MM::g_CFGCommand_PixelSizedydz) == 0)
-            {
-               if (tokens.size() == 3)
-                  setPixelSizedydz(tokens[1].c_str(), atof(tokens[2].c_str()));
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if (tokens[0].compare(MM::g_CFGCommand_PixelSizeOptimalZUm) == 0)
-            {
-               if (tokens.size() == 3)
-                  setPixelSizeOptimalZUm(tokens[1].c_str(), atof(tokens[2].c_str()));
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_Equipment) == 0)
-            {
-              // Property blocks have been removed
-              throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                    ToQuotedString(line) + ")",
-                    MMERR_InvalidCFGEntry);
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_ImageSynchro) == 0)
-            {
-               // ImageSynchro has been removed
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if (tokens[0].compare(MM::g_CFGCommand_PixelSizedxdz) == 0)
+         {
+            if (tokens.size() == 3)
+               setPixelSizedxdz(tokens[1].c_str(), atof(tokens[2].c_str()));
+            else
                throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
                      ToQuotedString(line) + ")",
                      MMERR_InvalidCFGEntry);
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_ParentID) == 0)
-            {
-               // set parent ID
-               // -------------
-               if (tokens.size() != 3)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-
-               setParentLabel(tokens[1].c_str(), tokens[2].c_str());
-            }
-
          }
-         catch (CMMError& err)
+         else if (tokens[0].compare(MM::g_CFGCommand_PixelSizedydz) == 0)
          {
-            std::ostringstream errorText;
-            errorText << "Line " << lineCount << ": " << line << '\n';
-            errorText << err.getFullMsg() << "\n\n";
-            throw CMMError(errorText.str().c_str(), MMERR_InvalidConfigurationFile);
+            if (tokens.size() == 3)
+               setPixelSizedydz(tokens[1].c_str(), atof(tokens[2].c_str()));
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if (tokens[0].compare(MM::g_CFGCommand_PixelSizeOptimalZUm) == 0)
+         {
+            if (tokens.size() == 3)
+               setPixelSizeOptimalZUm(tokens[1].c_str(), atof(tokens[2].c_str()));
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
          }
+         else if(tokens[0].compare(MM::g_CFGCommand_Equipment) == 0)
+         {
+           // Property blocks have been removed
+           throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                 ToQuotedString(line) + ")",
+                 MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_ImageSynchro) == 0)
+         {
+            // ImageSynchro has been removed
+            throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                  ToQuotedString(line) + ")",
+                  MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_ParentID) == 0)
+         {
+            // set parent ID
+            // -------------
+            if (tokens.size() != 3)
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+
+            setParentLabel(tokens[1].c_str(), tokens[2].c_str());
+         }
+
+      }
+      catch (CMMError& err)
+      {
+         std::ostringstream errorText;
+         errorText << "Line " << lineCount << ": " << line << '\n';
+         errorText << err.getFullMsg() << "\n\n";
+         throw CMMError(errorText.str().c_str(), MMERR_InvalidConfigurationFile);
       }
    }
 
@@ -7662,7 +8507,32 @@ void CMMCore::loadSystemConfigurationImpl(const char* fileName) MMCORE_LEGACY_TH
       waitForSystem();
       updateSystemStateCache();
 
-      this->setConfig(MM::g_CFGGroup_System, MM::g_CFGGroup_System_Startup);
+      if (useSnapshot)
+      {
+         Configuration startup = getConfigData(MM::g_CFGGroup_System,
+               MM::g_CFGGroup_System_Startup);
+         Configuration changes;
+         for (size_t i = 0; i < startup.size(); ++i)
+         {
+            PropertySetting s = startup.getSetting(i);
+            if (isPropertyValueCurrent(s.getDeviceLabel(), s.getPropertyName(),
+                     s.getPropertyValue()))
+               ++skippedWrites;
+            else
+               changes.addSetting(s);
+         }
+         applyConfiguration(changes);
+      }
+      else
+      {
+         this->setConfig(MM::g_CFGGroup_System, MM::g_CFGGroup_System_Startup);
+      }
+   }
+
+   if (useSnapshot)
+   {
+      LOG_INFO(coreLogger_) << "Skipped " << skippedWrites <<
+         " property writes that would not have changed any value";
    }
 
    waitForSystem();
@@ -7987,6 +8857,8 @@ void CMMCore::InitializeErrorMessages()
    errorText_[MMERR_InvalidImageSequence] = "Issue snapImage before getImage.";
    errorText_[MMERR_NullPointerException] = "Null Pointer Exception.";
    errorText_[MMERR_CreatePeripheralFailed] = "Hub failed to create specified peripheral device.";
+   errorText_[MMERR_CircularBufferImagesPinned] =
+      "Circular buffer images are pinned; release them first.";
    errorText_[MMERR_BadAffineTransform] = "Bad affine transform.  Affine transforms need to have 6 numbers; 2 rows of 3 column.";
 }
 
@@ -8046,6 +8918,18 @@ void CMMCore::CreateCoreProperties()
    CoreProperty propBusyTimeoutMs("5000", false, MM::Integer);
    properties_->Add(MM::g_Keyword_CoreTimeoutMs, propBusyTimeoutMs);
 
+   // Acquisition statistics; the read-only values are computed when read
+   for (const std::string& name : mm::AcquisitionStatistics::GetPropertyNames())
+   {
+      CoreProperty propStatistic("0", true,
+         name == mm::AcquisitionStatistics::FrameRateProperty ?
+         MM::Float : MM::Integer);
+      properties_->Add(name.c_str(), propStatistic);
+   }
+   CoreProperty propStatisticsLogInterval("0", false, MM::Integer);
+   properties_->Add(mm::AcquisitionStatistics::LogIntervalProperty,
+      propStatisticsLogInterval);
+
    properties_->Refresh();
 }
 
@@ -8142,7 +9026,7 @@ void CMMCore::applyConfiguration(const Configuration& config) MMCORE_LEGACY_THRO
          properties_->Execute(setting.getPropertyName().c_str(), setting.getPropertyValue().c_str());
          {
             MMThreadGuard scg(stateCacheLock_);
-            stateCache_.addSetting(PropertySetting(MM::g_Keyword_CoreDevice, setting.getPropertyName().c_str(), setting.getPropertyValue().c_str()));
+            addStateCacheSetting(PropertySetting(MM::g_Keyword_CoreDevice, setting.getPropertyName().c_str(), setting.getPropertyValue().c_str()));
          }
       }
       else
@@ -8158,7 +9042,7 @@ void CMMCore::applyConfiguration(const Configuration& config) MMCORE_LEGACY_THRO
 
             {
                MMThreadGuard scg(stateCacheLock_);
-               stateCache_.addSetting(setting);
+               addStateCacheSetting(setting);
             }
          }
          catch (const CMMError&)
@@ -8205,7 +9089,7 @@ int CMMCore::applyProperties(std::vector<PropertySetting>& props, std::string& l
 
          {
             MMThreadGuard scg(stateCacheLock_);
-            stateCache_.addSetting(props[i]);
+            addStateCacheSetting(props[i]);
          }
       }
       catch (const CMMError& e)
@@ -99,8 +99,13 @@ class VolumetricPumpInstance;
 class CMMCore;
 
 namespace mm {
+   class AcquisitionStatistics;
+   class DeviceCallTracer;
    class DeviceManager;
+   class ImageProcessingPipeline;
    class LogManager;
+   class SequenceStreamer;
+   class SLMPatternStore;
 } // namespace mm
 
 typedef unsigned int* imgRGB32;
@@ -125,6 +130,7 @@ class CMMCore
 {
    friend class CoreCallback;
    friend class CorePropertyCollection;
+   friend class DeviceInstance;
 
 public:
    CMMCore();
@@ -203,6 +209,11 @@ public:
          bool truncate = true, bool synchronous = false) MMCORE_LEGACY_THROW(CMMError);
    void stopSecondaryLogFile(int handle) MMCORE_LEGACY_THROW(CMMError);
 
+   void enableDeviceCallTracing(bool enable);
+   bool isDeviceCallTracingEnabled() const;
+   void clearDeviceCallTrace();
+   std::string getDeviceCallTraceJSON() const;
+
    ///@}
 
    /** \name Device listing. */
@@ -300,6 +311,8 @@ public:
    ///@{
    Configuration getSystemStateCache() const;
    void updateSystemStateCache();
+   long getSystemStateCacheVersion() const;
+   std::string getSystemStateCacheJSON() const;
    std::string getPropertyFromCache(const char* deviceLabel,
          const char* propName) const MMCORE_LEGACY_THROW(CMMError);
    std::string getCurrentConfigFromCache(const char* groupName) MMCORE_LEGACY_THROW(CMMError);
@@ -433,6 +446,13 @@ public:
       const MMCORE_LEGACY_THROW(CMMError);
    void* popNextImageMD(Metadata& md) MMCORE_LEGACY_THROW(CMMError);
 
+   void* getLastImagePinned() MMCORE_LEGACY_THROW(CMMError);
+   void* popNextImagePinned() MMCORE_LEGACY_THROW(CMMError);
+   void* popNextImageMDPinned(unsigned channel, Metadata& md)
+      MMCORE_LEGACY_THROW(CMMError);
+   void releasePinnedImage(void* pinnedPixels) MMCORE_LEGACY_THROW(CMMError);
+   long getPinnedImageCount();
+
    long getRemainingImageCount();
    long getBufferTotalCapacity();
    long getBufferFreeCapacity();
@@ -442,6 +462,11 @@ public:
    void initializeCircularBuffer() MMCORE_LEGACY_THROW(CMMError);
    void clearCircularBuffer() MMCORE_LEGACY_THROW(CMMError);
 
+   std::string getAcquisitionStatistics() const;
+   void resetAcquisitionStatistics();
+   void setAcquisitionStatisticsLogInterval(long intervalMs);
+   long getAcquisitionStatisticsLogInterval() const;
+
    bool isExposureSequenceable(const char* cameraLabel) MMCORE_LEGACY_THROW(CMMError);
    void startExposureSequence(const char* cameraLabel) MMCORE_LEGACY_THROW(CMMError);
    void stopExposureSequence(const char* cameraLabel) MMCORE_LEGACY_THROW(CMMError);
@@ -504,6 +529,9 @@ public:
    void loadStageSequence(const char* stageLabel,
          std::vector<double> positionSequence) MMCORE_LEGACY_THROW(CMMError);
    void setStageLinearSequence(const char* stageLabel, double dZ_um, int nSlices) MMCORE_LEGACY_THROW(CMMError);
+   void loadStreamingStageSequence(const char* stageLabel,
+         std::vector<double> positionSequence) MMCORE_LEGACY_THROW(CMMError);
+   long getStreamingStageSequenceRemaining(const char* stageLabel) MMCORE_LEGACY_THROW(CMMError);
    ///@}
 
    /** \name XY stage control. */
@@ -556,10 +584,15 @@ public:
          const char* term) MMCORE_LEGACY_THROW(CMMError);
    std::string getSerialPortAnswer(const char* portLabel,
          const char* term) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::string> transactSerialPortCommands(const char* portLabel,
+         const std::vector<std::string>& commands, const char* commandTerm,
+         const char* answerTerm) MMCORE_LEGACY_THROW(CMMError);
    void writeToSerialPort(const char* portLabel,
          const std::vector<char> &data) MMCORE_LEGACY_THROW(CMMError);
    std::vector<char> readFromSerialPort(const char* portLabel)
       MMCORE_LEGACY_THROW(CMMError);
+   std::string getSerialPortStatistics(const char* portLabel,
+         bool reset = false) MMCORE_LEGACY_THROW(CMMError);
    ///@}
 
    /** \name SLM control.
@@ -590,6 +623,19 @@ public:
    void stopSLMSequence(const char* slmLabel) MMCORE_LEGACY_THROW(CMMError);
    void loadSLMSequence(const char* slmLabel,
          std::vector<unsigned char*> imageSequence) MMCORE_LEGACY_THROW(CMMError);
+
+   long addSLMPattern(const char* slmLabel,
+         unsigned char* pixels) MMCORE_LEGACY_THROW(CMMError);
+   long addSLMPattern(const char* slmLabel,
+         imgRGB32 pixels) MMCORE_LEGACY_THROW(CMMError);
+   void deleteSLMPattern(long patternId) MMCORE_LEGACY_THROW(CMMError);
+   void deleteSLMPatterns();
+   long getNumberOfSLMPatterns();
+   long getSLMPatternStorageBytes();
+   void setSLMPattern(const char* slmLabel,
+         long patternId) MMCORE_LEGACY_THROW(CMMError);
+   void loadSLMPatternSequence(const char* slmLabel,
+         std::vector<long> patternIds) MMCORE_LEGACY_THROW(CMMError);
    ///@}
 
    /** \name Galvo control.
@@ -615,6 +661,10 @@ public:
          double x, double y) MMCORE_LEGACY_THROW(CMMError);
    void deleteGalvoPolygons(const char* galvoLabel) MMCORE_LEGACY_THROW(CMMError);
    void loadGalvoPolygons(const char* galvoLabel) MMCORE_LEGACY_THROW(CMMError);
+   void loadGalvoPolygons(const char* galvoLabel,
+         const std::vector<long>& vertexCounts,
+         const std::vector<double>& xs,
+         const std::vector<double>& ys) MMCORE_LEGACY_THROW(CMMError);
    void setGalvoPolygonRepetitions(const char* galvoLabel, int repetitions)
       MMCORE_LEGACY_THROW(CMMError);
    void runGalvoPolygons(const char* galvoLabel) MMCORE_LEGACY_THROW(CMMError);
@@ -714,16 +764,28 @@ private:
    CorePropertyCollection* properties_;
    MMEventCallback* externalCallback_;  // notification hook to the higher layer (e.g. GUI)
    PixelSizeConfigGroup* pixelSizeGroup_;
+   // Shared with cbuf_ and imageProcessingPipeline_, which record into it
+   std::shared_ptr<mm::AcquisitionStatistics> acqStatistics_;
    CircularBuffer* cbuf_;
+   std::unique_ptr<mm::ImageProcessingPipeline> imageProcessingPipeline_;
 
    std::shared_ptr<CPluginManager> pluginManager_;
    std::shared_ptr<mm::DeviceManager> deviceManager_;
+   // Shared with each DeviceInstance, which records into it
+   std::shared_ptr<mm::DeviceCallTracer> deviceCallTracer_;
+   // Refills streamed device sequences; notified through CoreCallback
+   std::unique_ptr<mm::SequenceStreamer> sequenceStreamer_;
+   std::unique_ptr<mm::SLMPatternStore> slmPatternStore_;
    std::map<int, std::string> errorText_;
 
    // Must be unlocked when calling MMEventCallback or calling device methods
    // or acquiring a module lock
    mutable MMThreadLock stateCacheLock_;
    mutable Configuration stateCache_; // Synchronized by stateCacheLock_
+   long stateCacheVersion_ = 0; // Incremented whenever stateCache_ changes
+   // stateCache_ serialized as of stateCacheJSONVersion_, built on demand
+   mutable std::string stateCacheJSON_;
+   mutable long stateCacheJSONVersion_ = -1;
 
    MMThreadLock* pPostedErrorsLock_;
    mutable std::deque<std::pair< int, std::string> > postedErrors_;
@@ -751,6 +813,11 @@ private:
    Configuration getConfigGroupState(const char* group, bool fromCache) MMCORE_LEGACY_THROW(CMMError);
    std::string getDeviceErrorText(int deviceCode, std::shared_ptr<DeviceInstance> pDevice);
    std::string getDeviceName(std::shared_ptr<DeviceInstance> pDev);
+   long addSLMPatternImpl(const char* slmLabel, const unsigned char* pixels,
+         unsigned bytesPerPixel) MMCORE_LEGACY_THROW(CMMError);
+   // Requires the SLM's module lock; returns the pattern's bytes per pixel
+   unsigned checkSLMPattern(std::shared_ptr<SLMInstance> pSLM,
+         long patternId) MMCORE_LEGACY_THROW(CMMError);
    void logError(const char* device, const char* msg);
    void updateAllowedChannelGroups();
    void assignDefaultRole(std::shared_ptr<DeviceInstance> pDev);
@@ -758,6 +825,18 @@ private:
    void removeAllDeviceRoles();
    void updateCoreProperty(const char* propName, MM::DeviceType devType) MMCORE_LEGACY_THROW(CMMError);
    void loadSystemConfigurationImpl(const char* fileName) MMCORE_LEGACY_THROW(CMMError);
+   void addStateCacheSetting(const PropertySetting& setting); // Requires stateCacheLock_
+   bool isPropertyValueCurrent(const std::string& label,
+         const std::string& propName, const std::string& value);
+   void setSerialPortCommandImpl(const std::string& client,
+         const char* portLabel, const char* command,
+         const char* term) MMCORE_LEGACY_THROW(CMMError);
+   std::string getSerialPortAnswerImpl(const std::string& client,
+         const char* portLabel, const char* term) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::string> transactSerialPortCommandsImpl(
+         const std::string& client, const char* portLabel,
+         const std::vector<std::string>& commands, const char* commandTerm,
+         const char* answerTerm) MMCORE_LEGACY_THROW(CMMError);
    void initializeAllDevicesSerial() MMCORE_LEGACY_THROW(CMMError);
    void initializeAllDevicesParallel() MMCORE_LEGACY_THROW(CMMError);
    int initializeVectorOfDevices(std::vector<std::pair<std::shared_ptr<DeviceInstance>, std::string> > pDevices);
@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SLMPatternStore.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Deduplicated, compactly stored SLM patterns referenced by ID.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "SLMPatternStore.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mm {
+
+namespace {
+
+// FNV-1a
+std::uint64_t Hash(const unsigned char* data, std::size_t size,
+   std::uint64_t h = 14695981039346656037ull)
+{
+   for (std::size_t i = 0; i < size; ++i)
+   {
+      h ^= data[i];
+      h *= 1099511628211ull;
+   }
+   return h;
+}
+
+} // namespace
+
+SLMPatternStore::Pattern
+SLMPatternStore::Encode(const unsigned char* pixels, const Geometry& geometry)
+{
+   Pattern p;
+   p.geometry = geometry;
+   p.bitPacked = false;
+   p.onValue = 0;
+   p.refCount = 1;
+
+   const std::size_t size = geometry.Bytes();
+   const unsigned dims[] = { geometry.width, geometry.height,
+      geometry.bytesPerPixel };
+   p.hash = Hash(pixels, size,
+      Hash(reinterpret_cast<const unsigned char*>(dims), sizeof(dims)));
+
+   if (geometry.bytesPerPixel == 1)
+   {
+      unsigned char on = 0;
+      bool binary = true;
+      for (std::size_t i = 0; i < size && binary; ++i)
+      {
+         if (pixels[i] == 0)
+            continue;
+         if (on == 0)
+            on = pixels[i];
+         else if (pixels[i] != on)
+            binary = false;
+      }
+      if (binary)
+      {
+         p.bitPacked = true;
+         p.onValue = on;
+         p.data.assign((size + 7) / 8, 0);
+         for (std::size_t i = 0; i < size; ++i)
+         {
+            if (pixels[i] != 0)
+               p.data[i / 8] |= static_cast<unsigned char>(1u << (i % 8));
+         }
+         return p;
+      }
+   }
+
+   p.data.assign(pixels, pixels + size);
+   return p;
+}
+
+void SLMPatternStore::Decode(const Pattern& pattern,
+   std::vector<unsigned char>& pixels)
+{
+   if (!pattern.bitPacked)
+   {
+      pixels = pattern.data;
+      return;
+   }
+   const std::size_t size = pattern.geometry.Bytes();
+   pixels.resize(size);
+   for (std::size_t i = 0; i < size; ++i)
+   {
+      pixels[i] = (pattern.data[i / 8] & (1u << (i % 8))) ?
+         pattern.onValue : 0;
+   }
+}
+
+long SLMPatternStore::Add(const unsigned char* pixels, const Geometry& geometry)
+{
+   Pattern pattern = Encode(pixels, geometry);
+
+   std::lock_guard<std::mutex> lock(mutex_);
+   auto range = idsByHash_.equal_range(pattern.hash);
+   for (auto it = range.first; it != range.second; ++it)
+   {
+      Pattern& existing = patterns_.at(it->second);
+      if (existing.geometry == pattern.geometry &&
+            existing.bitPacked == pattern.bitPacked &&
+            existing.onValue == pattern.onValue &&
+            existing.data == pattern.data)
+      {
+         ++existing.refCount;
+         return it->second;
+      }
+   }
+
+   const long id = nextId_++;
+   idsByHash_.emplace(pattern.hash, id);
+   patterns_.emplace(id, std::move(pattern));
+   return id;
+}
+
+bool SLMPatternStore::Remove(long id)
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   auto it = patterns_.find(id);
+   if (it == patterns_.end())
+      return false;
+   if (--it->second.refCount > 0)
+      return true;
+
+   auto range = idsByHash_.equal_range(it->second.hash);
+   for (auto h = range.first; h != range.second; ++h)
+   {
+      if (h->second == id)
+      {
+         idsByHash_.erase(h);
+         break;
+      }
+   }
+   patterns_.erase(it);
+   return true;
+}
+
+void SLMPatternStore::Clear()
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   patterns_.clear();
+   idsByHash_.clear();
+}
+
+bool SLMPatternStore::Contains(long id) const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return patterns_.count(id) > 0;
+}
+
+bool SLMPatternStore::GetGeometry(long id, Geometry& geometry) const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   auto it = patterns_.find(id);
+   if (it == patterns_.end())
+      return false;
+   geometry = it->second.geometry;
+   return true;
+}
+
+bool SLMPatternStore::Unpack(long id, std::vector<unsigned char>& pixels) const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   auto it = patterns_.find(id);
+   if (it == patterns_.end())
+      return false;
+   Decode(it->second, pixels);
+   return true;
+}
+
+std::size_t SLMPatternStore::GetNumberOfPatterns() const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return patterns_.size();
+}
+
+std::size_t SLMPatternStore::GetStoredBytes() const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   std::size_t total = 0;
+   for (const auto& entry : patterns_)
+      total += entry.second.data.size();
+   return total;
+}
+
+void SLMPatternStore::SetDisplayed(const std::string& slmLabel, long id)
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   displayed_[slmLabel] = id;
+}
+
+long SLMPatternStore::GetDisplayed(const std::string& slmLabel) const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   auto it = displayed_.find(slmLabel);
+   return it == displayed_.end() ? 0 : it->second;
+}
+
+void SLMPatternStore::ForgetDisplayed(const std::string& slmLabel)
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   displayed_.erase(slmLabel);
+}
+
+void SLMPatternStore::ForgetAllDisplayed()
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   displayed_.clear();
+}
+
+SLMPatternStore::Rect SLMPatternStore::ChangedArea(const unsigned char* before,
+   const unsigned char* after, const Geometry& geometry)
+{
+   Rect r;
+   r.left = geometry.width;
+   r.top = geometry.height;
+   const std::size_t bpp = geometry.bytesPerPixel;
+   const std::size_t rowBytes = geometry.width * bpp;
+   for (unsigned y = 0; y < geometry.height; ++y)
+   {
+      const unsigned char* b = before + y * rowBytes;
+      const unsigned char* a = after + y * rowBytes;
+      if (std::memcmp(b, a, rowBytes) == 0)
+         continue;
+
+      unsigned first = 0;
+      while (std::memcmp(b + first * bpp, a + first * bpp, bpp) == 0)
+         ++first;
+      unsigned last = geometry.width - 1;
+      while (std::memcmp(b + last * bpp, a + last * bpp, bpp) == 0)
+         --last;
+
+      r.left = (std::min)(r.left, first);
+      r.right = (std::max)(r.right, last + 1);
+      r.top = (std::min)(r.top, y);
+      r.bottom = y + 1;
+   }
+   if (r.IsEmpty())
+      r = Rect();
+   return r;
+}
+
+} // namespace mm
@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SLMPatternStore.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Deduplicated, compactly stored SLM patterns referenced by ID.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mm {
+
+// Holds SLM patterns so that sequences and repeated displays can refer to
+// them by ID instead of passing full frames around.
+//
+// Adding a pattern identical to a stored one returns the existing ID (and
+// counts a reference, so it must be removed as many times as it was added).
+// 8-bit patterns whose pixels are all 0 or one other value (the usual case
+// for binary DMD patterns) are kept at one bit per pixel.
+//
+// IDs are never reused, so an adapter may cache device-side copies by ID.
+// All member functions are thread-safe.
+class SLMPatternStore
+{
+public:
+   struct Geometry
+   {
+      unsigned width = 0;
+      unsigned height = 0;
+      unsigned bytesPerPixel = 0;
+
+      std::size_t Bytes() const
+      { return std::size_t(width) * height * bytesPerPixel; }
+      bool operator==(const Geometry& rhs) const
+      {
+         return width == rhs.width && height == rhs.height &&
+            bytesPerPixel == rhs.bytesPerPixel;
+      }
+      bool operator!=(const Geometry& rhs) const { return !(*this == rhs); }
+   };
+
+   // Pixel bounds (exclusive right and bottom) of a changed area
+   struct Rect
+   {
+      unsigned left = 0;
+      unsigned top = 0;
+      unsigned right = 0;
+      unsigned bottom = 0;
+
+      bool IsEmpty() const { return right <= left || bottom <= top; }
+   };
+
+   long Add(const unsigned char* pixels, const Geometry& geometry);
+   // Returns false if there is no such pattern
+   bool Remove(long id);
+   void Clear();
+
+   bool Contains(long id) const;
+   bool GetGeometry(long id, Geometry& geometry) const;
+   // Returns false if there is no such pattern
+   bool Unpack(long id, std::vector<unsigned char>& pixels) const;
+
+   std::size_t GetNumberOfPatterns() const;
+   // Memory used by pattern data
+   std::size_t GetStoredBytes() const;
+
+   // The pattern last written to each SLM, for computing changed areas
+   void SetDisplayed(const std::string& slmLabel, long id);
+   long GetDisplayed(const std::string& slmLabel) const; // 0 if unknown
+   void ForgetDisplayed(const std::string& slmLabel);
+   void ForgetAllDisplayed();
+
+   // Smallest rectangle containing all pixels that differ between two
+   // images of the same geometry
+   static Rect ChangedArea(const unsigned char* before,
+      const unsigned char* after, const Geometry& geometry);
+
+private:
+   struct Pattern
+   {
+      Geometry geometry;
+      std::uint64_t hash;
+      bool bitPacked;
+      unsigned char onValue; // Pixel value of set bits if bitPacked
+      std::vector<unsigned char> data;
+      unsigned refCount;
+   };
+
+   static Pattern Encode(const unsigned char* pixels, const Geometry& geometry);
+   static void Decode(const Pattern& pattern, std::vector<unsigned char>& pixels);
+
+   mutable std::mutex mutex_;
+   std::map<long, Pattern> patterns_;
+   std::unordered_multimap<std::uint64_t, long> idsByHash_;
+   std::map<std::string, long> displayed_;
+   long nextId_ = 1;
+};
+
+} // namespace mm
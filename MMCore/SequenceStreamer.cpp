@@ -0,0 +1,207 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SequenceStreamer.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Keeps device sequence buffers filled while streamed
+//                hardware sequences run.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "SequenceStreamer.h"
+
+#include "DeviceManager.h"
+#include "Devices/DeviceInstance.h"
+
+#include "../MMDevice/MMDeviceConstants.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace mm {
+
+SequenceStreamer::SequenceStreamer(logging::Logger logger) :
+   logger_(logger)
+{
+}
+
+SequenceStreamer::~SequenceStreamer()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+   }
+   cv_.notify_one();
+   if (thread_.joinable())
+      thread_.join();
+}
+
+int SequenceStreamer::Start(std::shared_ptr<DeviceInstance> device,
+   AppendFunction append, std::vector<double> values)
+{
+   Cancel(device.get());
+
+   long appended = 0;
+   int err = append(values.data(), static_cast<long>(values.size()), appended);
+   if (err != DEVICE_OK)
+      return err;
+   if (static_cast<std::size_t>(appended) >= values.size())
+      return DEVICE_OK;
+
+   LOG_DEBUG(logger_) << "Streaming sequence to " << device->GetLabel() <<
+      ": " << appended << " of " << values.size() << " values loaded";
+
+   std::lock_guard<std::mutex> lock(mutex_);
+   Stream stream;
+   stream.id = nextId_++;
+   stream.device = device;
+   stream.key = device.get();
+   stream.append = std::move(append);
+   stream.values = std::make_shared<const std::vector<double>>(std::move(values));
+   stream.next = static_cast<std::size_t>((std::max)(appended, 0L));
+   streams_.push_back(std::move(stream));
+   if (!thread_.joinable())
+      thread_ = std::thread([this] { Run(); });
+   return DEVICE_OK;
+}
+
+void SequenceStreamer::Cancel(const DeviceInstance* device)
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   streams_.erase(std::remove_if(streams_.begin(), streams_.end(),
+      [device](const Stream& s) { return s.key == device; }),
+      streams_.end());
+}
+
+void SequenceStreamer::CancelAll()
+{
+   std::lock_guard<std::mutex> refillLock(refillMutex_);
+   std::lock_guard<std::mutex> lock(mutex_);
+   streams_.clear();
+}
+
+std::size_t SequenceStreamer::GetRemaining(const DeviceInstance* device) const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   for (const Stream& s : streams_)
+   {
+      if (s.key == device)
+         return s.values->size() - s.next;
+   }
+   return 0;
+}
+
+void SequenceStreamer::Notify()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      notified_ = true;
+   }
+   cv_.notify_one();
+}
+
+void SequenceStreamer::Run()
+{
+   for (;;)
+   {
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         cv_.wait(lock, [this] { return notified_ || stop_; });
+         if (stop_)
+            return;
+         notified_ = false;
+      }
+      RefillAll();
+   }
+}
+
+void SequenceStreamer::RefillAll()
+{
+   std::lock_guard<std::mutex> refillLock(refillMutex_);
+
+   // We do not know which device has room (a device may relay for another,
+   // as DAZStage does for its DA), so offer every stream its next values
+   std::vector<std::pair<std::uint64_t, std::weak_ptr<DeviceInstance>>> targets;
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const Stream& s : streams_)
+         targets.emplace_back(s.id, s.device);
+   }
+
+   for (const auto& target : targets)
+   {
+      std::shared_ptr<DeviceInstance> device = target.second.lock();
+      if (!device)
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         auto it = Find(target.first);
+         if (it != streams_.end())
+            streams_.erase(it);
+         continue;
+      }
+      Refill(target.first, device);
+   }
+}
+
+void SequenceStreamer::Refill(std::uint64_t id,
+   const std::shared_ptr<DeviceInstance>& device)
+{
+   DeviceModuleLockGuard guard(device);
+
+   // Start() and Cancel() hold the module lock, so the stream cannot change
+   // between here and the update below (but it may have been replaced or
+   // removed before we got the lock)
+   AppendFunction append;
+   std::shared_ptr<const std::vector<double>> values;
+   std::size_t next;
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = Find(id);
+      if (it == streams_.end())
+         return;
+      append = it->append;
+      values = it->values;
+      next = it->next;
+   }
+
+   long appended = 0;
+   const int err = append(values->data() + next,
+      static_cast<long>(values->size() - next), appended);
+
+   std::lock_guard<std::mutex> lock(mutex_);
+   auto it = Find(id);
+   if (it == streams_.end())
+      return;
+   if (err != DEVICE_OK)
+   {
+      LOG_ERROR(logger_) << "Streaming sequence to " << device->GetLabel() <<
+         " stopped at value " << next << ": device error " << err;
+      streams_.erase(it);
+      return;
+   }
+   it->next += static_cast<std::size_t>((std::max)(appended, 0L));
+   if (it->next >= values->size())
+   {
+      LOG_DEBUG(logger_) << "Streaming sequence to " << device->GetLabel() <<
+         ": all " << values->size() << " values loaded";
+      streams_.erase(it);
+   }
+}
+
+std::vector<SequenceStreamer::Stream>::iterator
+SequenceStreamer::Find(std::uint64_t id)
+{
+   return std::find_if(streams_.begin(), streams_.end(),
+      [id](const Stream& s) { return s.id == id; });
+}
+
+} // namespace mm
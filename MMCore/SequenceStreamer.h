@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SequenceStreamer.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Keeps device sequence buffers filled while streamed
+//                hardware sequences run.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include "Logging/Logger.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class DeviceInstance;
+
+namespace mm {
+
+// Holds the part of each streamed sequence that did not fit in the device's
+// buffer, and appends it as the device makes room.
+//
+// Devices report room by calling MM::Core::OnSequenceBufferLow(), which ends
+// up in Notify(). Refilling happens on a thread owned by this object (started
+// on first use), which takes each device's module lock in turn and offers it
+// the rest of its sequence; the device takes what fits.
+//
+// Start() and Cancel() must be called with the device's module lock held.
+class SequenceStreamer
+{
+public:
+   // Appends up to count values to the device's sequence, setting
+   // numAppended; returns a device error code
+   using AppendFunction = std::function<int(const double* values,
+      long count, long& numAppended)>;
+
+   explicit SequenceStreamer(logging::Logger logger);
+   ~SequenceStreamer();
+
+   SequenceStreamer(const SequenceStreamer&) = delete;
+   SequenceStreamer& operator=(const SequenceStreamer&) = delete;
+
+   // Replaces any stream for the device. Appends as much of values as the
+   // device accepts now and keeps the rest for later. Returns the error code
+   // of the first append (in which case nothing is kept).
+   int Start(std::shared_ptr<DeviceInstance> device, AppendFunction append,
+      std::vector<double> values);
+
+   void Cancel(const DeviceInstance* device);
+
+   // Also waits for any refill in progress to finish; call without holding
+   // any module lock
+   void CancelAll();
+
+   // Number of values not yet appended to the device
+   std::size_t GetRemaining(const DeviceInstance* device) const;
+
+   void Notify();
+
+private:
+   struct Stream
+   {
+      std::uint64_t id;
+      std::weak_ptr<DeviceInstance> device;
+      const DeviceInstance* key;
+      AppendFunction append;
+      std::shared_ptr<const std::vector<double>> values;
+      std::size_t next;
+   };
+
+   void Run();
+   void RefillAll();
+   void Refill(std::uint64_t id, const std::shared_ptr<DeviceInstance>& device);
+   std::vector<Stream>::iterator Find(std::uint64_t id);
+
+   logging::Logger logger_;
+
+   mutable std::mutex mutex_;
+   std::condition_variable cv_;
+   std::vector<Stream> streams_; // Guarded by mutex_
+   std::uint64_t nextId_ = 1; // Guarded by mutex_
+   bool notified_ = false; // Guarded by mutex_
+   bool stop_ = false; // Guarded by mutex_
+
+   // Held for a whole refill pass; acquired before mutex_ or module locks
+   std::mutex refillMutex_;
+   std::thread thread_;
+};
+
+} // namespace mm
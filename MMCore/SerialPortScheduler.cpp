@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SerialPortScheduler.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Arbitrates access to a serial port shared by several devices.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "SerialPortScheduler.h"
+
+#include <algorithm>
+
+namespace mm {
+
+constexpr std::chrono::milliseconds SerialPortScheduler::answerHoldTimeout;
+constexpr std::chrono::milliseconds SerialPortScheduler::holdIdleTimeout;
+constexpr std::chrono::milliseconds SerialPortScheduler::shortSliceThreshold;
+constexpr std::chrono::milliseconds SerialPortScheduler::maxWaitBeforePromotion;
+
+namespace {
+
+double ToMs(SerialPortScheduler::Clock::duration d)
+{
+   return std::chrono::duration<double, std::milli>(d).count();
+}
+
+} // anonymous namespace
+
+SerialPortScheduler::Slot::Slot(SerialPortScheduler& scheduler,
+      const std::string& client) :
+   scheduler_(scheduler),
+   wasHeld_(scheduler.Acquire(client))
+{
+}
+
+SerialPortScheduler::Slot::~Slot()
+{
+   scheduler_.EndCall(keepHold_);
+}
+
+void SerialPortScheduler::BeginTransaction(const std::string& client)
+{
+   Slot slot(*this, client);
+   std::lock_guard<std::mutex> lock(mutex_);
+   ++transactionDepth_;
+}
+
+void SerialPortScheduler::EndTransaction(const std::string& client)
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   if (!held_ || holder_ != client || transactionDepth_ == 0)
+      return;
+   if (--transactionDepth_ == 0 && callsInProgress_ == 0)
+      ReleaseHold();
+}
+
+std::vector<SerialPortScheduler::ClientStatistics>
+SerialPortScheduler::GetStatistics() const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   std::vector<ClientStatistics> ret;
+   for (const auto& c : clients_)
+   {
+      ret.push_back(c.second.stats);
+      ret.back().client = c.first;
+   }
+   return ret;
+}
+
+void SerialPortScheduler::ResetStatistics()
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   for (auto& c : clients_)
+      c.second.stats = ClientStatistics();
+}
+
+std::size_t SerialPortScheduler::GetWaitingCalls() const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   std::size_t n = 0;
+   for (const auto& c : clients_)
+      n += c.second.waiters.size();
+   return n;
+}
+
+bool SerialPortScheduler::Acquire(const std::string& client)
+{
+   std::unique_lock<std::mutex> lock(mutex_);
+   if (held_ && holder_ == client)
+   {
+      ++callsInProgress_;
+      return true;
+   }
+
+   const std::uint64_t ticket = ++nextTicket_;
+   clients_[client].waiters.push_back(Waiter{ ticket, Clock::now() });
+   if (!held_)
+      GrantNext();
+
+   while (grantedTicket_ != ticket)
+   {
+      if (held_ && callsInProgress_ == 0)
+      {
+         // The holder is between calls; take the port from it if it stays
+         // idle for too long
+         if (HoldExpired(Clock::now()))
+            ReleaseHold();
+         else
+            cv_.wait_until(lock, idleSince_ + idleTimeout_);
+      }
+      else
+      {
+         cv_.wait(lock);
+      }
+   }
+   return false;
+}
+
+void SerialPortScheduler::EndCall(bool keepHold)
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   idleSince_ = Clock::now();
+   if (--callsInProgress_ > 0)
+      return;
+   if (transactionDepth_ > 0 || keepHold)
+   {
+      idleTimeout_ = transactionDepth_ > 0 ?
+         Clock::duration(holdIdleTimeout) : Clock::duration(answerHoldTimeout);
+      cv_.notify_all(); // Waiters start timing the idle hold
+   }
+   else
+   {
+      ReleaseHold();
+   }
+}
+
+bool SerialPortScheduler::HoldExpired(Clock::time_point now) const
+{
+   return held_ && callsInProgress_ == 0 &&
+      now - idleSince_ >= idleTimeout_;
+}
+
+void SerialPortScheduler::ReleaseHold()
+{
+   const double holdMs = ToMs(Clock::now() - heldSince_);
+   Client& c = clients_[holder_];
+   c.recentHoldMs = c.hasHeldPort ?
+      0.75 * c.recentHoldMs + 0.25 * holdMs : holdMs;
+   c.hasHeldPort = true;
+   c.stats.totalHoldMs += holdMs;
+   c.stats.maxHoldMs = (std::max)(c.stats.maxHoldMs, holdMs);
+
+   held_ = false;
+   holder_.clear();
+   transactionDepth_ = 0;
+   GrantNext();
+   cv_.notify_all();
+}
+
+bool SerialPortScheduler::IsUrgent(const Client& c,
+      Clock::time_point now) const
+{
+   return c.recentHoldMs < ToMs(shortSliceThreshold) ||
+      now - c.waiters.front().enqueued > maxWaitBeforePromotion;
+}
+
+void SerialPortScheduler::GrantNext()
+{
+   const Clock::time_point now = Clock::now();
+
+   // Round-robin, starting with the client after the one last served: first
+   // look for an urgent waiter, then take any waiter.
+   auto next = clients_.end();
+   for (int pass = 0; pass < 2 && next == clients_.end(); ++pass)
+   {
+      auto start = clients_.upper_bound(lastServed_);
+      for (std::size_t i = 0; i < clients_.size(); ++i, ++start)
+      {
+         if (start == clients_.end())
+            start = clients_.begin();
+         const Client& c = start->second;
+         if (c.waiters.empty())
+            continue;
+         if (pass == 1 || IsUrgent(c, now))
+         {
+            next = start;
+            break;
+         }
+      }
+   }
+   if (next == clients_.end())
+      return;
+
+   Client& c = next->second;
+   const Waiter w = c.waiters.front();
+   c.waiters.pop_front();
+
+   const double waitMs = ToMs(now - w.enqueued);
+   ++c.stats.slices;
+   c.stats.totalWaitMs += waitMs;
+   c.stats.maxWaitMs = (std::max)(c.stats.maxWaitMs, waitMs);
+
+   lastServed_ = next->first;
+   held_ = true;
+   holder_ = next->first;
+   heldSince_ = now;
+   callsInProgress_ = 1;
+   grantedTicket_ = w.ticket;
+   cv_.notify_all();
+}
+
+} // namespace mm
@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SerialPortScheduler.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMCore
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Arbitrates access to a serial port shared by several devices.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mm {
+
+// Grants exclusive use of a port to one client (device label) at a time.
+//
+// The unit of scheduling is an exchange, not a single call: a command and
+// the answer to it must not be split by another client's traffic, or one
+// device ends up reading another device's reply. A client keeps the port
+// (holds it) from a SetCommand or Write until a GetAnswer, or a Read that
+// returns data, ends the exchange; further calls from the holding client go
+// through without waiting. Whether a command will be answered is not known,
+// so a hold that sees no call for answerHoldTimeout is dropped: a command
+// sent without reading an answer costs the other clients no more than that.
+//
+// A client that needs the port for longer (e.g. a binary reply read in
+// several parts) opens a transaction with BeginTransaction(), and keeps the
+// port until EndTransaction(), or until it makes no call for
+// holdIdleTimeout.
+//
+// Each client has its own FIFO of waiting calls, and clients are served
+// round-robin, so that a device issuing many exchanges cannot starve the
+// others. Clients whose recent holds have been short (typically status
+// queries) are served before clients that hold the port for long (e.g. while
+// waiting for a move to complete); a call that has waited longer than
+// maxWaitBeforePromotion is served as if it were short, to avoid starvation.
+// The priority only decides who gets the port next: the scheduler does not
+// preempt, and an exchange that blocks keeps the port until it ends.
+//
+// Note that Core-side calls into devices of the same adapter module are
+// already serialized by the module lock; the scheduler matters for devices
+// in different modules sharing a port and for calls made from device
+// threads.
+class SerialPortScheduler
+{
+public:
+   using Clock = std::chrono::steady_clock;
+
+   struct ClientStatistics
+   {
+      std::string client;
+      std::uint64_t slices = 0; // Number of times the port was granted
+      double totalHoldMs = 0.0;
+      double maxHoldMs = 0.0;
+      double totalWaitMs = 0.0;
+      double maxWaitMs = 0.0;
+   };
+
+   // Scoped call on the port. Waits until the client holds the port (returns
+   // at once if it already does). On destruction, the hold ends unless
+   // KeepHold(true) was called (to await an answer) or a transaction is open.
+   class Slot
+   {
+      SerialPortScheduler& scheduler_;
+      bool wasHeld_;
+      bool keepHold_ = false;
+
+   public:
+      Slot(SerialPortScheduler& scheduler, const std::string& client);
+      ~Slot();
+
+      Slot(const Slot&) = delete;
+      Slot& operator=(const Slot&) = delete;
+
+      // True if the client already held the port when the call started
+      bool WasHeld() const { return wasHeld_; }
+      void KeepHold(bool keep) { keepHold_ = keep; }
+   };
+
+   SerialPortScheduler() = default;
+
+   // Waits for the port and keeps it for the client until the matching
+   // EndTransaction(). Transactions may be nested.
+   void BeginTransaction(const std::string& client);
+   // Does nothing if the hold has already been dropped for idleness
+   void EndTransaction(const std::string& client);
+
+   std::vector<ClientStatistics> GetStatistics() const;
+   void ResetStatistics();
+
+   // Number of calls currently waiting for the port
+   std::size_t GetWaitingCalls() const;
+
+   static constexpr std::chrono::milliseconds answerHoldTimeout{ 50 };
+   static constexpr std::chrono::milliseconds holdIdleTimeout{ 1000 };
+   static constexpr std::chrono::milliseconds shortSliceThreshold{ 20 };
+   static constexpr std::chrono::milliseconds maxWaitBeforePromotion{ 100 };
+
+private:
+   struct Waiter
+   {
+      std::uint64_t ticket;
+      Clock::time_point enqueued;
+   };
+
+   struct Client
+   {
+      std::deque<Waiter> waiters;
+      bool hasHeldPort = false;
+      double recentHoldMs = 0.0; // Exponential moving average
+      ClientStatistics stats;
+   };
+
+   bool Acquire(const std::string& client); // Returns true if already held
+   void EndCall(bool keepHold);
+   void ReleaseHold(); // Call with mutex_ held
+   void GrantNext(); // Call with mutex_ held and port not held
+   bool HoldExpired(Clock::time_point now) const;
+   bool IsUrgent(const Client& c, Clock::time_point now) const;
+
+   mutable std::mutex mutex_;
+   std::condition_variable cv_;
+   std::map<std::string, Client> clients_;
+   std::string lastServed_;
+
+   bool held_ = false;
+   std::string holder_;
+   Clock::time_point heldSince_;
+   Clock::time_point idleSince_;
+   Clock::duration idleTimeout_{}; // Of the current hold, while between calls
+   unsigned callsInProgress_ = 0;
+   unsigned transactionDepth_ = 0;
+
+   std::uint64_t nextTicket_ = 0;
+   std::uint64_t grantedTicket_ = 0; // 0 = none
+};
+
+} // namespace mm
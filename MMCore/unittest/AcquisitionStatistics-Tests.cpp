@@ -0,0 +1,144 @@
+#include <catch2/catch_all.hpp>
+
+#include "AcquisitionStatistics.h"
+#include "CircularBuffer.h"
+#include "MMCore.h"
+#include "Logging/Logging.h"
+#include "../../MMDevice/ImageMetadata.h"
+#include "../../MMDevice/MMDeviceConstants.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const unsigned width = 512, height = 512; // 4 frames fit in 1 MB
+
+std::shared_ptr<mm::AcquisitionStatistics> NewStatistics() {
+   static std::shared_ptr<mm::logging::LoggingCore> loggingCore =
+      std::make_shared<mm::logging::LoggingCore>();
+   return std::make_shared<mm::AcquisitionStatistics>(
+      loggingCore->NewLogger("test"));
+}
+
+bool Insert(CircularBuffer& cb) {
+   std::vector<unsigned char> pixels(width * height, 1);
+   Metadata md;
+   md.PutImageTag(MM::g_Keyword_Metadata_CameraLabel, "cam");
+   return cb.InsertImage(pixels.data(), width, height, 1, &md);
+}
+
+} // namespace
+
+TEST_CASE("Histogram counts small values exactly", "[AcquisitionStatistics]") {
+   mm::LogLinearHistogram h;
+   CHECK(h.Count() == 0);
+   CHECK(h.Percentile(50.0) == 0);
+
+   for (std::uint64_t v = 0; v < 16; ++v)
+      h.Record(v);
+   CHECK(h.Count() == 16);
+   CHECK(h.Min() == 0);
+   CHECK(h.Max() == 15);
+   CHECK(h.Mean() == 7.5);
+   CHECK(h.Percentile(50.0) == 7);
+   CHECK(h.Percentile(100.0) == 15);
+   CHECK(h.Percentile(0.0) == 0);
+
+   h.Reset();
+   CHECK(h.Count() == 0);
+   CHECK(h.Max() == 0);
+}
+
+TEST_CASE("Histogram percentiles are within 3%", "[AcquisitionStatistics]") {
+   mm::LogLinearHistogram h;
+   for (std::uint64_t v = 1; v <= 1000000; v += 7)
+      h.Record(v);
+   for (double p : {10.0, 50.0, 90.0, 99.0}) {
+      const double expected = p / 100.0 * 1000000;
+      CHECK_THAT(double(h.Percentile(p)),
+         Catch::Matchers::WithinRel(expected, 0.03));
+   }
+   CHECK(h.Max() == 1000000);
+
+   // Out-of-range values are clamped, not lost
+   h.Record(std::uint64_t(1) << 50);
+   CHECK(h.Max() == mm::LogLinearHistogram::MaxTrackableValue);
+   CHECK(h.Percentile(100.0) == mm::LogLinearHistogram::MaxTrackableValue);
+}
+
+TEST_CASE("Histogram records from several threads", "[AcquisitionStatistics]") {
+   mm::LogLinearHistogram h;
+   std::vector<std::thread> threads;
+   for (int t = 0; t < 4; ++t)
+      threads.emplace_back([&h] {
+         for (std::uint64_t v = 0; v < 10000; ++v)
+            h.Record(v);
+      });
+   for (auto& t : threads)
+      t.join();
+   CHECK(h.Count() == 40000);
+   CHECK(h.Min() == 0);
+   CHECK(h.Max() == 9999);
+}
+
+TEST_CASE("Circular buffer records into statistics", "[AcquisitionStatistics]") {
+   auto stats = NewStatistics();
+   CircularBuffer cb(1, stats);
+   REQUIRE(cb.Initialize(1, width, height, 1));
+   REQUIRE(cb.GetSize() == 4);
+
+   for (int i = 0; i < 4; ++i)
+      REQUIRE(Insert(cb));
+   CHECK_FALSE(Insert(cb));
+   std::this_thread::sleep_for(std::chrono::milliseconds(2));
+   REQUIRE(cb.GetNextImageBuffer(0) != nullptr);
+   REQUIRE(cb.GetNextImageBuffer(0) != nullptr);
+
+   using S = mm::AcquisitionStatistics;
+   CHECK(stats->GetFramesInserted() == 4);
+   CHECK(stats->GetFramesPopped() == 2);
+   CHECK(stats->GetOverflows() == 1);
+   CHECK(stats->GetPropertyValue(S::MaxQueueDepthProperty) == "4");
+   CHECK(stats->GetHistogram(S::Copy).Count() == 4);
+   CHECK(stats->GetHistogram(S::FrameInterval).Count() == 3);
+   CHECK(stats->GetHistogram(S::InsertToPop).Count() == 2);
+   CHECK(stats->GetHistogram(S::InsertToPop).Min() >= 2000);
+
+   stats->Reset();
+   CHECK(stats->GetFramesInserted() == 0);
+   CHECK(stats->GetHistogram(S::InsertToPop).Count() == 0);
+   CHECK(stats->GetPropertyValue(S::FrameRateProperty) == "0");
+}
+
+TEST_CASE("Statistics summary is JSON", "[AcquisitionStatistics]") {
+   auto stats = NewStatistics();
+   stats->RecordLatency(mm::AcquisitionStatistics::Processing,
+      std::chrono::microseconds(100));
+   const std::string json = stats->ToJSON();
+   CHECK(json.front() == '{');
+   CHECK(json.back() == '}');
+   CHECK(json.find("\"framesInserted\":0") != std::string::npos);
+   CHECK(json.find("\"processing\":{\"count\":1,\"min\":100,\"mean\":100,"
+      "\"p50\":100,\"p90\":100,\"p99\":100,\"max\":100}") != std::string::npos);
+}
+
+TEST_CASE("Core exposes acquisition statistics", "[AcquisitionStatistics]") {
+   CMMCore c;
+   CHECK(c.getAcquisitionStatistics().find("\"latencyUs\"") != std::string::npos);
+
+   using S = mm::AcquisitionStatistics;
+   CHECK(c.getProperty("Core", S::FramesInsertedProperty) == "0");
+   CHECK(c.isPropertyReadOnly("Core", S::CameraToInsertP99Property));
+   CHECK_THROWS(c.setProperty("Core", S::OverflowsProperty, "1"));
+
+   CHECK(c.getProperty("Core", S::LogIntervalProperty) == "0");
+   c.setProperty("Core", S::LogIntervalProperty, "1000");
+   CHECK(c.getAcquisitionStatisticsLogInterval() == 1000);
+   c.setAcquisitionStatisticsLogInterval(0);
+   CHECK(c.getProperty("Core", S::LogIntervalProperty) == "0");
+}
@@ -0,0 +1,153 @@
+#include <catch2/catch_all.hpp>
+
+#include "MMCore.h"
+#include "../../MMDevice/DeviceBase.h"
+#include "MockDeviceUtils.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const unsigned width = 16;
+const unsigned height = 8;
+
+// Uses the default sequence thread of CCameraBase; each frame is filled with
+// its number
+class PacedCamera : public CCameraBase<PacedCamera> {
+   std::vector<unsigned char> image_;
+
+public:
+   PacedCamera() : image_(width * height) {}
+
+   std::atomic<int> snaps{0};
+   std::atomic<bool> threadExited{false};
+   std::chrono::milliseconds snapDuration{0};
+
+   using CCameraBase<PacedCamera>::SetSequencePipelined;
+   using CCameraBase<PacedCamera>::GetSequenceTimingStats;
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "PacedCamera");
+   }
+
+   int SnapImage() override {
+      std::this_thread::sleep_for(snapDuration);
+      std::fill(image_.begin(), image_.end(),
+         static_cast<unsigned char>(snaps++));
+      return DEVICE_OK;
+   }
+   const unsigned char* GetImageBuffer() override { return image_.data(); }
+   long GetImageBufferSize() const override { return width * height; }
+   unsigned GetImageWidth() const override { return width; }
+   unsigned GetImageHeight() const override { return height; }
+   unsigned GetImageBytesPerPixel() const override { return 1; }
+   unsigned GetBitDepth() const override { return 8; }
+   int GetBinning() const override { return 1; }
+   int SetBinning(int) override { return DEVICE_OK; }
+   void SetExposure(double) override {}
+   double GetExposure() const override { return 0.0; }
+   int SetROI(unsigned, unsigned, unsigned, unsigned) override { return DEVICE_OK; }
+   int GetROI(unsigned& x, unsigned& y, unsigned& w, unsigned& h) override {
+      x = y = 0;
+      w = width;
+      h = height;
+      return DEVICE_OK;
+   }
+   int ClearROI() override { return DEVICE_OK; }
+   void OnThreadExiting() override {
+      CCameraBase<PacedCamera>::OnThreadExiting();
+      threadExited = true;
+   }
+   int IsExposureSequenceable(bool& f) const override {
+      f = false;
+      return DEVICE_OK;
+   }
+};
+
+// The Core sees the sequence as finished before the thread has made its last
+// call into the Core, so wait for the thread before the Core is destroyed
+void WaitForSequence(PacedCamera& cam) {
+   while (!cam.threadExited)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+} // namespace
+
+TEST_CASE("Default sequence thread paces frames at the interval",
+      "[CameraSequencePacing]") {
+   PacedCamera cam;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+
+   const auto start = std::chrono::steady_clock::now();
+   c.startSequenceAcquisition(6, 20.0, true);
+   WaitForSequence(cam);
+   const auto elapsed = std::chrono::steady_clock::now() - start;
+
+   // Five intervals between six frames; not more than one interval of drift
+   CHECK(elapsed >= std::chrono::milliseconds(100));
+   CHECK(c.getRemainingImageCount() == 6);
+
+   auto stats = cam.GetSequenceTimingStats();
+   CHECK(stats.frames == 5);
+   CHECK(stats.maxJitterUs >= stats.meanJitterUs);
+}
+
+TEST_CASE("Zero interval sequence is not paced", "[CameraSequencePacing]") {
+   PacedCamera cam;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+
+   c.startSequenceAcquisition(10, 0.0, true);
+   WaitForSequence(cam);
+   CHECK(c.getRemainingImageCount() == 10);
+   CHECK(cam.GetSequenceTimingStats().frames == 0);
+}
+
+TEST_CASE("Stopping interrupts the wait for the next frame",
+      "[CameraSequencePacing]") {
+   PacedCamera cam;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+
+   c.startSequenceAcquisition(100, 60000.0, true);
+   while (c.getRemainingImageCount() < 1)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+   const auto start = std::chrono::steady_clock::now();
+   c.stopSequenceAcquisition();
+   CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+   CHECK(c.getRemainingImageCount() == 1);
+}
+
+TEST_CASE("Pipelined sequence inserts every frame in order",
+      "[CameraSequencePacing]") {
+   PacedCamera cam;
+   cam.snapDuration = std::chrono::milliseconds(1);
+   cam.SetSequencePipelined(true);
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+
+   c.startSequenceAcquisition(20, 0.0, true);
+   WaitForSequence(cam);
+
+   REQUIRE(c.getRemainingImageCount() == 20);
+   for (int i = 0; i < 20; ++i) {
+      auto pixels = static_cast<const unsigned char*>(c.popNextImage());
+      CHECK(pixels[0] == i);
+      CHECK(pixels[width * height - 1] == i);
+   }
+}
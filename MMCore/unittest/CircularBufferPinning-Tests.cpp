@@ -0,0 +1,76 @@
+#include <catch2/catch_all.hpp>
+
+#include "CircularBuffer.h"
+#include "../../MMDevice/ImageMetadata.h"
+#include "../../MMDevice/MMDeviceConstants.h"
+
+#include <vector>
+
+namespace {
+
+const unsigned width = 512, height = 512; // 4 frames fit in 1 MB
+
+bool Insert(CircularBuffer& cb, unsigned char value) {
+   std::vector<unsigned char> pixels(width * height, value);
+   Metadata md;
+   md.PutImageTag(MM::g_Keyword_Metadata_CameraLabel, "cam");
+   return cb.InsertImage(pixels.data(), width, height, 1, &md);
+}
+
+} // namespace
+
+TEST_CASE("Pinned image is not overwritten") {
+   CircularBuffer cb(1);
+   REQUIRE(cb.Initialize(1, width, height, 1));
+   REQUIRE(cb.GetSize() == 4);
+
+   REQUIRE(Insert(cb, 1));
+   const mm::ImgBuffer* pinned = cb.PinNextImageBuffer(0);
+   REQUIRE(pinned != nullptr);
+   const unsigned char* pixels = pinned->GetPixels();
+   CHECK(cb.GetPinnedImageCount() == 1);
+
+   for (unsigned char v = 2; v <= 4; ++v) {
+      REQUIRE(Insert(cb, v));
+      REQUIRE(cb.GetNextImageBuffer(0) != nullptr);
+   }
+
+   // The next insertion would reuse the pinned slot
+   CHECK_FALSE(Insert(cb, 5));
+   CHECK(cb.Overflow());
+   CHECK(pixels[0] == 1);
+
+   CHECK(cb.UnpinImage(pixels));
+   CHECK(cb.GetPinnedImageCount() == 0);
+   cb.Clear();
+   REQUIRE(Insert(cb, 6));
+   CHECK(pixels[0] == 6);
+}
+
+TEST_CASE("Pin counts nest") {
+   CircularBuffer cb(1);
+   REQUIRE(cb.Initialize(1, width, height, 1));
+   REQUIRE(Insert(cb, 1));
+
+   const unsigned char* a = cb.PinNthFromTopImageBuffer(0, 0)->GetPixels();
+   const unsigned char* b = cb.PinNthFromTopImageBuffer(0, 0)->GetPixels();
+   CHECK(a == b);
+   CHECK(cb.GetPinnedImageCount() == 2);
+   CHECK(cb.UnpinImage(a));
+   CHECK(cb.GetPinnedImageCount() == 1);
+   CHECK(cb.UnpinImage(b));
+   CHECK_FALSE(cb.UnpinImage(b));
+}
+
+TEST_CASE("Buffer is not reallocated while images are pinned") {
+   CircularBuffer cb(1);
+   REQUIRE(cb.Initialize(1, width, height, 1));
+   REQUIRE(Insert(cb, 1));
+   const unsigned char* pixels = cb.PinNextImageBuffer(0)->GetPixels();
+
+   CHECK(cb.Initialize(1, width, height, 1)); // Unchanged; no reallocation
+   CHECK_FALSE(cb.Initialize(1, width / 2, height, 1));
+
+   cb.UnpinImage(pixels);
+   CHECK(cb.Initialize(1, width / 2, height, 1));
+}
@@ -0,0 +1,154 @@
+#include <catch2/catch_all.hpp>
+
+#include "ConfigSnapshot.h"
+#include "MMCore.h"
+#include "../../MMDevice/DeviceBase.h"
+#include "MockDeviceUtils.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Generic device whose "Value" property counts how often it is written. Its
+// name matches the label it is loaded under, so that a saved configuration
+// can load it again.
+class MockWritableDevice : public CGenericBase<MockWritableDevice> {
+   long value_ = 0;
+
+public:
+   int writes = 0;
+
+   MockWritableDevice() {
+      CreateIntegerProperty("Value", 0, false,
+         new CPropertyAction(this, &MockWritableDevice::OnValue));
+   }
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "dev");
+   }
+
+   int OnValue(MM::PropertyBase* pProp, MM::ActionType eAct) {
+      if (eAct == MM::BeforeGet) {
+         pProp->Set(value_);
+      } else if (eAct == MM::AfterSet) {
+         pProp->Get(value_);
+         ++writes;
+      }
+      return DEVICE_OK;
+   }
+};
+
+std::string ReadFile(const std::string& path) {
+   std::ifstream is(path.c_str(), std::ios_base::binary);
+   return std::string((std::istreambuf_iterator<char>(is)),
+      std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::string& text) {
+   std::ofstream os(path.c_str(), std::ios_base::binary | std::ios_base::trunc);
+   os << text;
+}
+
+} // namespace
+
+TEST_CASE("Configuration text is split into tokenized lines") {
+   const auto lines = mm::ParseConfigText(
+      "# comment\r\n"
+      "Device,dev,adapter,name\r\n"
+      "\r\n"
+      "Property,dev,Prop,\n"
+      ",,\n"
+      "Label,dev,1,One");
+   REQUIRE(lines.size() == 4);
+   CHECK(lines[0].lineNumber == 2);
+   CHECK(lines[0].text == "Device,dev,adapter,name");
+   CHECK(lines[0].tokens == std::vector<std::string>{"Device", "dev", "adapter", "name"});
+   CHECK(lines[1].lineNumber == 4);
+   CHECK(lines[1].tokens.size() == 3);
+   CHECK(lines[2].tokens.empty());
+   CHECK(lines[3].lineNumber == 6);
+   CHECK(lines[3].tokens.back() == "One");
+}
+
+TEST_CASE("Configuration snapshot is only used for matching text") {
+   const std::string path = "ConfigSnapshot-Tests.snapshot";
+   const std::string text = "Device,dev,adapter,name\nProperty,dev,Prop,1\n";
+   const auto parsed = mm::ParseConfigText(text);
+   REQUIRE(mm::WriteConfigSnapshot(path, text, parsed));
+
+   std::vector<mm::ConfigLine> lines;
+   REQUIRE(mm::ReadConfigSnapshot(path, text, lines));
+   REQUIRE(lines.size() == parsed.size());
+   for (size_t i = 0; i < lines.size(); ++i) {
+      CHECK(lines[i].lineNumber == parsed[i].lineNumber);
+      CHECK(lines[i].text == parsed[i].text);
+      CHECK(lines[i].tokens == parsed[i].tokens);
+   }
+
+   CHECK_FALSE(mm::ReadConfigSnapshot(path, text + "Property,dev,Prop,2\n", lines));
+   CHECK(lines.empty());
+
+   std::string corrupt = ReadFile(path);
+   corrupt.resize(corrupt.size() - 3);
+   WriteFile(path, corrupt);
+   CHECK_FALSE(mm::ReadConfigSnapshot(path, text, lines));
+
+   std::remove(path.c_str());
+   CHECK_FALSE(mm::ReadConfigSnapshot(path, text, lines));
+}
+
+TEST_CASE("Loading with a snapshot skips redundant property writes") {
+   const std::string cfg = "ConfigSnapshot-Tests.cfg";
+   const std::string snapshot = mm::ConfigSnapshotPath(cfg);
+
+   MockWritableDevice dev;
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.defineConfig("System", "Startup", "dev", "Value", "5");
+   c.setConfig("System", "Startup");
+   REQUIRE(dev.writes == 1);
+
+   c.enableFeature("ConfigSnapshots", true);
+   c.saveSystemConfiguration(cfg.c_str());
+   REQUIRE_FALSE(ReadFile(snapshot).empty());
+
+   SECTION("unchanged value is not written again") {
+      dev.writes = 0;
+      c.loadSystemConfiguration(cfg.c_str());
+      CHECK(dev.writes == 0);
+      CHECK(c.getProperty("dev", "Value") == "5");
+   }
+
+   SECTION("changed value is written") {
+      c.setProperty("dev", "Value", "3");
+      dev.writes = 0;
+      c.loadSystemConfiguration(cfg.c_str());
+      CHECK(dev.writes == 1);
+      CHECK(c.getProperty("dev", "Value") == "5");
+   }
+
+   SECTION("stale snapshot is ignored") {
+      WriteFile(cfg, ReadFile(cfg) + "# edited\n");
+      dev.writes = 0;
+      c.loadSystemConfiguration(cfg.c_str());
+      CHECK(dev.writes == 1);
+   }
+
+   SECTION("without the feature, every value is written") {
+      c.enableFeature("ConfigSnapshots", false);
+      dev.writes = 0;
+      c.loadSystemConfiguration(cfg.c_str());
+      CHECK(dev.writes == 1);
+   }
+
+   c.enableFeature("ConfigSnapshots", false);
+   std::remove(cfg.c_str());
+   std::remove(snapshot.c_str());
+}
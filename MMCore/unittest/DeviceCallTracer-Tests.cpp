@@ -0,0 +1,133 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceCallTracer.h"
+#include "MMCore.h"
+#include "../../MMDevice/DeviceBase.h"
+#include "MockDeviceUtils.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Catch::Matchers::ContainsSubstring;
+
+namespace {
+
+std::size_t CountOccurrences(const std::string& str, const std::string& sub) {
+   std::size_t count = 0;
+   for (std::size_t pos = str.find(sub); pos != std::string::npos;
+         pos = str.find(sub, pos + sub.size()))
+      ++count;
+   return count;
+}
+
+class SlowStage : public CStageBase<SlowStage> {
+   double pos_ = 0.0;
+public:
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "SlowStage");
+   }
+   int SetPositionUm(double pos) override {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      pos_ = pos;
+      return DEVICE_OK;
+   }
+   int GetPositionUm(double& pos) override { pos = pos_; return DEVICE_OK; }
+   int SetPositionSteps(long) override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int GetPositionSteps(long&) override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int SetOrigin() override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int GetLimits(double&, double&) override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int IsStageSequenceable(bool& f) const override { f = false; return DEVICE_OK; }
+   bool IsContinuousFocusDrive() const override { return false; }
+};
+
+} // namespace
+
+TEST_CASE("Tracer records calls in start order", "[DeviceCallTracer]") {
+   mm::DeviceCallTracer tracer(4);
+   const auto label = tracer.RegisterLabel("Dev\"1");
+   CHECK(tracer.RegisterLabel("Dev\"1") == label);
+   CHECK(tracer.RegisterLabel("Dev2") != label);
+
+   const auto t0 = mm::DeviceCallTracer::Clock::now();
+   tracer.Record("Outer", label, t0, t0 + std::chrono::milliseconds(3),
+      std::chrono::microseconds(250));
+   tracer.Record("Inner", label, t0 + std::chrono::milliseconds(1),
+      t0 + std::chrono::milliseconds(2),
+      mm::DeviceCallTracer::Clock::duration::zero());
+   CHECK(tracer.GetRecordCount() == 2);
+
+   const std::string json = tracer.ToChromeTraceJSON();
+   CHECK_THAT(json, ContainsSubstring("\"traceEvents\":["));
+   CHECK_THAT(json, ContainsSubstring("\"cat\":\"Dev\\\"1\""));
+   CHECK_THAT(json, ContainsSubstring("\"dur\":3000.000"));
+   CHECK_THAT(json, ContainsSubstring("\"lockWaitUs\":250.000"));
+   CHECK(json.find("\"Outer\"") < json.find("\"Inner\""));
+}
+
+TEST_CASE("Tracer keeps the most recent calls", "[DeviceCallTracer]") {
+   mm::DeviceCallTracer tracer(5);
+   CHECK(tracer.GetCapacity() == 8);
+   const auto label = tracer.RegisterLabel("dev");
+   const auto t0 = mm::DeviceCallTracer::Clock::now();
+   for (int i = 0; i < 20; ++i)
+      tracer.Record(i < 12 ? "Old" : "New", label, t0, t0,
+         mm::DeviceCallTracer::Clock::duration::zero());
+   CHECK(tracer.GetRecordCount() == 8);
+   const std::string json = tracer.ToChromeTraceJSON();
+   CHECK(CountOccurrences(json, "\"New\"") == 8);
+   CHECK(CountOccurrences(json, "\"Old\"") == 0);
+
+   tracer.Clear();
+   CHECK(tracer.GetRecordCount() == 0);
+   CHECK(CountOccurrences(tracer.ToChromeTraceJSON(), "\"ph\":\"X\"") == 0);
+}
+
+TEST_CASE("Tracer can be exported while recording", "[DeviceCallTracer]") {
+   mm::DeviceCallTracer tracer(64);
+   const auto label = tracer.RegisterLabel("dev");
+   std::vector<std::thread> threads;
+   for (int t = 0; t < 3; ++t)
+      threads.emplace_back([&] {
+         for (int i = 0; i < 20000; ++i) {
+            const auto now = mm::DeviceCallTracer::Clock::now();
+            tracer.Record("Call", label, now, now,
+               mm::DeviceCallTracer::Clock::duration::zero());
+         }
+      });
+   for (int i = 0; i < 50; ++i)
+      CHECK(CountOccurrences(tracer.ToChromeTraceJSON(), "\"ph\":\"X\"") <= 64);
+   for (auto& t : threads)
+      t.join();
+   CHECK(CountOccurrences(tracer.ToChromeTraceJSON(), "\"ph\":\"X\"") == 64);
+}
+
+TEST_CASE("Core traces device calls when enabled", "[DeviceCallTracer]") {
+   SlowStage stage;
+   MockAdapterWithDevices adapter{{"zstage", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   c.setPosition("zstage", 1.0);
+   CHECK_FALSE(c.isDeviceCallTracingEnabled());
+   CHECK_THAT(c.getDeviceCallTraceJSON(), !ContainsSubstring("SetPositionUm"));
+
+   c.enableDeviceCallTracing(true);
+   c.setPosition("zstage", 2.0);
+   c.getPosition("zstage");
+   c.enableDeviceCallTracing(false);
+   c.setPosition("zstage", 3.0);
+
+   const std::string json = c.getDeviceCallTraceJSON();
+   CHECK(CountOccurrences(json, "\"name\":\"SetPositionUm\"") == 1);
+   CHECK(CountOccurrences(json, "\"name\":\"GetPositionUm\"") == 1);
+   CHECK_THAT(json, ContainsSubstring("\"cat\":\"zstage\""));
+   CHECK_THAT(json, ContainsSubstring("\"lockWaitUs\":"));
+
+   c.clearDeviceCallTrace();
+   CHECK_THAT(c.getDeviceCallTraceJSON(), !ContainsSubstring("SetPositionUm"));
+}
@@ -0,0 +1,116 @@
+#include <catch2/catch_all.hpp>
+
+#include "MMCore.h"
+#include "../../MMDevice/DeviceBase.h"
+#include "MockDeviceUtils.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+class PolygonGalvo : public CGalvoBase<PolygonGalvo> {
+public:
+   explicit PolygonGalvo(bool bulk) : bulk_(bulk) {}
+
+   std::vector<std::vector<std::pair<double, double>>> polygons;
+   int bulkCalls = 0;
+   int vertexCalls = 0;
+   int loadCalls = 0;
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "PolygonGalvo");
+   }
+   int PointAndFire(double, double, double) override { return DEVICE_OK; }
+   int SetSpotInterval(double) override { return DEVICE_OK; }
+   int SetPosition(double, double) override { return DEVICE_OK; }
+   int GetPosition(double& x, double& y) override { x = y = 0.0; return DEVICE_OK; }
+   int SetIlluminationState(bool) override { return DEVICE_OK; }
+   double GetXRange() override { return 10.0; }
+   double GetYRange() override { return 10.0; }
+   int RunSequence() override { return DEVICE_OK; }
+   int SetPolygonRepetitions(int) override { return DEVICE_OK; }
+   int RunPolygons() override { return DEVICE_OK; }
+   int StopSequence() override { return DEVICE_OK; }
+   int GetChannel(char* name) override { name[0] = '\0'; return DEVICE_OK; }
+
+   int AddPolygonVertex(int index, double x, double y) override {
+      ++vertexCalls;
+      if (index == static_cast<int>(polygons.size()))
+         polygons.emplace_back();
+      polygons.at(index).emplace_back(x, y);
+      return DEVICE_OK;
+   }
+   int AddPolygonVertices(int index, const double* xs, const double* ys,
+         long numVertices) override {
+      if (!bulk_)
+         return DEVICE_UNSUPPORTED_COMMAND;
+      ++bulkCalls;
+      if (index == static_cast<int>(polygons.size()))
+         polygons.emplace_back();
+      for (long i = 0; i < numVertices; ++i)
+         polygons.at(index).emplace_back(xs[i], ys[i]);
+      return DEVICE_OK;
+   }
+   int DeletePolygons() override { polygons.clear(); return DEVICE_OK; }
+   int LoadPolygons() override { ++loadCalls; return DEVICE_OK; }
+
+private:
+   bool bulk_;
+};
+
+using Polygons = std::vector<std::vector<std::pair<double, double>>>;
+
+} // namespace
+
+TEST_CASE("Galvo polygons are loaded one polygon per call when supported",
+      "[GalvoPolygons]") {
+   PolygonGalvo galvo(true);
+   MockAdapterWithDevices adapter{{"galvo", &galvo}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   c.addGalvoPolygonVertex("galvo", 0, 9.0, 9.0); // Replaced
+   c.loadGalvoPolygons("galvo", {1, 3},
+      {1.0, 2.0, 3.0, 4.0}, {5.0, 6.0, 7.0, 8.0});
+   CHECK(galvo.polygons == Polygons{
+      {{1.0, 5.0}},
+      {{2.0, 6.0}, {3.0, 7.0}, {4.0, 8.0}},
+   });
+   CHECK(galvo.bulkCalls == 2);
+   CHECK(galvo.vertexCalls == 1);
+   CHECK(galvo.loadCalls == 1);
+}
+
+TEST_CASE("Galvo polygons fall back to one call per vertex",
+      "[GalvoPolygons]") {
+   PolygonGalvo galvo(false);
+   MockAdapterWithDevices adapter{{"galvo", &galvo}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   c.loadGalvoPolygons("galvo", {2, 1}, {1.0, 2.0, 3.0}, {4.0, 5.0, 6.0});
+   CHECK(galvo.polygons == Polygons{
+      {{1.0, 4.0}, {2.0, 5.0}},
+      {{3.0, 6.0}},
+   });
+   CHECK(galvo.vertexCalls == 3);
+   CHECK(galvo.loadCalls == 1);
+}
+
+TEST_CASE("Galvo polygon vertex counts must match coordinates",
+      "[GalvoPolygons]") {
+   PolygonGalvo galvo(true);
+   MockAdapterWithDevices adapter{{"galvo", &galvo}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   CHECK_THROWS(c.loadGalvoPolygons("galvo", {2}, {1.0, 2.0}, {3.0}));
+   CHECK_THROWS(c.loadGalvoPolygons("galvo", {3}, {1.0, 2.0}, {3.0, 4.0}));
+   CHECK_THROWS(c.loadGalvoPolygons("galvo", {0, 2}, {1.0, 2.0}, {3.0, 4.0}));
+   CHECK(galvo.loadCalls == 0);
+}
@@ -0,0 +1,162 @@
+#include <catch2/catch_all.hpp>
+
+#include "ImageProcessingPipeline.h"
+#include "../../MMDevice/DeviceBase.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Adds 1 to every byte; optionally holds each call until released
+class IncrementingProcessor : public CImageProcessorBase<IncrementingProcessor> {
+   std::mutex mutex_;
+   std::condition_variable cv_;
+   bool hold_ = false;
+
+public:
+   std::atomic<int> calls{0};
+   std::atomic<int> concurrent{0};
+   std::atomic<int> maxConcurrent{0};
+   bool throwOnProcess = false;
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "IncrementingProcessor");
+   }
+
+   void Hold(bool hold) {
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         hold_ = hold;
+      }
+      cv_.notify_all();
+   }
+
+   int Process(unsigned char* buffer, unsigned width, unsigned height,
+         unsigned byteDepth) override {
+      const int n = ++concurrent;
+      if (n > maxConcurrent)
+         maxConcurrent = n;
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         cv_.wait(lock, [&] { return !hold_; });
+      }
+      ++calls;
+      --concurrent;
+      if (throwOnProcess)
+         throw std::runtime_error("processing failed");
+      for (unsigned i = 0; i < width * height * byteDepth; ++i)
+         ++buffer[i];
+      return DEVICE_OK;
+   }
+};
+
+struct Published {
+   std::mutex mutex;
+   std::vector<std::vector<unsigned char>> frames;
+   std::vector<std::string> tags;
+};
+
+mm::ImageProcessingPipeline::PublishFunc Collect(Published& out) {
+   return [&out](const mm::ImageProcessingPipeline::Frame& frame) {
+      std::lock_guard<std::mutex> lock(out.mutex);
+      out.frames.push_back(frame.pixels);
+      out.tags.push_back(frame.metadata.GetSingleTag("Index").GetValue());
+   };
+}
+
+Metadata Tagged(int i) {
+   Metadata md;
+   md.PutImageTag("Index", std::to_string(i));
+   return md;
+}
+
+} // namespace
+
+TEST_CASE("Pipeline processes and publishes frames in order") {
+   IncrementingProcessor proc;
+   Published published;
+   mm::ImageProcessingPipeline pipeline(Collect(published));
+
+   for (int i = 0; i < 50; ++i) {
+      std::vector<unsigned char> pixels(16, static_cast<unsigned char>(i));
+      pipeline.Submit(&proc, pixels.data(), 4, 4, 1, 1, 1, Tagged(i));
+   }
+   pipeline.Drain();
+
+   CHECK(pipeline.GetFramesInFlight() == 0);
+   REQUIRE(published.frames.size() == 50);
+   for (int i = 0; i < 50; ++i) {
+      CHECK(published.frames[i] == std::vector<unsigned char>(16, i + 1));
+      CHECK(published.tags[i] == std::to_string(i));
+   }
+   CHECK(proc.maxConcurrent == 1);
+   CHECK(pipeline.GetStatistics().framesProcessed == 50);
+}
+
+TEST_CASE("Pipeline submission does not wait for processing") {
+   IncrementingProcessor proc;
+   proc.Hold(true);
+   Published published;
+   mm::ImageProcessingPipeline pipeline(Collect(published), 4);
+
+   std::vector<unsigned char> pixels(16, 7);
+   for (int i = 0; i < 4; ++i)
+      pipeline.Submit(&proc, pixels.data(), 4, 4, 1, 1, 1, Tagged(i));
+   pixels.assign(16, 99); // The camera may reuse its buffer right away
+   CHECK(pipeline.GetFramesInFlight() == 4);
+   CHECK(published.frames.empty());
+
+   proc.Hold(false);
+   pipeline.Drain();
+   REQUIRE(published.frames.size() == 4);
+   CHECK(published.frames[3] == std::vector<unsigned char>(16, 8));
+   CHECK(pipeline.GetStatistics().submitWaits == 0);
+}
+
+TEST_CASE("Pipeline publishes frames without a processor or whose processing failed") {
+   IncrementingProcessor proc;
+   proc.throwOnProcess = true;
+   Published published;
+   mm::ImageProcessingPipeline pipeline(Collect(published));
+
+   std::vector<unsigned char> pixels(8, 3);
+   pipeline.Submit(nullptr, pixels.data(), 2, 2, 2, 1, 1, Tagged(0));
+   pipeline.Submit(&proc, pixels.data(), 2, 2, 2, 1, 1, Tagged(1));
+   pipeline.Drain();
+
+   REQUIRE(published.frames.size() == 2);
+   CHECK(published.frames[0] == pixels);
+   CHECK(published.frames[1] == pixels);
+}
+
+TEST_CASE("Pipeline copies all channels of multi-channel frames") {
+   Published published;
+   mm::ImageProcessingPipeline pipeline(Collect(published));
+
+   std::vector<unsigned char> pixels(2 * 3 * 3);
+   for (unsigned i = 0; i < pixels.size(); ++i)
+      pixels[i] = static_cast<unsigned char>(i);
+   pipeline.Submit(nullptr, pixels.data(), 3, 3, 1, 1, 2, Tagged(0));
+   pipeline.Drain();
+
+   REQUIRE(published.frames.size() == 1);
+   CHECK(published.frames[0] == pixels);
+}
+
+TEST_CASE("Unused pipeline drains and stops without frames") {
+   Published published;
+   {
+      // No worker threads are started until the first frame
+      mm::ImageProcessingPipeline pipeline(Collect(published));
+      pipeline.Drain();
+      CHECK(pipeline.GetFramesInFlight() == 0);
+   }
+   CHECK(published.frames.empty());
+}
@@ -0,0 +1,280 @@
+#include <catch2/catch_all.hpp>
+
+#include "MMCore.h"
+#include "SLMPatternStore.h"
+#include "../../MMDevice/DeviceBase.h"
+#include "MockDeviceUtils.h"
+
+#include <vector>
+
+using mm::SLMPatternStore;
+
+namespace {
+
+const unsigned width = 64;
+const unsigned height = 32;
+
+std::vector<unsigned char> BinaryPattern(unsigned seed) {
+   std::vector<unsigned char> pixels(width * height);
+   for (std::size_t i = 0; i < pixels.size(); ++i)
+      pixels[i] = ((i * 7 + seed) % 5 == 0) ? 255 : 0;
+   return pixels;
+}
+
+class PatternSLM : public CSLMBase<PatternSLM> {
+public:
+   explicit PatternSLM(bool smart) : image(width * height), smart_(smart) {}
+
+   std::vector<unsigned char> image;
+   unsigned bytesPerPixel = 1;
+   int fullImageCalls = 0;
+   int colorImageCalls = 0;
+   int regionCalls = 0;
+   unsigned lastRegionPixels = 0;
+   std::vector<long> sequenceIds;
+   std::vector<std::vector<unsigned char>> sequenceFrames;
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "PatternSLM");
+   }
+   int SetImage(unsigned char* pixels) override {
+      ++fullImageCalls;
+      image.assign(pixels, pixels + image.size());
+      return DEVICE_OK;
+   }
+   int SetImage(unsigned int*) override {
+      ++colorImageCalls;
+      return DEVICE_OK;
+   }
+   int SetImageRegion(const unsigned char* const pixels, unsigned x,
+         unsigned y, unsigned w, unsigned h) override {
+      if (!smart_)
+         return DEVICE_UNSUPPORTED_COMMAND;
+      ++regionCalls;
+      lastRegionPixels = w * h;
+      for (unsigned row = 0; row < h; ++row)
+         std::copy(pixels + row * w, pixels + (row + 1) * w,
+            image.begin() + (y + row) * width + x);
+      return DEVICE_OK;
+   }
+   int DisplayImage() override { return DEVICE_OK; }
+   int SetPixelsTo(unsigned char) override { return DEVICE_OK; }
+   int SetPixelsTo(unsigned char, unsigned char, unsigned char) override {
+      return DEVICE_OK;
+   }
+   int SetExposure(double) override { return DEVICE_OK; }
+   double GetExposure() override { return 0.0; }
+   unsigned GetWidth() override { return width; }
+   unsigned GetHeight() override { return height; }
+   unsigned GetNumberOfComponents() override { return 1; }
+   unsigned GetBytesPerPixel() override { return bytesPerPixel; }
+   int IsSLMSequenceable(bool& f) const override { f = true; return DEVICE_OK; }
+
+   int ClearSLMSequence() override {
+      sequenceIds.clear();
+      sequenceFrames.clear();
+      return DEVICE_OK;
+   }
+   int AddToSLMSequence(const unsigned char* const pixels) override {
+      sequenceFrames.emplace_back(pixels, pixels + width * height);
+      return DEVICE_OK;
+   }
+   int AddPatternToSLMSequence(long id, const unsigned char* const) override {
+      if (!smart_)
+         return DEVICE_UNSUPPORTED_COMMAND;
+      sequenceIds.push_back(id);
+      return DEVICE_OK;
+   }
+   int SendSLMSequence() override { return DEVICE_OK; }
+   int StartSLMSequence() override { return DEVICE_OK; }
+   int StopSLMSequence() override { return DEVICE_OK; }
+
+private:
+   bool smart_;
+};
+
+} // namespace
+
+TEST_CASE("SLM pattern store deduplicates and bit-packs", "[SLMPatternStore]") {
+   SLMPatternStore store;
+   const SLMPatternStore::Geometry geometry{width, height, 1};
+   auto a = BinaryPattern(0);
+   auto b = BinaryPattern(1);
+
+   long idA = store.Add(a.data(), geometry);
+   long idB = store.Add(b.data(), geometry);
+   CHECK(idA != idB);
+   CHECK(store.Add(a.data(), geometry) == idA);
+   CHECK(store.GetNumberOfPatterns() == 2);
+   CHECK(store.GetStoredBytes() == 2 * width * height / 8);
+
+   std::vector<unsigned char> unpacked;
+   REQUIRE(store.Unpack(idA, unpacked));
+   CHECK(unpacked == a);
+
+   // Non-binary patterns are kept as they are
+   std::vector<unsigned char> gray(width * height);
+   for (std::size_t i = 0; i < gray.size(); ++i)
+      gray[i] = static_cast<unsigned char>(i);
+   long idGray = store.Add(gray.data(), geometry);
+   REQUIRE(store.Unpack(idGray, unpacked));
+   CHECK(unpacked == gray);
+
+   // Added twice, so removed twice
+   CHECK(store.Remove(idA));
+   CHECK(store.Contains(idA));
+   CHECK(store.Remove(idA));
+   CHECK_FALSE(store.Contains(idA));
+   CHECK_FALSE(store.Remove(idA));
+
+   // IDs are not reused
+   CHECK(store.Add(a.data(), geometry) > idGray);
+}
+
+TEST_CASE("SLM changed area covers all differing pixels", "[SLMPatternStore]") {
+   const SLMPatternStore::Geometry geometry{width, height, 1};
+   auto a = BinaryPattern(0);
+   auto b = a;
+   CHECK(SLMPatternStore::ChangedArea(a.data(), b.data(), geometry).IsEmpty());
+
+   b[3 * width + 10] ^= 1;
+   b[7 * width + 2] ^= 1;
+   auto r = SLMPatternStore::ChangedArea(a.data(), b.data(), geometry);
+   CHECK(r.left == 2);
+   CHECK(r.right == 11);
+   CHECK(r.top == 3);
+   CHECK(r.bottom == 8);
+}
+
+TEST_CASE("SLM patterns are written as changed regions when supported",
+      "[SLMPatternStore]") {
+   PatternSLM slm(true);
+   MockAdapterWithDevices adapter{{"slm", &slm}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   auto a = BinaryPattern(0);
+   auto b = a;
+   b[5 * width + 5] = 255 - b[5 * width + 5];
+   long idA = c.addSLMPattern("slm", a.data());
+   long idB = c.addSLMPattern("slm", b.data());
+
+   c.setSLMPattern("slm", idA);
+   CHECK(slm.fullImageCalls == 1);
+   CHECK(slm.image == a);
+
+   c.setSLMPattern("slm", idB);
+   CHECK(slm.fullImageCalls == 1);
+   CHECK(slm.regionCalls == 1);
+   CHECK(slm.lastRegionPixels == 1);
+   CHECK(slm.image == b);
+
+   c.setSLMPattern("slm", idB);
+   CHECK(slm.regionCalls == 1);
+
+   // An image set by other means is not assumed to be known
+   c.setSLMPixelsTo("slm", 0);
+   c.setSLMPattern("slm", idA);
+   CHECK(slm.fullImageCalls == 2);
+}
+
+TEST_CASE("SLM pattern sequence passes IDs when supported",
+      "[SLMPatternStore]") {
+   PatternSLM smart(true);
+   PatternSLM plain(false);
+   MockAdapterWithDevices adapter{{"smart", &smart}, {"plain", &plain}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   auto a = BinaryPattern(0);
+   auto b = BinaryPattern(1);
+   long idA = c.addSLMPattern("smart", a.data());
+   long idB = c.addSLMPattern("smart", b.data());
+   CHECK(c.getNumberOfSLMPatterns() == 2);
+
+   c.loadSLMPatternSequence("smart", {idA, idB, idA, idA});
+   CHECK(smart.sequenceIds == std::vector<long>{idA, idB, idA, idA});
+   CHECK(smart.sequenceFrames.empty());
+
+   c.loadSLMPatternSequence("plain", {idB, idA});
+   CHECK(plain.sequenceFrames == std::vector<std::vector<unsigned char>>{b, a});
+
+   CHECK_THROWS(c.loadSLMPatternSequence("plain", {idA, 12345}));
+   c.deleteSLMPatterns();
+   CHECK(c.getNumberOfSLMPatterns() == 0);
+   CHECK_THROWS(c.setSLMPattern("plain", idA));
+}
+
+TEST_CASE("SLM pattern is written in full after a sequence",
+      "[SLMPatternStore]") {
+   PatternSLM slm(true);
+   MockAdapterWithDevices adapter{{"slm", &slm}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   auto a = BinaryPattern(0);
+   auto b = BinaryPattern(1);
+   long idA = c.addSLMPattern("slm", a.data());
+   long idB = c.addSLMPattern("slm", b.data());
+
+   c.setSLMPattern("slm", idA);
+   REQUIRE(slm.fullImageCalls == 1);
+
+   // The sequence leaves the SLM showing some other frame, so setting the
+   // same pattern again must not be skipped or written as a region
+   c.loadSLMPatternSequence("slm", {idB});
+   c.setSLMPattern("slm", idA);
+   CHECK(slm.fullImageCalls == 2);
+
+   c.startSLMSequence("slm");
+   c.stopSLMSequence("slm");
+   c.setSLMPattern("slm", idA);
+   CHECK(slm.fullImageCalls == 3);
+
+   c.loadSLMSequence("slm", {b.data()});
+   c.setSLMPattern("slm", idA);
+   CHECK(slm.fullImageCalls == 4);
+   CHECK(slm.regionCalls == 0);
+   CHECK(slm.image == a);
+}
+
+TEST_CASE("SLM patterns keep the pixel format they were added in",
+      "[SLMPatternStore]") {
+   PatternSLM color(true);
+   color.bytesPerPixel = 4;
+   PatternSLM mono(false);
+   MockAdapterWithDevices adapter{{"color", &color}, {"mono", &mono}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   // An 8-bit pattern is width * height bytes, even for a 32-bit SLM
+   auto a = BinaryPattern(0);
+   long id8 = c.addSLMPattern("color", a.data());
+   CHECK(c.getSLMPatternStorageBytes() == width * height / 8);
+   std::vector<unsigned int> green(width * height, 0x00ff00);
+   long id32 = c.addSLMPattern("color", green.data());
+   CHECK(c.getSLMPatternStorageBytes() == width * height / 8 +
+      4 * width * height);
+
+   c.setSLMPattern("color", id8);
+   CHECK(color.fullImageCalls == 1);
+   CHECK(color.image == a);
+   c.setSLMPattern("color", id32);
+   CHECK(color.colorImageCalls == 1);
+   c.setSLMPattern("color", id8);
+   CHECK(color.fullImageCalls == 2);
+   CHECK(color.regionCalls == 0);
+
+   // IDs stand for pixels in the SLM's format, so are not passed here
+   c.loadSLMPatternSequence("color", {id8, id8});
+   CHECK(color.sequenceIds.empty());
+   CHECK(color.sequenceFrames ==
+      std::vector<std::vector<unsigned char>>{a, a});
+
+   c.setSLMPattern("mono", id8);
+   CHECK(mono.image == a);
+   CHECK_THROWS(c.setSLMPattern("mono", id32));
+}
@@ -0,0 +1,175 @@
+#include <catch2/catch_all.hpp>
+
+#include "MMCore.h"
+#include "../../MMDevice/DeviceBase.h"
+#include "MockDeviceUtils.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+class SequenceStage : public CStageBase<SequenceStage> {
+public:
+   explicit SequenceStage(bool bulk) : bulk_(bulk) {}
+
+   std::vector<double> loaded;
+   int bulkCalls = 0;
+   int elementCalls = 0;
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "SequenceStage");
+   }
+   int SetPositionUm(double) override { return DEVICE_OK; }
+   int GetPositionUm(double& pos) override { pos = 0.0; return DEVICE_OK; }
+   int SetPositionSteps(long) override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int GetPositionSteps(long&) override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int SetOrigin() override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int GetLimits(double&, double&) override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int IsStageSequenceable(bool& f) const override { f = true; return DEVICE_OK; }
+   bool IsContinuousFocusDrive() const override { return false; }
+
+   int ClearStageSequence() override {
+      pending_.clear();
+      return DEVICE_OK;
+   }
+   int AddToStageSequence(double position) override {
+      ++elementCalls;
+      pending_.push_back(position);
+      return DEVICE_OK;
+   }
+   int SendStageSequence() override {
+      loaded = pending_;
+      return DEVICE_OK;
+   }
+   int SetStageSequence(const double* positions, long numPositions) override {
+      if (!bulk_)
+         return DEVICE_UNSUPPORTED_COMMAND;
+      ++bulkCalls;
+      loaded.assign(positions, positions + numPositions);
+      return DEVICE_OK;
+   }
+
+private:
+   bool bulk_;
+   std::vector<double> pending_;
+};
+
+class SequenceXYStage : public CXYStageBase<SequenceXYStage> {
+public:
+   std::vector<double> loadedX, loadedY;
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "SequenceXYStage");
+   }
+   int SetPositionSteps(long, long) override { return DEVICE_OK; }
+   int GetPositionSteps(long& x, long& y) override { x = y = 0; return DEVICE_OK; }
+   int Home() override { return DEVICE_OK; }
+   int Stop() override { return DEVICE_OK; }
+   int SetOrigin() override { return DEVICE_OK; }
+   int GetLimitsUm(double&, double&, double&, double&) override {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
+   int GetStepLimits(long&, long&, long&, long&) override {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
+   double GetStepSizeXUm() override { return 1.0; }
+   double GetStepSizeYUm() override { return 1.0; }
+   int IsXYStageSequenceable(bool& f) const override { f = true; return DEVICE_OK; }
+
+   int SetXYStageSequence(const double* xs, const double* ys,
+         long numPositions) override {
+      loadedX.assign(xs, xs + numPositions);
+      loadedY.assign(ys, ys + numPositions);
+      return DEVICE_OK;
+   }
+};
+
+class SequenceGeneric : public CGenericBase<SequenceGeneric> {
+public:
+   std::vector<std::string> loaded;
+
+   SequenceGeneric() {
+      CreateStringProperty("Value", "a", false,
+         new CPropertyAction(this, &SequenceGeneric::OnValue));
+   }
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "SequenceGeneric");
+   }
+
+   int OnValue(MM::PropertyBase* pProp, MM::ActionType eAct) {
+      if (eAct == MM::IsSequenceable)
+         pProp->SetSequenceable(100);
+      else if (eAct == MM::AfterLoadSequence)
+         loaded = pProp->GetSequence();
+      return DEVICE_OK;
+   }
+};
+
+} // namespace
+
+TEST_CASE("Stage sequence is loaded in one call when supported",
+      "[SequenceLoading]") {
+   SequenceStage stage(true);
+   MockAdapterWithDevices adapter{{"z", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   std::vector<double> positions;
+   for (int i = 0; i < 1000; ++i)
+      positions.push_back(0.5 * i);
+   c.loadStageSequence("z", positions);
+   CHECK(stage.loaded == positions);
+   CHECK(stage.bulkCalls == 1);
+   CHECK(stage.elementCalls == 0);
+}
+
+TEST_CASE("Stage sequence falls back to one call per position",
+      "[SequenceLoading]") {
+   SequenceStage stage(false);
+   MockAdapterWithDevices adapter{{"z", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   const std::vector<double> positions{1.0, 2.0, 3.0};
+   c.loadStageSequence("z", positions);
+   CHECK(stage.loaded == positions);
+   CHECK(stage.elementCalls == 3);
+}
+
+TEST_CASE("XY stage sequence is loaded in one call", "[SequenceLoading]") {
+   SequenceXYStage stage;
+   MockAdapterWithDevices adapter{{"xy", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   c.loadXYStageSequence("xy", {1.0, 2.0, 3.0}, {4.0, 5.0, 6.0});
+   CHECK(stage.loadedX == std::vector<double>{1.0, 2.0, 3.0});
+   CHECK(stage.loadedY == std::vector<double>{4.0, 5.0, 6.0});
+}
+
+TEST_CASE("Property sequence is loaded in one call", "[SequenceLoading]") {
+   SequenceGeneric dev;
+   MockAdapterWithDevices adapter{{"gen", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   REQUIRE(c.isPropertySequenceable("gen", "Value"));
+   const std::vector<std::string> values{"x", "y", "z"};
+   c.loadPropertySequence("gen", "Value", values);
+   CHECK(dev.loaded == values);
+
+   // Too long for the device: the error comes back from the bulk call
+   CHECK_THROWS(c.loadPropertySequence("gen", "Value",
+      std::vector<std::string>(101, "x")));
+}
@@ -0,0 +1,160 @@
+#include <catch2/catch_all.hpp>
+
+#include "MMCore.h"
+#include "../../MMDevice/DeviceBase.h"
+#include "MockDeviceUtils.h"
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const long bufferLength = 10;
+
+// Stage with a small sequence buffer that is drained by Trigger(), which
+// stands in for the hardware trigger and runs on the test thread
+class StreamingStage : public CStageBase<StreamingStage> {
+public:
+   explicit StreamingStage(bool streaming) : streaming_(streaming) {}
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "StreamingStage");
+   }
+   int SetPositionUm(double) override { return DEVICE_OK; }
+   int GetPositionUm(double& pos) override { pos = 0.0; return DEVICE_OK; }
+   int SetPositionSteps(long) override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int GetPositionSteps(long&) override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int SetOrigin() override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int GetLimits(double&, double&) override { return DEVICE_UNSUPPORTED_COMMAND; }
+   int IsStageSequenceable(bool& f) const override { f = true; return DEVICE_OK; }
+   int GetStageSequenceMaxLength(long& n) const override {
+      n = bufferLength;
+      return DEVICE_OK;
+   }
+   bool IsContinuousFocusDrive() const override { return false; }
+
+   int StartStageSequence() override { return DEVICE_OK; }
+   int StopStageSequence() override { return DEVICE_OK; }
+   int ClearStageSequence() override {
+      std::lock_guard<std::mutex> lock(mutex_);
+      buffer_.clear();
+      return DEVICE_OK;
+   }
+   int AppendToStageSequence(const double* positions, long numPositions,
+         long& numAppended) override {
+      if (!streaming_)
+         return DEVICE_UNSUPPORTED_COMMAND;
+      std::lock_guard<std::mutex> lock(mutex_);
+      numAppended = (std::min)(numPositions,
+         bufferLength - static_cast<long>(buffer_.size()));
+      buffer_.insert(buffer_.end(), positions, positions + numAppended);
+      return DEVICE_OK;
+   }
+
+   // Moves to the next position; returns false if the buffer ran dry
+   bool Trigger() {
+      bool low;
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         if (buffer_.empty())
+            return false;
+         visited.push_back(buffer_.front());
+         buffer_.pop_front();
+         low = buffer_.size() == bufferLength / 2;
+      }
+      if (low)
+         OnSequenceBufferLow();
+      return true;
+   }
+
+   std::vector<double> visited;
+
+private:
+   bool streaming_;
+   std::mutex mutex_;
+   std::deque<double> buffer_;
+};
+
+// Triggers until the buffer stays empty for a while
+void RunStage(StreamingStage& stage) {
+   using namespace std::chrono;
+   auto idleSince = steady_clock::now();
+   while (steady_clock::now() - idleSince < milliseconds(500)) {
+      if (stage.Trigger())
+         idleSince = steady_clock::now();
+      else
+         std::this_thread::sleep_for(milliseconds(1));
+   }
+}
+
+} // namespace
+
+TEST_CASE("Streamed stage sequence longer than device buffer",
+      "[SequenceStreaming]") {
+   StreamingStage stage(true);
+   MockAdapterWithDevices adapter{{"z", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   std::vector<double> positions;
+   for (int i = 0; i < 1000; ++i)
+      positions.push_back(0.25 * i);
+   c.loadStreamingStageSequence("z", positions);
+   CHECK(c.getStreamingStageSequenceRemaining("z") ==
+      1000 - bufferLength);
+
+   c.startStageSequence("z");
+   RunStage(stage);
+   c.stopStageSequence("z");
+
+   CHECK(stage.visited == positions);
+   CHECK(c.getStreamingStageSequenceRemaining("z") == 0);
+}
+
+TEST_CASE("Streamed stage sequence that fits is loaded at once",
+      "[SequenceStreaming]") {
+   StreamingStage stage(true);
+   MockAdapterWithDevices adapter{{"z", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   const std::vector<double> positions{1.0, 2.0, 3.0};
+   c.loadStreamingStageSequence("z", positions);
+   CHECK(c.getStreamingStageSequenceRemaining("z") == 0);
+   RunStage(stage);
+   CHECK(stage.visited == positions);
+}
+
+TEST_CASE("Stopping a stage sequence cancels streaming",
+      "[SequenceStreaming]") {
+   StreamingStage stage(true);
+   MockAdapterWithDevices adapter{{"z", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   c.loadStreamingStageSequence("z", std::vector<double>(100, 1.0));
+   c.startStageSequence("z");
+   c.stopStageSequence("z");
+   CHECK(c.getStreamingStageSequenceRemaining("z") == 0);
+
+   // Only what was already in the device is left
+   RunStage(stage);
+   CHECK(stage.visited.size() == bufferLength);
+}
+
+TEST_CASE("Streamed sequence on stage without support throws",
+      "[SequenceStreaming]") {
+   StreamingStage stage(false);
+   MockAdapterWithDevices adapter{{"z", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   CHECK_THROWS(c.loadStreamingStageSequence("z", {1.0, 2.0}));
+   CHECK(c.getStreamingStageSequenceRemaining("z") == 0);
+}
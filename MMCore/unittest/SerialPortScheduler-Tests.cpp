@@ -0,0 +1,173 @@
+#include <catch2/catch_all.hpp>
+
+#include "SerialPortScheduler.h"
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using mm::SerialPortScheduler;
+
+namespace {
+
+struct OrderLog {
+   std::mutex mutex;
+   std::vector<std::string> order;
+
+   void Add(const std::string& entry) {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(entry);
+   }
+
+   void Use(SerialPortScheduler& sched, const std::string& client) {
+      SerialPortScheduler::Slot slot(sched, client);
+      Add(client);
+   }
+};
+
+// Returns once the given number of calls are queued for the port
+void AwaitWaiting(const SerialPortScheduler& sched, std::size_t n) {
+   while (sched.GetWaitingCalls() < n)
+      std::this_thread::yield();
+}
+
+}
+
+TEST_CASE("SerialPortScheduler records slices per client") {
+   SerialPortScheduler sched;
+   { SerialPortScheduler::Slot s(sched, "A"); }
+   { SerialPortScheduler::Slot s(sched, "B"); }
+   { SerialPortScheduler::Slot s(sched, "A"); }
+
+   auto stats = sched.GetStatistics();
+   REQUIRE(stats.size() == 2);
+   CHECK(stats[0].client == "A");
+   CHECK(stats[0].slices == 2);
+   CHECK(stats[1].client == "B");
+   CHECK(stats[1].slices == 1);
+
+   sched.ResetStatistics();
+   for (const auto& s : sched.GetStatistics())
+      CHECK(s.slices == 0);
+}
+
+TEST_CASE("SerialPortScheduler keeps the port from command to answer") {
+   SerialPortScheduler sched;
+   OrderLog log;
+   std::thread other;
+
+   {
+      SerialPortScheduler::Slot command(sched, "A");
+      CHECK_FALSE(command.WasHeld());
+      command.KeepHold(true);
+      log.Add("A command");
+   }
+
+   other = std::thread([&] { log.Use(sched, "B"); });
+   AwaitWaiting(sched, 1);
+
+   {
+      // Calls from the holder do not queue behind B
+      SerialPortScheduler::Slot answer(sched, "A");
+      CHECK(answer.WasHeld());
+      log.Add("A answer");
+   }
+   other.join();
+
+   CHECK(log.order ==
+      std::vector<std::string>{"A command", "A answer", "B"});
+   CHECK(sched.GetStatistics()[0].slices == 1);
+}
+
+TEST_CASE("SerialPortScheduler serves clients round-robin") {
+   SerialPortScheduler sched;
+
+   OrderLog log;
+   std::vector<std::thread> threads;
+   {
+      SerialPortScheduler::Slot held(sched, "C");
+      // "A" queues two calls before "B" queues one; "B" should not have to
+      // wait for both of A's.
+      std::size_t queued = 0;
+      for (const char* client : {"A", "A", "B"}) {
+         threads.emplace_back([&, client] { log.Use(sched, client); });
+         AwaitWaiting(sched, ++queued);
+      }
+   }
+   for (auto& t : threads)
+      t.join();
+
+   CHECK(log.order == std::vector<std::string>{"A", "B", "A"});
+}
+
+TEST_CASE("SerialPortScheduler drops a hold left idle") {
+   SerialPortScheduler sched;
+   {
+      // Command whose answer is never read
+      SerialPortScheduler::Slot command(sched, "A");
+      command.KeepHold(true);
+   }
+
+   const auto start = SerialPortScheduler::Clock::now();
+   { SerialPortScheduler::Slot s(sched, "B"); }
+   CHECK(SerialPortScheduler::Clock::now() - start >=
+      SerialPortScheduler::answerHoldTimeout);
+
+   // A's next call is a new hold
+   SerialPortScheduler::Slot again(sched, "A");
+   CHECK_FALSE(again.WasHeld());
+}
+
+TEST_CASE("SerialPortScheduler keeps the port through a transaction") {
+   SerialPortScheduler sched;
+   OrderLog log;
+   std::thread other;
+
+   sched.BeginTransaction("A");
+   other = std::thread([&] { log.Use(sched, "B"); });
+   AwaitWaiting(sched, 1);
+
+   for (int i = 0; i < 2; ++i) {
+      // Calls that would each end an exchange do not end the transaction
+      SerialPortScheduler::Slot call(sched, "A");
+      CHECK(call.WasHeld());
+      log.Add("A");
+   }
+   sched.EndTransaction("A");
+   other.join();
+
+   CHECK(log.order == std::vector<std::string>{"A", "A", "B"});
+
+   // Ending it again (or after the hold was dropped) does nothing
+   sched.EndTransaction("A");
+   SerialPortScheduler::Slot again(sched, "A");
+   CHECK_FALSE(again.WasHeld());
+}
+
+TEST_CASE("SerialPortScheduler serves clients with short holds first") {
+   SerialPortScheduler sched;
+   {
+      // "D" has held the port for long
+      SerialPortScheduler::Slot s(sched, "D");
+      std::this_thread::sleep_for(2 * SerialPortScheduler::shortSliceThreshold);
+   }
+
+   OrderLog log;
+   std::vector<std::thread> threads;
+   {
+      SerialPortScheduler::Slot held(sched, "C");
+      // Round-robin alone would serve "D" next
+      std::size_t queued = 0;
+      for (const char* client : {"D", "E"}) {
+         threads.emplace_back([&, client] { log.Use(sched, client); });
+         AwaitWaiting(sched, ++queued);
+      }
+   }
+   for (auto& t : threads)
+      t.join();
+
+   CHECK(log.order == std::vector<std::string>{"E", "D"});
+}
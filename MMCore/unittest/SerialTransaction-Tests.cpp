@@ -0,0 +1,210 @@
+#include <catch2/catch_all.hpp>
+#include <catch2/matchers/catch_matchers_vector.hpp>
+
+#include "MMCore.h"
+#include "../../MMDevice/DeviceBase.h"
+#include "MockDeviceUtils.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Simulated controller that answers each command with "ok <command>", and
+// records how many commands were outstanding at once.
+class MockControllerPort : public CSerialBase<MockControllerPort> {
+   std::deque<std::string> pending;
+
+public:
+   std::vector<std::string> received;
+   std::size_t maxPending = 0;
+   std::string failOn;
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "MockControllerPort");
+   }
+
+   MM::PortType GetPortType() const override { return MM::SerialPort; }
+   int SetCommand(const char* command, const char* term) override {
+      CHECK(std::string(term) == "\r");
+      if (command == failOn)
+         return DEVICE_SERIAL_COMMAND_FAILED;
+      received.push_back(command);
+      pending.push_back(std::string("ok ") + command);
+      maxPending = (std::max)(maxPending, pending.size());
+      return DEVICE_OK;
+   }
+   int GetAnswer(char* txt, unsigned maxChars, const char* term) override {
+      CHECK(std::string(term) == "\n");
+      if (pending.empty())
+         return DEVICE_SERIAL_TIMEOUT;
+      snprintf(txt, maxChars, "%s", pending.front().c_str());
+      pending.pop_front();
+      return DEVICE_OK;
+   }
+   int Write(const unsigned char*, unsigned long) override { return DEVICE_ERR; }
+   int Read(unsigned char*, unsigned long, unsigned long&) override { return DEVICE_ERR; }
+   int Purge() override { pending.clear(); return DEVICE_OK; }
+};
+
+// Binary port that echoes what is written to it.
+class MockEchoPort : public CSerialBase<MockEchoPort> {
+   std::vector<unsigned char> pending;
+
+public:
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "MockEchoPort");
+   }
+
+   MM::PortType GetPortType() const override { return MM::SerialPort; }
+   int SetCommand(const char*, const char*) override { return DEVICE_ERR; }
+   int GetAnswer(char*, unsigned, const char*) override { return DEVICE_ERR; }
+   int Write(const unsigned char* buf, unsigned long bufLen) override {
+      pending.insert(pending.end(), buf, buf + bufLen);
+      return DEVICE_OK;
+   }
+   int Read(unsigned char* buf, unsigned long bufLen, unsigned long& charsRead) override {
+      charsRead = (std::min)(bufLen, static_cast<unsigned long>(pending.size()));
+      std::copy(pending.begin(), pending.begin() + charsRead, buf);
+      pending.erase(pending.begin(), pending.begin() + charsRead);
+      return DEVICE_OK;
+   }
+   int Purge() override { pending.clear(); return DEVICE_OK; }
+};
+
+// Hub-style device that refreshes several axes in one transaction.
+class MockHub : public CGenericBase<MockHub> {
+public:
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "MockHub");
+   }
+
+   int QueryAxes(const std::vector<std::string>& commands,
+         std::vector<std::string>& answers) {
+      return SendSerialCommands("port", commands, "\r", "\n", answers);
+   }
+
+   int Exchange(unsigned char byte) {
+      int ret = WriteToComPort("port", &byte, 1);
+      if (ret != DEVICE_OK)
+         return ret;
+      unsigned long read;
+      return ReadFromComPort("port", &byte, 1, read);
+   }
+
+   int BeginTransaction() { return BeginSerialTransaction("port"); }
+   int EndTransaction() { return EndSerialTransaction("port"); }
+};
+
+// Number of times the port was granted to the client
+std::uint64_t Slices(CMMCore& c, const std::string& client) {
+   const std::string stats = c.getSerialPortStatistics("port");
+   const auto pos = stats.find(client + ": ");
+   REQUIRE(pos != std::string::npos);
+   return std::stoull(stats.substr(pos + client.size() + 2));
+}
+
+}
+
+TEST_CASE("transactSerialPortCommands writes all commands before reading") {
+   MockControllerPort port;
+   MockAdapterWithDevices adapter{{"port", &port}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   std::vector<std::string> commands{"WHERE X", "WHERE Y", "WHERE Z"};
+   auto answers = c.transactSerialPortCommands("port", commands, "\r", "\n");
+   CHECK_THAT(answers, Catch::Matchers::Equals(std::vector<std::string>{
+      "ok WHERE X", "ok WHERE Y", "ok WHERE Z"}));
+   CHECK(port.received == commands);
+   CHECK(port.maxPending == 3);
+}
+
+TEST_CASE("transactSerialPortCommands with no commands") {
+   MockControllerPort port;
+   MockAdapterWithDevices adapter{{"port", &port}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   CHECK(c.transactSerialPortCommands("port", {}, "\r", "\n").empty());
+   CHECK(port.received.empty());
+}
+
+TEST_CASE("transactSerialPortCommands requires an answer terminator") {
+   MockControllerPort port;
+   MockAdapterWithDevices adapter{{"port", &port}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   CHECK_THROWS_AS(c.transactSerialPortCommands("port", {"A"}, "\r", ""),
+      CMMError);
+   CHECK(port.received.empty());
+}
+
+TEST_CASE("Failed transaction does not leave answers for the next one") {
+   MockControllerPort port;
+   port.failOn = "BAD";
+   MockAdapterWithDevices adapter{{"port", &port}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   CHECK_THROWS_AS(c.transactSerialPortCommands("port",
+      {"WHERE X", "WHERE Y", "BAD"}, "\r", "\n"), CMMError);
+
+   auto answers = c.transactSerialPortCommands("port", {"WHERE Z"}, "\r", "\n");
+   CHECK_THAT(answers, Catch::Matchers::Equals(std::vector<std::string>{
+      "ok WHERE Z"}));
+}
+
+TEST_CASE("Device can send pipelined serial commands through the core") {
+   MockControllerPort port;
+   MockHub hub;
+   MockAdapterWithDevices adapter{{"port", &port}, {"hub", &hub}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   std::vector<std::string> answers;
+   REQUIRE(hub.QueryAxes({"STATUS 1", "STATUS 2"}, answers) == DEVICE_OK);
+   CHECK_THAT(answers, Catch::Matchers::Equals(std::vector<std::string>{
+      "ok STATUS 1", "ok STATUS 2"}));
+   CHECK(port.maxPending == 2);
+}
+
+TEST_CASE("Reading a binary reply releases the port") {
+   MockEchoPort port;
+   MockHub hub;
+   MockAdapterWithDevices adapter{{"port", &port}, {"hub", &hub}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   REQUIRE(hub.Exchange(1) == DEVICE_OK);
+   REQUIRE(hub.Exchange(2) == DEVICE_OK);
+   CHECK(Slices(c, "hub") == 2);
+}
+
+TEST_CASE("Device keeps the port through a serial transaction") {
+   MockEchoPort port;
+   MockHub hub;
+   MockAdapterWithDevices adapter{{"port", &port}, {"hub", &hub}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   REQUIRE(hub.BeginTransaction() == DEVICE_OK);
+   REQUIRE(hub.Exchange(1) == DEVICE_OK);
+   REQUIRE(hub.Exchange(2) == DEVICE_OK);
+   REQUIRE(hub.EndTransaction() == DEVICE_OK);
+   REQUIRE(hub.Exchange(3) == DEVICE_OK);
+   CHECK(Slices(c, "hub") == 2);
+}
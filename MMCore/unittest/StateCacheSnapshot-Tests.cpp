@@ -0,0 +1,63 @@
+#include <catch2/catch_all.hpp>
+
+#include "MMCore.h"
+#include "../../MMDevice/DeviceBase.h"
+#include "MockDeviceUtils.h"
+
+#include <string>
+
+namespace {
+
+class MockGeneric : public CGenericBase<MockGeneric> {
+public:
+   MockGeneric() {
+      CreateStringProperty("Text", "plain", false);
+      CreateIntegerProperty("Number", 1, false);
+   }
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* name) const override {
+      snprintf(name, MM::MaxStrLength, "MockGeneric");
+   }
+};
+
+} // namespace
+
+TEST_CASE("State cache version changes only when a value changes") {
+   MockGeneric dev;
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.updateSystemStateCache();
+
+   const long v0 = c.getSystemStateCacheVersion();
+   c.setProperty("dev", "Number", "1");
+   CHECK(c.getSystemStateCacheVersion() == v0);
+   c.setProperty("dev", "Number", "2");
+   const long v1 = c.getSystemStateCacheVersion();
+   CHECK(v1 != v0);
+   c.updateSystemStateCache();
+   CHECK(c.getSystemStateCacheVersion() != v1);
+}
+
+TEST_CASE("State cache JSON reflects the cache") {
+   MockGeneric dev;
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.updateSystemStateCache();
+
+   using Catch::Matchers::ContainsSubstring;
+   const std::string json = c.getSystemStateCacheJSON();
+   CHECK(json.front() == '{');
+   CHECK(json.back() == '}');
+   CHECK_THAT(json, ContainsSubstring("\"dev-Text\":\"plain\""));
+   CHECK_THAT(json, ContainsSubstring("\"dev-Number\":\"1\""));
+   CHECK(c.getSystemStateCacheJSON() == json);
+
+   c.setProperty("dev", "Text", "say \"hi\"\\");
+   CHECK_THAT(c.getSystemStateCacheJSON(),
+      ContainsSubstring("\"dev-Text\":\"say \\\"hi\\\"\\\\\""));
+}
@@ -510,6 +510,56 @@
    }
 }
 
+// Java typemap
+// map the pinned-image functions to direct ByteBuffers (in native byte order)
+// that point into the circular buffer, instead of copying the pixels; the
+// buffer must be passed to releasePinnedImage() once it is no longer used
+//
+// Assumes that class has the following method defined:
+// long getImageBufferSize()
+
+%typemap(jni) void* getLastImagePinned, void* popNextImagePinned, void* popNextImageMDPinned "jobject"
+%typemap(jtype) void* getLastImagePinned, void* popNextImagePinned, void* popNextImageMDPinned "java.nio.ByteBuffer"
+%typemap(jstype) void* getLastImagePinned, void* popNextImagePinned, void* popNextImageMDPinned "java.nio.ByteBuffer"
+%typemap(javaout) void* getLastImagePinned, void* popNextImagePinned, void* popNextImageMDPinned {
+   java.nio.ByteBuffer buffer = $jnicall;
+   if (buffer != null)
+      buffer.order(java.nio.ByteOrder.nativeOrder());
+   return buffer;
+}
+%typemap(out) void* getLastImagePinned, void* popNextImagePinned, void* popNextImageMDPinned
+{
+   $result = JCALL2(NewDirectByteBuffer, jenv, result, (jlong)(arg1)->getImageBufferSize());
+   if ($result == 0)
+   {
+      // Do not leave the image pinned if it cannot be returned
+      (arg1)->releasePinnedImage(result);
+      if (!jenv->ExceptionCheck())
+      {
+         jclass excep = jenv->FindClass("java/lang/UnsupportedOperationException");
+         if (excep)
+            jenv->ThrowNew(excep, "Direct buffer access is not supported by the JVM");
+      }
+      return $result;
+   }
+}
+
+%typemap(jni) void* pinnedPixels "jobject"
+%typemap(jtype) void* pinnedPixels "java.nio.ByteBuffer"
+%typemap(jstype) void* pinnedPixels "java.nio.ByteBuffer"
+%typemap(javain) void* pinnedPixels "$javainput"
+%typemap(in) void* pinnedPixels
+{
+   $1 = $input ? JCALL1(GetDirectBufferAddress, jenv, $input) : 0;
+   if ($1 == 0)
+   {
+      jclass excep = jenv->FindClass("java/lang/IllegalArgumentException");
+      if (excep)
+         jenv->ThrowNew(excep, "Not a pinned image buffer");
+      return $null;
+   }
+}
+
 // Java typemap
 // change default SWIG mapping of void* return values
 // to return CObject containing array of pixel values
@@ -651,6 +701,20 @@
       includeSystemStateCache_ = state;
    }
 
+   // The system state cache as tags, shared by all images taken while the
+   // cache does not change (see getSystemStateCacheVersion())
+   private JSONObject stateCacheTags_ = null;
+   private int stateCacheTagsVersion_;
+
+   private synchronized JSONObject getSystemStateCacheTags() throws java.lang.Exception {
+      int version = getSystemStateCacheVersion();
+      if (stateCacheTags_ == null || version != stateCacheTagsVersion_) {
+         stateCacheTags_ = new JSONObject(getSystemStateCacheJSON());
+         stateCacheTagsVersion_ = version;
+      }
+      return stateCacheTags_;
+   }
+
 
    private JSONObject metadataToMap(Metadata md) {
       JSONObject tags = new JSONObject();
@@ -732,14 +796,11 @@
 
    private TaggedImage createTaggedImage(Object pixels, Metadata md) throws java.lang.Exception {
       JSONObject tags = metadataToMap(md);
-      PropertySetting setting;
       if (includeSystemStateCache_) {
-         Configuration config = getSystemStateCache();
-         for (int i = 0; i < config.size(); ++i) {
-            setting = config.getSetting(i);
-            String key = setting.getDeviceLabel() + "-" + setting.getPropertyName();
-            String value = setting.getPropertyValue();
-             tags.put(key, value);
+         JSONObject state = getSystemStateCacheTags();
+         for (java.util.Iterator<String> it = state.keys(); it.hasNext(); ) {
+            String key = it.next();
+            tags.put(key, state.get(key));
          }
       }
       tags.put("BitDepth", getImageBitDepth());
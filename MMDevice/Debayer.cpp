@@ -25,7 +25,624 @@
 
 #include "Debayer.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DEBAYER_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+// The AVX2 kernels are compiled regardless of the target flags and selected
+// at run time.
+#if defined(DEBAYER_HAVE_SSE2) && (defined(_MSC_VER) || defined(__GNUC__))
+#define DEBAYER_HAVE_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define DEBAYER_TARGET_AVX2
+#else
+#define DEBAYER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Single-pass demosaicing kernels
+///////////////////////////////////////////////////////////////////////////////
+//
+// All kernels read the raw mosaic once and write the packed 32-bit output
+// (bytes B, G, R, 0) directly, one band of rows per thread. Pixels whose
+// neighborhood extends past the image edge are handled by a slower path that
+// mirrors the coordinates (without repeating the edge pixel, which preserves
+// the Bayer phase); everything else uses unchecked indexing.
+
+namespace {
+
+// Position (column and row parity) of the red sample in each 2x2 cell. The
+// blue sample is always at (1 - rx, 1 - ry).
+struct BayerLayout
+{
+   int rx;
+   int ry;
+};
+
+BayerLayout LayoutForOrder(int rowOrder)
+{
+   BayerLayout layout;
+   switch (rowOrder)
+   {
+      case 1: layout.rx = 1; layout.ry = 1; break; // B-G-B-G
+      case 2: layout.rx = 0; layout.ry = 1; break; // G-R-G-R
+      case 3: layout.rx = 1; layout.ry = 0; break; // G-B-G-B
+      default: layout.rx = 0; layout.ry = 0; break; // R-G-R-G
+   }
+   return layout;
+}
+
+enum BayerSite
+{
+   SiteRed,
+   SiteBlue,
+   SiteGreenInRedRow,
+   SiteGreenInBlueRow,
+};
+
+inline BayerSite SiteAt(int x, int y, const BayerLayout& layout)
+{
+   const bool redRow = (y & 1) == layout.ry;
+   const bool colorColumn = (x & 1) == (redRow ? layout.rx : 1 - layout.rx);
+   if (redRow)
+      return colorColumn ? SiteRed : SiteGreenInRedRow;
+   return colorColumn ? SiteBlue : SiteGreenInBlueRow;
+}
+
+inline int Reflect101(int i, int n)
+{
+   if (n == 1)
+      return 0;
+   while (i < 0 || i >= n)
+   {
+      if (i < 0)
+         i = -i;
+      if (i >= n)
+         i = 2 * (n - 1) - i;
+   }
+   return i;
+}
+
+template <typename T>
+struct DirectView
+{
+   const T* pixels;
+   int width;
+   int height;
+   int operator()(int x, int y) const { return pixels[y * width + x]; }
+};
+
+template <typename T>
+struct MirroredView
+{
+   const T* pixels;
+   int width;
+   int height;
+   int operator()(int x, int y) const
+   { return pixels[Reflect101(y, height) * width + Reflect101(x, width)]; }
+};
+
+inline void StorePixel(unsigned char* out, int r, int g, int b, int shift)
+{
+   out[0] = (unsigned char)(b >> shift);
+   out[1] = (unsigned char)(g >> shift);
+   out[2] = (unsigned char)(r >> shift);
+   out[3] = 0;
+}
+
+//
+// Replication: each color plane is filled by copying the nearest sample up
+// and to the left. Pixels with no such sample (first row or column of the
+// plane) are black. This is bit-for-bit what the original implementation
+// produced.
+//
+
+template <typename T>
+void ReplicateRows(const T* in, unsigned char* out, int width, int shift,
+   const BayerLayout& layout, int y0, int y1)
+{
+   const int bx = 1 - layout.rx;
+   const int by = 1 - layout.ry;
+   for (int y = y0; y < y1; ++y)
+   {
+      const T* redRow = y < layout.ry ? 0 :
+         in + (layout.ry + ((y - layout.ry) & ~1)) * width;
+      const T* blueRow = y < by ? 0 : in + (by + ((y - by) & ~1)) * width;
+      const T* greenRow = in + y * width;
+      const int gx = ((y & 1) == layout.ry) ? 1 - layout.rx : layout.rx;
+      unsigned char* o = out + 4 * y * width;
+
+      // Every plane has a sample at or left of x for all x >= 1
+      const int x1 = (redRow && blueRow) ? (std::min)(1, width) : width;
+      for (int x = 0; x < x1; ++x)
+      {
+         const int r = (!redRow || x < layout.rx) ? 0 :
+            redRow[layout.rx + ((x - layout.rx) & ~1)];
+         const int b = (!blueRow || x < bx) ? 0 : blueRow[bx + ((x - bx) & ~1)];
+         const int g = x < gx ? 0 : greenRow[gx + ((x - gx) & ~1)];
+         StorePixel(o + 4 * x, r, g, b, shift);
+      }
+      if (x1 == width)
+         continue;
+
+      // From odd x on, a plane sampled in odd columns repeats column x for
+      // both x and x + 1; one sampled in even columns uses x - 1 and x + 1.
+      const int rl = layout.rx == 1 ? 0 : -1, rr = -rl;
+      const int gl = gx == 1 ? 0 : -1, gr = -gl;
+      const int bl = bx == 1 ? 0 : -1, br = -bl;
+      int x = 1;
+      for (; x + 1 < width; x += 2)
+      {
+         StorePixel(o + 4 * x, redRow[x + rl], greenRow[x + gl], blueRow[x + bl], shift);
+         StorePixel(o + 4 * x + 4, redRow[x + rr], greenRow[x + gr], blueRow[x + br], shift);
+      }
+      if (x < width)
+         StorePixel(o + 4 * x, redRow[x + rl], greenRow[x + gl], blueRow[x + bl], shift);
+   }
+}
+
+//
+// Bilinear: missing colors are the rounded mean of the nearest 2 or 4
+// samples of that color.
+//
+
+template <typename View>
+inline void BilinearPixel(const View& v, int x, int y, const BayerLayout& layout,
+   int& r, int& g, int& b)
+{
+   const int c = v(x, y);
+   switch (SiteAt(x, y, layout))
+   {
+      case SiteRed:
+      case SiteBlue:
+      {
+         const int plus = (v(x - 1, y) + v(x + 1, y) + v(x, y - 1) + v(x, y + 1) + 2) >> 2;
+         const int cross = (v(x - 1, y - 1) + v(x + 1, y - 1) +
+            v(x - 1, y + 1) + v(x + 1, y + 1) + 2) >> 2;
+         g = plus;
+         if (SiteAt(x, y, layout) == SiteRed) { r = c; b = cross; }
+         else { b = c; r = cross; }
+         break;
+      }
+      case SiteGreenInRedRow:
+         g = c;
+         r = (v(x - 1, y) + v(x + 1, y) + 1) >> 1;
+         b = (v(x, y - 1) + v(x, y + 1) + 1) >> 1;
+         break;
+      case SiteGreenInBlueRow:
+         g = c;
+         b = (v(x - 1, y) + v(x + 1, y) + 1) >> 1;
+         r = (v(x, y - 1) + v(x, y + 1) + 1) >> 1;
+         break;
+   }
+}
+
+#ifdef DEBAYER_HAVE_SSE2
+
+inline __m128i Load4(const unsigned char* p)
+{
+   int packed;
+   memcpy(&packed, p, sizeof(packed));
+   const __m128i zero = _mm_setzero_si128();
+   return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+}
+
+inline __m128i Load4(const unsigned short* p)
+{
+   return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)),
+      _mm_setzero_si128());
+}
+
+inline __m128i Select4(__m128i mask, __m128i a, __m128i b)
+{
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Bilinear interpolation of interior row y (0 < y < height - 1), 4 pixels at
+// a time starting at x = 1. Returns the first x not processed.
+template <typename T>
+int BilinearRowSSE2(const T* in, unsigned char* out, int width, int y,
+   const BayerLayout& layout, int shift)
+{
+   const T* up = in + (y - 1) * width;
+   const T* mid = in + y * width;
+   const T* down = in + (y + 1) * width;
+   const bool redRow = (y & 1) == layout.ry;
+   const int colorParity = redRow ? layout.rx : 1 - layout.rx;
+   // Lanes hold x, x+1, x+2, x+3 with x odd
+   const __m128i colorSite = colorParity == 1 ?
+      _mm_set_epi32(0, -1, 0, -1) : _mm_set_epi32(-1, 0, -1, 0);
+   const __m128i one = _mm_set1_epi32(1);
+   const __m128i two = _mm_set1_epi32(2);
+   const __m128i byteMask = _mm_set1_epi32(0xff);
+   const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+
+   int x = 1;
+   for (; x + 4 <= width - 1; x += 4)
+   {
+      const __m128i c = Load4(mid + x);
+      const __m128i left = Load4(mid + x - 1);
+      const __m128i right = Load4(mid + x + 1);
+      const __m128i above = Load4(up + x);
+      const __m128i below = Load4(down + x);
+      const __m128i horiz = _mm_add_epi32(left, right);
+      const __m128i vert = _mm_add_epi32(above, below);
+      const __m128i diag = _mm_add_epi32(
+         _mm_add_epi32(Load4(up + x - 1), Load4(up + x + 1)),
+         _mm_add_epi32(Load4(down + x - 1), Load4(down + x + 1)));
+
+      const __m128i h = _mm_srli_epi32(_mm_add_epi32(horiz, one), 1);
+      const __m128i v = _mm_srli_epi32(_mm_add_epi32(vert, one), 1);
+      const __m128i plus = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(horiz, vert), two), 2);
+      const __m128i cross = _mm_srli_epi32(_mm_add_epi32(diag, two), 2);
+
+      const __m128i sameColor = Select4(colorSite, c, h);
+      const __m128i otherColor = Select4(colorSite, cross, v);
+      __m128i g = Select4(colorSite, plus, c);
+      __m128i r = redRow ? sameColor : otherColor;
+      __m128i b = redRow ? otherColor : sameColor;
+
+      r = _mm_and_si128(_mm_srl_epi32(r, shiftCount), byteMask);
+      g = _mm_and_si128(_mm_srl_epi32(g, shiftCount), byteMask);
+      b = _mm_and_si128(_mm_srl_epi32(b, shiftCount), byteMask);
+      const __m128i packed = _mm_or_si128(b,
+         _mm_or_si128(_mm_slli_epi32(g, 8), _mm_slli_epi32(r, 16)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * (y * width + x)), packed);
+   }
+   return x;
+}
+
+#endif // DEBAYER_HAVE_SSE2
+
+#ifdef DEBAYER_HAVE_AVX2
+
+DEBAYER_TARGET_AVX2 inline __m256i Load8(const unsigned char* p)
+{
+   return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+}
+
+DEBAYER_TARGET_AVX2 inline __m256i Load8(const unsigned short* p)
+{
+   return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+// Same as BilinearRowSSE2(), 8 pixels at a time.
+template <typename T>
+DEBAYER_TARGET_AVX2 int BilinearRowAVX2(const T* in, unsigned char* out,
+   int width, int y, const BayerLayout& layout, int shift)
+{
+   const T* up = in + (y - 1) * width;
+   const T* mid = in + y * width;
+   const T* down = in + (y + 1) * width;
+   const bool redRow = (y & 1) == layout.ry;
+   const int colorParity = redRow ? layout.rx : 1 - layout.rx;
+   const __m256i colorSite = colorParity == 1 ?
+      _mm256_set_epi32(0, -1, 0, -1, 0, -1, 0, -1) :
+      _mm256_set_epi32(-1, 0, -1, 0, -1, 0, -1, 0);
+   const __m256i one = _mm256_set1_epi32(1);
+   const __m256i two = _mm256_set1_epi32(2);
+   const __m256i byteMask = _mm256_set1_epi32(0xff);
+   const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+
+   int x = 1;
+   for (; x + 8 <= width - 1; x += 8)
+   {
+      const __m256i c = Load8(mid + x);
+      const __m256i horiz = _mm256_add_epi32(Load8(mid + x - 1), Load8(mid + x + 1));
+      const __m256i vert = _mm256_add_epi32(Load8(up + x), Load8(down + x));
+      const __m256i diag = _mm256_add_epi32(
+         _mm256_add_epi32(Load8(up + x - 1), Load8(up + x + 1)),
+         _mm256_add_epi32(Load8(down + x - 1), Load8(down + x + 1)));
+
+      const __m256i h = _mm256_srli_epi32(_mm256_add_epi32(horiz, one), 1);
+      const __m256i v = _mm256_srli_epi32(_mm256_add_epi32(vert, one), 1);
+      const __m256i plus = _mm256_srli_epi32(
+         _mm256_add_epi32(_mm256_add_epi32(horiz, vert), two), 2);
+      const __m256i cross = _mm256_srli_epi32(_mm256_add_epi32(diag, two), 2);
+
+      const __m256i sameColor = _mm256_blendv_epi8(h, c, colorSite);
+      const __m256i otherColor = _mm256_blendv_epi8(v, cross, colorSite);
+      __m256i g = _mm256_blendv_epi8(c, plus, colorSite);
+      __m256i r = redRow ? sameColor : otherColor;
+      __m256i b = redRow ? otherColor : sameColor;
+
+      r = _mm256_and_si256(_mm256_srl_epi32(r, shiftCount), byteMask);
+      g = _mm256_and_si256(_mm256_srl_epi32(g, shiftCount), byteMask);
+      b = _mm256_and_si256(_mm256_srl_epi32(b, shiftCount), byteMask);
+      const __m256i packed = _mm256_or_si256(b,
+         _mm256_or_si256(_mm256_slli_epi32(g, 8), _mm256_slli_epi32(r, 16)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4 * (y * width + x)), packed);
+   }
+   return x;
+}
+
+bool CpuSupportsAVX2()
+{
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 0);
+   if (info[0] < 7)
+      return false;
+   __cpuid(info, 1);
+   const bool osxsave = (info[2] & (1 << 27)) != 0;
+   const bool avx = (info[2] & (1 << 28)) != 0;
+   if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+      return false;
+   __cpuidex(info, 7, 0);
+   return (info[1] & (1 << 5)) != 0;
+#else
+   return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // DEBAYER_HAVE_AVX2
+
+enum SimdLevel
+{
+   SimdNone,
+   SimdSSE2,
+   SimdAVX2,
+};
+
+SimdLevel DetectSimdLevel()
+{
+#if defined(DEBAYER_HAVE_AVX2)
+   if (CpuSupportsAVX2())
+      return SimdAVX2;
+#endif
+#if defined(DEBAYER_HAVE_SSE2)
+   return SimdSSE2;
+#else
+   return SimdNone;
+#endif
+}
+
+template <typename T>
+void BilinearRows(const T* in, unsigned char* out, int width, int height, int shift,
+   const BayerLayout& layout, SimdLevel simd, int y0, int y1)
+{
+   const DirectView<T> direct = { in, width, height };
+   const MirroredView<T> mirrored = { in, width, height };
+   int r = 0, g = 0, b = 0;
+   for (int y = y0; y < y1; ++y)
+   {
+      unsigned char* o = out + 4 * y * width;
+      if (y < 1 || y >= height - 1 || width < 3)
+      {
+         for (int x = 0; x < width; ++x)
+         {
+            BilinearPixel(mirrored, x, y, layout, r, g, b);
+            StorePixel(o + 4 * x, r, g, b, shift);
+         }
+         continue;
+      }
+
+      BilinearPixel(mirrored, 0, y, layout, r, g, b);
+      StorePixel(o, r, g, b, shift);
+      int x = 1;
+#ifdef DEBAYER_HAVE_AVX2
+      if (simd == SimdAVX2)
+         x = BilinearRowAVX2(in, out, width, y, layout, shift);
+#endif
+#ifdef DEBAYER_HAVE_SSE2
+      if (simd == SimdSSE2)
+         x = BilinearRowSSE2(in, out, width, y, layout, shift);
+#endif
+      (void)simd;
+      for (; x < width - 1; ++x)
+      {
+         BilinearPixel(direct, x, y, layout, r, g, b);
+         StorePixel(o + 4 * x, r, g, b, shift);
+      }
+      BilinearPixel(mirrored, width - 1, y, layout, r, g, b);
+      StorePixel(o + 4 * (width - 1), r, g, b, shift);
+   }
+}
+
+//
+// Malvar-He-Cutler: bilinear interpolation corrected by the Laplacian of the
+// channel that was sampled at the pixel (IEEE ICASSP 2004, "High-quality
+// linear interpolation for demosaicing of Bayer-patterned color images").
+// The published 5x5 filters have weights in multiples of 1/16 when scaled by
+// 2, so they are evaluated in integer arithmetic.
+//
+
+template <BayerSite Site, typename View>
+inline void MalvarPixel(const View& v, int x, int y, int maxValue, unsigned char* out, int shift)
+{
+   const int c = v(x, y);
+   const int n2v = v(x, y - 2) + v(x, y + 2);
+   const int n2h = v(x - 2, y) + v(x + 2, y);
+   const int horiz = v(x - 1, y) + v(x + 1, y);
+   const int vert = v(x, y - 1) + v(x, y + 1);
+   const int diag = v(x - 1, y - 1) + v(x + 1, y - 1) + v(x - 1, y + 1) + v(x + 1, y + 1);
+
+   int s0, s1;
+   if (Site == SiteRed || Site == SiteBlue)
+   {
+      s0 = 8 * c + 4 * (horiz + vert) - 2 * (n2v + n2h); // green
+      s1 = 12 * c + 4 * diag - 3 * (n2v + n2h); // opposite color
+   }
+   else
+   {
+      s0 = 10 * c + 8 * horiz - 2 * (n2h + diag) + n2v; // color in this row
+      s1 = 10 * c + 8 * vert - 2 * (n2v + diag) + n2h; // color in this column
+   }
+   s0 = s0 < 0 ? 0 : (std::min)((s0 + 8) >> 4, maxValue);
+   s1 = s1 < 0 ? 0 : (std::min)((s1 + 8) >> 4, maxValue);
+
+   switch (Site)
+   {
+      case SiteRed: StorePixel(out, c, s0, s1, shift); break;
+      case SiteBlue: StorePixel(out, s1, s0, c, shift); break;
+      case SiteGreenInRedRow: StorePixel(out, s0, c, s1, shift); break;
+      case SiteGreenInBlueRow: StorePixel(out, s1, c, s0, shift); break;
+   }
+}
+
+template <typename View>
+inline void MalvarPixelAt(const View& v, int x, int y, const BayerLayout& layout,
+   int maxValue, unsigned char* out, int shift)
+{
+   switch (SiteAt(x, y, layout))
+   {
+      case SiteRed: MalvarPixel<SiteRed>(v, x, y, maxValue, out, shift); break;
+      case SiteBlue: MalvarPixel<SiteBlue>(v, x, y, maxValue, out, shift); break;
+      case SiteGreenInRedRow: MalvarPixel<SiteGreenInRedRow>(v, x, y, maxValue, out, shift); break;
+      case SiteGreenInBlueRow: MalvarPixel<SiteGreenInBlueRow>(v, x, y, maxValue, out, shift); break;
+   }
+}
+
+// Pixels x0 <= x < width - 2 (x0 even) of an interior row, whose even and
+// odd columns are of site types EvenSite and OddSite.
+template <BayerSite EvenSite, BayerSite OddSite, typename T>
+void MalvarInteriorRow(const DirectView<T>& v, int x0, int y, int maxValue,
+   unsigned char* rowOut, int shift)
+{
+   int x = x0;
+   for (; x + 1 < v.width - 2; x += 2)
+   {
+      MalvarPixel<EvenSite>(v, x, y, maxValue, rowOut + 4 * x, shift);
+      MalvarPixel<OddSite>(v, x + 1, y, maxValue, rowOut + 4 * x + 4, shift);
+   }
+   if (x < v.width - 2)
+      MalvarPixel<EvenSite>(v, x, y, maxValue, rowOut + 4 * x, shift);
+}
+
+#ifdef DEBAYER_HAVE_AVX2
+
+// Malvar-He-Cutler interpolation of interior row y (2 <= y < height - 2),
+// 8 pixels at a time starting at x = 2. Both the color-site and green-site
+// filters are evaluated for every lane and the results selected by column
+// parity. Returns the first x not processed (always even).
+template <typename T>
+DEBAYER_TARGET_AVX2 int MalvarRowAVX2(const T* in, unsigned char* out, int width,
+   int y, const BayerLayout& layout, int maxValue, int shift)
+{
+   const T* up2 = in + (y - 2) * width;
+   const T* up = in + (y - 1) * width;
+   const T* mid = in + y * width;
+   const T* down = in + (y + 1) * width;
+   const T* down2 = in + (y + 2) * width;
+   const bool redRow = (y & 1) == layout.ry;
+   const int colorParity = redRow ? layout.rx : 1 - layout.rx;
+   // Lanes hold x, ..., x+7 with x even
+   const __m256i colorSite = colorParity == 0 ?
+      _mm256_set_epi32(0, -1, 0, -1, 0, -1, 0, -1) :
+      _mm256_set_epi32(-1, 0, -1, 0, -1, 0, -1, 0);
+   const __m256i zero = _mm256_setzero_si256();
+   const __m256i eight = _mm256_set1_epi32(8);
+   const __m256i maxv = _mm256_set1_epi32(maxValue);
+   const __m256i byteMask = _mm256_set1_epi32(0xff);
+   const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+
+   int x = 2;
+   for (; x + 8 <= width - 2; x += 8)
+   {
+      const __m256i c = Load8(mid + x);
+      const __m256i n2v = _mm256_add_epi32(Load8(up2 + x), Load8(down2 + x));
+      const __m256i n2h = _mm256_add_epi32(Load8(mid + x - 2), Load8(mid + x + 2));
+      const __m256i horiz = _mm256_add_epi32(Load8(mid + x - 1), Load8(mid + x + 1));
+      const __m256i vert = _mm256_add_epi32(Load8(up + x), Load8(down + x));
+      const __m256i diag = _mm256_add_epi32(
+         _mm256_add_epi32(Load8(up + x - 1), Load8(up + x + 1)),
+         _mm256_add_epi32(Load8(down + x - 1), Load8(down + x + 1)));
+      const __m256i c2 = _mm256_slli_epi32(c, 1);
+      const __m256i c8 = _mm256_slli_epi32(c, 3);
+      const __m256i n2 = _mm256_add_epi32(n2v, n2h);
+
+      // Color site: green, and the opposite color
+      const __m256i greenAtColor = _mm256_sub_epi32(
+         _mm256_add_epi32(c8, _mm256_slli_epi32(_mm256_add_epi32(horiz, vert), 2)),
+         _mm256_slli_epi32(n2, 1));
+      const __m256i oppositeAtColor = _mm256_sub_epi32(
+         _mm256_add_epi32(_mm256_add_epi32(c8, _mm256_slli_epi32(c, 2)),
+            _mm256_slli_epi32(diag, 2)),
+         _mm256_add_epi32(n2, _mm256_slli_epi32(n2, 1)));
+      // Green site: color of this row, and color of this column
+      const __m256i rowAtGreen = _mm256_add_epi32(
+         _mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(c8, c2), _mm256_slli_epi32(horiz, 3)),
+            _mm256_slli_epi32(_mm256_add_epi32(n2h, diag), 1)),
+         n2v);
+      const __m256i columnAtGreen = _mm256_add_epi32(
+         _mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(c8, c2), _mm256_slli_epi32(vert, 3)),
+            _mm256_slli_epi32(_mm256_add_epi32(n2v, diag), 1)),
+         n2h);
+
+      __m256i s0 = _mm256_blendv_epi8(rowAtGreen, greenAtColor, colorSite);
+      __m256i s1 = _mm256_blendv_epi8(columnAtGreen, oppositeAtColor, colorSite);
+      s0 = _mm256_min_epi32(_mm256_srai_epi32(
+         _mm256_add_epi32(_mm256_max_epi32(s0, zero), eight), 4), maxv);
+      s1 = _mm256_min_epi32(_mm256_srai_epi32(
+         _mm256_add_epi32(_mm256_max_epi32(s1, zero), eight), 4), maxv);
+
+      // At color sites s0 is green; at green sites it is this row's color
+      const __m256i sameColor = _mm256_blendv_epi8(s0, c, colorSite);
+      __m256i g = _mm256_blendv_epi8(c, s0, colorSite);
+      __m256i r = redRow ? sameColor : s1;
+      __m256i b = redRow ? s1 : sameColor;
+
+      r = _mm256_and_si256(_mm256_srl_epi32(r, shiftCount), byteMask);
+      g = _mm256_and_si256(_mm256_srl_epi32(g, shiftCount), byteMask);
+      b = _mm256_and_si256(_mm256_srl_epi32(b, shiftCount), byteMask);
+      const __m256i packed = _mm256_or_si256(b,
+         _mm256_or_si256(_mm256_slli_epi32(g, 8), _mm256_slli_epi32(r, 16)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4 * (y * width + x)), packed);
+   }
+   return x;
+}
+
+#endif // DEBAYER_HAVE_AVX2
+
+template <typename T>
+void MalvarRows(const T* in, unsigned char* out, int width, int height, int shift,
+   int maxValue, const BayerLayout& layout, SimdLevel simd, int y0, int y1)
+{
+   const DirectView<T> direct = { in, width, height };
+   const MirroredView<T> mirrored = { in, width, height };
+   for (int y = y0; y < y1; ++y)
+   {
+      unsigned char* o = out + 4 * y * width;
+      if (y < 2 || y >= height - 2 || width < 5)
+      {
+         for (int x = 0; x < width; ++x)
+            MalvarPixelAt(mirrored, x, y, layout, maxValue, o + 4 * x, shift);
+         continue;
+      }
+
+      for (int x = 0; x < 2; ++x)
+         MalvarPixelAt(mirrored, x, y, layout, maxValue, o + 4 * x, shift);
+      int x = 2;
+#ifdef DEBAYER_HAVE_AVX2
+      if (simd == SimdAVX2)
+         x = MalvarRowAVX2(in, out, width, y, layout, maxValue, shift);
+#endif
+      (void)simd;
+      const bool redRow = (y & 1) == layout.ry;
+      const bool colorAtEven = (redRow ? layout.rx : 1 - layout.rx) == 0;
+      if (redRow && colorAtEven)
+         MalvarInteriorRow<SiteRed, SiteGreenInRedRow>(direct, x, y, maxValue, o, shift);
+      else if (redRow)
+         MalvarInteriorRow<SiteGreenInRedRow, SiteRed>(direct, x, y, maxValue, o, shift);
+      else if (colorAtEven)
+         MalvarInteriorRow<SiteBlue, SiteGreenInBlueRow>(direct, x, y, maxValue, o, shift);
+      else
+         MalvarInteriorRow<SiteGreenInBlueRow, SiteBlue>(direct, x, y, maxValue, o, shift);
+      for (int x = width - 2; x < width; ++x)
+         MalvarPixelAt(mirrored, x, y, layout, maxValue, o + 4 * x, shift);
+   }
+}
+
+} // anonymous namespace
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Debayer class implementation
@@ -43,10 +660,11 @@ Debayer::Debayer()
    algorithms.push_back("Bilinear");
    algorithms.push_back("Smooth-Hue");
    algorithms.push_back("Adaptive-Smooth-Hue");
+   algorithms.push_back("Malvar-He-Cutler");
 
    // default settings
    orderIndex = 0; // RGRG ordering
-   algoIndex = 0;  // replication - faster
+   algoIndex = 0;  // replication - fastest
 }
 
 Debayer::~Debayer()
@@ -97,19 +715,36 @@ int Debayer::ProcessT(ImgBuffer& out, const T* in, int width, int height, int bi
 
 template<typename T>
 int Debayer::Convert(const T* input, int* output, int width, int height, int bitDepth, int rowOrder, int algorithm)
-{				
-	if (algorithm == 0)
-      ReplicateDecode(input, output, width, height, bitDepth, rowOrder);
-	else if (algorithm == 1)
-      return DEVICE_NOT_SUPPORTED;
-	else if (algorithm == 2)
+{
+   const BayerLayout layout = LayoutForOrder(rowOrder);
+   const int shift = (std::max)(bitDepth - 8, 0);
+   unsigned char* out = reinterpret_cast<unsigned char*>(output);
+   static const SimdLevel simd = DetectSimdLevel();
+
+   if (algorithm == 0)
+   {
+      rowBands_.ForEachRowBand(width, height, 0, [&](int y0, int y1) {
+         ReplicateRows(input, out, width, shift, layout, y0, y1);
+      });
+   }
+   else if (algorithm == 1)
+   {
+      rowBands_.ForEachRowBand(width, height, 0, [&](int y0, int y1) {
+         BilinearRows(input, out, width, height, shift, layout, simd, y0, y1);
+      });
+   }
+   else if (algorithm == 2)
       SmoothDecode(input, output, width, height, bitDepth, rowOrder);
-	else if (algorithm == 3)
-      return DEVICE_NOT_SUPPORTED;
+   else if (algorithm == 4)
+   {
+      const int maxValue = (1 << (std::min)((std::max)(bitDepth, 1), 16)) - 1;
+      rowBands_.ForEachRowBand(width, height, 0, [&](int y0, int y1) {
+         MalvarRows(input, out, width, height, shift, maxValue, layout, simd, y0, y1);
+      });
+   }
    else
       return DEVICE_NOT_SUPPORTED;
 
-
    return DEVICE_OK;
 }
 
@@ -135,155 +770,6 @@ unsigned short Debayer::GetPixel(const unsigned char* v, int x, int y, int width
       return v[y*width + x];
 }
 
-// Replication algorithm
-template <typename T>
-void Debayer::ReplicateDecode(const T* input, int* output, int width, int height, int bitDepth, int rowOrder)
-{
-   unsigned numPixels(width*height);
-   if (r.size() != numPixels)
-   {
-      r.resize(numPixels);
-      g.resize(numPixels);
-      b.resize(numPixels);
-   }
-
-   int bitShift = bitDepth - 8;
-	
-	if (rowOrder == 0 || rowOrder == 1) {
-		for (int y=0; y<height; y+=2) {
-			for (int x=0; x<width; x+=2) {
-				unsigned short one = GetPixel(input, x, y, width, height);
-				SetPixel(b, one, x, y, width, height);
-				SetPixel(b, one, x+1, y, width, height);
-				SetPixel(b, one, x, y+1, width, height); 
-				SetPixel(b, one, x+1, y+1, width, height);
-			}
-		}
-		
-		for (int y=1; y<height; y+=2) {
-			for (int x=1; x<width; x+=2) {
-            unsigned short one = GetPixel(input, x, y, width, height);
-				SetPixel(r, one, x, y, width, height);
-				SetPixel(r, one, x+1, y, width, height);
-				SetPixel(r, one, x, y+1, width, height); 
-				SetPixel(r, one, x+1, y+1, width, height);
-			}
-		}
-		
-		for (int y=0; y<height; y+=2) {
-			for (int x=1; x<width; x+=2) {
-				unsigned short one = GetPixel(input, x, y, width, height);
-            SetPixel(g, one, x, y, width, height);
-            SetPixel(g, one, x+1, y, width, height);
-			}
-		}	
-			
-		for (int y=1; y<height; y+=2) {
-			for (int x=0; x<width; x+=2) {
-            unsigned short one = GetPixel(input, x, y, width, height);
-            SetPixel(g, one, x, y, width, height);
-            SetPixel(g, one, x+1, y, width, height);
-			}
-		}	
-		
-		if (rowOrder == 0) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(r[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(b[i] >> bitShift);
-
-			   //rgb.addSlice("red",b);	
-			   //rgb.addSlice("green",g);
-			   //rgb.addSlice("blue",r);
-         }
-		}
-		else if (rowOrder == 1) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(b[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(r[i] >> bitShift);
-
-			   //rgb.addSlice("red",r);	
-			   //rgb.addSlice("green",g);
-			   //rgb.addSlice("blue",b);			
-		   }
-      }
-	}
-
-	else if (rowOrder == 2 || rowOrder == 3) {
-		for (int y=1; y<height; y+=2) {
-			for (int x=0; x<width; x+=2) {
-				unsigned short one = GetPixel(input, x, y, width, height);
-				SetPixel(b, one, x, y, width, height);
-				SetPixel(b, one, x+1, y, width, height);
-				SetPixel(b, one, x, y+1, width, height); 
-				SetPixel(b, one, x+1, y+1, width, height);
-			}
-		}
-		
-		for (int y=0; y<height; y+=2) {
-			for (int x=1; x<width; x+=2) {
-            unsigned short one = GetPixel(input, x, y, width, height);
-				SetPixel(r, one, x, y, width, height);
-				SetPixel(r, one, x+1, y, width, height);
-				SetPixel(r, one, x, y+1, width, height); 
-				SetPixel(r, one, x+1, y+1, width, height);
-			}
-		}
-		
-		for (int y=0; y<height; y+=2) {
-			for (int x=0; x<width; x+=2) {
-				unsigned short one = GetPixel(input, x, y, width, height);
-            SetPixel(g, one, x, y, width, height);
-            SetPixel(g, one, x+1, y, width, height);
-			}
-		}	
-			
-		for (int y=1; y<height; y+=2) {
-			for (int x=1; x<width; x+=2) {
-            unsigned short one = GetPixel(input, x, y, width, height);
-            SetPixel(g, one, x, y, width, height);
-            SetPixel(g, one, x+1, y, width, height);
-			}
-		}	
-		
-		if (rowOrder == 2) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(r[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(b[i] >> bitShift);
-
-            //rgb.addSlice("red",b);	
-			   //rgb.addSlice("green",g);
-			   //rgb.addSlice("blue",r);
-         }
-		}
-		else if (rowOrder == 3) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(b[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(r[i] >> bitShift);
-
-            //rgb.addSlice("red",r);	
-			   //rgb.addSlice("green",g);
-			   //rgb.addSlice("blue",b);
-         }
-		}
-	}
-}
-
 // Smooth Hue algorithm
 template <typename T>
 void Debayer::SmoothDecode(const T* input, int* output, int width, int height, int bitDepth, int rowOrder)
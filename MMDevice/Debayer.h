@@ -25,6 +25,7 @@
 #pragma once
 
 #include "ImgBuffer.h"
+#include "RowBands.h"
 
 #include <string>
 #include <vector>
@@ -32,6 +33,11 @@
 /**
  * Utility class to build color image from the Bayer grayscale image
  * Based on the Debayer_Image plugin for ImageJ, by Jennifer West, University of Manitoba
+ *
+ * Replication, Bilinear and Malvar-He-Cutler run as single-pass kernels split
+ * into row bands across threads (Bilinear additionally uses SSE2/AVX2 where
+ * available). Smooth-Hue is the original implementation. Adaptive-Smooth-Hue
+ * is not implemented.
  */
 class Debayer
 {
@@ -52,8 +58,6 @@ public:
 private:
    template <typename T>
    int ProcessT(ImgBuffer& out, const T* in, int width, int height, int bitDepth);
-   template<typename T>
-   void ReplicateDecode(const T* input, int* out, int width, int height, int bitDepth, int rowOrder);
    template <typename T>
    void SmoothDecode(const T* input, int* output, int width, int height, int bitDepth, int rowOrder);
    template<typename T>
@@ -71,4 +75,6 @@ private:
 
    int orderIndex;
    int algoIndex;
+
+   RowBandPool rowBands_;
 };
@@ -38,6 +38,12 @@
 #include <iomanip>
 #include <map>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 // common error messages
 const char* const g_Msg_ERR = "Unknown error in the device";
@@ -476,6 +482,28 @@ public:
       return pProp->SendSequence();
    }
 
+   /**
+    * This function is used by the Core to communicate a sequence to the device.
+    * Replaces the sequence with the given values and sends it, going
+    * through the three functions above.
+    * @param name - name of the sequenceable property
+    */
+   virtual int SetPropertySequence(const char* name, const char* const* values, long numValues)
+   {
+      int ret = ClearPropertySequence(name);
+      if (ret != DEVICE_OK)
+         return ret;
+
+      for (long i = 0; i < numValues; ++i)
+      {
+         ret = AddToPropertySequence(name, values[i]);
+         if (ret != DEVICE_OK)
+            return ret;
+      }
+
+      return SendPropertySequence(name);
+   }
+
    /**
    * Obtains the property name given the index.
    * Can be used for enumerating properties.
@@ -1027,6 +1055,71 @@ protected:
       return DEVICE_NO_CALLBACK_REGISTERED;
    }
 
+   /**
+   * Sends several ASCII commands to the serial port back to back, and then
+   * collects the answer to each, in order. This saves a round trip per
+   * command for controllers that accept pipelined commands.
+   * @param portName
+   * @param commands - command strings
+   * @param commandTerm - terminating string appended to each command
+   * @param answerTerm - terminating string of each answer
+   * @param answers - answer strings without the terminating characters
+   */
+   int SendSerialCommands(const char* portName,
+         const std::vector<std::string>& commands, const char* commandTerm,
+         const char* answerTerm, std::vector<std::string>& answers)
+   {
+      if (!callback_)
+         return DEVICE_NO_CALLBACK_REGISTERED;
+
+      answers.clear();
+      if (commands.empty())
+         return DEVICE_OK;
+
+      std::vector<const char*> cmds;
+      cmds.reserve(commands.size());
+      for (std::vector<std::string>::const_iterator it = commands.begin(),
+            end = commands.end(); it != end; ++it)
+         cmds.push_back(it->c_str());
+
+      const unsigned long MAX_BUFLEN = 2000;
+      std::vector<char> buf(MAX_BUFLEN * commands.size());
+      int ret = callback_->TransactSerialCommands(this, portName, &cmds[0],
+            static_cast<unsigned>(cmds.size()), commandTerm, MAX_BUFLEN,
+            &buf[0], answerTerm);
+      if (ret != DEVICE_OK)
+         return ret;
+
+      for (std::size_t i = 0; i < commands.size(); ++i)
+         answers.push_back(&buf[i * MAX_BUFLEN]);
+      return DEVICE_OK;
+   }
+
+   /**
+   * Keeps the serial port for this device until EndSerialTransaction(), so
+   * that no other device's traffic comes between this device's calls.
+   * @param portName
+   */
+   int BeginSerialTransaction(const char* portName)
+   {
+      if (callback_)
+         return callback_->BeginSerialTransaction(this, portName);
+
+      return DEVICE_NO_CALLBACK_REGISTERED;
+   }
+
+   /**
+   * Releases the serial port kept by BeginSerialTransaction().
+   * @param portName
+   */
+   int EndSerialTransaction(const char* portName)
+   {
+      if (callback_)
+         return callback_->EndSerialTransaction(this, portName);
+
+      return DEVICE_NO_CALLBACK_REGISTERED;
+   }
+
    /**
    * Reads the current contents of Rx serial buffer.
    */
@@ -1100,6 +1193,17 @@ protected:
       return DEVICE_NO_CALLBACK_REGISTERED;
    }
 
+   /**
+    * Asks the core to append to a streamed sequence, once at least half of
+    * the device's sequence buffer is free
+    */
+   int OnSequenceBufferLow()
+   {
+      if (callback_)
+         return callback_->OnSequenceBufferLow(this);
+      return DEVICE_NO_CALLBACK_REGISTERED;
+   }
+
    /*
     */
    int OnExposureChanged(double exposure)
@@ -1300,6 +1404,23 @@ public:
    virtual unsigned GetImageBytesPerPixel() const = 0;
    virtual int SnapImage() = 0;
 
+   /**
+    * Timing of the frames acquired by the default sequence thread, relative
+    * to the schedule given by the interval passed to
+    * StartSequenceAcquisition(). Jitter is how late a frame was started;
+    * late frames are those started more than a whole interval late, after
+    * which the schedule restarts (missed frames are not made up for).
+    * Only collected when the interval is greater than zero.
+    */
+   struct SequenceTimingStats
+   {
+      long frames;
+      long lateFrames;
+      double meanJitterUs;
+      double rmsJitterUs;
+      double maxJitterUs;
+   };
+
    CCameraBase() : busy_(false), stopWhenCBOverflows_(false), thd_(0)
    {
       // create and initialize common transpose properties
@@ -1463,6 +1584,11 @@ public:
       return DEVICE_UNSUPPORTED_COMMAND;
    }
 
+   virtual int SetExposureSequence(const double* /*exposureTimes_ms*/, long /*numExposures*/)
+   {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
+
    virtual bool IsCapturing(){return !thd_->IsStopped();}
 
    virtual void AddTag(const char* key, const char* deviceLabel, const char* value)
@@ -1538,20 +1664,29 @@ protected:
    };
 
    virtual int InsertImage()
+   {
+      return InsertImageBuffer(GetImageBuffer(), GetImageWidth(),
+         GetImageHeight(), GetImageBytesPerPixel());
+   }
+
+   // Inserts the given pixels with the same metadata and overflow handling
+   // as InsertImage()
+   int InsertImageBuffer(const unsigned char* pixels, unsigned width,
+      unsigned height, unsigned bytesPerPixel)
    {
       char label[MM::MaxStrLength];
       this->GetLabel(label);
       Metadata md;
       md.put(MM::g_Keyword_Metadata_CameraLabel, label);
-      int ret = GetCoreCallback()->InsertImage(this, GetImageBuffer(), GetImageWidth(),
-         GetImageHeight(), GetImageBytesPerPixel(),
+      int ret = GetCoreCallback()->InsertImage(this, pixels, width,
+         height, bytesPerPixel,
          md.Serialize().c_str());
       if (!stopWhenCBOverflows_ && ret == DEVICE_BUFFER_OVERFLOW)
       {
          // do not stop on overflow - just reset the buffer
          GetCoreCallback()->ClearImageBuffer(this);
-         return GetCoreCallback()->InsertImage(this, GetImageBuffer(), GetImageWidth(),
-            GetImageHeight(), GetImageBytesPerPixel(),
+         return GetCoreCallback()->InsertImage(this, pixels, width,
+            height, bytesPerPixel,
             md.Serialize().c_str());
       } else
          return ret;
@@ -1578,6 +1713,31 @@ protected:
    virtual bool isStopOnOverflow() {return stopWhenCBOverflows_;}
    virtual void setStopOnOverflow(bool stop) {stopWhenCBOverflows_ = stop;}
 
+   /**
+    * Spin instead of sleeping for the last part of the wait between frames
+    * of the default sequence thread. Needed for accurate sub-millisecond
+    * intervals, at the cost of a busy CPU core. May be called while a
+    * sequence is running.
+    */
+   void SetSequenceBusyWait(bool busyWait) {thd_->busyWait_ = busyWait;}
+
+   /**
+    * Make the default sequence thread call SnapImage() for the next frame
+    * while the previous one is being inserted on a second thread. The image
+    * buffer is copied in between, so SnapImage() may reuse it right away.
+    *
+    * In this mode the sequence thread calls SnapImage(), GetImageBuffer()
+    * and InsertImageBuffer() directly: overrides of ThreadRun() and
+    * InsertImage() are NOT called, so cameras that override either of them
+    * (to add metadata, for example) must not enable it. Cameras with more
+    * than one channel are run as if it were off.
+    *
+    * Takes effect at the next StartSequenceAcquisition().
+    */
+   void SetSequencePipelined(bool pipelined) {thd_->pipelined_ = pipelined;}
+
+   SequenceTimingStats GetSequenceTimingStats() {return thd_->GetTimingStats();}
+
    ////////////////////////////////////////////////////////////////////////////
    // Helper Class
    class CaptureRestartHelper
@@ -1615,13 +1775,31 @@ protected:
          ,startTime_(0)
          ,actualDuration_(0)
          ,lastFrameTime_(0)
-      {};
+         ,busyWait_(false)
+         ,pipelined_(false)
+         ,pipeWidth_(0)
+         ,pipeHeight_(0)
+         ,pipeBytesPerPixel_(0)
+         ,pipeFull_(false)
+         ,pipeDone_(false)
+         ,pipeError_(DEVICE_OK)
+      {
+         ResetTimingStats();
+      };
 
       ~BaseSequenceThread() {}
 
       void Stop() {
-         MMThreadGuard g(this->stopLock_);
-         stop_=true;
+         {
+            MMThreadGuard g(this->stopLock_);
+            stop_=true;
+         }
+         // Wake up the wait for the next frame; taking the mutex ensures the
+         // waiting thread either sees stop_ or is already waiting
+         {
+            std::lock_guard<std::mutex> g(frameWaitMutex_);
+         }
+         frameWaitCond_.notify_all();
       }
 
       void Start(long numImages, double intervalMs)
@@ -1636,7 +1814,8 @@ protected:
          activate();
          actualDuration_ = MM::MMTime{};
          startTime_= camera_->GetCurrentMMTime();
-         lastFrameTime_ = MM::MMTime{};
+         SetLastFrameTime(MM::MMTime{});
+         ResetTimingStats();
       }
       bool IsStopped(){
          MMThreadGuard g(this->stopLock_);
@@ -1661,6 +1840,23 @@ protected:
       long GetImageCounter(){return imageCounter_;}
       MM::MMTime GetStartTime(){return startTime_;}
       MM::MMTime GetActualDuration(){return actualDuration_;}
+      MM::MMTime GetLastFrameTime()
+      {
+         MMThreadGuard g(this->statsLock_);
+         return lastFrameTime_;
+      }
+
+      SequenceTimingStats GetTimingStats()
+      {
+         MMThreadGuard g(this->statsLock_);
+         SequenceTimingStats stats;
+         stats.frames = timedFrames_;
+         stats.lateFrames = lateFrames_;
+         stats.meanJitterUs = timedFrames_ > 0 ? jitterSumUs_ / timedFrames_ : 0.0;
+         stats.rmsJitterUs = timedFrames_ > 0 ? sqrt(jitterSumSqUs_ / timedFrames_) : 0.0;
+         stats.maxJitterUs = jitterMaxUs_;
+         return stats;
+      }
 
       CCameraBase* GetCamera() {return camera_;}
       long GetNumberOfImages() {return numImages_;}
@@ -1668,27 +1864,208 @@ protected:
       void UpdateActualDuration() {actualDuration_ = camera_->GetCurrentMMTime() - startTime_;}
 
    private:
+      typedef std::chrono::steady_clock Clock;
+
       virtual int svc()
       {
          int ret=DEVICE_ERR;
          try
          {
-            do
+            if (pipelined_ && camera_->GetNumberOfChannels() == 1)
+            {
+               ret = RunPipelined();
+            }
+            else
             {
-               ret=camera_->ThreadRun();
-            } while (DEVICE_OK == ret && !IsStopped() && imageCounter_++ < numImages_-1);
+               do
+               {
+                  if (!WaitForNextFrame())
+                     break;
+                  ret=camera_->ThreadRun();
+                  SetLastFrameTime(camera_->GetCurrentMMTime());
+               } while (DEVICE_OK == ret && !IsStopped() && imageCounter_++ < numImages_-1);
+            }
             if (IsStopped())
                camera_->LogMessage("SeqAcquisition interrupted by the user\n");
 
          }catch(...){
             camera_->LogMessage(g_Msg_EXCEPTION_IN_THREAD, false);
          }
-         stop_=true;
+         {
+            MMThreadGuard g(this->stopLock_);
+            stop_=true;
+         }
          UpdateActualDuration();
          camera_->OnThreadExiting();
          return ret;
       }
+
+      // Waits until the scheduled start of the next frame; returns false if
+      // stopped while waiting. Frames are scheduled at whole intervals from
+      // the first one, so that the time taken by each frame does not add up
+      // to a drift.
+      bool WaitForNextFrame()
+      {
+         if (intervalMs_ <= 0.0)
+            return true;
+
+         const Clock::duration interval =
+            std::chrono::duration_cast<Clock::duration>(
+               std::chrono::duration<double, std::milli>(intervalMs_));
+         Clock::time_point now = Clock::now();
+         if (imageCounter_ == 0)
+         {
+            nextFrameTime_ = now + interval;
+            return true;
+         }
+
+         if (now < nextFrameTime_)
+         {
+            // Sleep until close to the deadline, then (if enabled) spin
+            // the rest, as sleeps are only accurate to about a millisecond
+            // (much worse on some systems)
+            const Clock::time_point wakeTime = busyWait_ ?
+               nextFrameTime_ - std::chrono::milliseconds(busyWaitMarginMs) :
+               nextFrameTime_;
+            {
+               std::unique_lock<std::mutex> g(frameWaitMutex_);
+               if (frameWaitCond_.wait_until(g, wakeTime,
+                     [this] { return IsStopped(); }))
+                  return false;
+            }
+            while (Clock::now() < nextFrameTime_)
+               ;
+            now = Clock::now();
+         }
+
+         const Clock::duration lateness = now - nextFrameTime_;
+         const bool late = lateness >= interval;
+         RecordJitter(std::chrono::duration<double, std::micro>(lateness).count(), late);
+
+         // After falling behind by a whole interval, continue from now
+         // rather than catching up with a burst of frames
+         nextFrameTime_ = (late ? now : nextFrameTime_) + interval;
+         return true;
+      }
+
+      void SetLastFrameTime(MM::MMTime t)
+      {
+         MMThreadGuard g(this->statsLock_);
+         lastFrameTime_ = t;
+      }
+
+      void ResetTimingStats()
+      {
+         MMThreadGuard g(this->statsLock_);
+         timedFrames_ = 0;
+         lateFrames_ = 0;
+         jitterSumUs_ = 0.0;
+         jitterSumSqUs_ = 0.0;
+         jitterMaxUs_ = 0.0;
+      }
+
+      void RecordJitter(double jitterUs, bool late)
+      {
+         MMThreadGuard g(this->statsLock_);
+         ++timedFrames_;
+         if (late)
+            ++lateFrames_;
+         jitterSumUs_ += jitterUs;
+         jitterSumSqUs_ += jitterUs * jitterUs;
+         jitterMaxUs_ = (std::max)(jitterMaxUs_, jitterUs);
+      }
+
+      // Snaps on this thread and inserts on a second one, with a single
+      // frame handed over in between
+      int RunPipelined()
+      {
+         {
+            std::lock_guard<std::mutex> g(pipeMutex_);
+            pipeFull_ = false;
+            pipeDone_ = false;
+            pipeError_ = DEVICE_OK;
+         }
+         std::thread inserter(&BaseSequenceThread::InsertPipelinedFrames, this);
+
+         int ret = DEVICE_OK;
+         do
+         {
+            if (!WaitForNextFrame())
+               break;
+            ret = camera_->SnapImage();
+            if (ret != DEVICE_OK)
+               break;
+
+            {
+               std::unique_lock<std::mutex> g(pipeMutex_);
+               pipeCond_.wait(g, [this] { return !pipeFull_ || pipeError_ != DEVICE_OK; });
+               if (pipeError_ != DEVICE_OK)
+                  break;
+
+               const unsigned char* pixels = camera_->GetImageBuffer();
+               if (pixels == 0)
+               {
+                  ret = DEVICE_ERR;
+                  break;
+               }
+               pipeWidth_ = camera_->GetImageWidth();
+               pipeHeight_ = camera_->GetImageHeight();
+               pipeBytesPerPixel_ = camera_->GetImageBytesPerPixel();
+               pipeImage_.assign(pixels,
+                  pixels + (size_t)pipeWidth_ * pipeHeight_ * pipeBytesPerPixel_);
+               pipeFull_ = true;
+            }
+            pipeCond_.notify_all();
+            SetLastFrameTime(camera_->GetCurrentMMTime());
+         } while (!IsStopped() && imageCounter_++ < numImages_-1);
+
+         {
+            std::lock_guard<std::mutex> g(pipeMutex_);
+            pipeDone_ = true;
+         }
+         pipeCond_.notify_all();
+         inserter.join();
+
+         if (ret == DEVICE_OK)
+            ret = pipeError_;
+         return ret;
+      }
+
+      void InsertPipelinedFrames()
+      {
+         std::vector<unsigned char> image;
+         for (;;)
+         {
+            unsigned width, height, bytesPerPixel;
+            {
+               std::unique_lock<std::mutex> g(pipeMutex_);
+               pipeCond_.wait(g, [this] { return pipeFull_ || pipeDone_; });
+               if (!pipeFull_)
+                  return;
+               image.swap(pipeImage_);
+               width = pipeWidth_;
+               height = pipeHeight_;
+               bytesPerPixel = pipeBytesPerPixel_;
+               pipeFull_ = false;
+            }
+            pipeCond_.notify_all();
+
+            int ret = camera_->InsertImageBuffer(&image[0], width, height, bytesPerPixel);
+            if (ret != DEVICE_OK)
+            {
+               {
+                  std::lock_guard<std::mutex> g(pipeMutex_);
+                  pipeError_ = ret;
+               }
+               pipeCond_.notify_all();
+               return;
+            }
+         }
+      }
+
    private:
+      enum { busyWaitMarginMs = 2 };
+
       double intervalMs_;
       long numImages_;
       long imageCounter_;
@@ -1697,9 +2074,34 @@ protected:
       CCameraBase* camera_;
       MM::MMTime startTime_;
       MM::MMTime actualDuration_;
-      MM::MMTime lastFrameTime_;
+      MM::MMTime lastFrameTime_; // Guarded by statsLock_
       MMThreadLock stopLock_;
       MMThreadLock suspendLock_;
+
+      // Set by the camera while svc() may be reading them
+      std::atomic<bool> busyWait_;
+      std::atomic<bool> pipelined_;
+
+      Clock::time_point nextFrameTime_;
+      std::mutex frameWaitMutex_;
+      std::condition_variable frameWaitCond_;
+
+      MMThreadLock statsLock_;
+      long timedFrames_;
+      long lateFrames_;
+      double jitterSumUs_;
+      double jitterSumSqUs_;
+      double jitterMaxUs_;
+
+      std::mutex pipeMutex_;
+      std::condition_variable pipeCond_;
+      std::vector<unsigned char> pipeImage_;
+      unsigned pipeWidth_;
+      unsigned pipeHeight_;
+      unsigned pipeBytesPerPixel_;
+      bool pipeFull_;
+      bool pipeDone_;
+      int pipeError_;
    };
    //////////////////////////////////////////////////////////////////////////
 
@@ -1804,6 +2206,16 @@ class CStageBase : public CDeviceBase<MM::Stage, U>
       return DEVICE_UNSUPPORTED_COMMAND;
    }
 
+   virtual int SetStageSequence(const double* /*positions*/, long /*numPositions*/)
+   {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
+
+   virtual int AppendToStageSequence(const double* /*positions*/, long /*numPositions*/, long& /*numAppended*/)
+   {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
+
    virtual int SetStageLinearSequence(double, long)
    {
       return DEVICE_UNSUPPORTED_COMMAND;
@@ -1999,6 +2411,11 @@ public:
       return DEVICE_UNSUPPORTED_COMMAND;
    }
 
+   virtual int SetXYStageSequence(const double* /*positionsX*/, const double* /*positionsY*/, long /*numPositions*/)
+   {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
+
 protected:
 
    /**
@@ -2098,6 +2515,14 @@ class CSignalIOBase : public CDeviceBase<MM::SignalIO, U>
    virtual int SendDASequence() {
       return DEVICE_UNSUPPORTED_COMMAND;
    }
+
+   virtual int SetDASequence(const double* /*voltages*/, long /*numVoltages*/) {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
+
+   virtual int AppendToDASequence(const double* /*voltages*/, long /*numVoltages*/, long& /*numAppended*/) {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
 };
 
 /**
@@ -2142,6 +2567,18 @@ class CSLMBase : public CDeviceBase<MM::SLM, U>
       return DEVICE_UNSUPPORTED_COMMAND;
    }
 
+   virtual int AddPatternToSLMSequence(long /*patternId*/,
+         const unsigned char * const /*pixels*/)
+   {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
+
+   virtual int SetImageRegion(const unsigned char * const /*pixels*/,
+         unsigned /*x*/, unsigned /*y*/, unsigned /*width*/, unsigned /*height*/)
+   {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
+
    virtual int SendSLMSequence() {
       return DEVICE_UNSUPPORTED_COMMAND;
    }
@@ -2155,6 +2592,11 @@ class CGalvoBase : public CDeviceBase<MM::Galvo, U>
 {
    double GetXMinimum() { return 0.0;};
    double GetYMinimum() { return 0.0;};
+
+   virtual int AddPolygonVertices(int /*polygonIndex*/, const double* /*xs*/,
+         const double* /*ys*/, long /*numVertices*/) {
+      return DEVICE_UNSUPPORTED_COMMAND;
+   }
 };
 
 /**
@@ -28,7 +28,7 @@
 // Header version
 // If any of the class definitions changes, the interface version
 // must be incremented
-#define DEVICE_INTERFACE_VERSION 73
+#define DEVICE_INTERFACE_VERSION 79
 ///////////////////////////////////////////////////////////////////////////////
 
 // N.B.
@@ -259,6 +259,14 @@ namespace MM {
        * Signal that we are done sending sequence values so that the adapter can send the whole sequence to the device
        */
       virtual int SendPropertySequence(const char* propertyName) = 0;
+      /**
+       * Replace the sequence with numValues values and send it to the device.
+       * Equivalent to ClearPropertySequence(), AddToPropertySequence() for
+       * each value, then SendPropertySequence(), but in a single call.
+       * May return DEVICE_UNSUPPORTED_COMMAND, in which case the caller
+       * should fall back to adding the values one at a time.
+       */
+      virtual int SetPropertySequence(const char* propertyName, const char* const* values, long numValues) = 0;
 
       virtual bool GetErrorText(int errorCode, char* errMessage) const = 0;
       virtual bool Busy() = 0;
@@ -544,6 +552,10 @@ namespace MM {
       virtual int AddToExposureSequence(double exposureTime_ms) = 0;
       // Signal that we are done sending sequence values so that the adapter can send the whole sequence to the device
       virtual int SendExposureSequence() const = 0;
+      // Replace the sequence with the given values and send it, in one call.
+      // Return DEVICE_UNSUPPORTED_COMMAND to have the caller fall back to
+      // Clear/AddTo/SendExposureSequence().
+      virtual int SetExposureSequence(const double* exposureTimes_ms, long numExposures) = 0;
    };
 
    /**
@@ -657,6 +669,33 @@ namespace MM {
        * can send the whole sequence to the device
        */
       virtual int SendStageSequence() = 0;
+      /**
+       * Replace the sequence with numPositions positions and send it to the
+       * device. Equivalent to ClearStageSequence(), AddToStageSequence() for
+       * each position, then SendStageSequence(), but lets the adapter upload
+       * the whole array in one transaction.
+       * May return DEVICE_UNSUPPORTED_COMMAND, in which case the caller
+       * should fall back to adding the positions one at a time.
+       */
+      virtual int SetStageSequence(const double* positions, long numPositions) = 0;
+      /**
+       * Append positions to a streamed sequence.
+       *
+       * A sequence built by calling this function after ClearStageSequence()
+       * (instead of AddToStageSequence()/SendStageSequence()) is streamed:
+       * the device's buffer holds up to GetStageSequenceMaxLength()
+       * positions, each position is used once and its slot then becomes
+       * free, and the sequence does not wrap around. This function may be
+       * called while the sequence is running.
+       *
+       * The adapter appends as many positions as currently fit (possibly
+       * none) and sets numAppended accordingly. Once at least half of the
+       * buffer is free, it should call MM::Core::OnSequenceBufferLow() so
+       * that the caller can append more.
+       *
+       * Return DEVICE_UNSUPPORTED_COMMAND if streaming is not supported.
+       */
+      virtual int AppendToStageSequence(const double* positions, long numPositions, long& numAppended) = 0;
 
       /**
        * Set up to perform an equally-spaced triggered Z stack.
@@ -752,6 +791,15 @@ namespace MM {
        * can send the whole sequence to the device
        */
       virtual int SendXYStageSequence() = 0;
+      /**
+       * Replace the sequence with numPositions (x, y) positions and send it
+       * to the device. Equivalent to ClearXYStageSequence(),
+       * AddToXYStageSequence() for each position, then SendXYStageSequence(),
+       * but lets the adapter upload the whole array in one transaction.
+       * May return DEVICE_UNSUPPORTED_COMMAND, in which case the caller
+       * should fall back to adding the positions one at a time.
+       */
+      virtual int SetXYStageSequence(const double* positionsX, const double* positionsY, long numPositions) = 0;
 
    };
 
@@ -929,6 +977,25 @@ namespace MM {
        * @return errorcode (DEVICE_OK if no error)
        */
       virtual int SendDASequence() = 0;
+      /**
+       * Replaces the sequence with numVoltages data points and sends it to
+       * the device. Equivalent to ClearDASequence(), AddToDASequence() for
+       * each voltage, then SendDASequence(), but lets the adapter upload the
+       * whole array in one transaction.
+       * @return errorcode (DEVICE_OK if no error); DEVICE_UNSUPPORTED_COMMAND
+       * if the caller should fall back to adding the voltages one at a time
+       */
+      virtual int SetDASequence(const double* voltages, long numVoltages) = 0;
+      /**
+       * Appends data points to a streamed sequence. Same semantics as
+       * MM::Stage::AppendToStageSequence(): after ClearDASequence(), the
+       * sequence is consumed once rather than repeated, and may be refilled
+       * while it runs. The adapter calls MM::Core::OnSequenceBufferLow() once
+       * at least half of its buffer (GetDASequenceMaxLength()) is free.
+       * @return errorcode (DEVICE_OK if no error); DEVICE_UNSUPPORTED_COMMAND
+       * if streaming is not supported
+       */
+      virtual int AppendToDASequence(const double* voltages, long numVoltages, long& numAppended) = 0;
 
    };
 
@@ -1091,6 +1158,29 @@ namespace MM {
        */
       virtual int AddToSLMSequence(const unsigned int * const pixels) = 0;
 
+      /**
+       * Adds a pattern from the Core's pattern store to the sequence.
+       * The same patternId always stands for the same pixels (IDs are not
+       * reused), so the adapter may keep one copy per ID and refer to it
+       * rather than storing the pixels again. The pixels (of the size expected
+       * by the SLM, 8-bit or 32-bit RGB) are passed every time nonetheless.
+       * @return errorcode (DEVICE_OK if no error); DEVICE_UNSUPPORTED_COMMAND
+       * if the caller should use AddToSLMSequence() instead
+       */
+      virtual int AddPatternToSLMSequence(long patternId,
+            const unsigned char * const pixels) = 0;
+
+      /**
+       * Replaces a rectangular part of the image, leaving the rest as set by
+       * the previous SetImage() or SetImageRegion(). Like SetImage(), does not
+       * display the image.
+       * @param pixels width * height pixels (in the SLM's pixel format)
+       * @return errorcode (DEVICE_OK if no error); DEVICE_UNSUPPORTED_COMMAND
+       * if the caller should set the whole image instead
+       */
+      virtual int SetImageRegion(const unsigned char * const pixels,
+            unsigned x, unsigned y, unsigned width, unsigned height) = 0;
+
       /**
        * Sends the complete sequence to the device.
        * If the individual images were already send to the device, there is
@@ -1190,6 +1280,14 @@ namespace MM {
        * @return errorcode (DEVICE_OK if no error)
        */
       virtual int AddPolygonVertex(int polygonIndex, double x, double y) = 0;
+      /**
+       * Adds numVertices vertices to a polygon in one call. Equivalent to
+       * calling AddPolygonVertex() for each vertex in order.
+       * @return errorcode (DEVICE_OK if no error); DEVICE_UNSUPPORTED_COMMAND
+       * if the caller should fall back to adding the vertices one at a time
+       */
+      virtual int AddPolygonVertices(int polygonIndex, const double* xs,
+            const double* ys, long numVertices) = 0;
       /**
        * Deletes all polygons previously stored in the device adapater.
        * @return errorcode (DEVICE_OK if no error)
@@ -1541,6 +1639,30 @@ namespace MM {
       virtual int ReadFromSerial(const Device* caller, const char* port, unsigned char* buf, unsigned long length, unsigned long& read) = 0;
       virtual int PurgeSerial(const Device* caller, const char* portName) = 0;
       virtual MM::PortType GetSerialPortType(const char* portName) const = 0;
+      /**
+       * Sends numCommands ASCII commands (each followed by commandTerm) to
+       * the serial port back to back, then receives one answer per command,
+       * in order. No other command or answer on the same port is interleaved
+       * with the transaction.
+       *
+       * The answers (with answerTerm stripped) are written to consecutive
+       * buffers of ansLength characters each, starting at answers; that is,
+       * answers must point to at least numCommands * ansLength characters.
+       */
+      virtual int TransactSerialCommands(const Device* caller, const char* portName, const char* const* commands, unsigned numCommands, const char* commandTerm, unsigned long ansLength, char* answers, const char* answerTerm) = 0;
+      /**
+       * Keeps the serial port for the caller until EndSerialTransaction(),
+       * so that no other device's commands or answers are interleaved with
+       * the caller's calls in between.
+       *
+       * Without a transaction, the port is kept from a command (or write)
+       * only until its answer (or the first data read) has been received.
+       * Use a transaction for longer exchanges, such as a binary reply read
+       * in several parts. The port is also released if the caller makes no
+       * call on it for a second.
+       */
+      virtual int BeginSerialTransaction(const Device* caller, const char* portName) = 0;
+      virtual int EndSerialTransaction(const Device* caller, const char* portName) = 0;
 
       virtual int OnPropertiesChanged(const Device* caller) = 0;
       /**
@@ -1559,6 +1681,13 @@ namespace MM {
        * this callback to signal the UI
        */
       virtual int OnXYStagePositionChanged(const Device* caller, double xPos, double yPos) = 0;
+      /**
+       * A device running a streamed sequence (see
+       * MM::Stage::AppendToStageSequence()) calls this once at least half of
+       * its sequence buffer is free. Returns immediately; the Core appends
+       * the next values from another thread. May be called from any thread.
+       */
+      virtual int OnSequenceBufferLow(const Device* caller) = 0;
       /**
        * When the exposure time has changed, use this callback to inform the UI
        */
@@ -0,0 +1,624 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          PixelConversion.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMDevice - Device adapter kit
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Conversions from common camera pixel formats to the formats
+//                used by Micro-Manager (16-bit grayscale and 32-bit RGB)
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+#include "PixelConversion.h"
+
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXCONV_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+// The SSSE3 and AVX2 kernels are compiled regardless of the target flags and
+// selected at run time.
+#if defined(PIXCONV_HAVE_SSE2) && (defined(_MSC_VER) || defined(__GNUC__))
+#define PIXCONV_HAVE_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PIXCONV_TARGET_SSSE3
+#define PIXCONV_TARGET_AVX2
+#else
+#define PIXCONV_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define PIXCONV_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace PixelConversion {
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// CPU dispatch
+///////////////////////////////////////////////////////////////////////////////
+
+SimdLevel DetectSimdLevel()
+{
+#if defined(PIXCONV_HAVE_AVX2)
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 0);
+   const int maxLeaf = info[0];
+   __cpuid(info, 1);
+   const bool ssse3 = (info[2] & (1 << 9)) != 0;
+   const bool osxsave = (info[2] & (1 << 27)) != 0;
+   const bool avx = (info[2] & (1 << 28)) != 0;
+   if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+   {
+      __cpuidex(info, 7, 0);
+      if (info[1] & (1 << 5))
+         return SimdAVX2;
+   }
+   if (ssse3)
+      return SimdSSSE3;
+#else
+   if (__builtin_cpu_supports("avx2"))
+      return SimdAVX2;
+   if (__builtin_cpu_supports("ssse3"))
+      return SimdSSSE3;
+#endif
+#endif
+#if defined(PIXCONV_HAVE_SSE2)
+   return SimdSSE2;
+#else
+   return SimdNone;
+#endif
+}
+
+std::atomic<int>& ActiveLevel()
+{
+   static std::atomic<int> level(GetSupportedSimdLevel());
+   return level;
+}
+
+inline SimdLevel Level()
+{
+   return static_cast<SimdLevel>(ActiveLevel().load(std::memory_order_relaxed));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Scalar conversions (also used for the ends of runs left by SIMD kernels)
+///////////////////////////////////////////////////////////////////////////////
+
+// LSB-first packing (Mono10p, Mono12p): pixel i occupies bits
+// [i * bits, (i + 1) * bits) of the little-endian byte stream. Every pixel
+// spans two bytes, both within the source.
+template <unsigned Bits>
+void UnpackLSBFirstScalar(uint16_t* dst, const uint8_t* src, std::size_t begin,
+   std::size_t count)
+{
+   for (std::size_t i = begin; i < count; ++i)
+   {
+      const std::size_t bit = i * Bits;
+      const uint8_t* p = src + bit / 8;
+      const unsigned word = p[0] | (p[1] << 8);
+      dst[i] = (uint16_t)((word >> (bit % 8)) & ((1u << Bits) - 1));
+   }
+}
+
+// GigE Vision packing: pixels a and b in 3 bytes, low bits in the middle
+template <unsigned Bits>
+void UnpackPairsScalar(uint16_t* dst, const uint8_t* src, std::size_t begin,
+   std::size_t count)
+{
+   const unsigned lowBits = Bits - 8;
+   const unsigned lowMask = (1u << lowBits) - 1;
+   std::size_t i = begin;
+   src += i / 2 * 3;
+   for (; i + 2 <= count; i += 2, src += 3)
+   {
+      dst[i] = (uint16_t)((src[0] << lowBits) | (src[1] & lowMask));
+      dst[i + 1] = (uint16_t)((src[2] << lowBits) | ((src[1] >> 4) & lowMask));
+   }
+   if (i < count)
+      dst[i] = (uint16_t)((src[0] << lowBits) | (src[1] & lowMask));
+}
+
+void ByteSwap16Scalar(uint16_t* dst, const uint16_t* src, std::size_t begin,
+   std::size_t count)
+{
+   for (std::size_t i = begin; i < count; ++i)
+      dst[i] = (uint16_t)((src[i] >> 8) | (src[i] << 8));
+}
+
+// rIndex is the offset of red within each source pixel (0 for RGB, 2 for BGR)
+void Color24ToRGB32Scalar(uint8_t* dst, const uint8_t* src, std::size_t begin,
+   std::size_t count, unsigned rIndex)
+{
+   for (std::size_t i = begin; i < count; ++i)
+   {
+      const uint8_t* s = src + 3 * i;
+      uint8_t* d = dst + 4 * i;
+      d[0] = s[2 - rIndex];
+      d[1] = s[1];
+      d[2] = s[rIndex];
+      d[3] = 255;
+   }
+}
+
+inline uint8_t Clip(int v)
+{
+   return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// Integer BT.601 (limited range) conversion. The SIMD kernels use the same
+// arithmetic, including the arithmetic right shift of negative values.
+inline void YUVToBGRA(uint8_t* d, int y, int u, int v)
+{
+   const int c = 298 * (y - 16) + 128;
+   const int du = u - 128;
+   const int dv = v - 128;
+   d[0] = Clip((c + 516 * du) >> 8);
+   d[1] = Clip((c - 100 * du - 208 * dv) >> 8);
+   d[2] = Clip((c + 409 * dv) >> 8);
+   d[3] = 255;
+}
+
+// yIndex is the offset of Y0 within each 4-byte pair (0 for YUYV, 1 for UYVY)
+void YUV422ToRGB32Scalar(uint8_t* dst, const uint8_t* src, std::size_t begin,
+   std::size_t count, unsigned yIndex)
+{
+   const unsigned uIndex = 1 - yIndex;
+   for (std::size_t i = begin; i + 2 <= count; i += 2)
+   {
+      const uint8_t* s = src + 2 * i;
+      const int u = s[uIndex];
+      const int v = s[uIndex + 2];
+      YUVToBGRA(dst + 4 * i, s[yIndex], u, v);
+      YUVToBGRA(dst + 4 * i + 4, s[yIndex + 2], u, v);
+   }
+}
+
+// yIndex as above
+void YUV422ToGray8Scalar(uint8_t* dst, const uint8_t* src, std::size_t begin,
+   std::size_t count, unsigned yIndex)
+{
+   for (std::size_t i = begin; i < count; ++i)
+      dst[i] = src[2 * i + yIndex];
+}
+
+#ifdef PIXCONV_HAVE_SSE2
+
+///////////////////////////////////////////////////////////////////////////////
+// SSE2 kernels
+///////////////////////////////////////////////////////////////////////////////
+//
+// Each kernel converts as many whole blocks as it can without reading past
+// the end of the source and returns the number of pixels converted.
+
+std::size_t ByteSwap16SSE2(uint16_t* dst, const uint16_t* src, std::size_t count)
+{
+   std::size_t i = 0;
+   for (; i + 8 <= count; i += 8)
+   {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+         _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)));
+   }
+   return i;
+}
+
+// 8 pixels (16 bytes) per iteration
+std::size_t YUV422ToRGB32SSE2(uint8_t* dst, const uint8_t* src, std::size_t count,
+   bool yFirst)
+{
+   const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+   const __m128i low16 = _mm_set1_epi32(0xffff);
+   const __m128i y16 = _mm_set1_epi16(16);
+   const __m128i uv128 = _mm_set1_epi16(128);
+   const __m128i round = _mm_set1_epi32(128);
+   const __m128i kB = _mm_set_epi16(516, 298, 516, 298, 516, 298, 516, 298);
+   const __m128i kGu = _mm_set_epi16(-100, 298, -100, 298, -100, 298, -100, 298);
+   const __m128i kGv = _mm_set_epi16(-208, 0, -208, 0, -208, 0, -208, 0);
+   const __m128i kR = _mm_set_epi16(409, 298, 409, 298, 409, 298, 409, 298);
+   const __m128i alpha = _mm_set1_epi16(255);
+
+   std::size_t i = 0;
+   for (; i + 8 <= count; i += 8)
+   {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+      const __m128i y = yFirst ? _mm_and_si128(x, lowBytes) : _mm_srli_epi16(x, 8);
+      const __m128i uv = yFirst ? _mm_srli_epi16(x, 8) : _mm_and_si128(x, lowBytes);
+      // uv holds U0 V0 U1 V1 ...; spread each U and V over its two pixels
+      const __m128i u = _mm_and_si128(uv, low16);
+      const __m128i v = _mm_srli_epi32(uv, 16);
+      const __m128i c = _mm_sub_epi16(y, y16);
+      const __m128i du = _mm_sub_epi16(_mm_or_si128(u, _mm_slli_epi32(u, 16)), uv128);
+      const __m128i dv = _mm_sub_epi16(_mm_or_si128(v, _mm_slli_epi32(v, 16)), uv128);
+
+      const __m128i cuLo = _mm_unpacklo_epi16(c, du);
+      const __m128i cuHi = _mm_unpackhi_epi16(c, du);
+      const __m128i cvLo = _mm_unpacklo_epi16(c, dv);
+      const __m128i cvHi = _mm_unpackhi_epi16(c, dv);
+
+      const __m128i b = _mm_packs_epi32(
+         _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cuLo, kB), round), 8),
+         _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cuHi, kB), round), 8));
+      const __m128i g = _mm_packs_epi32(
+         _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(cuLo, kGu),
+            _mm_madd_epi16(cvLo, kGv)), round), 8),
+         _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(cuHi, kGu),
+            _mm_madd_epi16(cvHi, kGv)), round), 8));
+      const __m128i r = _mm_packs_epi32(
+         _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cvLo, kR), round), 8),
+         _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cvHi, kR), round), 8));
+
+      // Saturate to bytes and interleave to B G R A
+      const __m128i br = _mm_packus_epi16(b, r);
+      const __m128i ga = _mm_packus_epi16(g, alpha);
+      const __m128i bg = _mm_unpacklo_epi8(br, ga);
+      const __m128i ra = _mm_unpackhi_epi8(br, ga);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), _mm_unpacklo_epi16(bg, ra));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i + 16), _mm_unpackhi_epi16(bg, ra));
+   }
+   return i;
+}
+
+// 16 pixels (32 bytes) per iteration
+std::size_t YUV422ToGray8SSE2(uint8_t* dst, const uint8_t* src, std::size_t count,
+   bool yFirst)
+{
+   const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+   std::size_t i = 0;
+   for (; i + 16 <= count; i += 16)
+   {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+      __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 16));
+      a = yFirst ? _mm_and_si128(a, lowBytes) : _mm_srli_epi16(a, 8);
+      b = yFirst ? _mm_and_si128(b, lowBytes) : _mm_srli_epi16(b, 8);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+   }
+   return i;
+}
+
+#endif // PIXCONV_HAVE_SSE2
+
+#ifdef PIXCONV_HAVE_AVX2
+
+///////////////////////////////////////////////////////////////////////////////
+// SSSE3 and AVX2 kernels
+///////////////////////////////////////////////////////////////////////////////
+//
+// The unpacking kernels gather the two bytes holding each pixel into a
+// 16-bit lane with a byte shuffle, then extract the pixel with a fixed
+// sequence of per-lane operations (see the Unpack*Params below). The AVX2
+// versions run the same shuffle on two 128-bit lanes, each loaded from its
+// own block of the source.
+
+// 12-bit formats: pixel = ((word >> 4) & maskHigh) | (word & maskLow)
+struct Unpack12Params
+{
+   int8_t shuffle[16];
+   uint16_t maskHigh[8];
+   uint16_t maskLow[8];
+};
+
+// Mono12p: a = w(b0, b1) & 0xfff, b = w(b1, b2) >> 4
+const Unpack12Params Mono12pParams = {
+   { 0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11 },
+   { 0, 0x0fff, 0, 0x0fff, 0, 0x0fff, 0, 0x0fff },
+   { 0x0fff, 0, 0x0fff, 0, 0x0fff, 0, 0x0fff, 0 },
+};
+
+// Mono12Packed: a = ((w(b1, b0) >> 4) & 0xff0) | (b1 & 0xf), b = w(b1, b2) >> 4
+const Unpack12Params Mono12PackedParams = {
+   { 1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11 },
+   { 0x0ff0, 0x0fff, 0x0ff0, 0x0fff, 0x0ff0, 0x0fff, 0x0ff0, 0x0fff },
+   { 0x000f, 0, 0x000f, 0, 0x000f, 0, 0x000f, 0 },
+};
+
+// Mono10p: pixel j of each group of 4 starts at bit 2j of its first byte;
+// multiplying by 2^(6 - 2j) and shifting right by 6 extracts it.
+const int8_t Mono10pShuffle[16] = { 0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9 };
+const int16_t Mono10pScale[8] = { 64, 16, 4, 1, 64, 16, 4, 1 };
+
+inline __m128i Load128(const void* p)
+{
+   return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// 8 pixels (12 bytes) per iteration
+PIXCONV_TARGET_SSSE3 std::size_t Unpack12SSSE3(uint16_t* dst, const uint8_t* src,
+   std::size_t count, std::size_t srcBytes, const Unpack12Params& params)
+{
+   const __m128i shuffle = Load128(params.shuffle);
+   const __m128i maskHigh = Load128(params.maskHigh);
+   const __m128i maskLow = Load128(params.maskLow);
+   std::size_t i = 0;
+   for (; i + 8 <= count && i / 8 * 12 + 16 <= srcBytes; i += 8)
+   {
+      const __m128i w = _mm_shuffle_epi8(Load128(src + i / 8 * 12), shuffle);
+      const __m128i p = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(w, 4), maskHigh),
+         _mm_and_si128(w, maskLow));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), p);
+   }
+   return i;
+}
+
+// 8 pixels (10 bytes) per iteration
+PIXCONV_TARGET_SSSE3 std::size_t UnpackMono10pSSSE3(uint16_t* dst, const uint8_t* src,
+   std::size_t count, std::size_t srcBytes)
+{
+   const __m128i shuffle = Load128(Mono10pShuffle);
+   const __m128i scale = Load128(Mono10pScale);
+   std::size_t i = 0;
+   for (; i + 8 <= count && i / 8 * 10 + 16 <= srcBytes; i += 8)
+   {
+      const __m128i w = _mm_shuffle_epi8(Load128(src + i / 8 * 10), shuffle);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+         _mm_srli_epi16(_mm_mullo_epi16(w, scale), 6));
+   }
+   return i;
+}
+
+// 4 pixels (12 bytes) per iteration
+PIXCONV_TARGET_SSSE3 std::size_t Color24ToRGB32SSSE3(uint8_t* dst, const uint8_t* src,
+   std::size_t count, bool bgr)
+{
+   const __m128i shuffle = bgr ?
+      _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1) :
+      _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+   const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+   std::size_t i = 0;
+   for (; i + 4 <= count && 3 * i + 16 <= 3 * count; i += 4)
+   {
+      const __m128i x = _mm_shuffle_epi8(Load128(src + 3 * i), shuffle);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), _mm_or_si128(x, alpha));
+   }
+   return i;
+}
+
+PIXCONV_TARGET_AVX2 inline __m256i LoadTwo128(const uint8_t* lo, const uint8_t* hi)
+{
+   return _mm256_inserti128_si256(_mm256_castsi128_si256(Load128(lo)), Load128(hi), 1);
+}
+
+PIXCONV_TARGET_AVX2 inline __m256i Broadcast128(const void* p)
+{
+   const __m128i x = Load128(p);
+   return _mm256_inserti128_si256(_mm256_castsi128_si256(x), x, 1);
+}
+
+// 16 pixels (24 bytes) per iteration
+PIXCONV_TARGET_AVX2 std::size_t Unpack12AVX2(uint16_t* dst, const uint8_t* src,
+   std::size_t count, std::size_t srcBytes, const Unpack12Params& params)
+{
+   const __m256i shuffle = Broadcast128(params.shuffle);
+   const __m256i maskHigh = Broadcast128(params.maskHigh);
+   const __m256i maskLow = Broadcast128(params.maskLow);
+   std::size_t i = 0;
+   for (; i + 16 <= count && i / 8 * 12 + 28 <= srcBytes; i += 16)
+   {
+      const uint8_t* s = src + i / 8 * 12;
+      const __m256i w = _mm256_shuffle_epi8(LoadTwo128(s, s + 12), shuffle);
+      const __m256i p = _mm256_or_si256(
+         _mm256_and_si256(_mm256_srli_epi16(w, 4), maskHigh),
+         _mm256_and_si256(w, maskLow));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), p);
+   }
+   return i;
+}
+
+// 16 pixels (20 bytes) per iteration
+PIXCONV_TARGET_AVX2 std::size_t UnpackMono10pAVX2(uint16_t* dst, const uint8_t* src,
+   std::size_t count, std::size_t srcBytes)
+{
+   const __m256i shuffle = Broadcast128(Mono10pShuffle);
+   const __m256i scale = Broadcast128(Mono10pScale);
+   std::size_t i = 0;
+   for (; i + 16 <= count && i / 8 * 10 + 26 <= srcBytes; i += 16)
+   {
+      const uint8_t* s = src + i / 8 * 10;
+      const __m256i w = _mm256_shuffle_epi8(LoadTwo128(s, s + 10), shuffle);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+         _mm256_srli_epi16(_mm256_mullo_epi16(w, scale), 6));
+   }
+   return i;
+}
+
+PIXCONV_TARGET_AVX2 std::size_t ByteSwap16AVX2(uint16_t* dst, const uint16_t* src,
+   std::size_t count)
+{
+   std::size_t i = 0;
+   for (; i + 16 <= count; i += 16)
+   {
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+         _mm256_or_si256(_mm256_slli_epi16(x, 8), _mm256_srli_epi16(x, 8)));
+   }
+   return i;
+}
+
+// 32 pixels (64 bytes) per iteration
+PIXCONV_TARGET_AVX2 std::size_t YUV422ToGray8AVX2(uint8_t* dst, const uint8_t* src,
+   std::size_t count, bool yFirst)
+{
+   const __m256i lowBytes = _mm256_set1_epi16(0x00ff);
+   std::size_t i = 0;
+   for (; i + 32 <= count; i += 32)
+   {
+      __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * i));
+      __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * i + 32));
+      a = yFirst ? _mm256_and_si256(a, lowBytes) : _mm256_srli_epi16(a, 8);
+      b = yFirst ? _mm256_and_si256(b, lowBytes) : _mm256_srli_epi16(b, 8);
+      // The pack works within 128-bit lanes; restore the order of the quads
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+         _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8));
+   }
+   return i;
+}
+
+#endif // PIXCONV_HAVE_AVX2
+
+} // anonymous namespace
+
+SimdLevel GetSupportedSimdLevel()
+{
+   static const SimdLevel supported = DetectSimdLevel();
+   return supported;
+}
+
+SimdLevel GetSimdLevel()
+{
+   return Level();
+}
+
+void SetSimdLevel(SimdLevel level)
+{
+   const SimdLevel supported = GetSupportedSimdLevel();
+   ActiveLevel().store(level < supported ? level : supported);
+}
+
+void UnpackMono10p(uint16_t* dst, const uint8_t* src, std::size_t count)
+{
+   std::size_t done = 0;
+#ifdef PIXCONV_HAVE_AVX2
+   const std::size_t srcBytes = (count * 10 + 7) / 8;
+   const SimdLevel level = Level();
+   if (level >= SimdAVX2)
+      done = UnpackMono10pAVX2(dst, src, count, srcBytes);
+   if (level >= SimdSSSE3)
+      done += UnpackMono10pSSSE3(dst + done, src + done / 8 * 10, count - done,
+         srcBytes - done / 8 * 10);
+#endif
+   UnpackLSBFirstScalar<10>(dst, src, done, count);
+}
+
+void UnpackMono12p(uint16_t* dst, const uint8_t* src, std::size_t count)
+{
+   std::size_t done = 0;
+#ifdef PIXCONV_HAVE_AVX2
+   const std::size_t srcBytes = (count * 12 + 7) / 8;
+   const SimdLevel level = Level();
+   if (level >= SimdAVX2)
+      done = Unpack12AVX2(dst, src, count, srcBytes, Mono12pParams);
+   if (level >= SimdSSSE3)
+      done += Unpack12SSSE3(dst + done, src + done / 8 * 12, count - done,
+         srcBytes - done / 8 * 12, Mono12pParams);
+#endif
+   UnpackLSBFirstScalar<12>(dst, src, done, count);
+}
+
+void UnpackMono10Packed(uint16_t* dst, const uint8_t* src, std::size_t count)
+{
+   UnpackPairsScalar<10>(dst, src, 0, count);
+}
+
+void UnpackMono12Packed(uint16_t* dst, const uint8_t* src, std::size_t count)
+{
+   std::size_t done = 0;
+#ifdef PIXCONV_HAVE_AVX2
+   const std::size_t srcBytes = (count * 12 + 7) / 8;
+   const SimdLevel level = Level();
+   if (level >= SimdAVX2)
+      done = Unpack12AVX2(dst, src, count, srcBytes, Mono12PackedParams);
+   if (level >= SimdSSSE3)
+      done += Unpack12SSSE3(dst + done, src + done / 8 * 12, count - done,
+         srcBytes - done / 8 * 12, Mono12PackedParams);
+#endif
+   UnpackPairsScalar<12>(dst, src, done, count);
+}
+
+void ByteSwap16(uint16_t* dst, const uint16_t* src, std::size_t count)
+{
+   std::size_t done = 0;
+#ifdef PIXCONV_HAVE_SSE2
+   const SimdLevel level = Level();
+#ifdef PIXCONV_HAVE_AVX2
+   if (level >= SimdAVX2)
+      done = ByteSwap16AVX2(dst, src, count);
+#endif
+   if (level >= SimdSSE2)
+      done += ByteSwap16SSE2(dst + done, src + done, count - done);
+#endif
+   ByteSwap16Scalar(dst, src, done, count);
+}
+
+void RGB24ToRGB32(uint8_t* dst, const uint8_t* src, std::size_t count)
+{
+   std::size_t done = 0;
+#ifdef PIXCONV_HAVE_AVX2
+   if (Level() >= SimdSSSE3)
+      done = Color24ToRGB32SSSE3(dst, src, count, false);
+#endif
+   Color24ToRGB32Scalar(dst, src, done, count, 0);
+}
+
+void BGR24ToRGB32(uint8_t* dst, const uint8_t* src, std::size_t count)
+{
+   std::size_t done = 0;
+#ifdef PIXCONV_HAVE_AVX2
+   if (Level() >= SimdSSSE3)
+      done = Color24ToRGB32SSSE3(dst, src, count, true);
+#endif
+   Color24ToRGB32Scalar(dst, src, done, count, 2);
+}
+
+void YUYVToRGB32(uint8_t* dst, const uint8_t* src, std::size_t count)
+{
+   std::size_t done = 0;
+#ifdef PIXCONV_HAVE_SSE2
+   if (Level() >= SimdSSE2)
+      done = YUV422ToRGB32SSE2(dst, src, count, true);
+#endif
+   YUV422ToRGB32Scalar(dst, src, done, count, 0);
+}
+
+void UYVYToRGB32(uint8_t* dst, const uint8_t* src, std::size_t count)
+{
+   std::size_t done = 0;
+#ifdef PIXCONV_HAVE_SSE2
+   if (Level() >= SimdSSE2)
+      done = YUV422ToRGB32SSE2(dst, src, count, false);
+#endif
+   YUV422ToRGB32Scalar(dst, src, done, count, 1);
+}
+
+void YUYVToGray8(uint8_t* dst, const uint8_t* src, std::size_t count)
+{
+   std::size_t done = 0;
+#ifdef PIXCONV_HAVE_SSE2
+   const SimdLevel level = Level();
+#ifdef PIXCONV_HAVE_AVX2
+   if (level >= SimdAVX2)
+      done = YUV422ToGray8AVX2(dst, src, count, true);
+#endif
+   if (level >= SimdSSE2)
+      done += YUV422ToGray8SSE2(dst + done, src + 2 * done, count - done, true);
+#endif
+   YUV422ToGray8Scalar(dst, src, done, count, 0);
+}
+
+void UYVYToGray8(uint8_t* dst, const uint8_t* src, std::size_t count)
+{
+   std::size_t done = 0;
+#ifdef PIXCONV_HAVE_SSE2
+   const SimdLevel level = Level();
+#ifdef PIXCONV_HAVE_AVX2
+   if (level >= SimdAVX2)
+      done = YUV422ToGray8AVX2(dst, src, count, false);
+#endif
+   if (level >= SimdSSE2)
+      done += YUV422ToGray8SSE2(dst + done, src + 2 * done, count - done, false);
+#endif
+   YUV422ToGray8Scalar(dst, src, done, count, 1);
+}
+
+} // namespace PixelConversion
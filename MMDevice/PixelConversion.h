@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          PixelConversion.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMDevice - Device adapter kit
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Conversions from common camera pixel formats to the formats
+//                used by Micro-Manager (16-bit grayscale and 32-bit RGB)
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+// Each function converts a run of 'count' pixels, e.g. one image or one row.
+// On x86 the conversions use SSE2, SSSE3 or AVX2 kernels, selected at run
+// time from what the CPU supports; the results are identical on all paths.
+// Source and destination must not overlap unless stated otherwise.
+namespace PixelConversion {
+
+enum SimdLevel
+{
+   SimdNone,
+   SimdSSE2,
+   SimdSSSE3,
+   SimdAVX2,
+};
+
+// The best instruction set supported by both the CPU and this build
+SimdLevel GetSupportedSimdLevel();
+
+// The instruction set used by the conversions, initially the supported one.
+// SetSimdLevel() can lower it (for testing or comparison); levels above the
+// supported one are clamped.
+SimdLevel GetSimdLevel();
+void SetSimdLevel(SimdLevel level);
+
+// Packed monochrome formats to 16 bits per pixel. Odd pixel counts are
+// allowed; 'src' holds (count * bits + 7) / 8 bytes, except for Mono10Packed
+// which takes 3 bytes per pair of pixels (2 for a final odd pixel).
+//
+// Mono10p and Mono12p (GenICam PFNC) pack pixels LSB first with no padding;
+// e.g. Mono12p stores pixels a and b as a[7:0], b[3:0]a[11:8], b[11:4].
+// Mono10Packed and Mono12Packed (GigE Vision) store each pair of pixels in 3
+// bytes: the high 8 bits of pixel a, the low bits of both pixels (a in the
+// low nibble), then the high 8 bits of pixel b.
+void UnpackMono10p(uint16_t* dst, const uint8_t* src, std::size_t count);
+void UnpackMono12p(uint16_t* dst, const uint8_t* src, std::size_t count);
+void UnpackMono10Packed(uint16_t* dst, const uint8_t* src, std::size_t count);
+void UnpackMono12Packed(uint16_t* dst, const uint8_t* src, std::size_t count);
+
+// Swaps the bytes of each 16-bit pixel (big- to little-endian or back).
+// dst may equal src.
+void ByteSwap16(uint16_t* dst, const uint16_t* src, std::size_t count);
+
+// 24-bit color to Micro-Manager's 32-bit RGB (bytes B, G, R, 255).
+void RGB24ToRGB32(uint8_t* dst, const uint8_t* src, std::size_t count);
+void BGR24ToRGB32(uint8_t* dst, const uint8_t* src, std::size_t count);
+
+// YUV 4:2:2 (BT.601, limited range) to 32-bit RGB. YUYV stores two pixels
+// as Y0 U Y1 V, UYVY as U Y0 V Y1. count must be even.
+void YUYVToRGB32(uint8_t* dst, const uint8_t* src, std::size_t count);
+void UYVYToRGB32(uint8_t* dst, const uint8_t* src, std::size_t count);
+
+// The luma of YUV 4:2:2 as 8-bit grayscale (Y copied unchanged, so black and
+// white are 16 and 235). count must be even.
+void YUYVToGray8(uint8_t* dst, const uint8_t* src, std::size_t count);
+void UYVYToGray8(uint8_t* dst, const uint8_t* src, std::size_t count);
+
+} // namespace PixelConversion
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          RowBands.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMDevice - Device adapter kit
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Splits per-row image work into horizontal bands that run on
+//                a persistent set of worker threads
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+#include "RowBands.h"
+
+#include <algorithm>
+#include <system_error>
+
+struct RowBandPool::Job
+{
+   const BandFunc* band;
+   unsigned height;
+   unsigned rowsPerBand;
+   unsigned bands;
+   unsigned started;
+   unsigned finished;
+   std::exception_ptr error;
+};
+
+RowBandPool::RowBandPool() :
+   stopping_(false)
+{
+}
+
+RowBandPool::~RowBandPool()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+   }
+   workCv_.notify_all();
+   for (std::thread& worker : workers_)
+      worker.join();
+}
+
+void RowBandPool::ForEachRowBand(unsigned width, unsigned height,
+   unsigned maxBands, const BandFunc& band)
+{
+   long long bands;
+   if (maxBands == 0)
+   {
+      const long long minPixelsPerBand = 1 << 18;
+      const long long minRowsPerBand = 16;
+      bands = std::thread::hardware_concurrency();
+      bands = (std::min)(bands, (long long)width * height / minPixelsPerBand);
+      bands = (std::min)(bands, (long long)height / minRowsPerBand);
+   }
+   else
+   {
+      bands = (std::min)((long long)maxBands, (long long)height);
+   }
+   if (bands <= 1)
+   {
+      band(0, height);
+      return;
+   }
+
+   Job job;
+   job.band = &band;
+   job.height = height;
+   job.rowsPerBand = (unsigned)((height + bands - 1) / bands);
+   job.bands = (height + job.rowsPerBand - 1) / job.rowsPerBand;
+   job.started = 0;
+   job.finished = 0;
+
+   std::unique_lock<std::mutex> lock(mutex_);
+   StartWorkers(job.bands - 1);
+   jobs_.push_back(&job);
+   workCv_.notify_all();
+   while (job.started < job.bands)
+      RunBand(job, lock);
+   doneCv_.wait(lock, [&] { return job.finished == job.bands; });
+   lock.unlock();
+
+   if (job.error)
+      std::rethrow_exception(job.error);
+}
+
+void RowBandPool::RunBand(Job& job, std::unique_lock<std::mutex>& lock)
+{
+   const unsigned y0 = job.started * job.rowsPerBand;
+   const unsigned y1 = (std::min)(y0 + job.rowsPerBand, job.height);
+   if (++job.started == job.bands)
+      jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &job));
+
+   lock.unlock();
+   std::exception_ptr error;
+   try
+   {
+      (*job.band)(y0, y1);
+   }
+   catch (...)
+   {
+      error = std::current_exception();
+   }
+   lock.lock();
+
+   if (error && !job.error)
+      job.error = error;
+   if (++job.finished == job.bands)
+      doneCv_.notify_all();
+}
+
+void RowBandPool::StartWorkers(unsigned count)
+{
+   const unsigned cores = std::thread::hardware_concurrency();
+   count = (std::min)(count, cores > 1 ? cores - 1 : 1);
+   while (workers_.size() < count)
+   {
+      try
+      {
+         workers_.emplace_back(&RowBandPool::WorkerLoop, this);
+      }
+      catch (const std::system_error&)
+      {
+         break; // Out of threads; the existing ones share the bands
+      }
+   }
+}
+
+void RowBandPool::WorkerLoop()
+{
+   std::unique_lock<std::mutex> lock(mutex_);
+   for (;;)
+   {
+      workCv_.wait(lock, [&] { return stopping_ || !jobs_.empty(); });
+      if (stopping_)
+         return;
+      RunBand(*jobs_.front(), lock);
+   }
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          RowBands.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     MMDevice - Device adapter kit
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Splits per-row image work into horizontal bands that run on
+//                a persistent set of worker threads
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs per-row image processing over horizontal bands of the image, in
+ * parallel.
+ *
+ * Worker threads are started on first use and kept until the pool is
+ * destroyed, so that per-frame processing does not pay for thread startup.
+ * The calling thread works on bands too. Give each object that processes
+ * frames (a camera, a Debayer) its own pool, so that the workers are joined
+ * when that object is destroyed rather than when the module is unloaded.
+ *
+ * ForEachRowBand() may be called from several threads at once; the calls
+ * share the workers.
+ */
+class RowBandPool
+{
+public:
+   typedef std::function<void(unsigned y0, unsigned y1)> BandFunc;
+
+   RowBandPool();
+   ~RowBandPool();
+
+   RowBandPool(const RowBandPool&) = delete;
+   RowBandPool& operator=(const RowBandPool&) = delete;
+
+   // Runs band(y0, y1) over bands of rows covering [0, height) and returns
+   // when all have finished. An exception thrown by any band is rethrown
+   // once all bands have finished.
+   //
+   // maxBands = 0 picks the band count from the image size and the number
+   // of cores, running small images on the calling thread only; otherwise
+   // the image is split into min(maxBands, height) bands.
+   void ForEachRowBand(unsigned width, unsigned height, unsigned maxBands,
+      const BandFunc& band);
+
+private:
+   struct Job;
+
+   void RunBand(Job& job, std::unique_lock<std::mutex>& lock);
+   void StartWorkers(unsigned count); // Call with mutex_ held
+   void WorkerLoop();
+
+   std::mutex mutex_;
+   std::condition_variable workCv_;
+   std::condition_variable doneCv_;
+   std::deque<Job*> jobs_; // Jobs with bands not yet started
+   std::vector<std::thread> workers_;
+   bool stopping_;
+};
@@ -0,0 +1,354 @@
+#include <catch2/catch_all.hpp>
+
+#include "Debayer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+enum
+{
+   AlgoReplication = 0,
+   AlgoBilinear = 1,
+   AlgoMalvar = 4,
+};
+
+template <typename T>
+std::vector<T> RandomMosaic(int width, int height, int bitDepth, unsigned seed)
+{
+   std::mt19937 rng(seed);
+   std::uniform_int_distribution<int> dist(0, (1 << bitDepth) - 1);
+   std::vector<T> pixels(width * height);
+   for (T& p : pixels)
+      p = static_cast<T>(dist(rng));
+   return pixels;
+}
+
+// The red sample of each 2x2 cell is at (rx, ry); blue is at (1-rx, 1-ry).
+void RedPosition(int order, int& rx, int& ry)
+{
+   const int pos[4][2] = { {0, 0}, {1, 1}, {0, 1}, {1, 0} };
+   rx = pos[order][0];
+   ry = pos[order][1];
+}
+
+// 0 = red, 1 = green, 2 = blue
+int ColorAt(int x, int y, int order)
+{
+   int rx, ry;
+   RedPosition(order, rx, ry);
+   if ((x & 1) == rx && (y & 1) == ry)
+      return 0;
+   if ((x & 1) != rx && (y & 1) != ry)
+      return 2;
+   return 1;
+}
+
+std::vector<std::uint32_t> Pack(const std::vector<int> planes[3], int shift)
+{
+   std::vector<std::uint32_t> out(planes[0].size());
+   for (std::size_t i = 0; i < out.size(); ++i)
+   {
+      out[i] = (std::uint32_t)(unsigned char)(planes[2][i] >> shift) |
+         ((std::uint32_t)(unsigned char)(planes[1][i] >> shift) << 8) |
+         ((std::uint32_t)(unsigned char)(planes[0][i] >> shift) << 16);
+   }
+   return out;
+}
+
+// Restatement of the original three-plane replication decoder, kept here to
+// check that the single-pass kernel reproduces it exactly.
+template <typename T>
+std::vector<std::uint32_t> ReferenceReplicate(const std::vector<T>& in,
+   int width, int height, int bitDepth, int order)
+{
+   std::vector<int> planes[3];
+   for (auto& p : planes)
+      p.assign(width * height, 0);
+   auto set = [&](int c, int x, int y, int v) {
+      if (x < width && y < height)
+         planes[c][y * width + x] = v;
+   };
+   for (int y = 0; y < height; ++y)
+   {
+      for (int x = 0; x < width; ++x)
+      {
+         const int v = in[y * width + x];
+         const int c = ColorAt(x, y, order);
+         set(c, x, y, v);
+         set(c, x + 1, y, v);
+         if (c != 1)
+         {
+            set(c, x, y + 1, v);
+            set(c, x + 1, y + 1, v);
+         }
+      }
+   }
+   return Pack(planes, bitDepth - 8);
+}
+
+int Mirror(int i, int n)
+{
+   if (n == 1)
+      return 0;
+   while (i < 0 || i >= n)
+      i = i < 0 ? -i : 2 * (n - 1) - i;
+   return i;
+}
+
+// Bilinear demosaicing defined as the rounded mean of all samples of each
+// color in the (mirrored) 3x3 neighborhood.
+template <typename T>
+std::vector<std::uint32_t> ReferenceBilinear(const std::vector<T>& in,
+   int width, int height, int bitDepth, int order)
+{
+   std::vector<int> planes[3];
+   for (auto& p : planes)
+      p.assign(width * height, 0);
+   for (int y = 0; y < height; ++y)
+   {
+      for (int x = 0; x < width; ++x)
+      {
+         int sum[3] = { 0, 0, 0 };
+         int count[3] = { 0, 0, 0 };
+         for (int dy = -1; dy <= 1; ++dy)
+         {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+               if (dx != 0 && dy != 0 && ColorAt(x, y, order) == 1)
+                  continue; // Green sites interpolate from the 4-neighbors only
+               const int c = ColorAt(x + dx, y + dy, order);
+               sum[c] += in[Mirror(y + dy, height) * width + Mirror(x + dx, width)];
+               ++count[c];
+            }
+         }
+         const int own = ColorAt(x, y, order);
+         for (int c = 0; c < 3; ++c)
+         {
+            planes[c][y * width + x] = (c == own) ? in[y * width + x] :
+               (sum[c] + count[c] / 2) / count[c];
+         }
+      }
+   }
+   return Pack(planes, bitDepth - 8);
+}
+
+// Malvar-He-Cutler filters as published, scaled by 16
+const int malvarGreenAtColor[5][5] = {
+   { 0, 0, -2, 0, 0 },
+   { 0, 0, 4, 0, 0 },
+   { -2, 4, 8, 4, -2 },
+   { 0, 0, 4, 0, 0 },
+   { 0, 0, -2, 0, 0 },
+};
+const int malvarRowColorAtGreen[5][5] = {
+   { 0, 0, 1, 0, 0 },
+   { 0, -2, 0, -2, 0 },
+   { -2, 8, 10, 8, -2 },
+   { 0, -2, 0, -2, 0 },
+   { 0, 0, 1, 0, 0 },
+};
+const int malvarColumnColorAtGreen[5][5] = {
+   { 0, 0, -2, 0, 0 },
+   { 0, -2, 8, -2, 0 },
+   { 1, 0, 10, 0, 1 },
+   { 0, -2, 8, -2, 0 },
+   { 0, 0, -2, 0, 0 },
+};
+const int malvarOppositeAtColor[5][5] = {
+   { 0, 0, -3, 0, 0 },
+   { 0, 4, 0, 4, 0 },
+   { -3, 0, 12, 0, -3 },
+   { 0, 4, 0, 4, 0 },
+   { 0, 0, -3, 0, 0 },
+};
+
+template <typename T>
+std::vector<std::uint32_t> ReferenceMalvar(const std::vector<T>& in,
+   int width, int height, int bitDepth, int order)
+{
+   const int maxValue = (1 << bitDepth) - 1;
+   auto filter = [&](const int k[5][5], int x, int y) {
+      int sum = 0;
+      for (int dy = -2; dy <= 2; ++dy)
+         for (int dx = -2; dx <= 2; ++dx)
+            sum += k[dy + 2][dx + 2] *
+               in[Mirror(y + dy, height) * width + Mirror(x + dx, width)];
+      return sum < 0 ? 0 : std::min((sum + 8) >> 4, maxValue);
+   };
+
+   std::vector<int> planes[3];
+   for (auto& p : planes)
+      p.assign(width * height, 0);
+   for (int y = 0; y < height; ++y)
+   {
+      for (int x = 0; x < width; ++x)
+      {
+         const int i = y * width + x;
+         const int own = ColorAt(x, y, order);
+         planes[own][i] = in[i];
+         if (own != 1)
+         {
+            planes[1][i] = filter(malvarGreenAtColor, x, y);
+            planes[2 - own][i] = filter(malvarOppositeAtColor, x, y);
+         }
+         else
+         {
+            const int rowColor = ColorAt(x + 1, y, order);
+            planes[rowColor][i] = filter(malvarRowColorAtGreen, x, y);
+            planes[2 - rowColor][i] = filter(malvarColumnColorAtGreen, x, y);
+         }
+      }
+   }
+   return Pack(planes, bitDepth - 8);
+}
+
+template <typename T>
+std::vector<std::uint32_t> Run(Debayer& debayer, const std::vector<T>& in,
+   int width, int height, int bitDepth, int order, int algorithm)
+{
+   debayer.SetOrderIndex(order);
+   debayer.SetAlgorithmIndex(algorithm);
+   ImgBuffer out;
+   REQUIRE(debayer.Process(out, in.data(), width, height, bitDepth) == DEVICE_OK);
+   REQUIRE(out.Width() == (unsigned)width);
+   REQUIRE(out.Height() == (unsigned)height);
+   REQUIRE(out.Depth() == 4u);
+   const std::uint32_t* p = reinterpret_cast<const std::uint32_t*>(out.GetPixels());
+   return std::vector<std::uint32_t>(p, p + width * height);
+}
+
+// Mosaic of a scene with a single uniform color
+template <typename T>
+std::vector<T> FlatColorMosaic(int width, int height, int order, const int rgb[3])
+{
+   std::vector<T> pixels(width * height);
+   for (int y = 0; y < height; ++y)
+      for (int x = 0; x < width; ++x)
+         pixels[y * width + x] = static_cast<T>(rgb[ColorAt(x, y, order)]);
+   return pixels;
+}
+
+const int sizes[][2] = {
+   {1, 1}, {2, 2}, {3, 2}, {5, 7}, {8, 8}, {37, 29}, {64, 3}, {1030, 700},
+};
+
+} // namespace
+
+TEST_CASE("Debayer replication matches original implementation", "[Debayer]")
+{
+   Debayer debayer;
+   for (const auto& size : sizes)
+   {
+      const int w = size[0];
+      const int h = size[1];
+      for (int order = 0; order < 4; ++order)
+      {
+         CAPTURE(w, h, order);
+         const auto in8 = RandomMosaic<unsigned char>(w, h, 8, 1);
+         CHECK(Run(debayer, in8, w, h, 8, order, AlgoReplication) ==
+            ReferenceReplicate(in8, w, h, 8, order));
+         const auto in12 = RandomMosaic<unsigned short>(w, h, 12, 2);
+         CHECK(Run(debayer, in12, w, h, 12, order, AlgoReplication) ==
+            ReferenceReplicate(in12, w, h, 12, order));
+      }
+   }
+}
+
+TEST_CASE("Debayer bilinear matches reference", "[Debayer]")
+{
+   Debayer debayer;
+   for (const auto& size : sizes)
+   {
+      const int w = size[0];
+      const int h = size[1];
+      if (w < 2 || h < 2)
+         continue; // A single row or column has no Bayer pattern to speak of
+      for (int order = 0; order < 4; ++order)
+      {
+         CAPTURE(w, h, order);
+         const auto in8 = RandomMosaic<unsigned char>(w, h, 8, 3);
+         CHECK(Run(debayer, in8, w, h, 8, order, AlgoBilinear) ==
+            ReferenceBilinear(in8, w, h, 8, order));
+         const auto in16 = RandomMosaic<unsigned short>(w, h, 16, 4);
+         CHECK(Run(debayer, in16, w, h, 16, order, AlgoBilinear) ==
+            ReferenceBilinear(in16, w, h, 16, order));
+      }
+   }
+}
+
+TEST_CASE("Debayer interpolating algorithms reproduce a flat color", "[Debayer]")
+{
+   Debayer debayer;
+   const int rgb[3] = { 200 << 4, 100 << 4, 50 << 4 };
+   const std::uint32_t expected = (200u << 16) | (100u << 8) | 50u;
+   for (int algorithm : { AlgoBilinear, AlgoMalvar })
+   {
+      for (int order = 0; order < 4; ++order)
+      {
+         CAPTURE(algorithm, order);
+         const auto in = FlatColorMosaic<unsigned short>(37, 29, order, rgb);
+         const auto out = Run(debayer, in, 37, 29, 12, order, algorithm);
+         CHECK(out == std::vector<std::uint32_t>(out.size(), expected));
+      }
+   }
+}
+
+TEST_CASE("Debayer Malvar-He-Cutler matches reference", "[Debayer]")
+{
+   Debayer debayer;
+   for (const auto& size : sizes)
+   {
+      const int w = size[0];
+      const int h = size[1];
+      if (w < 2 || h < 2)
+         continue;
+      for (int order = 0; order < 4; ++order)
+      {
+         CAPTURE(w, h, order);
+         const auto in8 = RandomMosaic<unsigned char>(w, h, 8, 5);
+         CHECK(Run(debayer, in8, w, h, 8, order, AlgoMalvar) ==
+            ReferenceMalvar(in8, w, h, 8, order));
+         const auto in12 = RandomMosaic<unsigned short>(w, h, 12, 6);
+         CHECK(Run(debayer, in12, w, h, 12, order, AlgoMalvar) ==
+            ReferenceMalvar(in12, w, h, 12, order));
+      }
+   }
+}
+
+TEST_CASE("Debayer rejects unsupported algorithm", "[Debayer]")
+{
+   Debayer debayer;
+   debayer.SetAlgorithmIndex(3);
+   std::vector<unsigned char> in(16);
+   ImgBuffer out;
+   CHECK(debayer.Process(out, in.data(), 4, 4, 8) == DEVICE_NOT_SUPPORTED);
+}
+
+TEST_CASE("Debayer 20 MP throughput", "[.][benchmark][Debayer]")
+{
+   const int w = 5472;
+   const int h = 3648;
+   const auto in = RandomMosaic<unsigned short>(w, h, 12, 6);
+   Debayer debayer;
+   ImgBuffer out(w, h, 4);
+
+   debayer.SetAlgorithmIndex(AlgoReplication);
+   BENCHMARK("Replication")
+   {
+      return debayer.Process(out, in.data(), w, h, 12);
+   };
+   debayer.SetAlgorithmIndex(AlgoBilinear);
+   BENCHMARK("Bilinear")
+   {
+      return debayer.Process(out, in.data(), w, h, 12);
+   };
+   debayer.SetAlgorithmIndex(AlgoMalvar);
+   BENCHMARK("Malvar-He-Cutler")
+   {
+      return debayer.Process(out, in.data(), w, h, 12);
+   };
+}
@@ -0,0 +1,345 @@
+#include <catch2/catch_all.hpp>
+
+#include "PixelConversion.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace PixelConversion;
+
+namespace {
+
+std::vector<std::uint8_t> RandomBytes(std::size_t n, unsigned seed)
+{
+   std::mt19937 rng(seed);
+   std::uniform_int_distribution<int> dist(0, 255);
+   std::vector<std::uint8_t> bytes(n);
+   for (std::uint8_t& b : bytes)
+      b = static_cast<std::uint8_t>(dist(rng));
+   return bytes;
+}
+
+// Bit-by-bit reading of LSB-first packed pixels
+std::vector<std::uint16_t> ReferenceLSBFirst(const std::vector<std::uint8_t>& src,
+   std::size_t count, unsigned bits)
+{
+   std::vector<std::uint16_t> out(count);
+   for (std::size_t i = 0; i < count; ++i)
+   {
+      unsigned v = 0;
+      for (unsigned k = 0; k < bits; ++k)
+      {
+         const std::size_t bit = i * bits + k;
+         v |= ((src[bit / 8] >> (bit % 8)) & 1u) << k;
+      }
+      out[i] = static_cast<std::uint16_t>(v);
+   }
+   return out;
+}
+
+std::vector<std::uint16_t> ReferenceGigEPacked(const std::vector<std::uint8_t>& src,
+   std::size_t count, unsigned bits)
+{
+   const unsigned low = bits - 8;
+   std::vector<std::uint16_t> out(count);
+   for (std::size_t i = 0; i < count; ++i)
+   {
+      const std::uint8_t* pair = &src[i / 2 * 3];
+      const unsigned high = (i % 2 == 0) ? pair[0] : pair[2];
+      const unsigned lowBits = (i % 2 == 0) ? (pair[1] & 0x0f) : (pair[1] >> 4);
+      out[i] = static_cast<std::uint16_t>((high << low) | (lowBits & ((1u << low) - 1)));
+   }
+   return out;
+}
+
+std::vector<std::uint8_t> ReferenceYUV422(const std::vector<std::uint8_t>& src,
+   std::size_t count, bool yuyv)
+{
+   std::vector<std::uint8_t> out(4 * count);
+   for (std::size_t i = 0; i < count; ++i)
+   {
+      const std::uint8_t* pair = &src[i / 2 * 4];
+      const int y = yuyv ? pair[2 * (i % 2)] : pair[1 + 2 * (i % 2)];
+      const int u = yuyv ? pair[1] : pair[0];
+      const int v = yuyv ? pair[3] : pair[2];
+      // Real-valued BT.601, rounded; the integer formula stays within 2 of it
+      const double c = 1.164 * (y - 16);
+      const double rgb[3] = {
+         c + 2.018 * (u - 128),
+         c - 0.391 * (u - 128) - 0.813 * (v - 128),
+         c + 1.596 * (v - 128),
+      };
+      for (int k = 0; k < 3; ++k)
+      {
+         const double clamped = rgb[k] < 0.0 ? 0.0 : (rgb[k] > 255.0 ? 255.0 : rgb[k]);
+         out[4 * i + k] = static_cast<std::uint8_t>(clamped + 0.5);
+      }
+      out[4 * i + 3] = 255;
+   }
+   return out;
+}
+
+std::vector<SimdLevel> LevelsToTest()
+{
+   std::vector<SimdLevel> levels;
+   for (int level = SimdNone; level <= GetSupportedSimdLevel(); ++level)
+      levels.push_back(static_cast<SimdLevel>(level));
+   return levels;
+}
+
+// Restores the default level when a test section ends
+struct SimdLevelGuard
+{
+   explicit SimdLevelGuard(SimdLevel level) { SetSimdLevel(level); }
+   ~SimdLevelGuard() { SetSimdLevel(GetSupportedSimdLevel()); }
+};
+
+// Sizes around the SIMD block sizes, plus an image-sized run
+const std::size_t Counts[] = { 0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 32, 33,
+   63, 64, 65, 100, 1001, 640 * 480 };
+
+} // anonymous namespace
+
+TEST_CASE("Packed formats match reference outputs", "[PixelConversion]")
+{
+   // Pixels 0x123, 0x345, 0x0ab, 0x3ff packed by hand
+   const std::uint8_t mono10p[] = { 0x23, 0x15, 0xbd, 0xca, 0xff };
+   // Pixels 0xabc, 0x123
+   const std::uint8_t mono12p[] = { 0xbc, 0x3a, 0x12 };
+   const std::uint8_t mono10Packed[] = { 0xab, 0x21, 0x12 };
+   const std::uint8_t mono12Packed[] = { 0xab, 0x3c, 0x12 };
+
+   for (SimdLevel level : LevelsToTest())
+   {
+      SimdLevelGuard guard(level);
+      std::uint16_t out[4] = {};
+      UnpackMono10p(out, mono10p, 4);
+      CHECK(out[0] == 0x123);
+      CHECK(out[1] == 0x345);
+      CHECK(out[2] == 0x0ab);
+      CHECK(out[3] == 0x3ff);
+
+      UnpackMono12p(out, mono12p, 2);
+      CHECK(out[0] == 0xabc);
+      CHECK(out[1] == 0x123);
+
+      UnpackMono10Packed(out, mono10Packed, 2);
+      CHECK(out[0] == 0x2ad);
+      CHECK(out[1] == 0x04a);
+
+      UnpackMono12Packed(out, mono12Packed, 2);
+      CHECK(out[0] == 0xabc);
+      CHECK(out[1] == 0x123);
+   }
+}
+
+TEST_CASE("Packed formats unpack any number of pixels", "[PixelConversion]")
+{
+   for (SimdLevel level : LevelsToTest())
+   {
+      SimdLevelGuard guard(level);
+      for (std::size_t count : Counts)
+      {
+         INFO("SIMD level " << level << ", count " << count);
+         std::vector<std::uint16_t> out(count);
+
+         // Sources are sized exactly, so that reading past the end shows up
+         // under a memory checker
+         const std::vector<std::uint8_t> src10 = RandomBytes((count * 10 + 7) / 8, 1);
+         UnpackMono10p(out.data(), src10.data(), count);
+         CHECK(out == ReferenceLSBFirst(src10, count, 10));
+
+         const std::vector<std::uint8_t> src12 = RandomBytes((count * 12 + 7) / 8, 2);
+         UnpackMono12p(out.data(), src12.data(), count);
+         CHECK(out == ReferenceLSBFirst(src12, count, 12));
+
+         UnpackMono12Packed(out.data(), src12.data(), count);
+         CHECK(out == ReferenceGigEPacked(src12, count, 12));
+
+         const std::vector<std::uint8_t> src10Packed =
+            RandomBytes(count / 2 * 3 + (count % 2) * 2, 3);
+         UnpackMono10Packed(out.data(), src10Packed.data(), count);
+         CHECK(out == ReferenceGigEPacked(src10Packed, count, 10));
+      }
+   }
+}
+
+TEST_CASE("ByteSwap16 swaps bytes, also in place", "[PixelConversion]")
+{
+   for (SimdLevel level : LevelsToTest())
+   {
+      SimdLevelGuard guard(level);
+      for (std::size_t count : Counts)
+      {
+         INFO("SIMD level " << level << ", count " << count);
+         const std::vector<std::uint8_t> bytes = RandomBytes(2 * count, 4);
+         std::vector<std::uint16_t> src(count);
+         std::vector<std::uint16_t> expected(count);
+         for (std::size_t i = 0; i < count; ++i)
+         {
+            src[i] = static_cast<std::uint16_t>(bytes[2 * i] | (bytes[2 * i + 1] << 8));
+            expected[i] = static_cast<std::uint16_t>(bytes[2 * i + 1] | (bytes[2 * i] << 8));
+         }
+
+         std::vector<std::uint16_t> out(count);
+         ByteSwap16(out.data(), src.data(), count);
+         CHECK(out == expected);
+
+         ByteSwap16(src.data(), src.data(), count);
+         CHECK(src == expected);
+      }
+   }
+}
+
+TEST_CASE("24-bit color converts to RGB32", "[PixelConversion]")
+{
+   for (SimdLevel level : LevelsToTest())
+   {
+      SimdLevelGuard guard(level);
+      for (std::size_t count : Counts)
+      {
+         INFO("SIMD level " << level << ", count " << count);
+         const std::vector<std::uint8_t> src = RandomBytes(3 * count, 5);
+         std::vector<std::uint8_t> fromRGB(4 * count);
+         std::vector<std::uint8_t> fromBGR(4 * count);
+         RGB24ToRGB32(fromRGB.data(), src.data(), count);
+         BGR24ToRGB32(fromBGR.data(), src.data(), count);
+
+         std::vector<std::uint8_t> expectedRGB(4 * count);
+         std::vector<std::uint8_t> expectedBGR(4 * count);
+         for (std::size_t i = 0; i < count; ++i)
+         {
+            for (int k = 0; k < 3; ++k)
+            {
+               expectedRGB[4 * i + k] = src[3 * i + 2 - k];
+               expectedBGR[4 * i + k] = src[3 * i + k];
+            }
+            expectedRGB[4 * i + 3] = 255;
+            expectedBGR[4 * i + 3] = 255;
+         }
+         CHECK(fromRGB == expectedRGB);
+         CHECK(fromBGR == expectedBGR);
+      }
+   }
+}
+
+TEST_CASE("YUV 4:2:2 converts to RGB32", "[PixelConversion]")
+{
+   SECTION("Reference colors")
+   {
+      // Black, white, and saturated red, green and blue (BT.601 limited
+      // range), as Y0 U Y1 V
+      const std::uint8_t yuyv[] = {
+         16, 128, 235, 128,
+         82, 90, 82, 240,
+         145, 54, 145, 34,
+         41, 240, 41, 110,
+      };
+      const std::uint8_t expected[] = {
+         0, 0, 0, 255, 255, 255, 255, 255,
+         0, 0, 255, 255, 0, 0, 255, 255,
+         0, 255, 0, 255, 0, 255, 0, 255,
+         255, 0, 0, 255, 255, 0, 0, 255,
+      };
+      std::uint8_t uyvy[16];
+      for (int i = 0; i < 16; i += 2)
+      {
+         uyvy[i] = yuyv[i + 1];
+         uyvy[i + 1] = yuyv[i];
+      }
+      for (SimdLevel level : LevelsToTest())
+      {
+         SimdLevelGuard guard(level);
+         std::uint8_t out[32];
+         YUYVToRGB32(out, yuyv, 8);
+         for (int i = 0; i < 32; ++i)
+            CHECK(std::abs(out[i] - expected[i]) <= 1);
+         UYVYToRGB32(out, uyvy, 8);
+         for (int i = 0; i < 32; ++i)
+            CHECK(std::abs(out[i] - expected[i]) <= 1);
+      }
+   }
+
+   SECTION("All paths agree and are within rounding of BT.601")
+   {
+      const std::size_t count = 4096;
+      const std::vector<std::uint8_t> src = RandomBytes(2 * count, 6);
+      std::vector<std::uint8_t> scalarYUYV(4 * count);
+      std::vector<std::uint8_t> scalarUYVY(4 * count);
+      {
+         SimdLevelGuard guard(SimdNone);
+         YUYVToRGB32(scalarYUYV.data(), src.data(), count);
+         UYVYToRGB32(scalarUYVY.data(), src.data(), count);
+      }
+      const std::vector<std::uint8_t> refYUYV = ReferenceYUV422(src, count, true);
+      const std::vector<std::uint8_t> refUYVY = ReferenceYUV422(src, count, false);
+      for (std::size_t i = 0; i < 4 * count; ++i)
+      {
+         REQUIRE(std::abs(scalarYUYV[i] - refYUYV[i]) <= 2);
+         REQUIRE(std::abs(scalarUYVY[i] - refUYVY[i]) <= 2);
+      }
+
+      for (SimdLevel level : LevelsToTest())
+      {
+         SimdLevelGuard guard(level);
+         for (std::size_t n : Counts)
+         {
+            if (n % 2 != 0 || n > count)
+               continue;
+            INFO("SIMD level " << level << ", count " << n);
+            const std::vector<std::uint8_t> part(src.begin(), src.begin() + 2 * n);
+            std::vector<std::uint8_t> out(4 * n);
+            YUYVToRGB32(out.data(), part.data(), n);
+            CHECK(std::equal(out.begin(), out.end(), scalarYUYV.begin()));
+            UYVYToRGB32(out.data(), part.data(), n);
+            CHECK(std::equal(out.begin(), out.end(), scalarUYVY.begin()));
+         }
+      }
+   }
+}
+
+TEST_CASE("YUV 4:2:2 luma extracts to 8-bit gray", "[PixelConversion]")
+{
+   for (SimdLevel level : LevelsToTest())
+   {
+      SimdLevelGuard guard(level);
+      for (std::size_t count : Counts)
+      {
+         if (count % 2 != 0)
+            continue;
+         INFO("SIMD level " << level << ", count " << count);
+         const std::vector<std::uint8_t> src = RandomBytes(2 * count, 7);
+         std::vector<std::uint8_t> fromYUYV(count);
+         std::vector<std::uint8_t> fromUYVY(count);
+         YUYVToGray8(fromYUYV.data(), src.data(), count);
+         UYVYToGray8(fromUYVY.data(), src.data(), count);
+
+         std::vector<std::uint8_t> expectedYUYV(count);
+         std::vector<std::uint8_t> expectedUYVY(count);
+         for (std::size_t i = 0; i < count; ++i)
+         {
+            expectedYUYV[i] = src[2 * i];
+            expectedUYVY[i] = src[2 * i + 1];
+         }
+         CHECK(fromYUYV == expectedYUYV);
+         CHECK(fromUYVY == expectedUYVY);
+      }
+   }
+}
+
+TEST_CASE("SIMD level can be lowered but not raised", "[PixelConversion]")
+{
+   const SimdLevel supported = GetSupportedSimdLevel();
+   CHECK(GetSimdLevel() == supported);
+   {
+      SimdLevelGuard guard(SimdNone);
+      CHECK(GetSimdLevel() == SimdNone);
+   }
+   {
+      SimdLevelGuard guard(SimdAVX2);
+      CHECK(GetSimdLevel() == supported);
+   }
+}
@@ -0,0 +1,86 @@
+#include <catch2/catch_all.hpp>
+
+#include "RowBands.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Counts how many bands covered each row
+std::vector<int> CoverRows(RowBandPool& pool, unsigned height,
+   unsigned maxBands)
+{
+   std::vector<std::atomic<int>> hits(height);
+   for (auto& h : hits)
+      h = 0;
+   pool.ForEachRowBand(1, height, maxBands, [&](unsigned y0, unsigned y1)
+   {
+      for (unsigned y = y0; y < y1; ++y)
+         ++hits[y];
+   });
+   return std::vector<int>(hits.begin(), hits.end());
+}
+
+} // namespace
+
+TEST_CASE("Row bands cover every row exactly once", "[RowBands]")
+{
+   RowBandPool pool;
+   for (unsigned height : {1u, 2u, 7u, 100u, 1001u})
+   {
+      for (unsigned maxBands : {0u, 1u, 2u, 3u, 8u, 5000u})
+      {
+         CAPTURE(height, maxBands);
+         CHECK(CoverRows(pool, height, maxBands) ==
+            std::vector<int>(height, 1));
+      }
+   }
+}
+
+TEST_CASE("Row band pool is reused across calls", "[RowBands]")
+{
+   RowBandPool pool;
+   for (int i = 0; i < 100; ++i)
+      CHECK(CoverRows(pool, 64, 4) == std::vector<int>(64, 1));
+}
+
+TEST_CASE("Row band pool serves concurrent callers", "[RowBands]")
+{
+   RowBandPool pool;
+   std::atomic<int> failures(0);
+   std::vector<std::thread> callers;
+   for (int t = 0; t < 4; ++t)
+   {
+      callers.emplace_back([&]
+      {
+         for (int i = 0; i < 50; ++i)
+         {
+            if (CoverRows(pool, 37, 5) != std::vector<int>(37, 1))
+               ++failures;
+         }
+      });
+   }
+   for (std::thread& caller : callers)
+      caller.join();
+   CHECK(failures == 0);
+}
+
+TEST_CASE("Row band exceptions reach the caller after all bands finish",
+   "[RowBands]")
+{
+   RowBandPool pool;
+   std::atomic<int> finished(0);
+   CHECK_THROWS_AS(pool.ForEachRowBand(1, 40, 4, [&](unsigned y0, unsigned)
+   {
+      if (y0 == 10)
+         throw std::runtime_error("band failed");
+      ++finished;
+   }), std::runtime_error);
+   CHECK(finished == 3);
+
+   // The pool is still usable
+   CHECK(CoverRows(pool, 40, 4) == std::vector<int>(40, 1));
+}